@@ -8,9 +8,27 @@ workspace "Magnet"
    filter "system:windows"
       buildoptions { "/EHsc", "/Zc:preprocessor", "/Zc:__cplusplus" }
 
+   -- SSE2 is the x64 baseline, AVX2 enables the wider conversion kernels (see Engine/Assets/Kernels.h)
+   filter "options:avx2"
+      vectorextensions "AVX2"
+
+   filter {}
+
 OutputDir = "%{cfg.system}-%{cfg.architecture}/%{cfg.buildcfg}"
 
+newoption {
+   trigger = "with-basisu",
+   description = "Transcode Basis Universal KTX2 textures, the transcoder and Zstandard are downloaded to Magnet-Core/Source/Third-Party/basisu and built with the engine"
+}
+
+newoption {
+   trigger = "avx2",
+   description = "Build with AVX2 for the vertex, index and image conversion kernels"
+}
+
 
 include "Magnet-Core/Build-Core.lua"
 
-include "Magnet-Editor/Build-Editor.lua"
\ No newline at end of file
+include "Magnet-Editor/Build-Editor.lua"
+
+include "Magnet-Cooker/Build-Cooker.lua"
\ No newline at end of file
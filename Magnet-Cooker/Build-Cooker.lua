@@ -0,0 +1,53 @@
+project "Magnet-Cooker"
+   kind "ConsoleApp"
+   language "C++"
+   cppdialect "C++20"
+   targetdir "Binaries/%{cfg.buildcfg}"
+   staticruntime "off"
+
+   files { "Source/**.h", "Source/**.cpp" , "Source/**.c"}
+   
+
+   includedirs
+   {
+      "../Magnet-Core/Source",
+      "../Magnet-Core/Source/Third-Party",
+      "../Magnet-Core/Source/Third-Party/include"
+   }
+
+   links 
+   { 
+    "Magnet-Core"
+   }
+
+   defines
+   {
+    "_CONSOLE"
+   }
+
+   targetdir ("../Binaries/" .. OutputDir .. "/%{prj.name}")
+   objdir ("../Binaries/Intermediates/" .. OutputDir .. "/%{prj.name}")
+   
+   -- Assets are cooked in place, run from the editor directory by default
+   debugdir "../Magnet-Editor"
+
+   filter "system:windows"
+       systemversion "latest"
+       defines { "WINDOWS" }
+
+   filter "configurations:Debug"
+       defines { "DEBUG" }
+       runtime "Debug"
+       symbols "On"
+
+   filter "configurations:Release"
+       defines { "RELEASE" }
+       runtime "Release"
+       optimize "On"
+       symbols "On"
+
+   filter "configurations:Dist"
+       defines { "DIST" }
+       runtime "Release"
+       optimize "On"
+       symbols "Off"
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include "Engine/Assets/MeshImporter.h"
+#include "Engine/Rendering/TextureCompressor.h"
+#include "KernelBenchmark.h"
+#include "OBJBenchmark.h"
+
+// Offline asset cooker : converts OBJ and glTF meshes to memory mappable .mesh files next to their source,
+// and optionally compresses textures to BC7 KTX2 files.
+// Meshes get a LOD chain and are reordered for the vertex cache, overdraw and vertex fetch unless disabled.
+// Usage : Magnet-Cooker [--force] [--textures] [--no-lod] [--no-optimize] [--no-overdraw] [files or directories...], assets/defaults by default
+//         Magnet-Cooker --bench-kernels
+//         Magnet-Cooker --bench-obj [OBJ files...], a generated 1M triangle sphere by default
+int main(int argc, char** argv) {
+
+    bool force = false;
+    bool textures = false;
+    bool optimize = true;
+    bool lods = true;
+    bool benchOBJ = false;
+    Magnet::EngineBase::Assets::MeshOptimizer::Settings optimizerSettings{};
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--force") {
+            force = true;
+        }
+        else if (argument == "--textures") {
+            textures = true;
+        }
+        else if (argument == "--no-lod") {
+            lods = false;
+        }
+        else if (argument == "--no-optimize") {
+            optimize = false;
+        }
+        else if (argument == "--no-overdraw") {
+            optimizerSettings.overdraw = false;
+        }
+        else if (argument == "--bench-kernels") {
+            Magnet::Cooker::benchmarkKernels();
+            return 0;
+        }
+        else if (argument == "--bench-obj") {
+            benchOBJ = true;
+        }
+        else {
+            inputs.push_back(argument);
+        }
+    }
+    if (benchOBJ) {
+        Magnet::Cooker::benchmarkOBJ(inputs);
+        return 0;
+    }
+    if (inputs.empty()) {
+        inputs.push_back("assets/defaults");
+    }
+
+    std::vector<std::string> meshes;
+    for (const auto& input : inputs) {
+        if (std::filesystem::is_directory(input)) {
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(input)) {
+                if (entry.is_regular_file() && Magnet::EngineBase::Assets::MeshImporter::isSupported(entry.path().string())) {
+                    meshes.push_back(entry.path().string());
+                }
+            }
+        }
+        else {
+            meshes.push_back(input);
+        }
+    }
+
+    Magnet::EngineBase::Assets::MeshOptimizer optimizer{ optimizerSettings };
+    Magnet::EngineBase::Assets::MeshSimplifier simplifier{ Magnet::EngineBase::Assets::MeshSimplifier::Settings{} };
+    auto start = std::chrono::high_resolution_clock::now();
+    uintmax_t sourceBytes = 0;
+    uintmax_t cookedBytes = 0;
+    uint32_t failures = 0;
+    for (const auto& mesh : meshes) {
+        try {
+            bool upToDate = !force && Magnet::EngineBase::Assets::MeshFile::isUpToDate(mesh);
+            std::string cooked = Magnet::EngineBase::Assets::MeshImporter::cookToCache(mesh, force, optimize ? &optimizer : nullptr, lods ? &simplifier : nullptr);
+            sourceBytes += std::filesystem::file_size(mesh);
+            cookedBytes += std::filesystem::file_size(cooked);
+            std::cout << (upToDate ? "\t- Up to date : " : "\t- Cooked : ") << mesh << " -> " << cooked << std::endl;
+        }
+        catch (const std::exception& exception) {
+            std::cerr << "\t- Failed : " << mesh << " (" << exception.what() << ")" << std::endl;
+            failures++;
+        }
+    }
+
+    std::cout << "\nMesh cooking :" << std::endl;
+    std::cout << "------------------------------" << std::endl;
+    std::cout << "\t- Meshes : " << meshes.size() - failures << " (" << failures << " failed)" << std::endl;
+    std::cout << "\t- Source : " << sourceBytes / 1024 << " KB, cooked : " << cookedBytes / 1024 << " KB" << std::endl;
+    std::cout << "\t- Time : " << std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() << " ms" << std::endl;
+    if (simplifier.getStats().meshes > 0) {
+        simplifier.printStats();
+    }
+    if (optimizer.getStats().meshes > 0) {
+        optimizer.printStats();
+    }
+
+    if (textures) {
+        Magnet::EngineBase::Rendering::TextureCompressor compressor{ Magnet::EngineBase::Rendering::TextureCompressor::Settings{} };
+        for (const auto& input : inputs) {
+            if (std::filesystem::is_directory(input)) {
+                compressor.compressDirectory(input);
+            }
+        }
+        compressor.printStats();
+    }
+
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,148 @@
+#include "Engine/Assets/Kernels.h"
+#include "Engine/Assets/MeshFile.h"
+#include "KernelBenchmark.h"
+
+#include <random>
+
+namespace {
+	using Magnet::EngineBase::Assets::MeshFile;
+	namespace Kernels = Magnet::EngineBase::Assets::Kernels;
+
+	constexpr size_t VERTEX_COUNT = size_t(1) << 20;
+	constexpr size_t INDEX_COUNT = 3 * VERTEX_COUNT;
+	constexpr size_t TEXTURE_SIZE = 8192;
+
+	// Best of runs, in milliseconds
+	template<typename Function>
+	double time(uint32_t runs, Function function)
+	{
+		double best = std::numeric_limits<double>::max();
+		for (uint32_t run = 0; run < runs; run++) {
+			auto start = std::chrono::high_resolution_clock::now();
+			function();
+			best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+		}
+		return best;
+	}
+
+	void printResult(const char* name, double referenceMs, double kernelMs, bool matches)
+	{
+		std::cout << "\t- " << name << " : reference " << referenceMs << " ms, kernels " << kernelMs << " ms (x"
+			<< referenceMs / std::max(kernelMs, 1e-6) << ")" << (matches ? "" : " MISMATCH") << std::endl;
+	}
+}
+
+void Magnet::Cooker::benchmarkKernels(uint32_t runs)
+{
+	std::mt19937 random{ 42 };
+	std::uniform_real_distribution<float> distribution{ -1.0f, 1.0f };
+
+	// Separate tightly packed streams, as glTF accessors usually are
+	std::vector<glm::vec3> positions(VERTEX_COUNT), normals(VERTEX_COUNT);
+	std::vector<glm::vec2> texCoords(VERTEX_COUNT);
+	for (size_t i = 0; i < VERTEX_COUNT; i++) {
+		positions[i] = { distribution(random), distribution(random), distribution(random) };
+		normals[i] = { distribution(random), distribution(random), distribution(random) };
+		texCoords[i] = { distribution(random), distribution(random) };
+	}
+	std::vector<uint16_t> indices16(INDEX_COUNT);
+	std::vector<uint32_t> indices32(INDEX_COUNT);
+	for (size_t i = 0; i < INDEX_COUNT; i++) {
+		indices16[i] = static_cast<uint16_t>(random());
+		indices32[i] = static_cast<uint32_t>(random() % VERTEX_COUNT);
+	}
+	std::vector<uint8_t> rgb(TEXTURE_SIZE * TEXTURE_SIZE * 3);
+	for (auto& channel : rgb) {
+		channel = static_cast<uint8_t>(random());
+	}
+
+	std::cout << "\nKernel benchmark (" << Kernels::getInstructionSet() << ", best of " << runs << ") :" << std::endl;
+	std::cout << "------------------------------" << std::endl;
+
+	// Vertices : what loadNode did, then kernels writing to presized output like the staging buffer
+	std::vector<MeshFile::Vertex> referenceVertices, kernelVertices(VERTEX_COUNT);
+	double referenceMs = time(runs, [&]() {
+		referenceVertices.clear();
+		referenceVertices.shrink_to_fit();
+		for (size_t v = 0; v < VERTEX_COUNT; v++) {
+			MeshFile::Vertex vertex{};
+			vertex.pos = positions[v];
+			vertex.normal = glm::normalize(normals[v]);
+			vertex.uv = texCoords[v];
+			vertex.color = glm::vec3(1.0f);
+			referenceVertices.push_back(vertex);
+		}
+	});
+	double kernelMs = time(runs, [&]() {
+		glm::vec3 white{ 1.0f };
+		Kernels::copyAttribute(positions.data(), sizeof(glm::vec3), &kernelVertices[0].pos, sizeof(MeshFile::Vertex), sizeof(glm::vec3), VERTEX_COUNT);
+		Kernels::copyAttribute(normals.data(), sizeof(glm::vec3), &kernelVertices[0].normal, sizeof(MeshFile::Vertex), sizeof(glm::vec3), VERTEX_COUNT);
+		Kernels::normalize3(&kernelVertices[0].normal, sizeof(MeshFile::Vertex), VERTEX_COUNT);
+		Kernels::copyAttribute(texCoords.data(), sizeof(glm::vec2), &kernelVertices[0].uv, sizeof(MeshFile::Vertex), sizeof(glm::vec2), VERTEX_COUNT);
+		Kernels::fillAttribute(&white, &kernelVertices[0].color, sizeof(MeshFile::Vertex), sizeof(glm::vec3), VERTEX_COUNT);
+	});
+	bool matches = true;
+	for (size_t v = 0; v < VERTEX_COUNT; v++) {
+		matches &= referenceVertices[v].pos == kernelVertices[v].pos && referenceVertices[v].uv == kernelVertices[v].uv;
+		matches &= glm::all(glm::lessThan(glm::abs(referenceVertices[v].normal - kernelVertices[v].normal), glm::vec3(1e-5f)));
+	}
+	printResult("1M vertices", referenceMs, kernelMs, matches);
+
+	// Indices, rebased like primitives appended to the shared vertex buffer
+	constexpr uint32_t BASE = 1000;
+	std::vector<uint32_t> referenceIndices, kernelIndices(INDEX_COUNT);
+	referenceMs = time(runs, [&]() {
+		referenceIndices.clear();
+		referenceIndices.shrink_to_fit();
+		for (size_t i = 0; i < INDEX_COUNT; i++) {
+			referenceIndices.push_back(indices16[i] + BASE);
+		}
+	});
+	kernelMs = time(runs, [&]() {
+		Kernels::widenIndices(indices16.data(), INDEX_COUNT, BASE, kernelIndices.data());
+	});
+	printResult("3M 16 bit indices", referenceMs, kernelMs, referenceIndices == kernelIndices);
+
+	referenceMs = time(runs, [&]() {
+		referenceIndices.clear();
+		referenceIndices.shrink_to_fit();
+		for (size_t i = 0; i < INDEX_COUNT; i++) {
+			referenceIndices.push_back(indices32[i] + BASE);
+		}
+	});
+	kernelMs = time(runs, [&]() {
+		Kernels::widenIndices(indices32.data(), INDEX_COUNT, BASE, kernelIndices.data());
+	});
+	printResult("3M 32 bit indices", referenceMs, kernelMs, referenceIndices == kernelIndices);
+
+	// Back to 16 bits, as uploadGeometry does for primitives spanning fewer than 65536 vertices
+	Kernels::widenIndices(indices16.data(), INDEX_COUNT, BASE, kernelIndices.data());
+	std::vector<uint16_t> referenceNarrowed(INDEX_COUNT), kernelNarrowed(INDEX_COUNT);
+	referenceMs = time(runs, [&]() {
+		for (size_t i = 0; i < INDEX_COUNT; i++) {
+			referenceNarrowed[i] = static_cast<uint16_t>(kernelIndices[i] - BASE);
+		}
+	});
+	kernelMs = time(runs, [&]() {
+		Kernels::narrowIndices(kernelIndices.data(), INDEX_COUNT, BASE, kernelNarrowed.data());
+	});
+	printResult("3M indices to 16 bit", referenceMs, kernelMs, referenceNarrowed == kernelNarrowed && kernelNarrowed == indices16);
+
+	// 8K texture, what loadImages did for RGB images
+	size_t pixelCount = TEXTURE_SIZE * TEXTURE_SIZE;
+	std::vector<uint8_t> referenceRGBA(pixelCount * 4), kernelRGBA(pixelCount * 4);
+	referenceMs = time(runs, [&]() {
+		unsigned char* output = referenceRGBA.data();
+		const unsigned char* input = rgb.data();
+		for (size_t i = 0; i < pixelCount; ++i) {
+			memcpy(output, input, sizeof(unsigned char) * 3);
+			output[3] = 255;
+			output += 4;
+			input += 3;
+		}
+	});
+	kernelMs = time(runs, [&]() {
+		Kernels::expandRGBToRGBA(rgb.data(), pixelCount, kernelRGBA.data());
+	});
+	printResult("8K RGB to RGBA", referenceMs, kernelMs, referenceRGBA == kernelRGBA);
+}
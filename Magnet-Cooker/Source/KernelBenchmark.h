@@ -0,0 +1,10 @@
+#pragma once
+#include "Commons.h"
+
+namespace Magnet {
+	namespace Cooker {
+		// Times the asset conversion kernels against the per-element loops they replace, on a million vertex
+		// mesh, 3 million indices and an 8K RGB texture, and checks both produce the same data
+		void benchmarkKernels(uint32_t runs = 5);
+	}
+}
@@ -0,0 +1,149 @@
+#include "Engine/Assets/OBJFile.h"
+#include "Engine/Parallel.h"
+#include "Utils.h"
+#include "OBJBenchmark.h"
+
+#include <tinyObjLoader/tiny_obj_loader.h>
+
+namespace {
+	using Magnet::EngineBase::Assets::OBJFile;
+
+	constexpr uint32_t SPHERE_SEGMENTS = 1024;
+
+	// Best of runs, in milliseconds
+	template<typename Function>
+	double time(uint32_t runs, Function function)
+	{
+		double best = std::numeric_limits<double>::max();
+		for (uint32_t run = 0; run < runs; run++) {
+			auto start = std::chrono::high_resolution_clock::now();
+			function();
+			best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+		}
+		return best;
+	}
+
+	// UV sphere of quads with positions, texture coordinates and normals, as exported by DCC tools
+	std::string writeSphere(uint32_t segments)
+	{
+		std::string path = (std::filesystem::temp_directory_path() / "magnet_bench_sphere.obj").string();
+		std::ofstream output{ path, std::ios::trunc };
+		if (!output.is_open()) {
+			throw std::runtime_error("failed to open file: " + path);
+		}
+		uint32_t rings = segments / 2;
+		output << "o Sphere\n";
+		for (uint32_t ring = 0; ring <= rings; ring++) {
+			float phi = glm::pi<float>() * ring / rings;
+			for (uint32_t segment = 0; segment <= segments; segment++) {
+				float theta = glm::two_pi<float>() * segment / segments;
+				glm::vec3 normal{ std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta) };
+				output << "v " << normal.x << " " << normal.y << " " << normal.z << "\n";
+				output << "vt " << float(segment) / segments << " " << float(ring) / rings << "\n";
+				output << "vn " << normal.x << " " << normal.y << " " << normal.z << "\n";
+			}
+		}
+		for (uint32_t ring = 0; ring < rings; ring++) {
+			for (uint32_t segment = 0; segment < segments; segment++) {
+				uint32_t corners[4] = {
+					ring * (segments + 1) + segment + 1,
+					(ring + 1) * (segments + 1) + segment + 1,
+					(ring + 1) * (segments + 1) + segment + 2,
+					ring * (segments + 1) + segment + 2 };
+				output << "f";
+				for (uint32_t corner : corners) {
+					output << " " << corner << "/" << corner << "/" << corner;
+				}
+				output << "\n";
+			}
+		}
+		return path;
+	}
+
+	// What MeshImporter::importOBJ did before OBJFile
+	void loadReference(const std::string& path, size_t& vertexCount, size_t& indexCount)
+	{
+		tinyobj::attrib_t attrib;
+		std::vector<tinyobj::shape_t> shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string warning, error;
+		std::string baseDirectory = std::filesystem::path(path).parent_path().string() + "/";
+		if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warning, &error, path.c_str(), baseDirectory.c_str())) {
+			throw std::runtime_error("failed to load OBJ file: " + path + " " + warning + error);
+		}
+
+		struct Key {
+			int vertex, normal, texCoord;
+			bool operator==(const Key& other) const { return vertex == other.vertex && normal == other.normal && texCoord == other.texCoord; }
+		};
+		struct KeyHash {
+			size_t operator()(const Key& key) const
+			{
+				size_t seed = 0;
+				Magnet::hashCombine(seed, key.vertex, key.normal, key.texCoord);
+				return seed;
+			}
+		};
+		std::unordered_map<Key, uint32_t, KeyHash> uniqueVertices;
+		std::vector<Magnet::EngineBase::Assets::MeshFile::Vertex> vertices;
+		std::vector<uint32_t> indices;
+		for (const auto& shape : shapes) {
+			for (const auto& index : shape.mesh.indices) {
+				Key key{ index.vertex_index, index.normal_index, index.texcoord_index };
+				auto found = uniqueVertices.find(key);
+				if (found != uniqueVertices.end()) {
+					indices.push_back(found->second);
+					continue;
+				}
+				Magnet::EngineBase::Assets::MeshFile::Vertex vertex{};
+				vertex.pos = glm::make_vec3(&attrib.vertices[3 * index.vertex_index]);
+				if (index.normal_index >= 0) {
+					vertex.normal = glm::make_vec3(&attrib.normals[3 * index.normal_index]);
+				}
+				if (index.texcoord_index >= 0) {
+					vertex.uv = { attrib.texcoords[2 * index.texcoord_index], 1.0f - attrib.texcoords[2 * index.texcoord_index + 1] };
+				}
+				uint32_t vertexIndex = static_cast<uint32_t>(vertices.size());
+				uniqueVertices.emplace(key, vertexIndex);
+				vertices.push_back(vertex);
+				indices.push_back(vertexIndex);
+			}
+		}
+		vertexCount = vertices.size();
+		indexCount = indices.size();
+	}
+}
+
+void Magnet::Cooker::benchmarkOBJ(const std::vector<std::string>& paths, uint32_t runs)
+{
+	std::vector<std::string> files = paths;
+	if (files.empty()) {
+		files.push_back(writeSphere(SPHERE_SEGMENTS));
+	}
+
+	std::cout << "\nOBJ benchmark (" << EngineBase::getWorkerCount() << " workers, best of " << runs << ") :" << std::endl;
+	std::cout << "------------------------------" << std::endl;
+	for (const auto& file : files) {
+		size_t referenceVertices = 0, referenceIndices = 0;
+		double referenceMs = time(runs, [&]() { loadReference(file, referenceVertices, referenceIndices); });
+
+		OBJFile::Settings serial{};
+		serial.threadCount = 1;
+		double serialMs = time(runs, [&]() { OBJFile obj{ file, serial }; });
+
+		size_t vertexCount = 0, indexCount = 0;
+		uint32_t chunkCount = 0;
+		double parallelMs = time(runs, [&]() {
+			OBJFile obj{ file, OBJFile::Settings{} };
+			vertexCount = obj.getVertices().size();
+			indexCount = obj.getIndices().size();
+			chunkCount = obj.getChunkCount();
+		});
+
+		bool matches = vertexCount == referenceVertices && indexCount == referenceIndices;
+		std::cout << "\t- " << std::filesystem::path(file).filename().string() << " (" << std::filesystem::file_size(file) / 1024 << " KB, "
+			<< vertexCount << " vertices, " << indexCount / 3 << " triangles, " << chunkCount << " chunks) : tinyobj " << referenceMs
+			<< " ms, 1 worker " << serialMs << " ms, all workers " << parallelMs << " ms (x" << referenceMs / std::max(parallelMs, 1e-6) << ")"
+			<< (matches ? "" : " MISMATCH") << std::endl;
+	}
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include "Commons.h"
+
+namespace Magnet {
+	namespace Cooker {
+		// Times OBJFile, with all workers and with one, against tinyobj followed by the std::unordered_map vertex
+		// deduplication the importer used, and checks both produce as many vertices and indices.
+		// Without paths a 1M triangle sphere is written to the temporary directory and loaded
+		void benchmarkOBJ(const std::vector<std::string>& paths, uint32_t runs = 5);
+	}
+}
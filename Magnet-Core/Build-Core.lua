@@ -1,3 +1,32 @@
+BasisuVersion = "1.16.4"
+
+function fetchBasisu(directory)
+   if os.isdir(path.join(directory, "transcoder")) and os.isdir(path.join(directory, "zstd")) then
+      return
+   end
+
+   local parent = path.getdirectory(directory)
+   local archive = path.join(parent, "basis_universal-" .. BasisuVersion .. ".zip")
+   print("Downloading Basis Universal " .. BasisuVersion)
+   local result, code = http.download("https://github.com/BinomialLLC/basis_universal/archive/refs/tags/" .. BasisuVersion .. ".zip", archive)
+   if result ~= "OK" then
+      error("failed to download Basis Universal: " .. result .. " (" .. tostring(code) .. ")")
+   end
+
+   -- Only the transcoder and Zstandard are kept from the repository
+   local extracted = path.join(parent, "basis_universal-" .. BasisuVersion)
+   zip.extract(archive, parent)
+   os.mkdir(directory)
+   for _, folder in ipairs({ "transcoder", "zstd" }) do
+      local ok, err = os.rename(path.join(extracted, folder), path.join(directory, folder))
+      if not ok then
+         error("failed to extract Basis Universal: " .. err)
+      end
+   end
+   os.rmdir(extracted)
+   os.remove(archive)
+end
+
 project "Magnet-Core"
    kind "StaticLib"
    language "C++"
@@ -34,6 +63,18 @@ project "Magnet-Core"
    targetdir ("../Binaries/" .. OutputDir .. "/%{prj.name}")
    objdir ("../Binaries/Intermediates/" .. OutputDir .. "/%{prj.name}")
 
+   -- Transcoder and Zstandard sources of the Basis Universal repository, downloaded to Source/Third-Party/basisu
+   -- on the first generation with --with-basisu and compiled with the engine
+   if _OPTIONS["with-basisu"] then
+       fetchBasisu(path.join(_SCRIPT_DIR, "Source/Third-Party/basisu"))
+       defines { "MAGNET_WITH_BASISU" }
+       includedirs { "Source/Third-Party" }
+       -- zstd.c is the full single file library, the decoder only amalgamation would duplicate its symbols
+       removefiles { "Source/Third-Party/basisu/zstd/zstddeclib.c" }
+   else
+       removefiles { "Source/Third-Party/basisu/**" }
+   end
+
    filter "system:windows"
        systemversion "latest"
        defines { }
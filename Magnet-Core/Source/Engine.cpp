@@ -1,5 +1,13 @@
 #include "Engine.h"
 
+namespace {
+    bool loadglTFImage(tinygltf::Image* image, const int /*imageIndex*/, std::string* /*error*/, std::string* /*warning*/, int /*requestedWidth*/, int /*requestedHeight*/, const unsigned char* bytes, int size, void* /*userData*/)
+    {
+        // Decoding is deferred to VulkanglTFModel::loadImages, which runs it on worker threads
+        image->image.assign(bytes, bytes + size);
+        return true;
+    }
+}
 
 
 Magnet::Engine::Engine()
@@ -9,10 +17,49 @@ Magnet::Engine::Engine()
 
 Magnet::Engine::~Engine()
 {
-    vkDestroyPipeline(device.device(), pipelines.solid, nullptr);
-    if (pipelines.wireframe != VK_NULL_HANDLE) {
-        vkDestroyPipeline(device.device(), pipelines.wireframe, nullptr);
+    std::cout << "\nRender backend : " << (renderBackend == RenderBackend::ShaderObjects ? "Shader objects" : "Pipelines") << std::endl;
+    std::cout << "------------------------------" << std::endl;
+    creationTimes.print();
+    bindTimes.print();
+    frameTimes.print();
+    gpuFrameTimes.print();
+
+    vkDeviceWaitIdle(device.device());
+    renderGraph.reset();
+    visibility.reset();
+    if (meshlets) {
+        meshlets->printStats();
+    }
+    meshlets.reset();
+    if (vertexPuller) {
+        vertexPuller->printStats();
+    }
+    vertexPuller.reset();
+    if (textureStreamer) {
+        textureStreamer->printStats();
+    }
+    textureStreamer.reset();
+    glTFModel.releaseGeometry();
+    if (geometryArena) {
+        geometryArena->printStats();
     }
+    geometryArena.reset();
+    lighting.reset();
+    gpuTimer.reset();
+    if (shadows) {
+        shadows->printStats();
+    }
+    shadows.reset();
+
+    // Pipelines are released by the renderer's pipeline registry
+    pipelines.solid.reset();
+    pipelines.wireframe.reset();
+    pipelines.pulled.reset();
+    boundPipeline.pipeline.reset();
+    shaderObject.reset();
+    pulledShaderObject.reset();
+    // Waits for background pipeline optimizations, which still reference the pipeline layout
+    renderer.getPipelineRegistry().clear();
     vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
     vkDestroyDescriptorSetLayout(device.device(), descriptorSetLayouts.matrices, nullptr);
     vkDestroyDescriptorSetLayout(device.device(), descriptorSetLayouts.textures, nullptr);
@@ -50,18 +97,125 @@ void Magnet::Engine::init()
 
     renderer.createPipelineCache();
     swapchain.createFramebuffers();
+    textureStreamer = std::make_unique<EngineBase::Rendering::TextureStreamer>(device, VKBase::SwapChain::MAX_FRAMES_IN_FLIGHT, EngineBase::Rendering::TextureStreamer::Settings{});
+    glTFModel.textureStreamer = textureStreamer.get();
+    geometryArena = std::make_unique<EngineBase::Rendering::GeometryArena>(device, VKBase::SwapChain::MAX_FRAMES_IN_FLIGHT, EngineBase::Rendering::GeometryArena::Settings{});
+    glTFModel.geometryArena = geometryArena.get();
     loadAssets();
     prepareUniformBuffers();
     setupDescriptors();
+    lighting = std::make_unique<EngineBase::Rendering::ClusteredLighting>(device, CLUSTER_SHADER, VKBase::SwapChain::MAX_FRAMES_IN_FLIGHT);
+    // Same light the scene had with the single light of GlobalUbo
+    lighting->setLights({ { glm::vec4(-1.0f, -1.0f, -1.0f, 10.0f), glm::vec4(1.0f) } });
+    gpuTimer = std::make_unique<VKBase::GpuTimer>(device, VKBase::SwapChain::MAX_FRAMES_IN_FLIGHT);
+    createShadows();
+    if (device.capabilities().bufferDeviceAddress) {
+        vertexPuller = std::make_unique<EngineBase::Rendering::VertexPuller>(device, VKBase::SwapChain::MAX_FRAMES_IN_FLIGHT);
+    }
+    createPipelineLayout();
     preparePipelines();
+    createVisibilityBuffer();
+    createMeshletRenderer();
+    buildRenderGraph();
     buildCommandBuffers();
     
 
 }
 
 void Magnet::Engine::run() {
+    EngineBase::ScopedTimer timer{ frameTimes };
 
     glfwPollEvents();
+    drawFrame();
+}
+
+void Magnet::Engine::drawFrame()
+{
+    uint32_t imageIndex;
+    VkResult result = swapchain.acquireNextImage(&imageIndex);
+    if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+        throw std::runtime_error("failed to acquire swap chain image!");
+    }
+
+    // Acquiring waited on this frame slot's fence, its timestamps are available
+    double gpuMs;
+    if (gpuTimer->read(currentFrameIndex, gpuMs)) {
+        gpuFrameTimes.add(gpuMs);
+    }
+
+    VkCommandBuffer commandBuffer = renderer.getCommandBuffer(currentFrameIndex);
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin recording command buffer!");
+    }
+
+    gpuTimer->begin(commandBuffer, currentFrameIndex);
+    if (geometryArena->update()) {
+        updateGeometryBindings();
+    }
+    updateTextureStreaming();
+    updateLods();
+    lighting->update(camera, swapchain.getSwapChainExtent(), currentFrameIndex);
+    shadows->update(camera, sunDirection, sunColor, currentFrameIndex);
+    if (renderPath == RenderPath::VisibilityBuffer) {
+        visibility->update(camera.matrices.perspective * camera.matrices.view, swapchain.getSwapChainExtent(), ambientLight, currentFrameIndex);
+    }
+    if (renderPath == RenderPath::Meshlets) {
+        updateMeshlets();
+        meshlets->cull(commandBuffer, currentFrameIndex);
+    }
+    if (renderPath == RenderPath::VertexPulling) {
+        updateVertexPulling();
+    }
+    recordFrame(commandBuffer, imageIndex);
+    gpuTimer->end(commandBuffer, currentFrameIndex);
+
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record command buffer!");
+    }
+
+    swapchain.submitCommandBuffers(&commandBuffer, &imageIndex);
+    currentFrameIndex = (currentFrameIndex + 1) % VKBase::SwapChain::MAX_FRAMES_IN_FLIGHT;
+}
+
+void Magnet::Engine::benchmarkLighting(uint32_t framesPerCase)
+{
+    using Lighting = EngineBase::Rendering::ClusteredLighting;
+
+    struct Result {
+        uint32_t lightCount;
+        double bruteForceMs;
+        double clusteredMs;
+    };
+    std::vector<Result> results;
+
+    Lighting::Mode previousMode = lighting->getMode();
+    for (uint32_t lightCount : { 16u, 256u, 4096u }) {
+        lighting->setLights(Lighting::randomLights(lightCount, glm::vec3(-4.0f), glm::vec3(4.0f), 1.0f));
+
+        Result result{ lightCount, 0.0, 0.0 };
+        for (Lighting::Mode mode : { Lighting::Mode::BruteForce, Lighting::Mode::Clustered }) {
+            lighting->setMode(mode);
+            gpuFrameTimes.reset();
+            for (uint32_t frame = 0; frame < framesPerCase; frame++) {
+                glfwPollEvents();
+                drawFrame();
+            }
+            vkDeviceWaitIdle(device.device());
+            (mode == Lighting::Mode::BruteForce ? result.bruteForceMs : result.clusteredMs) = gpuFrameTimes.percentile(50.0);
+        }
+        results.push_back(result);
+    }
+    lighting->setMode(previousMode);
+    gpuFrameTimes.reset();
+
+    std::cout << "\nLighting benchmark (median GPU frame time) :" << std::endl;
+    std::cout << "------------------------------" << std::endl;
+    for (const auto& result : results) {
+        std::cout << "\t- " << result.lightCount << " lights : brute force " << result.bruteForceMs
+            << " ms, clustered " << result.clusteredMs << " ms (x" << result.bruteForceMs / std::max(result.clusteredMs, 1e-6) << ")" << std::endl;
+    }
 }
 
 void Magnet::Engine::waitIdle()
@@ -77,27 +231,52 @@ bool Magnet::Engine::shouldClose()
 }
 
 void Magnet::Engine::loadglTFFile(std::string filename) {
+	if (EngineBase::Assets::MeshFile::isUpToDate(filename)) {
+		loadMeshFile(EngineBase::Assets::MeshFile::getCookedPath(filename));
+		return;
+	}
+	if (std::filesystem::path(filename).extension() == ".glb") {
+		loadGLBFile(filename);
+		return;
+	}
+
 	tinygltf::Model glTFInput;
 	tinygltf::TinyGLTF gltfContext;
 	std::string error, warning;
 
+	auto start = std::chrono::high_resolution_clock::now();
+	// Images are kept encoded, VulkanglTFModel::loadImages decodes or transcodes them
+	gltfContext.SetImageLoader(loadglTFImage, nullptr);
 	bool fileLoaded = gltfContext.LoadASCIIFromFile(&glTFInput, &error, &warning, filename);
+	auto parsed = std::chrono::high_resolution_clock::now();
 
 	// Pass some Vulkan resources required for setup and rendering to the glTF model loading class
-	glTFModel.vulkanDevice = &device;
-	glTFModel.copyQueue = queue;
+	glTFModel.device = &device;
+	glTFModel.copyQueue = device.graphicsQueue();
 
 	std::vector<uint32_t> indexBuffer;
 	std::vector<VulkanglTFModel::Vertex> vertexBuffer;
+	std::vector<VulkanglTFModel::VertexRange> vertexRanges;
 	if (fileLoaded) {
 		glTFModel.loadImages(glTFInput);
+		auto imagesLoaded = std::chrono::high_resolution_clock::now();
 		glTFModel.loadMaterials(glTFInput);
 		glTFModel.loadTextures(glTFInput);
+		// Geometry is converted in parallel, the node tree is built last
+		std::vector<VulkanglTFModel::Mesh> meshes = glTFModel.loadMeshes(glTFInput, indexBuffer, vertexBuffer, vertexRanges);
 		const tinygltf::Scene& scene = glTFInput.scenes[0];
 		for (size_t i = 0; i < scene.nodes.size(); i++) {
-				const tinygltf::Node node = glTFInput.nodes[scene.nodes[i]];
-				glTFModel.loadNode(node, glTFInput, nullptr, indexBuffer, vertexBuffer);
+				const tinygltf::Node& node = glTFInput.nodes[scene.nodes[i]];
+				glTFModel.loadNode(node, glTFInput, nullptr, meshes);
 			}
+		auto converted = std::chrono::high_resolution_clock::now();
+
+		auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+		std::cout << "\nglTF file : " << filename << std::endl;
+		std::cout << "------------------------------" << std::endl;
+		std::cout << "\t- Vertices : " << vertexBuffer.size() << ", indices : " << indexBuffer.size() << ", images : " << glTFInput.images.size() << std::endl;
+		std::cout << "\t- Parse : " << ms(start, parsed) << " ms, images : " << ms(parsed, imagesLoaded) << " ms, geometry : " << ms(imagesLoaded, converted)
+			<< " ms (" << EngineBase::getWorkerCount() << " threads)" << std::endl;
 		}
 		else {
 			vks::tools::exitFatal("Could not open the glTF file.\n\nMake sure the assets submodule has been checked out and is up-to-date.", -1);
@@ -107,74 +286,933 @@ void Magnet::Engine::loadglTFFile(std::string filename) {
 		// Create and upload vertex and index buffer
 		// We will be using one single vertex buffer and one single index buffer for the whole glTF scene
 		// Primitives (of the glTF model) will then index into these using index offsets
+		glTFModel.uploadGeometry(VulkanglTFModel::GeometrySource::fromVertices(vertexBuffer.data(), vertexBuffer.size(), std::move(vertexRanges), indexBuffer.data(), indexBuffer.size()));
+}
+
+void Magnet::Engine::loadMeshFile(std::string filename)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    EngineBase::Assets::MeshFile meshFile{ filename };
+    const auto& header = meshFile.getHeader();
 
-		size_t vertexBufferSize = vertexBuffer.size() * sizeof(VulkanglTFModel::Vertex);
-		size_t indexBufferSize = indexBuffer.size() * sizeof(uint32_t);
-		glTFModel.indices.count = static_cast<uint32_t>(indexBuffer.size());
-
-		struct StagingBuffer {
-			VkBuffer buffer;
-			VkDeviceMemory memory;
-		} vertexStaging, indexStaging;
-
-		// Create host visible staging buffers (source)
-		VK_CHECK_RESULT(vulkanDevice->createBuffer(
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			vertexBufferSize,
-			&vertexStaging.buffer,
-			&vertexStaging.memory,
-			vertexBuffer.data()));
-		// Index data
-		VK_CHECK_RESULT(vulkanDevice->createBuffer(
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			indexBufferSize,
-			&indexStaging.buffer,
-			&indexStaging.memory,
-			indexBuffer.data()));
-
-		// Create device local buffers (target)
-		VK_CHECK_RESULT(vulkanDevice->createBuffer(
-			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-			vertexBufferSize,
-			&glTFModel.vertices.buffer,
-			&glTFModel.vertices.memory));
-		VK_CHECK_RESULT(vulkanDevice->createBuffer(
-			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-			indexBufferSize,
-			&glTFModel.indices.buffer,
-			&glTFModel.indices.memory));
-
-		// Copy data from staging buffers (host) do device local buffer (gpu)
-		VkCommandBuffer copyCmd = vulkanDevice->createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-		VkBufferCopy copyRegion = {};
-
-		copyRegion.size = vertexBufferSize;
-		vkCmdCopyBuffer(
-			copyCmd,
-			vertexStaging.buffer,
-			glTFModel.vertices.buffer,
-			1,
-			&copyRegion);
-
-		copyRegion.size = indexBufferSize;
-		vkCmdCopyBuffer(
-			copyCmd,
-			indexStaging.buffer,
-			glTFModel.indices.buffer,
-			1,
-			&copyRegion);
-
-		vulkanDevice->flushCommandBuffer(copyCmd, queue, true);
-
-		// Free staging resources
-		vkDestroyBuffer(device, vertexStaging.buffer, nullptr);
-		vkFreeMemory(device, vertexStaging.memory, nullptr);
-		vkDestroyBuffer(device, indexStaging.buffer, nullptr);
-		vkFreeMemory(device, indexStaging.memory, nullptr);
+    glTFModel.device = &device;
+    glTFModel.copyQueue = device.graphicsQueue();
+
+    // Materials sharing a texture share its image, untextured ones sample white tinted by their base color
+    std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+    const auto* materials = meshFile.getMaterials();
+    std::unordered_map<std::string, uint32_t> textureIndices;
+    glTFModel.materials.resize(header.materialCount);
+    for (uint32_t i = 0; i < header.materialCount; i++) {
+        std::string texturePath{ materials[i].baseColorTexture, strnlen(materials[i].baseColorTexture, sizeof(materials[i].baseColorTexture)) };
+        auto texture = textureIndices.find(texturePath);
+        if (texture == textureIndices.end()) {
+            auto& image = glTFModel.images.emplace_back();
+            if (texturePath.empty()) {
+                unsigned char white[4] = { 255, 255, 255, 255 };
+                image.texture.fromBuffer(white, sizeof(white), VK_FORMAT_R8G8B8A8_UNORM, 1, 1, &device);
+            }
+            else {
+                image.texture.loadFromFile((directory / texturePath).string(), &device);
+            }
+            glTFModel.textures.push_back({ static_cast<int32_t>(glTFModel.images.size() - 1) });
+            texture = textureIndices.emplace(texturePath, static_cast<uint32_t>(glTFModel.textures.size() - 1)).first;
+        }
+        glTFModel.materials[i].baseColorFactor = materials[i].baseColorFactor;
+        glTFModel.materials[i].baseColorTextureIndex = texture->second;
+    }
+
+    // Transforms are baked, one root node per submesh keeps per-submesh culling. Submeshes share
+    // vertices, so they are all quantized to the box of the file
+    const auto* submeshes = meshFile.getSubmeshes();
+    const auto* lods = meshFile.getLods();
+    for (uint32_t i = 0; i < header.submeshCount; i++) {
+        auto* node = new VulkanglTFModel::Node{};
+        node->parent = nullptr;
+        node->matrix = glm::mat4(1.0f);
+        node->mesh.primitives.push_back({ submeshes[i].firstIndex, submeshes[i].indexCount, submeshes[i].materialIndex });
+        for (uint32_t lod = submeshes[i].firstLod; lod < submeshes[i].firstLod + submeshes[i].lodCount && lod < header.lodCount; lod++) {
+            node->mesh.lods.push_back({ { { lods[lod].firstIndex, lods[lod].indexCount, submeshes[i].materialIndex } }, lods[lod].error });
+        }
+        node->mesh.boundsMin = submeshes[i].boundsMin;
+        node->mesh.boundsMax = submeshes[i].boundsMax;
+        node->mesh.quantization = header.quantization;
+        glTFModel.nodes.push_back(node);
+    }
+
+    // Blobs are copied as is from the mapping to staging memory, meshlets are built from the packed positions
+    const auto* vertices = meshFile.getVertices();
+    const uint32_t* colors = meshFile.getColors();
+    const uint32_t* indices = meshFile.getIndices();
+    VulkanglTFModel::GeometrySource source;
+    source.vertexCount = header.vertexCount;
+    source.indexCount = header.indexCount;
+    source.vertexRanges = { { 0, header.vertexCount, header.quantization } };
+    source.writeVertices = [&](const VulkanglTFModel::VertexRange& range, VulkanglTFModel::PackedVertex* packed, uint32_t* rangeColors) {
+        memcpy(packed, vertices + range.firstVertex, range.vertexCount * sizeof(VulkanglTFModel::PackedVertex));
+        if (header.colorCount == header.vertexCount) {
+            memcpy(rangeColors, colors + range.firstVertex, range.vertexCount * sizeof(uint32_t));
+        }
+        else {
+            std::fill_n(rangeColors, range.vertexCount, colors[0]);
+        }
+    };
+    source.getTriangles = [&](uint32_t firstIndex, uint32_t indexCount) {
+        EngineBase::Assets::TriangleList triangles{};
+        triangles.indices = indices + firstIndex;
+        triangles.indexCount = indexCount;
+        triangles.positions = reinterpret_cast<const unsigned char*>(vertices->position);
+        triangles.positionStride = sizeof(VulkanglTFModel::PackedVertex);
+        triangles.quantized = true;
+        return triangles;
+    };
+    glTFModel.uploadGeometry(source);
+
+    std::cout << "\nMesh file : " << filename << std::endl;
+    std::cout << "------------------------------" << std::endl;
+    std::cout << "\t- Vertices : " << header.vertexCount << ", indices : " << header.indexCount << ", submeshes : " << header.submeshCount << ", LOD levels : " << header.lodCount << std::endl;
+    std::cout << "\t- Size : " << meshFile.getFileSize() / 1024 << " KB" << std::endl;
+    std::cout << "\t- Load time : " << std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() << " ms" << std::endl;
+}
+
+void Magnet::Engine::loadGLBFile(std::string filename)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    EngineBase::Assets::GLBFile glb{ filename };
+    auto parsed = std::chrono::high_resolution_clock::now();
+
+    glTFModel.device = &device;
+    glTFModel.copyQueue = device.graphicsQueue();
+
+    // Sizes and bounds first, every mesh is converted once and shared by the nodes instancing it. Offsets of each
+    // primitive are a prefix sum of the counts, so primitives are packed in parallel
+    struct PrimitiveJob {
+        const EngineBase::Assets::GLBFile::Primitive* primitive = nullptr;
+        size_t mesh = 0;
+        uint32_t firstVertex = 0;
+        uint32_t firstIndex = 0;
+        uint32_t vertexCount = 0;
+        uint32_t indexCount = 0;
+        glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+        glm::vec3 boundsMax{ std::numeric_limits<float>::lowest() };
+    };
+    const auto& meshes = glb.getMeshes();
+    const auto& accessors = glb.getAccessors();
+    std::vector<PrimitiveJob> jobs;
+    VkDeviceSize vertexCount = 0;
+    VkDeviceSize indexCount = 0;
+    for (size_t m = 0; m < meshes.size(); m++) {
+        for (const auto& primitive : meshes[m].primitives) {
+            PrimitiveJob& job = jobs.emplace_back();
+            job.primitive = &primitive;
+            job.mesh = m;
+            job.firstVertex = static_cast<uint32_t>(vertexCount);
+            job.firstIndex = static_cast<uint32_t>(indexCount);
+            int32_t positionAccessor = primitive.getAttribute("POSITION");
+            auto positions = glb.getAccessor<glm::vec3>(positionAccessor);
+            job.vertexCount = static_cast<uint32_t>(positions.size());
+            // Primitives without positions draw nothing
+            job.indexCount = job.vertexCount == 0 ? 0 : primitive.indices > -1 ? static_cast<uint32_t>(accessors[primitive.indices].count) : job.vertexCount;
+            if (job.indexCount > 0 && primitive.indices > -1) {
+                uint32_t componentType = accessors[primitive.indices].componentType;
+                if (componentType != TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT && componentType != TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT && componentType != TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE) {
+                    throw std::runtime_error("failed to load GLB file, unsupported index type!");
+                }
+            }
+            // The quantization box comes from the accessor bounds, positions are only read when they are missing
+            if (job.vertexCount > 0 && accessors[positionAccessor].hasBounds) {
+                job.boundsMin = accessors[positionAccessor].boundsMin;
+                job.boundsMax = accessors[positionAccessor].boundsMax;
+            }
+            else {
+                for (size_t v = 0; v < positions.size(); v++) {
+                    job.boundsMin = glm::min(job.boundsMin, positions[v]);
+                    job.boundsMax = glm::max(job.boundsMax, positions[v]);
+                }
+            }
+            vertexCount += job.vertexCount;
+            indexCount += job.indexCount;
+        }
+    }
+    if (vertexCount == 0 || indexCount == 0) {
+        throw std::runtime_error("failed to load GLB file, no geometry: " + filename);
+    }
+
+    // Primitives without material use a white one appended after the file's materials
+    int32_t defaultMaterial = static_cast<int32_t>(glb.getMaterials().size());
+    std::vector<VulkanglTFModel::Mesh> convertedMeshes(meshes.size());
+    for (const PrimitiveJob& job : jobs) {
+        VulkanglTFModel::Mesh& mesh = convertedMeshes[job.mesh];
+        mesh.boundsMin = glm::min(mesh.boundsMin, job.boundsMin);
+        mesh.boundsMax = glm::max(mesh.boundsMax, job.boundsMax);
+        int32_t material = job.primitive->material > -1 ? job.primitive->material : defaultMaterial;
+        mesh.primitives.push_back({ job.firstIndex, job.primitive->mode == 4 ? job.indexCount : 0, material });
+    }
+    for (auto& mesh : convertedMeshes) {
+        mesh.quantization = EngineBase::Assets::PackedVertex::getQuantization(mesh.boundsMin, mesh.boundsMax);
+    }
+
+    // Attributes are packed from the mapping straight into staging memory, indices copied or rebased into their pool.
+    // Ranges are split in chunks, the job of a chunk is the last one starting at or before it
+    auto findJob = [&jobs](uint32_t first, uint32_t PrimitiveJob::* offset) -> const PrimitiveJob& {
+        auto next = std::upper_bound(jobs.begin(), jobs.end(), first, [offset](uint32_t value, const PrimitiveJob& job) { return value < job.*offset; });
+        return *std::prev(next);
+    };
+    VulkanglTFModel::GeometrySource source;
+    source.vertexCount = vertexCount;
+    source.indexCount = indexCount;
+    for (const PrimitiveJob& job : jobs) {
+        source.vertexRanges.push_back({ job.firstVertex, job.vertexCount, convertedMeshes[job.mesh].quantization });
+    }
+    source.writeVertices = [&](const VulkanglTFModel::VertexRange& range, VulkanglTFModel::PackedVertex* packed, uint32_t* colors) {
+        const PrimitiveJob& job = findJob(range.firstVertex, &PrimitiveJob::firstVertex);
+        auto positions = glb.getAccessor<glm::vec3>(job.primitive->getAttribute("POSITION"));
+        auto normals = glb.getAccessor<glm::vec3>(job.primitive->getAttribute("NORMAL"));
+        auto texCoords = glb.getAccessor<glm::vec2>(job.primitive->getAttribute("TEXCOORD_0"));
+        bool hasNormals = normals.size() == positions.size();
+        bool hasTexCoords = texCoords.size() == positions.size();
+        const glm::vec3 zero{ 0.0f };
+        const glm::vec2 zeroUV{ 0.0f };
+        uint32_t first = range.firstVertex - job.firstVertex;
+        for (uint32_t v = first; v < first + range.vertexCount; v++) {
+            *packed++ = VulkanglTFModel::PackedVertex::pack(positions[v], hasNormals ? normals[v] : zero, hasTexCoords ? texCoords[v] : zeroUV, range.quantization);
+        }
+        std::fill_n(colors, range.vertexCount, VulkanglTFModel::PackedVertex::packColor(glm::vec3(1.0f)));
+    };
+    source.getTriangles = [&](uint32_t firstIndex, uint32_t primitiveIndices) {
+        const PrimitiveJob& job = findJob(firstIndex, &PrimitiveJob::firstIndex);
+        auto positions = glb.getAccessor<glm::vec3>(job.primitive->getAttribute("POSITION"));
+        EngineBase::Assets::TriangleList triangles{};
+        triangles.indexCount = primitiveIndices;
+        triangles.baseVertex = job.firstVertex;
+        triangles.positions = reinterpret_cast<const unsigned char*>(&positions[0]);
+        triangles.positionStride = positions.getStride();
+        // Index buffer views are never interleaved, non indexed primitives are sequential
+        int32_t indices = job.primitive->indices;
+        if (indices > -1) {
+            switch (accessors[indices].componentType) {
+            case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT:
+                triangles.indices = glb.getAccessor<uint32_t>(indices).contiguous().data();
+                triangles.indexSize = sizeof(uint32_t);
+                break;
+            case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT:
+                triangles.indices = glb.getAccessor<uint16_t>(indices).contiguous().data();
+                triangles.indexSize = sizeof(uint16_t);
+                break;
+            default:
+                triangles.indices = glb.getAccessor<uint8_t>(indices).contiguous().data();
+                triangles.indexSize = sizeof(uint8_t);
+                break;
+            }
+        }
+        return triangles;
+    };
+
+    // Same node hierarchy as loadNode
+    std::function<void(uint32_t, VulkanglTFModel::Node*)> createNode = [&](uint32_t index, VulkanglTFModel::Node* parent) {
+        const auto& input = glb.getNodes().at(index);
+        auto* node = new VulkanglTFModel::Node{};
+        node->parent = parent;
+        node->matrix = input.matrix;
+        node->isStatic = (parent == nullptr || parent->isStatic) && !input.animated;
+        if (input.mesh > -1) {
+            node->mesh = convertedMeshes.at(input.mesh);
+        }
+        if (parent) {
+            parent->children.push_back(node);
+        }
+        else {
+            glTFModel.nodes.push_back(node);
+        }
+        for (uint32_t child : input.children) {
+            createNode(child, node);
+        }
+    };
+    for (uint32_t root : glb.getSceneNodes()) {
+        createNode(root, nullptr);
+    }
+    auto converted = std::chrono::high_resolution_clock::now();
+
+    // Images are decoded from the mapped BIN chunk, a white image serves untextured materials
+    std::vector<std::span<const unsigned char>> encodedImages;
+    for (size_t i = 0; i < glb.getImages().size(); i++) {
+        encodedImages.push_back(glb.getImageData(i));
+    }
+    uint32_t whiteImage = static_cast<uint32_t>(encodedImages.size());
+    encodedImages.push_back({});
+    glTFModel.loadEncodedImages(encodedImages);
+
+    for (int32_t image : glb.getTextureImages()) {
+        glTFModel.textures.push_back({ image > -1 ? image : static_cast<int32_t>(whiteImage) });
+    }
+    uint32_t whiteTexture = static_cast<uint32_t>(glTFModel.textures.size());
+    glTFModel.textures.push_back({ static_cast<int32_t>(whiteImage) });
+    for (const auto& input : glb.getMaterials()) {
+        uint32_t texture = input.baseColorTexture > -1 ? static_cast<uint32_t>(input.baseColorTexture) : whiteTexture;
+        glTFModel.materials.push_back({ input.baseColorFactor, texture });
+    }
+    glTFModel.materials.push_back({ glm::vec4(1.0f), whiteTexture });
+    auto imagesLoaded = std::chrono::high_resolution_clock::now();
+
+    glTFModel.uploadGeometry(source);
+    auto uploaded = std::chrono::high_resolution_clock::now();
+
+    auto ms = [](auto from, auto to) { return std::chrono::duration<double, std::milli>(to - from).count(); };
+    std::cout << "\nGLB file : " << filename << std::endl;
+    std::cout << "------------------------------" << std::endl;
+    std::cout << "\t- Mapped : " << glb.getFileSize() / 1024 << " KB, JSON chunk : " << glb.getJSONSize() / 1024 << " KB" << std::endl;
+    std::cout << "\t- Vertices : " << vertexCount << " (" << vertexCount * sizeof(VulkanglTFModel::PackedVertex) / 1024 << " KB packed), indices : " << indexCount << std::endl;
+    std::cout << "\t- Load time : " << ms(start, uploaded) << " ms (parse " << ms(start, parsed) << ", convert " << ms(parsed, converted)
+        << ", images " << ms(converted, imagesLoaded) << ", pack and upload " << ms(imagesLoaded, uploaded) << ")" << std::endl;
+    std::cout << "\t- Peak resident memory : " << EngineBase::getPeakResidentBytes() / (1024 * 1024) << " MB" << std::endl;
+}
+
+void Magnet::Engine::createPipelineLayout()
+{
+    std::array<VkDescriptorSetLayout, 4> setLayouts = {
+        descriptorSetLayouts.matrices,
+        descriptorSetLayouts.textures,
+        lighting->getDescriptorSetLayout(),
+        shadows->getDescriptorSetLayout() };
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline layout!");
+    }
+}
+
+void Magnet::Engine::createShadows()
+{
+    // Casters only need positions, the shadow pipeline reads location 0 of the model's packed vertex binding
+    auto attributes = VulkanglTFModel::PackedVertex::getAttributeDescriptions();
+    shadows = std::make_unique<EngineBase::Rendering::CascadedShadowMaps>(
+        device,
+        SHADOW_VERT_SHADER,
+        SHADOW_FRAG_SHADER,
+        std::vector<VkVertexInputBindingDescription>{ glTFModel.getBindingDescriptions()[0] },
+        std::vector<VkVertexInputAttributeDescription>{ attributes[0] },
+        VKBase::SwapChain::MAX_FRAMES_IN_FLIGHT,
+        EngineBase::Rendering::CascadedShadowMaps::Settings{});
+    updateShadowCasters();
+}
+
+void Magnet::Engine::updateShadowCasters()
+{
+    shadowCasterNodes.clear();
+    glTFModel.collectMeshNodes(shadowCasterNodes);
+
+    shadowCasters.clear();
+    for (auto* node : shadowCasterNodes) {
+        // World space box around the transformed local bounds
+        glm::mat4 worldMatrix = VulkanglTFModel::getWorldMatrix(node);
+        EngineBase::Rendering::ShadowCaster caster{ glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest()), node->isStatic };
+        for (uint32_t i = 0; i < 8; i++) {
+            glm::vec3 corner{
+                (i & 1) ? node->mesh.boundsMax.x : node->mesh.boundsMin.x,
+                (i & 2) ? node->mesh.boundsMax.y : node->mesh.boundsMin.y,
+                (i & 4) ? node->mesh.boundsMax.z : node->mesh.boundsMin.z };
+            glm::vec3 world = glm::vec3(worldMatrix * glm::vec4(corner, 1.0f));
+            caster.boundsMin = glm::min(caster.boundsMin, world);
+            caster.boundsMax = glm::max(caster.boundsMax, world);
+        }
+        shadowCasters.push_back(caster);
+    }
+    shadows->markStaticDirty();
+}
+
+void Magnet::Engine::updateTextureStreaming()
+{
+    glm::mat4 viewProjection = camera.matrices.perspective * camera.matrices.view;
+    VkExtent2D extent = swapchain.getSwapChainExtent();
+
+    // Mesh nodes are culled against the view with the same world bounds as the shadow casters
+    for (size_t i = 0; i < shadowCasterNodes.size(); i++) {
+        const auto& caster = shadowCasters[i];
+        glm::vec2 ndcMin{ std::numeric_limits<float>::max() };
+        glm::vec2 ndcMax{ std::numeric_limits<float>::lowest() };
+        bool crossesNearPlane = false;
+        for (uint32_t corner = 0; corner < 8; corner++) {
+            glm::vec4 clip = viewProjection * glm::vec4(
+                (corner & 1) ? caster.boundsMax.x : caster.boundsMin.x,
+                (corner & 2) ? caster.boundsMax.y : caster.boundsMin.y,
+                (corner & 4) ? caster.boundsMax.z : caster.boundsMin.z,
+                1.0f);
+            if (clip.w <= 0.0f) {
+                crossesNearPlane = true;
+                break;
+            }
+            glm::vec2 ndc = glm::vec2(clip) / clip.w;
+            ndcMin = glm::min(ndcMin, ndc);
+            ndcMax = glm::max(ndcMax, ndc);
+        }
+
+        // Bounds around the camera cover the whole screen
+        float screenSize = static_cast<float>(std::max(extent.width, extent.height));
+        if (!crossesNearPlane) {
+            if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f) {
+                continue;
+            }
+            screenSize = std::max((ndcMax.x - ndcMin.x) * 0.5f * extent.width, (ndcMax.y - ndcMin.y) * 0.5f * extent.height);
+        }
+
+        for (const auto& primitive : shadowCasterNodes[i]->mesh.primitives) {
+            if (primitive.indexCount == 0) {
+                continue;
+            }
+            const auto& image = glTFModel.images[glTFModel.textures[glTFModel.materials[primitive.materialIndex].baseColorTextureIndex].imageIndex];
+            if (image.streamHandle != EngineBase::Rendering::TextureStreamer::INVALID_HANDLE) {
+                // Assumes the texture spans the mesh once, tiled textures are undersampled
+                uint32_t textureSize = std::max(image.texture.width, image.texture.height);
+                textureStreamer->request(image.streamHandle, EngineBase::Rendering::TextureStreamer::mipForScreenSize(textureSize, screenSize));
+            }
+        }
+    }
+
+    textureStreamer->update(currentFrameIndex);
+    for (auto& image : glTFModel.images) {
+        if (image.streamHandle != EngineBase::Rendering::TextureStreamer::INVALID_HANDLE) {
+            image.descriptorSet = textureStreamer->getDescriptorSet(image.streamHandle, currentFrameIndex);
+        }
+    }
+}
+
+void Magnet::Engine::updateLods()
+{
+    glm::vec3 cameraPosition = glm::vec3(glm::inverse(camera.matrices.view)[3]);
+    float screenHeight = static_cast<float>(swapchain.getSwapChainExtent().height);
+
+    // Distance to the world bounds of the shadow casters, the error scales with the node's largest axis scale
+    std::vector<float> errors;
+    for (size_t i = 0; i < shadowCasterNodes.size(); i++) {
+        auto* node = shadowCasterNodes[i];
+        if (node->mesh.lods.empty()) {
+            continue;
+        }
+        const auto& caster = shadowCasters[i];
+        float distance = glm::length(cameraPosition - glm::clamp(cameraPosition, caster.boundsMin, caster.boundsMax));
+        glm::mat4 worldMatrix = VulkanglTFModel::getWorldMatrix(node);
+        float scale = std::max({ glm::length(glm::vec3(worldMatrix[0])), glm::length(glm::vec3(worldMatrix[1])), glm::length(glm::vec3(worldMatrix[2])) });
+
+        errors.assign(1, 0.0f);
+        for (const auto& lod : node->mesh.lods) {
+            errors.push_back(lod.error * scale);
+        }
+        node->lod = lodSelector.select(errors.data(), node->mesh.getLevelCount(), node->lod,
+            EngineBase::Rendering::LodSelector::getPixelsPerUnit(camera.getFov(), screenHeight, distance));
+    }
+}
+
+void Magnet::Engine::createVisibilityBuffer()
+{
+    // Rendered through the frame graph, which only exists with dynamic rendering,
+    // and the visibility pass reads gl_PrimitiveID which needs the geometry shader feature
+    if (!swapchain.usesDynamicRendering() || !device.features.geometryShader) {
+        return;
+    }
+
+    auto attributes = VulkanglTFModel::PackedVertex::getAttributeDescriptions();
+    visibility = std::make_unique<EngineBase::Rendering::VisibilityBuffer>(
+        device,
+        EngineBase::Rendering::VisibilityBuffer::Shaders{
+            VISIBILITY_VERT_SHADER, VISIBILITY_FRAG_SHADER, VISIBILITY_RESOLVE_VERT_SHADER, VISIBILITY_RESOLVE_FRAG_SHADER },
+        std::vector<VkVertexInputBindingDescription>{ glTFModel.getBindingDescriptions()[0] },
+        std::vector<VkVertexInputAttributeDescription>{ attributes[0] },
+        std::vector<VkDescriptorSetLayout>{
+            descriptorSetLayouts.matrices,
+            descriptorSetLayouts.textures,
+            lighting->getDescriptorSetLayout(),
+            shadows->getDescriptorSetLayout() },
+        swapchain.getSwapChainImageFormat(),
+        swapchain.getDepthFormat(),
+        VKBase::SwapChain::MAX_FRAMES_IN_FLIGHT);
+    setVisibilityGeometry();
+}
+
+void Magnet::Engine::setVisibilityGeometry()
+{
+    // One draw per primitive, in the same order as the forward path
+    std::vector<EngineBase::Rendering::VisibilityBuffer::DrawInput> draws;
+    for (auto* node : shadowCasterNodes) {
+        glm::mat4 worldMatrix = VulkanglTFModel::getWorldMatrix(node) * VulkanglTFModel::PackedVertex::getDequantizationMatrix(node->mesh.quantization);
+        for (const auto& primitive : node->mesh.primitives) {
+            if (primitive.indexCount > 0) {
+                draws.push_back({ worldMatrix, glTFModel.getFirstIndex(primitive), primitive.indexCount, glTFModel.getVertexOffset(primitive), primitive.indexType });
+            }
+        }
+    }
+    // Both index pools are addressed from the start of the arena's index buffer
+    visibility->setGeometry({ geometryArena->getVertexBuffer(), geometryArena->getColorBuffer(), true, geometryArena->getIndexBuffer(), 0 }, draws);
+}
+
+void Magnet::Engine::updateGeometryBindings()
+{
+    if (visibility) {
+        setVisibilityGeometry();
+    }
+    if (meshlets) {
+        meshlets->setVertexBuffers({ geometryArena->getVertexBuffer(), geometryArena->getColorBuffer(), true });
+    }
+}
+
+void Magnet::Engine::createMeshletRenderer()
+{
+    meshlets = std::make_unique<EngineBase::Rendering::MeshletRenderer>(
+        device,
+        EngineBase::Rendering::MeshletRenderer::Shaders{
+            MESHLET_TASK_SHADER, MESHLET_MESH_SHADER, MESHLET_FRAG_SHADER, MESHLET_CULL_SHADER },
+        std::vector<VkDescriptorSetLayout>{
+            descriptorSetLayouts.matrices,
+            descriptorSetLayouts.textures,
+            lighting->getDescriptorSetLayout(),
+            shadows->getDescriptorSetLayout() },
+        swapchain.getSwapChainImageFormat(),
+        swapchain.getDepthFormat(),
+        VKBase::SwapChain::MAX_FRAMES_IN_FLIGHT,
+        EngineBase::Rendering::MeshletRenderer::Settings{});
+    meshlets->setGeometry({ geometryArena->getVertexBuffer(), geometryArena->getColorBuffer(), true }, glTFModel.meshlets);
+}
+
+void Magnet::Engine::updateMeshlets()
+{
+    // One draw per primitive, in the same order as the forward path
+    std::vector<EngineBase::Rendering::MeshletRenderer::DrawInput> draws;
+    for (auto* node : shadowCasterNodes) {
+        glm::mat4 modelMatrix = VulkanglTFModel::getWorldMatrix(node) * VulkanglTFModel::PackedVertex::getDequantizationMatrix(node->mesh.quantization);
+        for (const auto& primitive : node->mesh.getPrimitives(node->lod)) {
+            if (primitive.meshletCount > 0) {
+                draws.push_back({ modelMatrix, primitive.firstMeshlet, primitive.meshletCount, glTFModel.getFirstVertex() });
+            }
+        }
+    }
+    glm::vec3 cameraPosition = glm::vec3(glm::inverse(camera.matrices.view)[3]);
+    meshlets->update(draws, camera.matrices.perspective * camera.matrices.view, cameraPosition, ambientLight, currentFrameIndex);
+}
+
+void Magnet::Engine::updateVertexPulling()
+{
+    using VertexPuller = EngineBase::Rendering::VertexPuller;
+    // Addresses are fetched every frame, a compaction of the arena needs no rebinding
+    std::vector<VertexPuller::DrawInput> draws;
+    for (auto* node : shadowCasterNodes) {
+        glm::mat4 modelMatrix = VulkanglTFModel::getWorldMatrix(node) * VulkanglTFModel::PackedVertex::getDequantizationMatrix(node->mesh.quantization);
+        for (const auto& primitive : node->mesh.getPrimitives(node->lod)) {
+            // Not uploaded, no pool offset or index type to draw it with
+            if (primitive.indexCount == 0) {
+                continue;
+            }
+            draws.push_back({
+                modelMatrix,
+                geometryArena->getVertexAddress(),
+                geometryArena->getColorAddress(),
+                VertexPuller::VertexFormat::Packed,
+                true,
+                glTFModel.getFirstIndex(primitive),
+                primitive.indexCount,
+                glTFModel.getVertexOffset(primitive),
+                primitive.indexType });
+        }
+    }
+    vertexPuller->update(draws, currentFrameIndex);
+}
+
+void Magnet::Engine::setRenderBackend(RenderBackend backend)
+{
+    if (backend == renderBackend) {
+        return;
+    }
+
+    renderBackend = backend;
+    if (pipelineLayout == VK_NULL_HANDLE) {
+        return;
+    }
+
+    vkDeviceWaitIdle(device.device());
+    pipelines.solid.reset();
+    pipelines.wireframe.reset();
+    pipelines.pulled.reset();
+    shaderObject.reset();
+    pulledShaderObject.reset();
+    preparePipelines();
+}
+
+void Magnet::Engine::setRenderGraphDump(bool dump)
+{
+    if (dump == renderGraphDump) {
+        return;
+    }
+
+    renderGraphDump = dump;
+    if (dump && renderGraph) {
+        vkDeviceWaitIdle(device.device());
+        buildRenderGraph();
+    }
+}
+
+void Magnet::Engine::setRenderPath(RenderPath path)
+{
+    if (path == RenderPath::VisibilityBuffer && !visibility) {
+        std::cout << "Visibility buffer unavailable on this device, falling back to forward" << std::endl;
+        path = RenderPath::Forward;
+    }
+    if (path == RenderPath::Meshlets && !meshlets) {
+        std::cout << "Meshlet renderer unavailable, falling back to forward" << std::endl;
+        path = RenderPath::Forward;
+    }
+    if (path == RenderPath::VertexPulling && !vertexPuller) {
+        std::cout << "Vertex pulling unavailable without buffer device address, falling back to forward" << std::endl;
+        path = RenderPath::Forward;
+    }
+    if (path == renderPath) {
+        return;
+    }
+
+    renderPath = path;
+    if (renderGraph) {
+        vkDeviceWaitIdle(device.device());
+        buildRenderGraph();
+    }
+}
+
+void Magnet::Engine::configurePipeline(VKBase::PipelineConfigInfo& config)
+{
+    VKBase::Pipeline::defaultPipelineConfigInfo(config);
+    if (swapchain.usesDynamicRendering()) {
+        config.renderPass = nullptr;
+        config.colorAttachmentFormats = { swapchain.getSwapChainImageFormat() };
+        config.depthAttachmentFormat = swapchain.getDepthFormat();
+    }
+    else {
+        config.renderPass = swapchain.getRenderPass();
+    }
+    config.pipelineLayout = pipelineLayout;
+    // Cull mode, depth state, topology and polygon mode move to the command buffer when supported
+    VKBase::RasterState::enableDynamicStates(config, device);
+}
+
+void Magnet::Engine::preparePipelines()
+{
+    configurePipeline(pipelineConfig);
+    pipelineConfig.bindingDescriptions = glTFModel.getBindingDescriptions();
+    pipelineConfig.attributeDescriptions = VulkanglTFModel::PackedVertex::getAttributeDescriptions();
+    // The pulled vertex shader fetches its vertices itself
+    configurePipeline(pulledPipelineConfig);
+
+    if (renderBackend == RenderBackend::ShaderObjects && (!device.capabilities().shaderObject || !swapchain.usesDynamicRendering())) {
+        std::cout << "VK_EXT_shader_object or dynamic rendering unavailable, falling back to pipelines" << std::endl;
+        renderBackend = RenderBackend::Pipelines;
+    }
+
+    if (renderBackend == RenderBackend::ShaderObjects) {
+        EngineBase::ScopedTimer timer{ creationTimes };
+        shaderObject = std::make_unique<VKBase::ShaderObject>(
+            device,
+            VERT_SHADER,
+            FRAG_SHADER,
+            std::vector<VkDescriptorSetLayout>{ descriptorSetLayouts.matrices, descriptorSetLayouts.textures, lighting->getDescriptorSetLayout(), shadows->getDescriptorSetLayout() },
+            std::vector<VkPushConstantRange>{ pushConstantRange });
+        if (vertexPuller) {
+            pulledShaderObject = std::make_unique<VKBase::ShaderObject>(
+                device,
+                PULLED_VERT_SHADER,
+                FRAG_SHADER,
+                std::vector<VkDescriptorSetLayout>{ descriptorSetLayouts.matrices, descriptorSetLayouts.textures, lighting->getDescriptorSetLayout(), shadows->getDescriptorSetLayout() },
+                std::vector<VkPushConstantRange>{ pushConstantRange });
+        }
+        return;
+    }
+
+    auto& registry = renderer.getPipelineRegistry();
+    EngineBase::ScopedTimer timer{ creationTimes };
+    boundPipeline.pipeline.reset();
+
+    rasterState.applyToConfig(pipelineConfig);
+    pipelines.solid = registry.getPipeline(VERT_SHADER, FRAG_SHADER, pipelineConfig);
+
+    // Wire frame rendering pipeline, the registry hands back the solid one when polygon mode is dynamic
+    if (device.features.fillModeNonSolid) {
+        VKBase::RasterState wireframeState = rasterState;
+        wireframeState.polygonMode = VK_POLYGON_MODE_LINE;
+        wireframeState.applyToConfig(pipelineConfig);
+        pipelines.wireframe = registry.getPipeline(VERT_SHADER, FRAG_SHADER, pipelineConfig);
+    }
+
+    if (vertexPuller) {
+        rasterState.applyToConfig(pulledPipelineConfig);
+        pipelines.pulled = registry.getPipeline(PULLED_VERT_SHADER, FRAG_SHADER, pulledPipelineConfig);
+    }
+}
+
+void Magnet::Engine::bindPipeline(VkCommandBuffer commandBuffer)
+{
+    EngineBase::ScopedTimer timer{ bindTimes };
+
+    VKBase::RasterState state = rasterState;
+    state.polygonMode = wireframe && device.features.fillModeNonSolid ? VK_POLYGON_MODE_LINE : VK_POLYGON_MODE_FILL;
+
+    bool pulled = renderPath == RenderPath::VertexPulling;
+    VKBase::PipelineConfigInfo& config = pulled ? pulledPipelineConfig : pipelineConfig;
+    if (renderBackend == RenderBackend::ShaderObjects) {
+        state.applyToConfig(config);
+        (pulled ? pulledShaderObject : shaderObject)->bind(commandBuffer, config, swapchain.getSwapChainExtent());
+        return;
+    }
+
+    // Without extended dynamic state every state combination is its own pipeline permutation,
+    // compiled on first use and shared through the registry. The registry is only asked again when the state changes
+    if (!boundPipeline.pipeline || boundPipeline.pulled != pulled || boundPipeline.state != state) {
+        state.applyToConfig(config);
+        boundPipeline.pipeline = renderer.getPipelineRegistry().getPipeline(pulled ? PULLED_VERT_SHADER : VERT_SHADER, FRAG_SHADER, config);
+        boundPipeline.state = state;
+        boundPipeline.pulled = pulled;
+    }
+    boundPipeline.pipeline->bind(commandBuffer);
+    state.record(device, commandBuffer);
+}
+
+void Magnet::Engine::buildRenderGraph()
+{
+    using namespace EngineBase::Rendering;
+    renderGraph = std::make_unique<RenderGraph>(device);
+
+    // Every layer is either cleared or copied from the static caches each frame, the caches persist
+    RGImageDesc shadowDesc{ shadows->getDepthFormat(), shadows->getExtent() };
+    frameResources.shadowMaps = renderGraph->importImage(
+        "Shadow Maps",
+        shadows->getShadowImage(),
+        shadows->getShadowView(),
+        shadowDesc,
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        RGAccess::SampledRead);
+    frameResources.shadowCache = renderGraph->importImage(
+        "Shadow Cache",
+        shadows->getStaticImage(),
+        VK_NULL_HANDLE,
+        shadowDesc,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        RGAccess::TransferRead);
+
+    auto importLightingBuffer = [this](const std::string& name, VKBase::Buffer& buffer) {
+        return renderGraph->importBuffer(name, buffer.getBuffer(), RGBufferDesc{ buffer.getBufferSize(), buffer.getUsageFlags() });
+    };
+    frameResources.lights = importLightingBuffer("Lights", lighting->getLightBuffer());
+    frameResources.lightGrid = importLightingBuffer("Light Grid", lighting->getLightGridBuffer());
+    frameResources.lightIndices = importLightingBuffer("Light Indices", lighting->getLightIndexBuffer());
+
+    // Bins the lights into the froxel grid read by the shading passes
+    renderGraph->addPass("Light Culling",
+        [this](RenderGraph::PassBuilder& builder) {
+            builder.read(frameResources.lights, RGAccess::StorageRead);
+            builder.write(frameResources.lightGrid, RGAccess::StorageWrite);
+            builder.write(frameResources.lightIndices, RGAccess::StorageWrite);
+        },
+        [this](VkCommandBuffer commandBuffer, const RenderGraph& /*graph*/) {
+            lighting->cull(commandBuffer, currentFrameIndex);
+        });
+
+    // Vertex and index bindings are command buffer state, shared by every cascade of a pass
+    auto drawCaster = [this](VkCommandBuffer commandBuffer, uint32_t casterIndex) {
+        glTFModel.drawMesh(commandBuffer, shadows->getPipelineLayout(), shadowCasterNodes[casterIndex], false);
+    };
+
+    // Only records draws when a cache was invalidated, the transitions keep the cached contents otherwise
+    renderGraph->addPass("Shadow Cache",
+        [this](RenderGraph::PassBuilder& builder) {
+            builder.write(frameResources.shadowCache, RGAccess::DepthAttachmentWrite);
+        },
+        [this, drawCaster](VkCommandBuffer commandBuffer, const RenderGraph& /*graph*/) {
+            glTFModel.bindBuffers(commandBuffer);
+            shadows->renderStaticCaches(commandBuffer, shadowCasters, drawCaster);
+        });
+
+    renderGraph->addPass("Shadow Copy",
+        [this](RenderGraph::PassBuilder& builder) {
+            builder.read(frameResources.shadowCache, RGAccess::TransferRead);
+            builder.write(frameResources.shadowMaps, RGAccess::TransferWrite);
+        },
+        [this](VkCommandBuffer commandBuffer, const RenderGraph& /*graph*/) {
+            shadows->copyStaticCaches(commandBuffer);
+        });
+
+    renderGraph->addPass("Shadows",
+        [this](RenderGraph::PassBuilder& builder) {
+            builder.write(frameResources.shadowMaps, RGAccess::DepthAttachmentWrite);
+        },
+        [this, drawCaster](VkCommandBuffer commandBuffer, const RenderGraph& /*graph*/) {
+            glTFModel.bindBuffers(commandBuffer);
+            shadows->renderCascades(commandBuffer, shadowCasters, drawCaster);
+        });
+
+    // Shading passes read the lights through their froxel binning
+    auto readLighting = [this](RenderGraph::PassBuilder& builder) {
+        builder.read(frameResources.lights, RGAccess::StorageRead);
+        builder.read(frameResources.lightGrid, RGAccess::StorageRead);
+        builder.read(frameResources.lightIndices, RGAccess::StorageRead);
+    };
+
+    VkExtent2D extent = swapchain.getSwapChainExtent();
+    frameResources.backbuffer = {};
+    if (swapchain.usesDynamicRendering()) {
+        frameResources.backbuffer = renderGraph->importImage(
+            "Backbuffer",
+            swapchain.getImage(0),
+            swapchain.getImageView(0),
+            RGImageDesc{ swapchain.getSwapChainImageFormat(), extent });
+        frameResources.depth = renderGraph->createImage("Depth", RGImageDesc{ swapchain.getDepthFormat(), extent });
+    }
+
+    if (!swapchain.usesDynamicRendering()) {
+        // The swapchain render pass transitions its own attachments, the graph only orders the scene after the shadows
+        renderGraph->addPass("Scene",
+            [this, readLighting](RenderGraph::PassBuilder& builder) {
+                builder.read(frameResources.shadowMaps, RGAccess::SampledRead);
+                readLighting(builder);
+                builder.setSideEffect();
+            },
+            [this](VkCommandBuffer commandBuffer, const RenderGraph& /*graph*/) {
+                std::array<VkClearValue, 2> clearValues{};
+                clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+                clearValues[1].depthStencil = { 1.0f, 0 };
+
+                VkRenderPassBeginInfo renderPassInfo{};
+                renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+                renderPassInfo.renderPass = swapchain.getRenderPass();
+                renderPassInfo.framebuffer = swapchain.getFrameBuffer(currentImageIndex);
+                renderPassInfo.renderArea = { { 0, 0 }, swapchain.getSwapChainExtent() };
+                renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+                renderPassInfo.pClearValues = clearValues.data();
+
+                vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+                drawScene(commandBuffer, swapchain.getSwapChainExtent());
+                vkCmdEndRenderPass(commandBuffer);
+            });
+    }
+    else if (renderPath == RenderPath::VisibilityBuffer) {
+        frameResources.visibility = renderGraph->createImage("Visibility", RGImageDesc{ EngineBase::Rendering::VisibilityBuffer::FORMAT, extent });
+
+        // Positions only, every pixel ends up with the (draw, triangle) that won the depth test
+        renderGraph->addPass("Visibility",
+            [this](RenderGraph::PassBuilder& builder) {
+                builder.write(frameResources.visibility, RGAccess::ColorAttachmentWrite);
+                builder.write(frameResources.depth, RGAccess::DepthAttachmentWrite);
+            },
+            [this](VkCommandBuffer commandBuffer, const RenderGraph& graph) {
+                VkExtent2D extent = graph.getExtent(frameResources.visibility);
+                VkClearColorValue empty{};
+                empty.uint32[0] = EngineBase::Rendering::VisibilityBuffer::EMPTY;
+
+                VKBase::RenderingInfo renderingInfo{ extent };
+                renderingInfo
+                    .addColorAttachment(graph.getImageView(frameResources.visibility), VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE, empty)
+                    .setDepthAttachment(graph.getImageView(frameResources.depth))
+                    .begin(device, commandBuffer);
+
+                visibility->drawVisibility(commandBuffer, extent);
+                renderingInfo.end(device, commandBuffer);
+            });
+
+        // Shades each pixel once from the triangle it stores
+        renderGraph->addPass("Resolve",
+            [this, readLighting](RenderGraph::PassBuilder& builder) {
+                builder.read(frameResources.visibility, RGAccess::SampledRead);
+                builder.read(frameResources.shadowMaps, RGAccess::SampledRead);
+                readLighting(builder);
+                builder.write(frameResources.backbuffer, RGAccess::ColorAttachmentWrite);
+            },
+            [this](VkCommandBuffer commandBuffer, const RenderGraph& graph) {
+                VkExtent2D extent = graph.getExtent(frameResources.backbuffer);
+                VKBase::RenderingInfo renderingInfo{ extent };
+                renderingInfo
+                    .addColorAttachment(graph.getImageView(frameResources.backbuffer))
+                    .begin(device, commandBuffer);
+
+                VkPipelineLayout layout = visibility->getResolvePipelineLayout();
+                lighting->bind(commandBuffer, layout, 2, currentFrameIndex);
+                shadows->bind(commandBuffer, layout, 3, currentFrameIndex);
+                visibility->resolve(commandBuffer, extent, currentFrameIndex);
+                renderingInfo.end(device, commandBuffer);
+            });
+    }
+    else {
+        renderGraph->addPass("Scene",
+            [this, readLighting](RenderGraph::PassBuilder& builder) {
+                builder.read(frameResources.shadowMaps, RGAccess::SampledRead);
+                readLighting(builder);
+                builder.write(frameResources.backbuffer, RGAccess::ColorAttachmentWrite);
+                builder.write(frameResources.depth, RGAccess::DepthAttachmentWrite);
+            },
+            [this](VkCommandBuffer commandBuffer, const RenderGraph& graph) {
+                VkExtent2D extent = graph.getExtent(frameResources.backbuffer);
+                VKBase::RenderingInfo renderingInfo{ extent };
+                renderingInfo
+                    .addColorAttachment(graph.getImageView(frameResources.backbuffer))
+                    .setDepthAttachment(graph.getImageView(frameResources.depth))
+                    .begin(device, commandBuffer);
+
+                drawScene(commandBuffer, extent);
+                renderingInfo.end(device, commandBuffer);
+            });
+    }
+
+    renderGraph->compile();
+    if (renderGraphDump) {
+        renderGraph->dump(std::cout);
+    }
+    if (renderPath == RenderPath::VisibilityBuffer) {
+        visibility->setVisibilityImage(renderGraph->getImageView(frameResources.visibility));
+    }
+}
+
+void Magnet::Engine::recordFrame(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+{
+    currentImageIndex = imageIndex;
+    if (frameResources.backbuffer.valid()) {
+        renderGraph->setImportedImage(frameResources.backbuffer, swapchain.getImage(imageIndex), swapchain.getImageView(imageIndex));
+    }
+    renderGraph->execute(commandBuffer);
+}
+
+void Magnet::Engine::drawScene(VkCommandBuffer commandBuffer, VkExtent2D extent)
+{
+    using MeshletMode = EngineBase::Rendering::MeshletRenderer::Mode;
+    if (renderPath == RenderPath::Meshlets && meshlets->getMode() == MeshletMode::MeshShader) {
+        VkPipelineLayout layout = meshlets->getPipelineLayout();
+        lighting->bind(commandBuffer, layout, 2, currentFrameIndex);
+        shadows->bind(commandBuffer, layout, 3, currentFrameIndex);
+        meshlets->draw(commandBuffer, extent, currentFrameIndex);
+        return;
+    }
+
+    bindPipeline(commandBuffer);
+    if (renderBackend == RenderBackend::Pipelines) {
+        VkViewport viewport{ 0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f };
+        VkRect2D scissor{ { 0, 0 }, extent };
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    }
+    lighting->bind(commandBuffer, pipelineLayout, 2, currentFrameIndex);
+    shadows->bind(commandBuffer, pipelineLayout, 3, currentFrameIndex);
+    if (renderPath == RenderPath::Meshlets) {
+        // Forward shading of the meshlet triangles, culled by the compute pass
+        glTFModel.bindBuffers(commandBuffer);
+        meshlets->drawIndirect(commandBuffer, pipelineLayout, currentFrameIndex);
+        glTFModel.boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+        return;
+    }
+    if (renderPath == RenderPath::VertexPulling) {
+        // No vertex buffers, every primitive in one indirect draw per index type
+        vertexPuller->draw(commandBuffer, pipelineLayout, geometryArena->getIndexBuffer(), currentFrameIndex);
+        glTFModel.boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+        return;
+    }
+    glTFModel.draw(commandBuffer, pipelineLayout);
 }
 
 void Magnet::Engine::loadAssets()
@@ -5,9 +5,30 @@
 #include "Engine/Object.h"
 #include "VK/Swapchain.h"
 #include "Renderer.h"
+#include "VK/DynamicState.h"
+#include "VK/ShaderObject.h"
+#include "Engine/Profiling.h"
 #include "Engine/Rendering/Texture.h"
+#include "Engine/Rendering/TextureStreamer.h"
+#include "Engine/Rendering/KTX2Loader.h"
+#include "Engine/Rendering/RenderGraph.h"
+#include "Engine/Rendering/ClusteredLighting.h"
+#include "Engine/Rendering/ShadowMaps.h"
+#include "Engine/Rendering/VisibilityBuffer.h"
+#include "Engine/Rendering/LodSelector.h"
+#include "Engine/Rendering/MeshletRenderer.h"
+#include "Engine/Rendering/GeometryArena.h"
+#include "Engine/Rendering/VertexPuller.h"
+#include "Engine/Assets/MeshFile.h"
+#include "Engine/Assets/GLBFile.h"
+#include "Engine/Assets/PackedVertex.h"
+#include "Engine/Assets/MeshletBuilder.h"
+#include "Engine/Assets/Kernels.h"
+#include "Engine/Parallel.h"
+#include "VK/GpuTimer.h"
 
 #include <tinygltf/tiny_gltf.h>
+#include <stb/stb_image.h>
 
 namespace Magnet {
 
@@ -17,27 +38,24 @@ namespace Magnet {
 		// The class requires some Vulkan objects so it can create it's own resources
 		Magnet::VKBase::Device* device;
 		VkQueue copyQueue;
-
-		// The vertex layout for the samples' model
-		struct Vertex {
-			glm::vec3 pos;
-			glm::vec3 normal;
-			glm::vec2 uv;
-			glm::vec3 color;
-		};
-
-		// Single vertex buffer for all primitives
-		struct {
-			VkBuffer buffer;
-			VkDeviceMemory memory;
-		} vertices;
-
-		// Single index buffer for all primitives
-		struct {
-			int count;
-			VkBuffer buffer;
-			VkDeviceMemory memory;
-		} indices;
+		// When set, images are registered with the streamer instead of being uploaded at full resolution
+		Magnet::EngineBase::Rendering::TextureStreamer* textureStreamer = nullptr;
+		// Must be set before loading, vertices, colors and indices are sub-allocated from it
+		Magnet::EngineBase::Rendering::GeometryArena* geometryArena = nullptr;
+
+		// The vertex layout of the text loaders, packed to 16 bytes on upload (see uploadGeometry)
+		using Vertex = EngineBase::Assets::MeshFile::Vertex;
+		using PackedVertex = EngineBase::Assets::PackedVertex;
+
+		// Vertices and colors of all primitives, and their indices : the 16-bit pool, then the 32-bit pool from
+		// indexOffset32 bytes into the allocation. Offsets move when the arena compacts, they are read when drawing
+		Magnet::EngineBase::Rendering::GeometryArena::Handle geometry = Magnet::EngineBase::Rendering::GeometryArena::INVALID_HANDLE;
+		VkDeviceSize indexOffset32 = 0;
+		// Clusters of every primitive and level, vertices index the vertex buffer and bounds are in the quantized space
+		// of the primitive's mesh
+		EngineBase::Assets::MeshletBuilder::Meshlets meshlets;
+		// Pool bound by the last bindBuffers or bindIndexPool, recording is single threaded
+		VkIndexType boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
 
 		// The following structures roughly represent the glTF scene structure
 		// To keep things simple, they only contain those properties that are required for this sample
@@ -45,14 +63,84 @@ namespace Magnet {
 
 		// A primitive contains the data for a single draw call
 		struct Primitive {
+			// Indices of the model, read again by every uploadGeometry
 			uint32_t firstIndex;
 			uint32_t indexCount;
 			int32_t materialIndex;
+			// Set by uploadGeometry : primitives spanning at most 65536 vertices move to the 16-bit pool, their indices
+			// relative to vertexOffset. poolIndex is their first index in the pool of indexType
+			uint32_t poolIndex = 0;
+			int32_t vertexOffset = 0;
+			VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+			// Set by uploadGeometry : range of the primitive in meshlets
+			uint32_t firstMeshlet = 0;
+			uint32_t meshletCount = 0;
+		};
+
+		// Simplified version of a mesh's primitives, drawn from the same vertices
+		struct Lod {
+			std::vector<Primitive> primitives;
+			// Largest distance the level moves the surface by, in mesh space
+			float error = 0.0f;
 		};
 
 		// Contains the node's (optional) geometry and can be made up of an arbitrary number of primitives
 		struct Mesh {
 			std::vector<Primitive> primitives;
+			// Coarser levels from the cooked file, level 0 being primitives
+			std::vector<Lod> lods;
+			// Local space bounds of every primitive, used for culling
+			glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+			glm::vec3 boundsMax{ std::numeric_limits<float>::lowest() };
+			// Box the packed positions of the mesh are quantized to, folded into the model matrix when drawing
+			glm::vec4 quantization{ 0.0f, 0.0f, 0.0f, 1.0f };
+
+			uint32_t getLevelCount() const { return static_cast<uint32_t>(lods.size()) + 1; }
+			std::vector<Primitive>& getPrimitives(uint32_t level) { return level == 0 ? primitives : lods[level - 1].primitives; }
+		};
+
+		// Vertices quantized to the same box
+		struct VertexRange {
+			uint32_t firstVertex;
+			uint32_t vertexCount;
+			glm::vec4 quantization;
+		};
+
+		// Geometry read in place by uploadGeometry, through the loader that mapped or parsed it
+		struct GeometrySource {
+			size_t vertexCount = 0;
+			size_t indexCount = 0;
+			// Every vertex belongs to one of the ranges
+			std::vector<VertexRange> vertexRanges;
+			// Packs the vertices of a range, or of part of one, and writes their colors. Called from worker threads, the
+			// outputs are staging memory and must only be written
+			std::function<void(const VertexRange& vertices, PackedVertex* packed, uint32_t* colors)> writeVertices;
+			// Indices firstIndex to firstIndex + indexCount of the model, and the positions their meshlets are built from
+			std::function<EngineBase::Assets::TriangleList(uint32_t firstIndex, uint32_t indexCount)> getTriangles;
+
+			// Float vertices and 32-bit indices of the text loaders, which outlive the upload
+			static GeometrySource fromVertices(const Vertex* vertices, size_t vertexCount, std::vector<VertexRange> vertexRanges, const uint32_t* indices, size_t indexCount)
+			{
+				GeometrySource source;
+				source.vertexCount = vertexCount;
+				source.indexCount = indexCount;
+				source.vertexRanges = std::move(vertexRanges);
+				source.writeVertices = [vertices](const VertexRange& range, PackedVertex* packed, uint32_t* colors) {
+					PackedVertex::pack(vertices + range.firstVertex, range.vertexCount, range.quantization, packed);
+					for (uint32_t v = 0; v < range.vertexCount; v++) {
+						colors[v] = PackedVertex::packColor(vertices[range.firstVertex + v].color);
+					}
+				};
+				source.getTriangles = [vertices, indices](uint32_t firstIndex, uint32_t indexCount) {
+					EngineBase::Assets::TriangleList triangles{};
+					triangles.indices = indices + firstIndex;
+					triangles.indexCount = indexCount;
+					triangles.positions = reinterpret_cast<const unsigned char*>(&vertices->pos);
+					triangles.positionStride = sizeof(Vertex);
+					return triangles;
+				};
+				return source;
+			}
 		};
 
 		// A node represents an object in the glTF scene graph
@@ -61,6 +149,10 @@ namespace Magnet {
 			std::vector<Node*> children;
 			Mesh mesh;
 			glm::mat4 matrix;
+			// Static nodes are cached in the far shadow cascades. Animated or skinned nodes and their children are dynamic
+			bool isStatic = true;
+			// Level of detail drawn, chosen every frame from the camera
+			uint32_t lod = 0;
 			~Node() {
 				for (auto& child : children) {
 					delete child;
@@ -80,6 +172,8 @@ namespace Magnet {
 			Magnet::EngineBase::Rendering::Texture2D texture;
 			// We also store (and create) a descriptor set that's used to access this texture from the fragment shader
 			VkDescriptorSet descriptorSet;
+			// Streamed images leave texture empty, their descriptor set changes with the frame in flight
+			Magnet::EngineBase::Rendering::TextureStreamer::Handle streamHandle = Magnet::EngineBase::Rendering::TextureStreamer::INVALID_HANDLE;
 		};
 
 		// A glTF texture stores a reference to the image and a sampler
@@ -102,15 +196,11 @@ namespace Magnet {
 				delete node;
 			}
 			// Release all Vulkan resources allocated for the model
-			vkDestroyBuffer(device->device(), vertices.buffer, nullptr);
-			vkFreeMemory(device->device(), vertices.memory, nullptr);
-			vkDestroyBuffer(device->device(), indices.buffer, nullptr);
-			vkFreeMemory(device->device(), indices.memory, nullptr);
-			for (Image image : images) {
-				vkDestroyImageView(device->device(), image.texture.view, nullptr);
-				vkDestroyImage(device->device(), image.texture.image, nullptr);
-				vkDestroySampler(device->device(), image.texture.sampler, nullptr);
-				vkFreeMemory(device->device(), image.texture.deviceMemory, nullptr);
+			releaseGeometry();
+			for (Image& image : images) {
+				if (image.streamHandle == Magnet::EngineBase::Rendering::TextureStreamer::INVALID_HANDLE) {
+					image.texture.destroy();
+				}
 			}
 		}
 
@@ -120,40 +210,95 @@ namespace Magnet {
 			The following functions take a glTF input model loaded via tinyglTF and convert all required data into our own structure
 		*/
 
+		// Images are kept encoded by the glTF loader (see loadglTFImage) and decoded in parallel by loadEncodedImages
 		void loadImages(tinygltf::Model& input)
 		{
-			// Images can be stored inside the glTF (which is the case for the sample model), so instead of directly
-			// loading them from disk, we fetch them from the glTF loader and upload the buffers
-			images.resize(input.images.size());
-			for (size_t i = 0; i < input.images.size(); i++) {
-				tinygltf::Image& glTFImage = input.images[i];
-				// Get the image data from the glTF loader
-				unsigned char* buffer = nullptr;
-				VkDeviceSize bufferSize = 0;
-				bool deleteBuffer = false;
-				// We convert RGB-only images to RGBA, as most devices don't support RGB-formats in Vulkan
-				if (glTFImage.component == 3) {
-					bufferSize = glTFImage.width * glTFImage.height * 4;
-					buffer = new unsigned char[bufferSize];
-					unsigned char* rgba = buffer;
-					unsigned char* rgb = &glTFImage.image[0];
-					for (size_t i = 0; i < glTFImage.width * glTFImage.height; ++i) {
-						memcpy(rgba, rgb, sizeof(unsigned char) * 3);
-						rgba += 4;
-						rgb += 3;
+			std::vector<std::span<const unsigned char>> encodedImages;
+			encodedImages.reserve(input.images.size());
+			for (const tinygltf::Image& glTFImage : input.images) {
+				encodedImages.push_back(glTFImage.image);
+			}
+			loadEncodedImages(encodedImages);
+		}
+
+		// Images still encoded (PNG, JPEG or KTX2), e.g. read in place from a mapped GLB file. They are decoded
+		// by a pool of worker threads and uploaded through one batch, or handed to the streamer. Empty images become white
+		void loadEncodedImages(const std::vector<std::span<const unsigned char>>& encodedImages)
+		{
+			struct DecodedImage {
+				EngineBase::Rendering::MipChain mipChain;
+				// Level 0 decoded by stb, the mip chain is built afterwards. Null for KTX2, RGB and empty images
+				stbi_uc* pixels = nullptr;
+				// RGB images are decoded as is and expanded here, as most devices don't support RGB formats in Vulkan
+				std::vector<unsigned char> expanded;
+				int width = 0;
+				int height = 0;
+
+				const unsigned char* getPixels() const { return pixels ? pixels : expanded.data(); }
+			};
+
+			// Decoded images must outlive the batch submission
+			EngineBase::Rendering::KTX2Loader ktx2Loader{ *device };
+			std::vector<DecodedImage> decodedImages(encodedImages.size());
+			EngineBase::parallelFor(encodedImages.size(), [&](size_t i) {
+				const auto& encoded = encodedImages[i];
+				DecodedImage& image = decodedImages[i];
+				if (EngineBase::Rendering::KTX2Loader::isKTX2(encoded.data(), encoded.size())) {
+					image.mipChain = ktx2Loader.load(encoded.data(), encoded.size());
+					return;
+				}
+				int channels = 0;
+				if (!encoded.empty() && stbi_info_from_memory(encoded.data(), static_cast<int>(encoded.size()), &image.width, &image.height, &channels)) {
+					image.pixels = stbi_load_from_memory(encoded.data(), static_cast<int>(encoded.size()), &image.width, &image.height, &channels, channels == 3 ? STBI_rgb : STBI_rgb_alpha);
+					if (image.pixels && channels == 3) {
+						image.expanded.resize(size_t(image.width) * image.height * 4);
+						EngineBase::Assets::Kernels::expandRGBToRGBA(image.pixels, size_t(image.width) * image.height, image.expanded.data());
+						stbi_image_free(image.pixels);
+						image.pixels = nullptr;
 					}
-					deleteBuffer = true;
 				}
-				else {
-					buffer = &glTFImage.image[0];
-					bufferSize = glTFImage.image.size();
+				if (image.pixels == nullptr && image.expanded.empty()) {
+					image.mipChain = { VK_FORMAT_R8G8B8A8_UNORM, 1, 1, { { 255, 255, 255, 255 } } };
+				}
+			});
+
+			EngineBase::Rendering::TextureUploadBatch batch{ *device };
+			images.resize(encodedImages.size());
+			for (size_t i = 0; i < decodedImages.size(); i++) {
+				DecodedImage& decoded = decodedImages[i];
+				Image& image = images[i];
+				if (decoded.pixels == nullptr && decoded.expanded.empty()) {
+					image.texture.width = decoded.mipChain.width;
+					image.texture.height = decoded.mipChain.height;
+					if (textureStreamer) {
+						image.streamHandle = textureStreamer->add(std::move(decoded.mipChain));
+						image.descriptorSet = textureStreamer->getDescriptorSet(image.streamHandle, 0);
+					}
+					else {
+						batch.add(image.texture, decoded.mipChain);
+					}
+					continue;
+				}
+				if (textureStreamer) {
+					// The streamer keeps the mip chain in host memory and only uploads the levels in use
+					image.texture.width = decoded.width;
+					image.texture.height = decoded.height;
+					image.streamHandle = textureStreamer->add(EngineBase::Rendering::TextureStreamer::buildMipChain(decoded.getPixels(), decoded.width, decoded.height));
+					image.descriptorSet = textureStreamer->getDescriptorSet(image.streamHandle, 0);
+					continue;
 				}
-				// Load texture from image buffer
-				images[i].texture.fromBuffer(buffer, bufferSize, VK_FORMAT_R8G8B8A8_UNORM, glTFImage.width, glTFImage.height, vulkanDevice, copyQueue);
-				if (deleteBuffer) {
-					delete[] buffer;
+				// Level 0 is copied and the mip chain generated on submit
+				batch.add(image.texture, decoded.getPixels(), VkDeviceSize(decoded.width) * decoded.height * 4, VK_FORMAT_R8G8B8A8_UNORM, decoded.width, decoded.height);
+			}
+			batch.submit();
+			for (auto& decoded : decodedImages) {
+				if (decoded.pixels) {
+					stbi_image_free(decoded.pixels);
 				}
 			}
+			if (ktx2Loader.getStats().images > 0) {
+				ktx2Loader.printStats();
+			}
 		}
 
 		void loadTextures(tinygltf::Model& input)
@@ -161,6 +306,11 @@ namespace Magnet {
 			textures.resize(input.textures.size());
 			for (size_t i = 0; i < input.textures.size(); i++) {
 				textures[i].imageIndex = input.textures[i].source;
+				// KTX2 images are referenced through KHR_texture_basisu, source being the optional fallback
+				auto basisu = input.textures[i].extensions.find("KHR_texture_basisu");
+				if (basisu != input.textures[i].extensions.end() && basisu->second.Has("source")) {
+					textures[i].imageIndex = basisu->second.Get("source").GetNumberAsInt();
+				}
 			}
 		}
 
@@ -181,11 +331,154 @@ namespace Magnet {
 			}
 		}
 
-		void loadNode(const tinygltf::Node& inputNode, const tinygltf::Model& input, VulkanglTFModel::Node* parent, std::vector<uint32_t>& indexBuffer, std::vector<VulkanglTFModel::Vertex>& vertexBuffer)
+		// Converts the geometry of every mesh once, meshes instanced by several nodes share it. Offsets of each primitive
+		// in the shared vertex and index buffers are a prefix sum of the accessor counts, so primitives are converted in parallel.
+		// Each primitive adds a vertex range quantized to the bounds of its mesh
+		std::vector<Mesh> loadMeshes(const tinygltf::Model& input, std::vector<uint32_t>& indexBuffer, std::vector<VulkanglTFModel::Vertex>& vertexBuffer, std::vector<VertexRange>& vertexRanges)
+		{
+			struct PrimitiveJob {
+				const tinygltf::Primitive* primitive;
+				size_t mesh;
+				uint32_t firstVertex;
+				uint32_t firstIndex;
+				uint32_t vertexCount = 0;
+				uint32_t indexCount = 0;
+				glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+				glm::vec3 boundsMax{ std::numeric_limits<float>::lowest() };
+			};
+
+			std::vector<PrimitiveJob> jobs;
+			size_t vertexCount = vertexBuffer.size();
+			size_t indexCount = indexBuffer.size();
+			for (size_t m = 0; m < input.meshes.size(); m++) {
+				for (const tinygltf::Primitive& glTFPrimitive : input.meshes[m].primitives) {
+					PrimitiveJob& job = jobs.emplace_back(PrimitiveJob{ &glTFPrimitive, m, static_cast<uint32_t>(vertexCount), static_cast<uint32_t>(indexCount) });
+					auto position = glTFPrimitive.attributes.find("POSITION");
+					job.vertexCount = position != glTFPrimitive.attributes.end() ? static_cast<uint32_t>(input.accessors[position->second].count) : 0;
+					job.indexCount = job.vertexCount;
+					if (glTFPrimitive.indices > -1) {
+						const tinygltf::Accessor& accessor = input.accessors[glTFPrimitive.indices];
+						job.indexCount = static_cast<uint32_t>(accessor.count);
+						if (accessor.componentType != TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT && accessor.componentType != TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT && accessor.componentType != TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE) {
+							std::cerr << "Index component type " << accessor.componentType << " not supported!" << std::endl;
+							job.indexCount = 0;
+						}
+					}
+					vertexCount += job.vertexCount;
+					indexCount += job.indexCount;
+				}
+			}
+			vertexBuffer.resize(vertexCount);
+			indexBuffer.resize(indexCount);
+
+			// Each job only writes its own ranges of the buffers
+			EngineBase::parallelFor(jobs.size(), [&](size_t j) {
+				PrimitiveJob& job = jobs[j];
+				const tinygltf::Primitive& glTFPrimitive = *job.primitive;
+				// In glTF vertices and indices are read via accessors and buffer views
+				auto getAttribute = [&](const char* name, size_t& stride) -> const float* {
+					auto attribute = glTFPrimitive.attributes.find(name);
+					if (attribute == glTFPrimitive.attributes.end()) {
+						return nullptr;
+					}
+					const tinygltf::Accessor& accessor = input.accessors[attribute->second];
+					const tinygltf::BufferView& view = input.bufferViews[accessor.bufferView];
+					stride = view.byteStride > 0 ? view.byteStride : stride;
+					return reinterpret_cast<const float*>(&(input.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
+				};
+				size_t positionStride = sizeof(glm::vec3), normalsStride = sizeof(glm::vec3), texCoordsStride = sizeof(glm::vec2);
+				const float* positionBuffer = getAttribute("POSITION", positionStride);
+				const float* normalsBuffer = getAttribute("NORMAL", normalsStride);
+				// glTF supports multiple sets, we only load the first one
+				const float* texCoordsBuffer = getAttribute("TEXCOORD_0", texCoordsStride);
+
+				// Filled one attribute at a time
+				Vertex* vertices = vertexBuffer.data() + job.firstVertex;
+				const glm::vec3 zero{ 0.0f }, white{ 1.0f };
+				const glm::vec2 zeroUV{ 0.0f };
+				if (positionBuffer) {
+					EngineBase::Assets::Kernels::copyAttribute(positionBuffer, positionStride, &vertices->pos, sizeof(Vertex), sizeof(glm::vec3), job.vertexCount);
+				}
+				if (normalsBuffer) {
+					EngineBase::Assets::Kernels::copyAttribute(normalsBuffer, normalsStride, &vertices->normal, sizeof(Vertex), sizeof(glm::vec3), job.vertexCount);
+					EngineBase::Assets::Kernels::normalize3(&vertices->normal, sizeof(Vertex), job.vertexCount);
+				}
+				else {
+					EngineBase::Assets::Kernels::fillAttribute(&zero, &vertices->normal, sizeof(Vertex), sizeof(glm::vec3), job.vertexCount);
+				}
+				if (texCoordsBuffer) {
+					EngineBase::Assets::Kernels::copyAttribute(texCoordsBuffer, texCoordsStride, &vertices->uv, sizeof(Vertex), sizeof(glm::vec2), job.vertexCount);
+				}
+				else {
+					EngineBase::Assets::Kernels::fillAttribute(&zeroUV, &vertices->uv, sizeof(Vertex), sizeof(glm::vec2), job.vertexCount);
+				}
+				EngineBase::Assets::Kernels::fillAttribute(&white, &vertices->color, sizeof(Vertex), sizeof(glm::vec3), job.vertexCount);
+				for (uint32_t v = 0; v < job.vertexCount; v++) {
+					job.boundsMin = glm::min(job.boundsMin, vertices[v].pos);
+					job.boundsMax = glm::max(job.boundsMax, vertices[v].pos);
+				}
+
+				// All index component types are widened and rebased to 32 bits, non indexed primitives get a sequential list
+				uint32_t* indices = indexBuffer.data() + job.firstIndex;
+				if (glTFPrimitive.indices < 0) {
+					for (uint32_t i = 0; i < job.indexCount; i++) {
+						indices[i] = job.firstVertex + i;
+					}
+					return;
+				}
+				const tinygltf::Accessor& accessor = input.accessors[glTFPrimitive.indices];
+				const tinygltf::BufferView& bufferView = input.bufferViews[accessor.bufferView];
+				const unsigned char* indexData = &input.buffers[bufferView.buffer].data[accessor.byteOffset + bufferView.byteOffset];
+				switch (accessor.componentType) {
+				case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT:
+					EngineBase::Assets::Kernels::widenIndices(reinterpret_cast<const uint32_t*>(indexData), job.indexCount, job.firstVertex, indices);
+					break;
+				case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT:
+					EngineBase::Assets::Kernels::widenIndices(reinterpret_cast<const uint16_t*>(indexData), job.indexCount, job.firstVertex, indices);
+					break;
+				case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE:
+					EngineBase::Assets::Kernels::widenIndices(reinterpret_cast<const uint8_t*>(indexData), job.indexCount, job.firstVertex, indices);
+					break;
+				}
+			});
+
+			// Gathered in file order, so the output doesn't depend on the thread count
+			std::vector<Mesh> meshes(input.meshes.size());
+			for (const PrimitiveJob& job : jobs) {
+				Mesh& mesh = meshes[job.mesh];
+				mesh.boundsMin = glm::min(mesh.boundsMin, job.boundsMin);
+				mesh.boundsMax = glm::max(mesh.boundsMax, job.boundsMax);
+				mesh.primitives.push_back({ job.firstIndex, job.indexCount, job.primitive->material });
+			}
+			for (Mesh& mesh : meshes) {
+				mesh.quantization = EngineBase::Assets::PackedVertex::getQuantization(mesh.boundsMin, mesh.boundsMax);
+			}
+			for (const PrimitiveJob& job : jobs) {
+				vertexRanges.push_back({ job.firstVertex, job.vertexCount, meshes[job.mesh].quantization });
+			}
+			return meshes;
+		}
+
+		// Targeted by an animation channel, the node moves even though animations are not played yet
+		static bool isAnimated(const tinygltf::Model& input, int nodeIndex)
+		{
+			for (const auto& animation : input.animations) {
+				for (const auto& channel : animation.channels) {
+					if (channel.target_node == nodeIndex) {
+						return true;
+					}
+				}
+			}
+			return false;
+		}
+
+		// Builds the node hierarchy once every mesh is converted (see loadMeshes)
+		void loadNode(const tinygltf::Node& inputNode, const tinygltf::Model& input, VulkanglTFModel::Node* parent, const std::vector<Mesh>& meshes)
 		{
 			VulkanglTFModel::Node* node = new VulkanglTFModel::Node{};
 			node->matrix = glm::mat4(1.0f);
 			node->parent = parent;
+			node->isStatic = (parent == nullptr || parent->isStatic) && inputNode.skin < 0 && !isAnimated(input, static_cast<int>(&inputNode - input.nodes.data()));
 
 			// Get the local node matrix
 			// It's either made up from translation, rotation, scale or a 4x4 matrix
@@ -206,153 +499,323 @@ namespace Magnet {
 			// Load node's children
 			if (inputNode.children.size() > 0) {
 				for (size_t i = 0; i < inputNode.children.size(); i++) {
-					loadNode(input.nodes[inputNode.children[i]], input, node, indexBuffer, vertexBuffer);
+					loadNode(input.nodes[inputNode.children[i]], input, node, meshes);
 				}
 			}
 
-			// If the node contains mesh data, we load vertices and indices from the buffers
-			// In glTF this is done via accessors and buffer views
 			if (inputNode.mesh > -1) {
-				const tinygltf::Mesh mesh = input.meshes[inputNode.mesh];
-				// Iterate through all primitives of this node's mesh
-				for (size_t i = 0; i < mesh.primitives.size(); i++) {
-					const tinygltf::Primitive& glTFPrimitive = mesh.primitives[i];
-					uint32_t firstIndex = static_cast<uint32_t>(indexBuffer.size());
-					uint32_t vertexStart = static_cast<uint32_t>(vertexBuffer.size());
-					uint32_t indexCount = 0;
-					// Vertices
-					{
-						const float* positionBuffer = nullptr;
-						const float* normalsBuffer = nullptr;
-						const float* texCoordsBuffer = nullptr;
-						size_t vertexCount = 0;
-
-						// Get buffer data for vertex positions
-						if (glTFPrimitive.attributes.find("POSITION") != glTFPrimitive.attributes.end()) {
-							const tinygltf::Accessor& accessor = input.accessors[glTFPrimitive.attributes.find("POSITION")->second];
-							const tinygltf::BufferView& view = input.bufferViews[accessor.bufferView];
-							positionBuffer = reinterpret_cast<const float*>(&(input.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
-							vertexCount = accessor.count;
-						}
-						// Get buffer data for vertex normals
-						if (glTFPrimitive.attributes.find("NORMAL") != glTFPrimitive.attributes.end()) {
-							const tinygltf::Accessor& accessor = input.accessors[glTFPrimitive.attributes.find("NORMAL")->second];
-							const tinygltf::BufferView& view = input.bufferViews[accessor.bufferView];
-							normalsBuffer = reinterpret_cast<const float*>(&(input.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
-						}
-						// Get buffer data for vertex texture coordinates
-						// glTF supports multiple sets, we only load the first one
-						if (glTFPrimitive.attributes.find("TEXCOORD_0") != glTFPrimitive.attributes.end()) {
-							const tinygltf::Accessor& accessor = input.accessors[glTFPrimitive.attributes.find("TEXCOORD_0")->second];
-							const tinygltf::BufferView& view = input.bufferViews[accessor.bufferView];
-							texCoordsBuffer = reinterpret_cast<const float*>(&(input.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset]));
-						}
+				node->mesh = meshes[inputNode.mesh];
+			}
 
-						// Append data to model's vertex buffer
-						for (size_t v = 0; v < vertexCount; v++) {
-							Vertex vert{};
-							vert.pos = glm::vec4(glm::make_vec3(&positionBuffer[v * 3]), 1.0f);
-							vert.normal = glm::normalize(glm::vec3(normalsBuffer ? glm::make_vec3(&normalsBuffer[v * 3]) : glm::vec3(0.0f)));
-							vert.uv = texCoordsBuffer ? glm::make_vec2(&texCoordsBuffer[v * 2]) : glm::vec3(0.0f);
-							vert.color = glm::vec3(1.0f);
-							vertexBuffer.push_back(vert);
-						}
-					}
-					// Indices
-					{
-						const tinygltf::Accessor& accessor = input.accessors[glTFPrimitive.indices];
-						const tinygltf::BufferView& bufferView = input.bufferViews[accessor.bufferView];
-						const tinygltf::Buffer& buffer = input.buffers[bufferView.buffer];
-
-						indexCount += static_cast<uint32_t>(accessor.count);
-
-						// glTF supports different component types of indices
-						switch (accessor.componentType) {
-						case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT: {
-							const uint32_t* buf = reinterpret_cast<const uint32_t*>(&buffer.data[accessor.byteOffset + bufferView.byteOffset]);
-							for (size_t index = 0; index < accessor.count; index++) {
-								indexBuffer.push_back(buf[index] + vertexStart);
-							}
-							break;
+			if (parent) {
+				parent->children.push_back(node);
+			}
+			else {
+				nodes.push_back(node);
+			}
+		}
+
+		// Has the source write packed vertices (see PackedVertex), colors and indices straight into one staging buffer, and
+		// uploads it into a single allocation of the geometry arena, replacing the previous one. The nodes must exist, the
+		// index ranges of their primitives are placed in the 16 or 32-bit pool and split into meshlets, and the primitives updated
+		void uploadGeometry(const GeometrySource& source)
+		{
+			// Index ranges of the drawn primitives, nodes instancing the same mesh share them
+			struct IndexRange {
+				uint32_t firstIndex;
+				uint32_t indexCount;
+				EngineBase::Assets::TriangleList triangles{};
+				uint32_t minVertex = 0;
+				uint32_t maxVertex = 0;
+				uint32_t poolIndex = 0;
+				VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+				uint32_t firstMeshlet = 0;
+				uint32_t meshletCount = 0;
+			};
+			std::vector<VulkanglTFModel::Node*> meshNodes;
+			collectMeshNodes(meshNodes);
+			std::vector<IndexRange> indexRanges;
+			// Indices address the model's vertices, the same indices always cover the same vertex range
+			auto rangeKey = [](const Primitive& primitive) { return (uint64_t(primitive.firstIndex) << 32) | primitive.indexCount; };
+			std::unordered_map<uint64_t, size_t> rangeOfIndices;
+			for (auto* node : meshNodes) {
+				for (uint32_t level = 0; level < node->mesh.getLevelCount(); level++) {
+					for (const Primitive& primitive : node->mesh.getPrimitives(level)) {
+						if (primitive.indexCount == 0) {
+							continue;
 						}
-						case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT: {
-							const uint16_t* buf = reinterpret_cast<const uint16_t*>(&buffer.data[accessor.byteOffset + bufferView.byteOffset]);
-							for (size_t index = 0; index < accessor.count; index++) {
-								indexBuffer.push_back(buf[index] + vertexStart);
-							}
-							break;
+						if (size_t(primitive.firstIndex) + primitive.indexCount > source.indexCount) {
+							throw std::runtime_error("failed to upload model geometry, primitive indices out of range!");
 						}
-						case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE: {
-							const uint8_t* buf = reinterpret_cast<const uint8_t*>(&buffer.data[accessor.byteOffset + bufferView.byteOffset]);
-							for (size_t index = 0; index < accessor.count; index++) {
-								indexBuffer.push_back(buf[index] + vertexStart);
-							}
-							break;
+						if (rangeOfIndices.emplace(rangeKey(primitive), indexRanges.size()).second) {
+							indexRanges.push_back({ primitive.firstIndex, primitive.indexCount });
 						}
-						default:
-							std::cerr << "Index component type " << accessor.componentType << " not supported!" << std::endl;
-							return;
+					}
+				}
+			}
+			EngineBase::parallelFor(indexRanges.size(), [&](size_t i) {
+				IndexRange& range = indexRanges[i];
+				range.triangles = source.getTriangles(range.firstIndex, range.indexCount);
+				range.triangles.getVertexBounds(range.minVertex, range.maxVertex);
+			});
+			buildMeshlets(source.vertexRanges, indexRanges);
+
+			VkDeviceSize indexCount16 = 0;
+			VkDeviceSize indexCount32 = 0;
+			uint32_t rangeCount16 = 0;
+			for (IndexRange& range : indexRanges) {
+				if (range.maxVertex - range.minVertex <= std::numeric_limits<uint16_t>::max()) {
+					range.indexType = VK_INDEX_TYPE_UINT16;
+					range.poolIndex = static_cast<uint32_t>(indexCount16);
+					indexCount16 += range.indexCount;
+					rangeCount16++;
+				}
+				else {
+					range.poolIndex = static_cast<uint32_t>(indexCount32);
+					indexCount32 += range.indexCount;
+				}
+			}
+
+			if (geometryArena == nullptr) {
+				throw std::runtime_error("failed to upload model geometry, no geometry arena!");
+			}
+			// Colors are per vertex in the arena, a constant color is repeated
+			VkDeviceSize vertexBytes = source.vertexCount * sizeof(PackedVertex);
+			VkDeviceSize colorBytes = source.vertexCount * PackedVertex::COLOR_STRIDE;
+			// 32-bit indices are addressed in 4 byte units from the start of the arena's index buffer
+			indexOffset32 = (indexCount16 * sizeof(uint16_t) + 3) & ~VkDeviceSize(3);
+			VkDeviceSize indexBytes = indexOffset32 + indexCount32 * sizeof(uint32_t);
+			if (vertexBytes == 0 || indexBytes == 0) {
+				throw std::runtime_error("failed to upload model geometry, no vertices or indices!");
+			}
+
+			VKBase::Buffer stagingBuffer{
+				*device,
+				vertexBytes + colorBytes + indexBytes,
+				1,
+				VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+			stagingBuffer.map();
+
+			// Packed straight into staging memory, ranges are split so a single large mesh still uses every core
+			constexpr uint32_t PACK_CHUNK = 64 * 1024;
+			std::vector<VertexRange> chunks;
+			for (const VertexRange& range : source.vertexRanges) {
+				for (uint32_t first = 0; first < range.vertexCount; first += PACK_CHUNK) {
+					chunks.push_back({ range.firstVertex + first, std::min(PACK_CHUNK, range.vertexCount - first), range.quantization });
+				}
+			}
+			auto* packed = static_cast<PackedVertex*>(stagingBuffer.getMappedMemory());
+			auto* colors = reinterpret_cast<uint32_t*>(static_cast<char*>(stagingBuffer.getMappedMemory()) + vertexBytes);
+			EngineBase::parallelFor(chunks.size(), [&](size_t i) {
+				source.writeVertices(chunks[i], packed + chunks[i].firstVertex, colors + chunks[i].firstVertex);
+			});
+
+			// 16-bit ranges are rebased to their lowest vertex, drawn with it as vertexOffset
+			auto* pool16 = reinterpret_cast<uint16_t*>(static_cast<char*>(stagingBuffer.getMappedMemory()) + vertexBytes + colorBytes);
+			auto* pool32 = reinterpret_cast<uint32_t*>(reinterpret_cast<char*>(pool16) + indexOffset32);
+			EngineBase::parallelFor(indexRanges.size(), [&](size_t i) {
+				const IndexRange& range = indexRanges[i];
+				if (range.indexType == VK_INDEX_TYPE_UINT16) {
+					range.triangles.write(range.minVertex, pool16 + range.poolIndex);
+				}
+				else {
+					range.triangles.write(0, pool32 + range.poolIndex);
+				}
+			});
+			for (auto* node : meshNodes) {
+				for (uint32_t level = 0; level < node->mesh.getLevelCount(); level++) {
+					for (Primitive& primitive : node->mesh.getPrimitives(level)) {
+						auto range = rangeOfIndices.find(rangeKey(primitive));
+						if (primitive.indexCount == 0 || range == rangeOfIndices.end()) {
+							continue;
 						}
+						primitive.poolIndex = indexRanges[range->second].poolIndex;
+						primitive.indexType = indexRanges[range->second].indexType;
+						primitive.vertexOffset = primitive.indexType == VK_INDEX_TYPE_UINT16 ? static_cast<int32_t>(indexRanges[range->second].minVertex) : 0;
+						primitive.firstMeshlet = indexRanges[range->second].firstMeshlet;
+						primitive.meshletCount = indexRanges[range->second].meshletCount;
 					}
-					Primitive primitive{};
-					primitive.firstIndex = firstIndex;
-					primitive.indexCount = indexCount;
-					primitive.materialIndex = glTFPrimitive.material;
-					node->mesh.primitives.push_back(primitive);
 				}
 			}
 
-			if (parent) {
-				parent->children.push_back(node);
+			releaseGeometry();
+			geometry = geometryArena->allocate(static_cast<uint32_t>(source.vertexCount), indexBytes);
+			VkCommandBuffer commandBuffer = device->beginSingleTimeCommands();
+			geometryArena->upload(commandBuffer, geometry, stagingBuffer.getBuffer(), 0, vertexBytes, vertexBytes + colorBytes);
+			device->endSingleTimeCommands(commandBuffer);
+
+			VkDeviceSize widenedBytes = (indexCount16 + indexCount32) * sizeof(uint32_t);
+			std::cout << "\nIndex buffer :" << std::endl;
+			std::cout << "------------------------------" << std::endl;
+			std::cout << "\t- 16-bit : " << rangeCount16 << " of " << indexRanges.size() << " index ranges, " << indexCount16 << " indices" << std::endl;
+			std::cout << "\t- Size : " << indexBytes / 1024 << " KB, " << (widenedBytes - std::min(widenedBytes, indexBytes)) / 1024 << " KB saved over 32-bit only" << std::endl;
+		}
+
+		// Splits every index range into meshlets, in parallel, and concatenates them in range order. Bounds of float positions
+		// move to the quantized space of the range's vertices so they are drawn with the same model matrix as the primitive
+		template<typename IndexRange>
+		void buildMeshlets(const std::vector<VertexRange>& vertexRanges, std::vector<IndexRange>& indexRanges)
+		{
+			using MeshletBuilder = EngineBase::Assets::MeshletBuilder;
+			auto start = std::chrono::high_resolution_clock::now();
+
+			std::vector<MeshletBuilder::Meshlets> rangeMeshlets(indexRanges.size());
+			EngineBase::parallelFor(indexRanges.size(), [&](size_t i) {
+				const IndexRange& range = indexRanges[i];
+				MeshletBuilder::build(range.triangles, rangeMeshlets[i]);
+				if (range.triangles.quantized) {
+					return;
+				}
+
+				auto vertexRange = std::find_if(vertexRanges.begin(), vertexRanges.end(), [&range](const VertexRange& vertices) {
+					return range.minVertex >= vertices.firstVertex && range.minVertex - vertices.firstVertex < vertices.vertexCount;
+				});
+				glm::vec4 quantization = vertexRange != vertexRanges.end() ? vertexRange->quantization : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+				for (auto& bounds : rangeMeshlets[i].bounds) {
+					bounds.sphere = glm::vec4((glm::vec3(bounds.sphere) - glm::vec3(quantization)) / quantization.w, bounds.sphere.w / quantization.w);
+					bounds.coneApex = glm::vec4((glm::vec3(bounds.coneApex) - glm::vec3(quantization)) / quantization.w, 1.0f);
+				}
+			});
+
+			meshlets = {};
+			for (size_t i = 0; i < indexRanges.size(); i++) {
+				indexRanges[i].firstMeshlet = static_cast<uint32_t>(meshlets.meshlets.size());
+				indexRanges[i].meshletCount = static_cast<uint32_t>(rangeMeshlets[i].meshlets.size());
+				MeshletBuilder::append(meshlets, rangeMeshlets[i]);
 			}
-			else {
-				nodes.push_back(node);
+
+			size_t triangleCount = meshlets.triangles.size();
+			size_t meshletCount = std::max<size_t>(meshlets.meshlets.size(), 1);
+			std::cout << "\nMeshlets :" << std::endl;
+			std::cout << "------------------------------" << std::endl;
+			std::cout << "\t- Meshlets : " << meshlets.meshlets.size() << " for " << triangleCount << " triangles" << std::endl;
+			std::cout << "\t- Average : " << double(meshlets.vertices.size()) / meshletCount << " vertices, " << double(triangleCount) / meshletCount << " triangles" << std::endl;
+			std::cout << "\t- Build time : " << std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() << " ms" << std::endl;
+		}
+
+		// Vertex input of the pipelines drawing the model, colors are per vertex in the geometry arena
+		std::vector<VkVertexInputBindingDescription> getBindingDescriptions() const
+		{
+			return PackedVertex::getBindingDescriptions(true);
+		}
+
+		// The allocation is reused once the frames in flight are complete
+		void releaseGeometry()
+		{
+			if (geometry != Magnet::EngineBase::Rendering::GeometryArena::INVALID_HANDLE) {
+				geometryArena->free(geometry);
+				geometry = Magnet::EngineBase::Rendering::GeometryArena::INVALID_HANDLE;
 			}
 		}
 
+		// Draw parameters of a primitive in the arena's buffers, both pools are bound at offset 0
+		uint32_t getFirstIndex(const Primitive& primitive) const
+		{
+			const auto& allocation = geometryArena->getAllocation(geometry);
+			if (primitive.indexType == VK_INDEX_TYPE_UINT16) {
+				return static_cast<uint32_t>(allocation.indexOffset / sizeof(uint16_t)) + primitive.poolIndex;
+			}
+			return static_cast<uint32_t>((allocation.indexOffset + indexOffset32) / sizeof(uint32_t)) + primitive.poolIndex;
+		}
+		int32_t getVertexOffset(const Primitive& primitive) const
+		{
+			return static_cast<int32_t>(geometryArena->getAllocation(geometry).firstVertex) + primitive.vertexOffset;
+		}
+		// Added to the meshlet vertices, which index the model's vertices
+		int32_t getFirstVertex() const
+		{
+			return static_cast<int32_t>(geometryArena->getAllocation(geometry).firstVertex);
+		}
+
 		/*
 			glTF rendering functions
 		*/
 
-		// Draw a single node including child nodes (if present)
-		void drawNode(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, VulkanglTFModel::Node* node)
+		// Traverse the node hierarchy to the top-most parent to get the final matrix of the node
+		static glm::mat4 getWorldMatrix(const VulkanglTFModel::Node* node)
 		{
-			if (node->mesh.primitives.size() > 0) {
-				// Pass the node's matrix via push constants
-				// Traverse the node hierarchy to the top-most parent to get the final matrix of the current node
-				glm::mat4 nodeMatrix = node->matrix;
-				VulkanglTFModel::Node* currentParent = node->parent;
-				while (currentParent) {
-					nodeMatrix = currentParent->matrix * nodeMatrix;
-					currentParent = currentParent->parent;
-				}
-				// Pass the final matrix to the vertex shader using push constants
-				vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &nodeMatrix);
-				for (VulkanglTFModel::Primitive& primitive : node->mesh.primitives) {
-					if (primitive.indexCount > 0) {
+			glm::mat4 nodeMatrix = node->matrix;
+			VulkanglTFModel::Node* currentParent = node->parent;
+			while (currentParent) {
+				nodeMatrix = currentParent->matrix * nodeMatrix;
+				currentParent = currentParent->parent;
+			}
+			return nodeMatrix;
+		}
+
+		// Draw the primitives of a single node at its level of detail, without its children
+		void drawMesh(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, VulkanglTFModel::Node* node, bool bindTextures = true)
+		{
+			// Pass the final matrix to the vertex shader using push constants, with the position dequantization folded in
+			glm::mat4 nodeMatrix = getWorldMatrix(node) * PackedVertex::getDequantizationMatrix(node->mesh.quantization);
+			vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &nodeMatrix);
+			for (const VulkanglTFModel::Primitive& primitive : node->mesh.getPrimitives(node->lod)) {
+				if (primitive.indexCount > 0) {
+					if (bindTextures) {
 						// Get the texture index for this primitive
 						VulkanglTFModel::Texture texture = textures[materials[primitive.materialIndex].baseColorTextureIndex];
 						// Bind the descriptor for the current primitive's texture
 						vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 1, 1, &images[texture.imageIndex].descriptorSet, 0, nullptr);
-						vkCmdDrawIndexed(commandBuffer, primitive.indexCount, 1, primitive.firstIndex, 0, 0);
 					}
+					bindIndexPool(commandBuffer, primitive.indexType);
+					vkCmdDrawIndexed(commandBuffer, primitive.indexCount, 1, getFirstIndex(primitive), getVertexOffset(primitive), 0);
+				}
+			}
+		}
+
+		// Draw a single node including child nodes (if present)
+		void drawNode(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, VulkanglTFModel::Node* node, bool bindTextures = true)
+		{
+			if (node->mesh.primitives.size() > 0) {
+				drawMesh(commandBuffer, pipelineLayout, node, bindTextures);
+			}
+			for (auto& child : node->children) {
+				drawNode(commandBuffer, pipelineLayout, child, bindTextures);
+			}
+		}
+
+		// Nodes with geometry, in draw order
+		void collectMeshNodes(std::vector<VulkanglTFModel::Node*>& meshNodes, VulkanglTFModel::Node* node = nullptr)
+		{
+			if (node == nullptr) {
+				for (auto& root : nodes) {
+					collectMeshNodes(meshNodes, root);
 				}
+				return;
+			}
+			if (node->mesh.primitives.size() > 0) {
+				meshNodes.push_back(node);
 			}
 			for (auto& child : node->children) {
-				drawNode(commandBuffer, pipelineLayout, child);
+				collectMeshNodes(meshNodes, child);
+			}
+		}
+
+		void bindBuffers(VkCommandBuffer commandBuffer)
+		{
+			geometryArena->bindVertexBuffers(commandBuffer);
+			boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+			bindIndexPool(commandBuffer, VK_INDEX_TYPE_UINT32);
+		}
+
+		// Rebinds the index buffer only when the pool changes between primitives
+		void bindIndexPool(VkCommandBuffer commandBuffer, VkIndexType indexType)
+		{
+			if (indexType != boundIndexType) {
+				geometryArena->bindIndexBuffer(commandBuffer, indexType);
+				boundIndexType = indexType;
 			}
 		}
 
 		// Draw the glTF scene starting at the top-level-nodes
-		void draw(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout)
+		void draw(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, bool bindTextures = true)
 		{
-			// All vertices and indices are stored in single buffers, so we only need to bind once
-			VkDeviceSize offsets[1] = { 0 };
-			vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertices.buffer, offsets);
-			vkCmdBindIndexBuffer(commandBuffer, indices.buffer, 0, VK_INDEX_TYPE_UINT32);
+			// All vertices and indices are stored in the arena's buffers, so we only need to bind once
+			bindBuffers(commandBuffer);
 			// Render all nodes at top-level
 			for (auto& node : nodes) {
-				drawNode(commandBuffer, pipelineLayout, node);
+				drawNode(commandBuffer, pipelineLayout, node, bindTextures);
 			}
 		}
 
@@ -370,8 +833,25 @@ namespace Magnet {
 
 	class Engine {
 	public:
+		enum class RenderBackend { Pipelines, ShaderObjects };
+		enum class RenderPath { Forward, VisibilityBuffer, Meshlets, VertexPulling };
+
 		static constexpr int WIDTH = 800;
 		static constexpr int HEIGHT = 600;
+		static constexpr const char* VERT_SHADER = "assets/defaults/shaders/shader.vert.spv";
+		static constexpr const char* PULLED_VERT_SHADER = "assets/defaults/shaders/shader_pulled.vert.spv";
+		static constexpr const char* FRAG_SHADER = "assets/defaults/shaders/shader.frag.spv";
+		static constexpr const char* CLUSTER_SHADER = "assets/defaults/shaders/cluster.comp.spv";
+		static constexpr const char* SHADOW_VERT_SHADER = "assets/defaults/shaders/shadow.vert.spv";
+		static constexpr const char* SHADOW_FRAG_SHADER = "assets/defaults/shaders/shadow.frag.spv";
+		static constexpr const char* VISIBILITY_VERT_SHADER = "assets/defaults/shaders/visibility.vert.spv";
+		static constexpr const char* VISIBILITY_FRAG_SHADER = "assets/defaults/shaders/visibility.frag.spv";
+		static constexpr const char* VISIBILITY_RESOLVE_VERT_SHADER = "assets/defaults/shaders/visibility_resolve.vert.spv";
+		static constexpr const char* VISIBILITY_RESOLVE_FRAG_SHADER = "assets/defaults/shaders/visibility_resolve.frag.spv";
+		static constexpr const char* MESHLET_TASK_SHADER = "assets/defaults/shaders/meshlet.task.spv";
+		static constexpr const char* MESHLET_MESH_SHADER = "assets/defaults/shaders/meshlet.mesh.spv";
+		static constexpr const char* MESHLET_FRAG_SHADER = "assets/defaults/shaders/meshlet.frag.spv";
+		static constexpr const char* MESHLET_CULL_SHADER = "assets/defaults/shaders/meshlet_cull.comp.spv";
 		Engine();
 		~Engine();
 
@@ -386,11 +866,59 @@ namespace Magnet {
 
 		bool shouldClose();
 
+		// Loads the cooked mesh instead when Magnet-Cooker produced an up to date one next to the file
 		void loadglTFFile(std::string filename);
+		// Cooked mesh (see Magnet-Cooker), vertices are packed from the mapped file straight to staging memory
+		void loadMeshFile(std::string filename);
+		// Binary glTF read in place from a file mapping, attributes are converted without copying the file
+		void loadGLBFile(std::string filename);
+
+		// Rebuilds the pipelines or shader objects of the forward path when the backend changes.
+		// Shader objects need VK_EXT_shader_object and dynamic rendering, pipelines are used without them
+		void setRenderBackend(RenderBackend backend);
+		RenderBackend getRenderBackend() const { return renderBackend; }
+
+		// Rebuilds the frame graph, the visibility buffer needs VK_KHR_dynamic_rendering and geometryShader (gl_PrimitiveID) and falls back to forward without them.
+		// Meshlets are drawn with mesh shaders when supported, through compute culled indirect draws otherwise.
+		// Vertex pulling needs bufferDeviceAddress and falls back to forward without it
+		void setRenderPath(RenderPath path);
+		RenderPath getRenderPath() const { return renderPath; }
+
+		// Prints the passes, barriers and transient resources every time the frame graph is built, rebuilding it when enabled
+		void setRenderGraphDump(bool dump);
+
+		// Renders framesPerCase frames with 16, 256 and 4096 lights, brute force and clustered, and prints GPU frame times
+		void benchmarkLighting(uint32_t framesPerCase = 200);
 
 		
 
 	private:
+		void createPipelineLayout();
+		void preparePipelines();
+		// Render pass or attachment formats, layout and dynamic states shared by the forward pipelines
+		void configurePipeline(VKBase::PipelineConfigInfo& config);
+		void bindPipeline(VkCommandBuffer commandBuffer);
+		void buildRenderGraph();
+		void drawFrame();
+		void recordFrame(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+		void drawScene(VkCommandBuffer commandBuffer, VkExtent2D extent);
+		void createShadows();
+		void updateShadowCasters();
+		void createVisibilityBuffer();
+		// One visibility draw per primitive, drawn from the geometry arena
+		void setVisibilityGeometry();
+		// Points the renderers reading the geometry arena at its buffers and offsets after a compaction moved them
+		void updateGeometryBindings();
+		void createMeshletRenderer();
+		// Meshlet draws of every mesh node at its level of detail
+		void updateMeshlets();
+		// Pulled draws of every mesh node at its level of detail, read from the geometry arena's addresses
+		void updateVertexPulling();
+		// Requests texture levels from the screen size of visible meshes and swaps in the streamed descriptor sets
+		void updateTextureStreaming();
+		// Picks the level of detail of every mesh node, shadows draw the same levels
+		void updateLods();
+
 		VulkanglTFModel glTFModel;
 
 		Window window{ WIDTH, HEIGHT, "Magnet" };
@@ -404,5 +932,81 @@ namespace Magnet {
 
 		EngineBase::Object::Map objects;
 
+		VkPipelineLayout pipelineLayout{ VK_NULL_HANDLE };
+		// Node matrix of the forward vertex shaders, the shader objects declare the same range as the pipeline layout
+		VkPushConstantRange pushConstantRange{ VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4) };
+		struct {
+			VkDescriptorSetLayout matrices;
+			VkDescriptorSetLayout textures;
+		} descriptorSetLayouts;
+		VKBase::PipelineConfigInfo pipelineConfig{};
+		// Same as pipelineConfig without vertex input
+		VKBase::PipelineConfigInfo pulledPipelineConfig{};
+
+		// State of the next draws, recorded dynamically when the device supports it
+		VKBase::RasterState rasterState{};
+		bool wireframe = false;
+
+		// Owned by the renderer's pipeline registry, identical configurations share the same pipeline
+		struct {
+			std::shared_ptr<VKBase::Pipeline> solid;
+			std::shared_ptr<VKBase::Pipeline> wireframe;
+			std::shared_ptr<VKBase::Pipeline> pulled;
+		} pipelines;
+		// Pipeline bindPipeline resolved for the last draw state
+		struct {
+			std::shared_ptr<VKBase::Pipeline> pipeline;
+			VKBase::RasterState state{};
+			bool pulled = false;
+		} boundPipeline;
+
+		RenderBackend renderBackend = RenderBackend::Pipelines;
+		std::unique_ptr<VKBase::ShaderObject> shaderObject;
+		std::unique_ptr<VKBase::ShaderObject> pulledShaderObject;
+
+		// Frame passes, built once and executed every frame with the acquired swapchain image rebound.
+		// Without dynamic rendering the scene pass begins the swapchain render pass itself
+		std::unique_ptr<EngineBase::Rendering::RenderGraph> renderGraph;
+		struct {
+			EngineBase::Rendering::RGResource backbuffer;
+			EngineBase::Rendering::RGResource depth;
+			EngineBase::Rendering::RGResource visibility;
+			EngineBase::Rendering::RGResource shadowMaps;
+			EngineBase::Rendering::RGResource shadowCache;
+			EngineBase::Rendering::RGResource lights;
+			EngineBase::Rendering::RGResource lightGrid;
+			EngineBase::Rendering::RGResource lightIndices;
+		} frameResources;
+
+		RenderPath renderPath = RenderPath::Forward;
+		bool renderGraphDump = false;
+		std::unique_ptr<EngineBase::Rendering::VisibilityBuffer> visibility;
+		std::unique_ptr<EngineBase::Rendering::MeshletRenderer> meshlets;
+		std::unique_ptr<EngineBase::Rendering::VertexPuller> vertexPuller;
+		glm::vec4 ambientLight{ 1.0f, 1.0f, 1.0f, 0.02f };
+
+		std::unique_ptr<EngineBase::Rendering::TextureStreamer> textureStreamer;
+		std::unique_ptr<EngineBase::Rendering::GeometryArena> geometryArena;
+		EngineBase::Rendering::LodSelector lodSelector{ EngineBase::Rendering::LodSelector::Settings{} };
+
+		std::unique_ptr<EngineBase::Rendering::ClusteredLighting> lighting;
+		std::unique_ptr<VKBase::GpuTimer> gpuTimer;
+
+		std::unique_ptr<EngineBase::Rendering::CascadedShadowMaps> shadows;
+		// One caster per glTF node with geometry, same order as shadowCasterNodes
+		std::vector<EngineBase::Rendering::ShadowCaster> shadowCasters;
+		std::vector<VulkanglTFModel::Node*> shadowCasterNodes;
+		glm::vec3 sunDirection = glm::normalize(glm::vec3(-0.5f, -1.0f, -0.3f));
+		glm::vec4 sunColor{ 1.0f, 0.95f, 0.85f, 1.0f };
+		uint32_t currentFrameIndex = 0;
+		// Swapchain image of the frame being recorded, the render pass path picks its framebuffer with it
+		uint32_t currentImageIndex = 0;
+
+		// Used to compare both backends : creation cost, bind hitches (lazy permutation compiles) and frame CPU time
+		EngineBase::TimingStats creationTimes{ "Pipeline creation" };
+		EngineBase::TimingStats bindTimes{ "Pipeline bind", 1.0 };
+		EngineBase::TimingStats frameTimes{ "Frame CPU", 16.7 };
+		EngineBase::TimingStats gpuFrameTimes{ "Frame GPU", 16.7 };
+
 	};
 }
@@ -0,0 +1,219 @@
+#include "GLBFile.h"
+
+#include <json/json.hpp>
+
+namespace {
+	constexpr uint32_t CHUNK_JSON = 0x4E4F534A;
+	constexpr uint32_t CHUNK_BIN = 0x004E4942;
+
+	uint32_t read32(const unsigned char* data)
+	{
+		uint32_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+}
+
+Magnet::EngineBase::Assets::GLBFile::GLBFile(const std::string& path) : file{ path }
+{
+	// 12 byte header then chunks, each with its length and type
+	if (!isGLB(file.data(), file.size()) || read32(file.data() + 4) != 2) {
+		throw std::runtime_error("failed to load GLB file, invalid header: " + path);
+	}
+	size_t length = std::min<size_t>(read32(file.data() + 8), file.size());
+
+	size_t offset = 12;
+	const unsigned char* json = nullptr;
+	while (offset + 8 <= length) {
+		uint32_t chunkLength = read32(file.data() + offset);
+		uint32_t chunkType = read32(file.data() + offset + 4);
+		if (offset + 8 + chunkLength > length) {
+			throw std::runtime_error("failed to load GLB file, truncated chunk: " + path);
+		}
+		if (chunkType == CHUNK_JSON && json == nullptr) {
+			json = file.data() + offset + 8;
+			jsonSize = chunkLength;
+		}
+		else if (chunkType == CHUNK_BIN && binChunk.empty()) {
+			binChunk = { file.data() + offset + 8, chunkLength };
+		}
+		// Chunks are 4 byte aligned
+		offset += 8 + ((size_t(chunkLength) + 3) & ~size_t(3));
+	}
+	if (json == nullptr) {
+		throw std::runtime_error("failed to load GLB file, no JSON chunk: " + path);
+	}
+	parseJSON(json, jsonSize);
+}
+
+bool Magnet::EngineBase::Assets::GLBFile::isGLB(const unsigned char* data, size_t size)
+{
+	return size >= 12 && read32(data) == MAGIC;
+}
+
+uint32_t Magnet::EngineBase::Assets::GLBFile::componentSize(uint32_t componentType)
+{
+	switch (componentType) {
+	case 5120: // BYTE
+	case 5121: // UNSIGNED_BYTE
+		return 1;
+	case 5122: // SHORT
+	case 5123: // UNSIGNED_SHORT
+		return 2;
+	case 5125: // UNSIGNED_INT
+	case 5126: // FLOAT
+		return 4;
+	default:
+		return 0;
+	}
+}
+
+std::span<const unsigned char> Magnet::EngineBase::Assets::GLBFile::getBufferView(int32_t index) const
+{
+	const BufferView& view = bufferViews.at(index);
+	return binChunk.subspan(view.byteOffset, view.byteLength);
+}
+
+std::span<const unsigned char> Magnet::EngineBase::Assets::GLBFile::getImageData(size_t index) const
+{
+	const Image& image = images.at(index);
+	return image.bufferView > -1 ? getBufferView(image.bufferView) : std::span<const unsigned char>{};
+}
+
+void Magnet::EngineBase::Assets::GLBFile::parseJSON(const unsigned char* json, size_t size)
+{
+	// The document only lives during parsing, what the engine reads is kept in compact structures
+	nlohmann::json document = nlohmann::json::parse(json, json + size);
+
+	const auto empty = nlohmann::json::array();
+	for (const auto& buffer : document.value("buffers", empty)) {
+		if (buffer.contains("uri")) {
+			throw std::runtime_error("failed to load GLB file, external buffers are not supported!");
+		}
+	}
+
+	for (const auto& view : document.value("bufferViews", empty)) {
+		BufferView bufferView{};
+		bufferView.byteOffset = view.value("byteOffset", size_t(0));
+		bufferView.byteLength = view.at("byteLength").get<size_t>();
+		bufferView.byteStride = view.value("byteStride", size_t(0));
+		if (view.value("buffer", 0) != 0 || bufferView.byteOffset + bufferView.byteLength > binChunk.size()) {
+			throw std::runtime_error("failed to load GLB file, buffer view outside the BIN chunk!");
+		}
+		bufferViews.push_back(bufferView);
+	}
+
+	const std::unordered_map<std::string, uint32_t> componentCounts = {
+		{ "SCALAR", 1 }, { "VEC2", 2 }, { "VEC3", 3 }, { "VEC4", 4 }, { "MAT2", 4 }, { "MAT3", 9 }, { "MAT4", 16 } };
+	for (const auto& input : document.value("accessors", empty)) {
+		if (input.contains("sparse") || !input.contains("bufferView")) {
+			throw std::runtime_error("failed to load GLB file, sparse accessors are not supported!");
+		}
+		Accessor accessor{};
+		accessor.bufferView = input.at("bufferView").get<int32_t>();
+		accessor.byteOffset = input.value("byteOffset", size_t(0));
+		accessor.count = input.at("count").get<size_t>();
+		accessor.componentType = input.at("componentType").get<uint32_t>();
+		accessor.componentCount = componentCounts.at(input.at("type").get<std::string>());
+		if (accessor.componentCount >= 3 && input.contains("min") && input.contains("max")) {
+			std::vector<float> boundsMin = input.at("min").get<std::vector<float>>();
+			std::vector<float> boundsMax = input.at("max").get<std::vector<float>>();
+			accessor.hasBounds = boundsMin.size() >= 3 && boundsMax.size() >= 3;
+			if (accessor.hasBounds) {
+				accessor.boundsMin = glm::make_vec3(boundsMin.data());
+				accessor.boundsMax = glm::make_vec3(boundsMax.data());
+			}
+		}
+		if (accessor.bufferView < 0 || accessor.bufferView >= static_cast<int32_t>(bufferViews.size())) {
+			throw std::runtime_error("failed to load GLB file, invalid accessor buffer view!");
+		}
+		accessors.push_back(accessor);
+	}
+
+	for (const auto& input : document.value("meshes", empty)) {
+		Mesh mesh;
+		for (const auto& inputPrimitive : input.at("primitives")) {
+			Primitive primitive;
+			for (const auto& [name, accessor] : inputPrimitive.at("attributes").items()) {
+				primitive.attributes[name] = accessor.get<int32_t>();
+			}
+			primitive.indices = inputPrimitive.value("indices", -1);
+			primitive.material = inputPrimitive.value("material", -1);
+			primitive.mode = inputPrimitive.value("mode", 4u);
+			mesh.primitives.push_back(std::move(primitive));
+		}
+		meshes.push_back(std::move(mesh));
+	}
+
+	for (const auto& input : document.value("nodes", empty)) {
+		Node node;
+		node.mesh = input.value("mesh", -1);
+		node.children = input.value("children", std::vector<uint32_t>{});
+		node.animated = input.contains("skin");
+		// Either a matrix or translation, rotation and scale
+		if (input.contains("matrix")) {
+			std::vector<float> matrix = input.at("matrix").get<std::vector<float>>();
+			node.matrix = glm::make_mat4x4(matrix.data());
+		}
+		else {
+			if (input.contains("translation")) {
+				std::vector<float> translation = input.at("translation").get<std::vector<float>>();
+				node.matrix = glm::translate(node.matrix, glm::make_vec3(translation.data()));
+			}
+			if (input.contains("rotation")) {
+				std::vector<float> rotation = input.at("rotation").get<std::vector<float>>();
+				node.matrix *= glm::mat4(glm::make_quat(rotation.data()));
+			}
+			if (input.contains("scale")) {
+				std::vector<float> scale = input.at("scale").get<std::vector<float>>();
+				node.matrix = glm::scale(node.matrix, glm::make_vec3(scale.data()));
+			}
+		}
+		nodes.push_back(std::move(node));
+	}
+	for (const auto& animation : document.value("animations", empty)) {
+		for (const auto& channel : animation.value("channels", empty)) {
+			int32_t target = channel.contains("target") ? channel.at("target").value("node", -1) : -1;
+			if (target >= 0 && static_cast<size_t>(target) < nodes.size()) {
+				nodes[target].animated = true;
+			}
+		}
+	}
+
+	for (const auto& input : document.value("materials", empty)) {
+		Material material;
+		if (input.contains("pbrMetallicRoughness")) {
+			const auto& pbr = input.at("pbrMetallicRoughness");
+			if (pbr.contains("baseColorFactor")) {
+				std::vector<float> factor = pbr.at("baseColorFactor").get<std::vector<float>>();
+				material.baseColorFactor = glm::make_vec4(factor.data());
+			}
+			if (pbr.contains("baseColorTexture")) {
+				material.baseColorTexture = pbr.at("baseColorTexture").value("index", -1);
+			}
+		}
+		materials.push_back(material);
+	}
+
+	for (const auto& input : document.value("textures", empty)) {
+		int32_t source = input.value("source", -1);
+		// KTX2 images are referenced through KHR_texture_basisu, source being the optional fallback
+		if (input.contains("extensions") && input.at("extensions").contains("KHR_texture_basisu")) {
+			source = input.at("extensions").at("KHR_texture_basisu").value("source", source);
+		}
+		textureImages.push_back(source);
+	}
+
+	for (const auto& input : document.value("images", empty)) {
+		Image image;
+		image.bufferView = input.value("bufferView", -1);
+		image.mimeType = input.value("mimeType", std::string{});
+		image.uri = input.value("uri", std::string{});
+		images.push_back(std::move(image));
+	}
+
+	if (document.contains("scenes") && !document.at("scenes").empty()) {
+		uint32_t scene = document.value("scene", 0u);
+		sceneNodes = document.at("scenes").at(scene).value("nodes", std::vector<uint32_t>{});
+	}
+}
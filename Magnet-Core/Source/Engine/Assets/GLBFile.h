@@ -0,0 +1,149 @@
+#pragma once
+#include "../../Commons.h"
+#include "MappedFile.h"
+
+#include <span>
+
+namespace Magnet {
+	namespace EngineBase {
+		namespace Assets {
+
+			// Accessor elements read in place, stride apart
+			template<typename T>
+			class StridedSpan {
+			public:
+				StridedSpan() = default;
+				StridedSpan(const unsigned char* data, size_t count, size_t stride) : data{ data }, count{ count }, stride{ stride } {}
+
+				const T& operator[](size_t index) const { return *reinterpret_cast<const T*>(data + index * stride); }
+				size_t size() const { return count; }
+				bool empty() const { return count == 0; }
+				size_t getStride() const { return stride; }
+				// Tightly packed elements, empty when interleaved
+				std::span<const T> contiguous() const { return stride == sizeof(T) ? std::span<const T>{ reinterpret_cast<const T*>(data), count } : std::span<const T>{}; }
+
+			private:
+				const unsigned char* data = nullptr;
+				size_t count = 0;
+				size_t stride = 0;
+			};
+
+			// Binary glTF mapped in memory. Only the JSON chunk is parsed, into the few structures the engine
+			// uses, buffer data stays in the mapped BIN chunk and accessors are read through typed spans.
+			// Buffers must live in the BIN chunk, external and sparse data is not supported.
+			class GLBFile {
+			public:
+				struct Accessor {
+					int32_t bufferView = -1;
+					size_t byteOffset = 0;
+					size_t count = 0;
+					uint32_t componentType = 0;
+					uint32_t componentCount = 0;
+					// First three components of min and max, glTF requires them on POSITION accessors
+					bool hasBounds = false;
+					glm::vec3 boundsMin{ 0.0f };
+					glm::vec3 boundsMax{ 0.0f };
+				};
+
+				struct BufferView {
+					size_t byteOffset = 0;
+					size_t byteLength = 0;
+					size_t byteStride = 0;
+				};
+
+				struct Primitive {
+					std::unordered_map<std::string, int32_t> attributes;
+					int32_t indices = -1;
+					int32_t material = -1;
+					uint32_t mode = 4;
+
+					int32_t getAttribute(const std::string& name) const {
+						auto attribute = attributes.find(name);
+						return attribute != attributes.end() ? attribute->second : -1;
+					}
+				};
+
+				struct Mesh {
+					std::vector<Primitive> primitives;
+				};
+
+				struct Node {
+					glm::mat4 matrix{ 1.0f };
+					int32_t mesh = -1;
+					std::vector<uint32_t> children;
+					// Skinned or targeted by an animation channel
+					bool animated = false;
+				};
+
+				struct Material {
+					glm::vec4 baseColorFactor{ 1.0f };
+					int32_t baseColorTexture = -1;
+				};
+
+				struct Image {
+					int32_t bufferView = -1;
+					std::string mimeType;
+					std::string uri;
+				};
+
+				static constexpr uint32_t MAGIC = 0x46546C67; // "glTF"
+
+				explicit GLBFile(const std::string& path);
+
+				static bool isGLB(const unsigned char* data, size_t size);
+
+				// Throws when the accessor elements are not T sized or fall outside the BIN chunk
+				template<typename T>
+				StridedSpan<T> getAccessor(int32_t index) const {
+					if (index < 0) {
+						return {};
+					}
+					const Accessor& accessor = accessors.at(index);
+					if (accessor.componentCount * componentSize(accessor.componentType) != sizeof(T)) {
+						throw std::runtime_error("failed to read accessor, unexpected element size!");
+					}
+					const BufferView& view = bufferViews.at(accessor.bufferView);
+					size_t stride = view.byteStride > 0 ? view.byteStride : sizeof(T);
+					if (accessor.count > 0 && accessor.byteOffset + (accessor.count - 1) * stride + sizeof(T) > view.byteLength) {
+						throw std::runtime_error("failed to read accessor, out of its buffer view!");
+					}
+					return StridedSpan<T>{ binChunk.data() + view.byteOffset + accessor.byteOffset, accessor.count, stride };
+				}
+
+				std::span<const unsigned char> getBufferView(int32_t index) const;
+				// Encoded bytes of an image stored in the BIN chunk, empty for external images
+				std::span<const unsigned char> getImageData(size_t index) const;
+
+				static uint32_t componentSize(uint32_t componentType);
+
+				const std::vector<Accessor>& getAccessors() const { return accessors; }
+				const std::vector<Mesh>& getMeshes() const { return meshes; }
+				const std::vector<Node>& getNodes() const { return nodes; }
+				const std::vector<Material>& getMaterials() const { return materials; }
+				// Image of every texture, KHR_texture_basisu first
+				const std::vector<int32_t>& getTextureImages() const { return textureImages; }
+				const std::vector<Image>& getImages() const { return images; }
+				const std::vector<uint32_t>& getSceneNodes() const { return sceneNodes; }
+
+				size_t getFileSize() const { return file.size(); }
+				size_t getJSONSize() const { return jsonSize; }
+
+			private:
+				void parseJSON(const unsigned char* json, size_t size);
+
+				MappedFile file;
+				std::span<const unsigned char> binChunk;
+				size_t jsonSize = 0;
+
+				std::vector<Accessor> accessors;
+				std::vector<BufferView> bufferViews;
+				std::vector<Mesh> meshes;
+				std::vector<Node> nodes;
+				std::vector<Material> materials;
+				std::vector<int32_t> textureImages;
+				std::vector<Image> images;
+				std::vector<uint32_t> sceneNodes;
+			};
+		}
+	}
+}
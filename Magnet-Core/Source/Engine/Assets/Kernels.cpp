@@ -0,0 +1,245 @@
+#include "Kernels.h"
+
+#if defined(MAGNET_KERNELS_AVX2)
+#include <immintrin.h>
+#elif defined(MAGNET_KERNELS_SSE2)
+#include <emmintrin.h>
+#endif
+
+const char* Magnet::EngineBase::Assets::Kernels::getInstructionSet()
+{
+#if defined(MAGNET_KERNELS_AVX2)
+	return "AVX2";
+#elif defined(MAGNET_KERNELS_SSE2)
+	return "SSE2";
+#else
+	return "Scalar";
+#endif
+}
+
+void Magnet::EngineBase::Assets::Kernels::copyAttribute(const void* source, size_t sourceStride, void* destination, size_t destinationStride, size_t elementSize, size_t count)
+{
+	const unsigned char* input = static_cast<const unsigned char*>(source);
+	unsigned char* output = static_cast<unsigned char*>(destination);
+	if (sourceStride == elementSize && destinationStride == elementSize) {
+		memcpy(output, input, elementSize * count);
+		return;
+	}
+	// Fixed size copies of the common attribute sizes compile to plain loads and stores
+	switch (elementSize) {
+	case 8:
+		for (size_t i = 0; i < count; i++) {
+			memcpy(output + i * destinationStride, input + i * sourceStride, 8);
+		}
+		break;
+	case 12:
+		for (size_t i = 0; i < count; i++) {
+			memcpy(output + i * destinationStride, input + i * sourceStride, 12);
+		}
+		break;
+	case 16:
+		for (size_t i = 0; i < count; i++) {
+			memcpy(output + i * destinationStride, input + i * sourceStride, 16);
+		}
+		break;
+	default:
+		for (size_t i = 0; i < count; i++) {
+			memcpy(output + i * destinationStride, input + i * sourceStride, elementSize);
+		}
+		break;
+	}
+}
+
+void Magnet::EngineBase::Assets::Kernels::fillAttribute(const void* value, void* destination, size_t destinationStride, size_t elementSize, size_t count)
+{
+	unsigned char* output = static_cast<unsigned char*>(destination);
+	for (size_t i = 0; i < count; i++) {
+		memcpy(output + i * destinationStride, value, elementSize);
+	}
+}
+
+void Magnet::EngineBase::Assets::Kernels::normalize3(void* data, size_t stride, size_t count)
+{
+	unsigned char* bytes = static_cast<unsigned char*>(data);
+	size_t i = 0;
+
+#if defined(MAGNET_KERNELS_AVX2) || defined(MAGNET_KERNELS_SSE2)
+	// Vectors are transposed to one register per component, the reciprocal square root estimate is refined
+	// with one Newton-Raphson step, close to full float precision
+#if defined(MAGNET_KERNELS_AVX2)
+	constexpr size_t WIDTH = 8;
+	using Register = __m256;
+	auto load = [](const float* values) { return _mm256_loadu_ps(values); };
+	auto store = [](float* values, Register value) { _mm256_storeu_ps(values, value); };
+	auto add = [](Register a, Register b) { return _mm256_add_ps(a, b); };
+	auto multiply = [](Register a, Register b) { return _mm256_mul_ps(a, b); };
+	auto subtract = [](Register a, Register b) { return _mm256_sub_ps(a, b); };
+	auto broadcast = [](float value) { return _mm256_set1_ps(value); };
+	auto rsqrt = [](Register value) { return _mm256_rsqrt_ps(value); };
+	auto nonZero = [](Register value, Register mask) { return _mm256_and_ps(mask, _mm256_cmp_ps(value, _mm256_setzero_ps(), _CMP_GT_OQ)); };
+#else
+	constexpr size_t WIDTH = 4;
+	using Register = __m128;
+	auto load = [](const float* values) { return _mm_loadu_ps(values); };
+	auto store = [](float* values, Register value) { _mm_storeu_ps(values, value); };
+	auto add = [](Register a, Register b) { return _mm_add_ps(a, b); };
+	auto multiply = [](Register a, Register b) { return _mm_mul_ps(a, b); };
+	auto subtract = [](Register a, Register b) { return _mm_sub_ps(a, b); };
+	auto broadcast = [](float value) { return _mm_set1_ps(value); };
+	auto rsqrt = [](Register value) { return _mm_rsqrt_ps(value); };
+	auto nonZero = [](Register value, Register mask) { return _mm_and_ps(mask, _mm_cmpgt_ps(value, _mm_setzero_ps())); };
+#endif
+
+	alignas(32) float x[WIDTH], y[WIDTH], z[WIDTH];
+	for (; i + WIDTH <= count; i += WIDTH) {
+		for (size_t lane = 0; lane < WIDTH; lane++) {
+			const float* vector = reinterpret_cast<const float*>(bytes + (i + lane) * stride);
+			x[lane] = vector[0];
+			y[lane] = vector[1];
+			z[lane] = vector[2];
+		}
+		Register vx = load(x), vy = load(y), vz = load(z);
+		Register lengthSquared = add(add(multiply(vx, vx), multiply(vy, vy)), multiply(vz, vz));
+		Register estimate = rsqrt(lengthSquared);
+		// estimate * (1.5 - 0.5 * lengthSquared * estimate^2)
+		Register inverseLength = multiply(estimate, subtract(broadcast(1.5f), multiply(multiply(broadcast(0.5f), lengthSquared), multiply(estimate, estimate))));
+		inverseLength = nonZero(lengthSquared, inverseLength);
+		store(x, multiply(vx, inverseLength));
+		store(y, multiply(vy, inverseLength));
+		store(z, multiply(vz, inverseLength));
+		for (size_t lane = 0; lane < WIDTH; lane++) {
+			float* vector = reinterpret_cast<float*>(bytes + (i + lane) * stride);
+			vector[0] = x[lane];
+			vector[1] = y[lane];
+			vector[2] = z[lane];
+		}
+	}
+#endif
+
+	for (; i < count; i++) {
+		float* vector = reinterpret_cast<float*>(bytes + i * stride);
+		float lengthSquared = vector[0] * vector[0] + vector[1] * vector[1] + vector[2] * vector[2];
+		float inverseLength = lengthSquared > 0.0f ? 1.0f / std::sqrt(lengthSquared) : 0.0f;
+		vector[0] *= inverseLength;
+		vector[1] *= inverseLength;
+		vector[2] *= inverseLength;
+	}
+}
+
+void Magnet::EngineBase::Assets::Kernels::widenIndices(const uint8_t* source, size_t count, uint32_t base, uint32_t* destination)
+{
+	size_t i = 0;
+#if defined(MAGNET_KERNELS_AVX2)
+	__m256i offset = _mm256_set1_epi32(static_cast<int>(base));
+	for (; i + 8 <= count; i += 8) {
+		__m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source + i));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), _mm256_add_epi32(_mm256_cvtepu8_epi32(bytes), offset));
+	}
+#elif defined(MAGNET_KERNELS_SSE2)
+	__m128i offset = _mm_set1_epi32(static_cast<int>(base));
+	__m128i zero = _mm_setzero_si128();
+	for (; i + 16 <= count; i += 16) {
+		__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+		__m128i low = _mm_unpacklo_epi8(bytes, zero);
+		__m128i high = _mm_unpackhi_epi8(bytes, zero);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_add_epi32(_mm_unpacklo_epi16(low, zero), offset));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i + 4), _mm_add_epi32(_mm_unpackhi_epi16(low, zero), offset));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i + 8), _mm_add_epi32(_mm_unpacklo_epi16(high, zero), offset));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i + 12), _mm_add_epi32(_mm_unpackhi_epi16(high, zero), offset));
+	}
+#endif
+	for (; i < count; i++) {
+		destination[i] = source[i] + base;
+	}
+}
+
+void Magnet::EngineBase::Assets::Kernels::widenIndices(const uint16_t* source, size_t count, uint32_t base, uint32_t* destination)
+{
+	size_t i = 0;
+#if defined(MAGNET_KERNELS_AVX2)
+	__m256i offset = _mm256_set1_epi32(static_cast<int>(base));
+	for (; i + 8 <= count; i += 8) {
+		__m128i shorts = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), _mm256_add_epi32(_mm256_cvtepu16_epi32(shorts), offset));
+	}
+#elif defined(MAGNET_KERNELS_SSE2)
+	__m128i offset = _mm_set1_epi32(static_cast<int>(base));
+	__m128i zero = _mm_setzero_si128();
+	for (; i + 8 <= count; i += 8) {
+		__m128i shorts = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_add_epi32(_mm_unpacklo_epi16(shorts, zero), offset));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i + 4), _mm_add_epi32(_mm_unpackhi_epi16(shorts, zero), offset));
+	}
+#endif
+	for (; i < count; i++) {
+		destination[i] = source[i] + base;
+	}
+}
+
+void Magnet::EngineBase::Assets::Kernels::widenIndices(const uint32_t* source, size_t count, uint32_t base, uint32_t* destination)
+{
+	size_t i = 0;
+#if defined(MAGNET_KERNELS_AVX2)
+	__m256i offset = _mm256_set1_epi32(static_cast<int>(base));
+	for (; i + 8 <= count; i += 8) {
+		__m256i indices = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), _mm256_add_epi32(indices, offset));
+	}
+#elif defined(MAGNET_KERNELS_SSE2)
+	__m128i offset = _mm_set1_epi32(static_cast<int>(base));
+	for (; i + 4 <= count; i += 4) {
+		__m128i indices = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_add_epi32(indices, offset));
+	}
+#endif
+	for (; i < count; i++) {
+		destination[i] = source[i] + base;
+	}
+}
+
+void Magnet::EngineBase::Assets::Kernels::narrowIndices(const uint32_t* source, size_t count, uint32_t base, uint16_t* destination)
+{
+	size_t i = 0;
+#if defined(MAGNET_KERNELS_SSE2)
+	// SSE2 only has a signed 32 to 16 bit saturating pack, values are biased into the signed range around it
+	__m128i offset = _mm_set1_epi32(static_cast<int>(base + 0x8000u));
+	__m128i bias = _mm_set1_epi16(static_cast<short>(0x8000));
+	for (; i + 8 <= count; i += 8) {
+		__m128i low = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i)), offset);
+		__m128i high = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 4)), offset);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_add_epi16(_mm_packs_epi32(low, high), bias));
+	}
+#endif
+	for (; i < count; i++) {
+		destination[i] = static_cast<uint16_t>(source[i] - base);
+	}
+}
+
+void Magnet::EngineBase::Assets::Kernels::expandRGBToRGBA(const uint8_t* rgb, size_t pixelCount, uint8_t* rgba)
+{
+	size_t i = 0;
+#if defined(MAGNET_KERNELS_AVX2)
+	// 4 pixels per shuffle, the 16 byte load reads 4 bytes ahead so the last pixels are left to the scalar loop
+	const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+	for (; i + 6 <= pixelCount; i += 4) {
+		__m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb + i * 3));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + i * 4), _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), alpha));
+	}
+#endif
+	// 4 pixels from three 32 bit loads, shifted into four 32 bit stores
+	for (; i + 4 <= pixelCount; i += 4) {
+		uint32_t words[3];
+		memcpy(words, rgb + i * 3, sizeof(words));
+		uint32_t pixels[4] = {
+			words[0] | 0xFF000000u,
+			(words[0] >> 24) | (words[1] << 8) | 0xFF000000u,
+			(words[1] >> 16) | (words[2] << 16) | 0xFF000000u,
+			(words[2] >> 8) | 0xFF000000u };
+		memcpy(rgba + i * 4, pixels, sizeof(pixels));
+	}
+	for (; i < pixelCount; i++) {
+		uint32_t pixel = uint32_t(rgb[i * 3]) | (uint32_t(rgb[i * 3 + 1]) << 8) | (uint32_t(rgb[i * 3 + 2]) << 16) | 0xFF000000u;
+		memcpy(rgba + i * 4, &pixel, 4);
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "../../Commons.h"
+
+// AVX2 builds (see the avx2 premake option) process 8 elements per instruction, other x64 builds use SSE2
+#if defined(__AVX2__)
+#define MAGNET_KERNELS_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MAGNET_KERNELS_SSE2
+#endif
+
+namespace Magnet {
+	namespace EngineBase {
+		namespace Assets {
+
+			// Conversion kernels of the asset loaders : attribute interleaving, normal normalization, index widening
+			// and narrowing, and RGB expansion. Strides are in bytes so the same kernels read glTF accessors and write any vertex
+			// layout, outputs must be sized for count elements.
+			namespace Kernels {
+				// Instruction set the kernels were built for
+				const char* getInstructionSet();
+
+				// Copies elementSize bytes per element between interleaved or packed streams
+				void copyAttribute(const void* source, size_t sourceStride, void* destination, size_t destinationStride, size_t elementSize, size_t count);
+				// Writes the same value to every element
+				void fillAttribute(const void* value, void* destination, size_t destinationStride, size_t elementSize, size_t count);
+				// Normalizes vec3 elements in place, zero vectors stay zero
+				void normalize3(void* data, size_t stride, size_t count);
+
+				// Widens indices to 32 bits and adds base, for primitives appended to a shared vertex buffer
+				void widenIndices(const uint8_t* source, size_t count, uint32_t base, uint32_t* destination);
+				void widenIndices(const uint16_t* source, size_t count, uint32_t base, uint32_t* destination);
+				void widenIndices(const uint32_t* source, size_t count, uint32_t base, uint32_t* destination);
+				// Subtracts base and narrows to 16 bits, every source index must be in [base, base + 65535]
+				void narrowIndices(const uint32_t* source, size_t count, uint32_t base, uint16_t* destination);
+
+				// RGB8 to RGBA8 with opaque alpha
+				void expandRGBToRGBA(const uint8_t* rgb, size_t pixelCount, uint8_t* rgba);
+			}
+		}
+	}
+}
@@ -0,0 +1,133 @@
+#include "MappedFile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+Magnet::EngineBase::Assets::MappedFile::MappedFile(const std::string& path)
+{
+	open(path);
+}
+
+Magnet::EngineBase::Assets::MappedFile::~MappedFile()
+{
+	close();
+}
+
+Magnet::EngineBase::Assets::MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+Magnet::EngineBase::Assets::MappedFile& Magnet::EngineBase::Assets::MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other) {
+		close();
+		mapped = std::exchange(other.mapped, nullptr);
+		fileSize = std::exchange(other.fileSize, 0);
+		opened = std::exchange(other.opened, false);
+#ifdef _WIN32
+		fileHandle = std::exchange(other.fileHandle, nullptr);
+		mappingHandle = std::exchange(other.mappingHandle, nullptr);
+#else
+		fileDescriptor = std::exchange(other.fileDescriptor, -1);
+#endif
+	}
+	return *this;
+}
+
+void Magnet::EngineBase::Assets::MappedFile::open(const std::string& path)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("failed to open file: " + path);
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size)) {
+		CloseHandle(file);
+		throw std::runtime_error("failed to read file size: " + path);
+	}
+	fileHandle = file;
+	fileSize = static_cast<size_t>(size.QuadPart);
+	opened = true;
+	// Empty files cannot be mapped
+	if (fileSize == 0) {
+		return;
+	}
+	mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mappingHandle == nullptr) {
+		close();
+		throw std::runtime_error("failed to map file: " + path);
+	}
+	mapped = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (mapped == nullptr) {
+		close();
+		throw std::runtime_error("failed to map file: " + path);
+	}
+#else
+	fileDescriptor = ::open(path.c_str(), O_RDONLY);
+	if (fileDescriptor < 0) {
+		throw std::runtime_error("failed to open file: " + path);
+	}
+	struct stat status;
+	if (fstat(fileDescriptor, &status) != 0) {
+		close();
+		throw std::runtime_error("failed to read file size: " + path);
+	}
+	fileSize = static_cast<size_t>(status.st_size);
+	opened = true;
+	if (fileSize == 0) {
+		return;
+	}
+	mapped = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	if (mapped == MAP_FAILED) {
+		mapped = nullptr;
+		close();
+		throw std::runtime_error("failed to map file: " + path);
+	}
+	// The file is read front to back when copied to staging memory
+	madvise(mapped, fileSize, MADV_SEQUENTIAL);
+#endif
+}
+
+void Magnet::EngineBase::Assets::MappedFile::close()
+{
+#ifdef _WIN32
+	if (mapped) {
+		UnmapViewOfFile(mapped);
+	}
+	if (mappingHandle) {
+		CloseHandle(mappingHandle);
+	}
+	if (fileHandle) {
+		CloseHandle(fileHandle);
+	}
+	mappingHandle = nullptr;
+	fileHandle = nullptr;
+#else
+	if (mapped) {
+		munmap(mapped, fileSize);
+	}
+	if (fileDescriptor >= 0) {
+		::close(fileDescriptor);
+	}
+	fileDescriptor = -1;
+#endif
+	mapped = nullptr;
+	fileSize = 0;
+	opened = false;
+}
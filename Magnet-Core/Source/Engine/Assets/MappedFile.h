@@ -0,0 +1,40 @@
+#pragma once
+#include "../../Commons.h"
+
+namespace Magnet {
+	namespace EngineBase {
+		namespace Assets {
+
+			// Read only memory mapping of a whole file, pages are loaded by the OS on first access
+			class MappedFile {
+			public:
+				MappedFile() = default;
+				explicit MappedFile(const std::string& path);
+				~MappedFile();
+
+				MappedFile(const MappedFile&) = delete;
+				MappedFile& operator=(const MappedFile&) = delete;
+				MappedFile(MappedFile&& other) noexcept;
+				MappedFile& operator=(MappedFile&& other) noexcept;
+
+				void open(const std::string& path);
+				void close();
+
+				bool isOpen() const { return opened; }
+				const unsigned char* data() const { return static_cast<const unsigned char*>(mapped); }
+				size_t size() const { return fileSize; }
+
+			private:
+				void* mapped = nullptr;
+				size_t fileSize = 0;
+				bool opened = false;
+#ifdef _WIN32
+				void* fileHandle = nullptr;
+				void* mappingHandle = nullptr;
+#else
+				int fileDescriptor = -1;
+#endif
+			};
+		}
+	}
+}
@@ -0,0 +1,115 @@
+#include "MeshFile.h"
+#include "PackedVertex.h"
+
+static_assert(sizeof(Magnet::EngineBase::Assets::MeshFile::Header) == 128, "Cooked header layout changed, bump MeshFile::VERSION");
+static_assert(sizeof(Magnet::EngineBase::Assets::MeshFile::Submesh) == 44, "Cooked submesh layout changed, bump MeshFile::VERSION");
+static_assert(sizeof(Magnet::EngineBase::Assets::MeshFile::Lod) == 16, "Cooked LOD layout changed, bump MeshFile::VERSION");
+static_assert(sizeof(Magnet::EngineBase::Assets::MeshFile::Material) == 256, "Cooked material layout changed, bump MeshFile::VERSION");
+
+namespace {
+	uint64_t alignOffset(uint64_t offset, uint64_t alignment)
+	{
+		return (offset + alignment - 1) / alignment * alignment;
+	}
+}
+
+Magnet::EngineBase::Assets::MeshFile::MeshFile(const std::string& path) : file{ path }
+{
+	if (file.size() < sizeof(Header)) {
+		throw std::runtime_error("failed to load mesh file, truncated header: " + path);
+	}
+	header = reinterpret_cast<const Header*>(file.data());
+	if (header->magic != MAGIC || header->version != VERSION || header->vertexStride != sizeof(PackedVertex)) {
+		throw std::runtime_error("failed to load mesh file, unsupported version: " + path);
+	}
+	if (header->colorCount != 1 && header->colorCount != header->vertexCount) {
+		throw std::runtime_error("failed to load mesh file, invalid color count: " + path);
+	}
+
+	auto fits = [this](uint64_t offset, uint64_t size) { return offset <= file.size() && size <= file.size() - offset; };
+	if (!fits(header->submeshOffset, uint64_t(header->submeshCount) * sizeof(Submesh)) ||
+		!fits(header->materialOffset, uint64_t(header->materialCount) * sizeof(Material)) ||
+		!fits(header->lodOffset, uint64_t(header->lodCount) * sizeof(Lod)) ||
+		!fits(header->vertexOffset, getVertexBytes()) ||
+		!fits(header->colorOffset, getColorBytes()) ||
+		!fits(header->indexOffset, getIndexBytes())) {
+		throw std::runtime_error("failed to load mesh file, truncated data: " + path);
+	}
+}
+
+void Magnet::EngineBase::Assets::MeshFile::write(const std::string& path, const Data& data)
+{
+	Header fileHeader{};
+	fileHeader.magic = MAGIC;
+	fileHeader.version = VERSION;
+	fileHeader.vertexStride = sizeof(PackedVertex);
+	fileHeader.vertexCount = static_cast<uint32_t>(data.vertices.size());
+	fileHeader.indexCount = static_cast<uint32_t>(data.indices.size());
+	fileHeader.submeshCount = static_cast<uint32_t>(data.submeshes.size());
+	fileHeader.materialCount = static_cast<uint32_t>(data.materials.size());
+	fileHeader.lodCount = static_cast<uint32_t>(data.lods.size());
+	fileHeader.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+	fileHeader.boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+	for (const auto& submesh : data.submeshes) {
+		fileHeader.boundsMin = glm::min(fileHeader.boundsMin, submesh.boundsMin);
+		fileHeader.boundsMax = glm::max(fileHeader.boundsMax, submesh.boundsMax);
+	}
+	// Vertices no submesh references must fit the box too
+	glm::vec3 vertexMin{ std::numeric_limits<float>::max() };
+	glm::vec3 vertexMax{ std::numeric_limits<float>::lowest() };
+	for (const auto& vertex : data.vertices) {
+		vertexMin = glm::min(vertexMin, vertex.pos);
+		vertexMax = glm::max(vertexMax, vertex.pos);
+	}
+	fileHeader.quantization = PackedVertex::getQuantization(vertexMin, vertexMax);
+	std::vector<uint32_t> colors = PackedVertex::packColors(data.vertices.data(), data.vertices.size());
+	fileHeader.colorCount = static_cast<uint32_t>(colors.size());
+
+	fileHeader.submeshOffset = sizeof(Header);
+	fileHeader.materialOffset = fileHeader.submeshOffset + data.submeshes.size() * sizeof(Submesh);
+	fileHeader.lodOffset = fileHeader.materialOffset + data.materials.size() * sizeof(Material);
+	fileHeader.vertexOffset = alignOffset(fileHeader.lodOffset + data.lods.size() * sizeof(Lod), BLOB_ALIGNMENT);
+	fileHeader.colorOffset = alignOffset(fileHeader.vertexOffset + data.vertices.size() * sizeof(PackedVertex), BLOB_ALIGNMENT);
+	fileHeader.indexOffset = alignOffset(fileHeader.colorOffset + colors.size() * sizeof(uint32_t), BLOB_ALIGNMENT);
+
+	std::vector<char> bytes(fileHeader.indexOffset + data.indices.size() * sizeof(uint32_t), 0);
+	memcpy(bytes.data(), &fileHeader, sizeof(Header));
+	memcpy(bytes.data() + fileHeader.submeshOffset, data.submeshes.data(), data.submeshes.size() * sizeof(Submesh));
+	memcpy(bytes.data() + fileHeader.materialOffset, data.materials.data(), data.materials.size() * sizeof(Material));
+	memcpy(bytes.data() + fileHeader.lodOffset, data.lods.data(), data.lods.size() * sizeof(Lod));
+	PackedVertex::pack(data.vertices.data(), data.vertices.size(), fileHeader.quantization, reinterpret_cast<PackedVertex*>(bytes.data() + fileHeader.vertexOffset));
+	memcpy(bytes.data() + fileHeader.colorOffset, colors.data(), colors.size() * sizeof(uint32_t));
+	memcpy(bytes.data() + fileHeader.indexOffset, data.indices.data(), data.indices.size() * sizeof(uint32_t));
+
+	std::ofstream output{ path, std::ios::binary | std::ios::trunc };
+	if (!output.is_open()) {
+		throw std::runtime_error("failed to open file: " + path);
+	}
+	output.write(bytes.data(), bytes.size());
+}
+
+std::string Magnet::EngineBase::Assets::MeshFile::getCookedPath(const std::string& sourcePath)
+{
+	return std::filesystem::path(sourcePath).replace_extension(EXTENSION).string();
+}
+
+bool Magnet::EngineBase::Assets::MeshFile::isUpToDate(const std::string& sourcePath)
+{
+	std::error_code error;
+	std::string cookedPath = getCookedPath(sourcePath);
+	if (!std::filesystem::exists(cookedPath, error)) {
+		return false;
+	}
+	// Files of an older version are cooked again
+	uint32_t identification[2] = {};
+	std::ifstream cooked{ cookedPath, std::ios::binary };
+	if (!cooked.read(reinterpret_cast<char*>(identification), sizeof(identification)) || identification[0] != MAGIC || identification[1] != VERSION) {
+		return false;
+	}
+	auto sourceTime = std::filesystem::last_write_time(sourcePath, error);
+	if (error) {
+		// Only the cooked file was shipped
+		return true;
+	}
+	return std::filesystem::last_write_time(cookedPath, error) >= sourceTime;
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include "../../Commons.h"
+#include "MappedFile.h"
+
+namespace Magnet {
+	namespace EngineBase {
+		namespace Assets {
+
+			struct PackedVertex;
+
+			// Cooked mesh, written by Magnet-Cooker and memory mapped at runtime.
+			// Layout : Header, Submesh table, Material table, LOD table, vertex blob, color blob, index blob. Blobs start on a
+			// BLOB_ALIGNMENT boundary and are stored exactly as the GPU reads them : PackedVertex quantized to the header's box,
+			// RGBA8 colors and 32-bit indices. Loading is a copy from the mapping to staging memory with no parsing.
+			class MeshFile {
+			public:
+				static constexpr uint32_t MAGIC = 0x48534D4D; // "MMSH"
+				static constexpr uint32_t VERSION = 3;
+				static constexpr uint64_t BLOB_ALIGNMENT = 256;
+				static constexpr const char* EXTENSION = ".mesh";
+
+				// Vertex of the importer and the cooking passes, packed when written
+				struct Vertex {
+					glm::vec3 pos;
+					glm::vec3 normal;
+					glm::vec2 uv;
+					glm::vec3 color;
+				};
+
+				struct Header {
+					uint32_t magic;
+					uint32_t version;
+					uint32_t vertexStride;
+					uint32_t vertexCount;
+					uint32_t indexCount;
+					uint32_t submeshCount;
+					uint32_t materialCount;
+					uint32_t lodCount;
+					// A single color is stored when every vertex has it
+					uint32_t colorCount;
+					uint32_t reserved;
+					glm::vec3 boundsMin;
+					glm::vec3 boundsMax;
+					// Box the vertex positions are quantized to, see PackedVertex::getQuantization
+					glm::vec4 quantization;
+					uint64_t submeshOffset;
+					uint64_t materialOffset;
+					uint64_t lodOffset;
+					uint64_t vertexOffset;
+					uint64_t colorOffset;
+					uint64_t indexOffset;
+				};
+
+				// One draw, indices already point into the whole vertex blob
+				struct Submesh {
+					uint32_t firstIndex;
+					uint32_t indexCount;
+					int32_t materialIndex;
+					// Coarser levels in the LOD table, from the finest
+					uint32_t firstLod;
+					uint32_t lodCount;
+					glm::vec3 boundsMin;
+					glm::vec3 boundsMax;
+				};
+
+				// Simplified indices of a submesh, over the same vertices
+				struct Lod {
+					uint32_t firstIndex;
+					uint32_t indexCount;
+					// Largest distance the level moves the surface by, in mesh space
+					float error;
+					uint32_t reserved;
+				};
+
+				struct Material {
+					glm::vec4 baseColorFactor;
+					// Relative to the mesh file, empty without texture
+					char baseColorTexture[240];
+				};
+
+				// Geometry as imported, before it is written
+				struct Data {
+					std::vector<Vertex> vertices;
+					std::vector<uint32_t> indices;
+					std::vector<Submesh> submeshes;
+					std::vector<Material> materials;
+					std::vector<Lod> lods;
+				};
+
+				// Maps the file and checks its header, throws on invalid files
+				explicit MeshFile(const std::string& path);
+
+				static void write(const std::string& path, const Data& data);
+				// Next to the source, with the .mesh extension
+				static std::string getCookedPath(const std::string& sourcePath);
+				// The cooked file exists, has the current version and is not older than its source
+				static bool isUpToDate(const std::string& sourcePath);
+
+				const Header& getHeader() const { return *header; }
+				const PackedVertex* getVertices() const { return reinterpret_cast<const PackedVertex*>(file.data() + header->vertexOffset); }
+				const uint32_t* getColors() const { return reinterpret_cast<const uint32_t*>(file.data() + header->colorOffset); }
+				const uint32_t* getIndices() const { return reinterpret_cast<const uint32_t*>(file.data() + header->indexOffset); }
+				const Submesh* getSubmeshes() const { return reinterpret_cast<const Submesh*>(file.data() + header->submeshOffset); }
+				const Material* getMaterials() const { return reinterpret_cast<const Material*>(file.data() + header->materialOffset); }
+				const Lod* getLods() const { return reinterpret_cast<const Lod*>(file.data() + header->lodOffset); }
+				VkDeviceSize getVertexBytes() const { return VkDeviceSize(header->vertexCount) * header->vertexStride; }
+				VkDeviceSize getColorBytes() const { return VkDeviceSize(header->colorCount) * sizeof(uint32_t); }
+				VkDeviceSize getIndexBytes() const { return VkDeviceSize(header->indexCount) * sizeof(uint32_t); }
+				size_t getFileSize() const { return file.size(); }
+
+			private:
+				MappedFile file;
+				const Header* header = nullptr;
+			};
+		}
+	}
+}
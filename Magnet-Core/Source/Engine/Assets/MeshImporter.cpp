@@ -0,0 +1,284 @@
+#include "MeshImporter.h"
+#include "OBJFile.h"
+
+#include <tinygltf/tiny_gltf.h>
+
+namespace {
+	using Magnet::EngineBase::Assets::MeshFile;
+
+	std::string getExtension(const std::string& path)
+	{
+		std::string extension = std::filesystem::path(path).extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return extension;
+	}
+
+	MeshFile::Material makeMaterial(const glm::vec4& baseColorFactor, const std::string& baseColorTexture)
+	{
+		MeshFile::Material material{};
+		material.baseColorFactor = baseColorFactor;
+		if (baseColorTexture.size() >= sizeof(material.baseColorTexture)) {
+			throw std::runtime_error("failed to cook material, texture path too long: " + baseColorTexture);
+		}
+		memcpy(material.baseColorTexture, baseColorTexture.c_str(), baseColorTexture.size());
+		return material;
+	}
+
+	MeshFile::Submesh makeSubmesh(const MeshFile::Data& data, uint32_t firstIndex, uint32_t indexCount, int32_t materialIndex)
+	{
+		MeshFile::Submesh submesh{};
+		submesh.firstIndex = firstIndex;
+		submesh.indexCount = indexCount;
+		submesh.materialIndex = materialIndex;
+		submesh.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+		submesh.boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+		for (uint32_t i = firstIndex; i < firstIndex + indexCount; i++) {
+			submesh.boundsMin = glm::min(submesh.boundsMin, data.vertices[data.indices[i]].pos);
+			submesh.boundsMax = glm::max(submesh.boundsMax, data.vertices[data.indices[i]].pos);
+		}
+		return submesh;
+	}
+
+	// Float attribute of a glTF primitive, honouring the view stride
+	struct AttributeReader {
+		const unsigned char* data = nullptr;
+		size_t stride = 0;
+
+		AttributeReader(const tinygltf::Model& model, const tinygltf::Primitive& primitive, const char* name, uint32_t components, size_t& count)
+		{
+			auto attribute = primitive.attributes.find(name);
+			if (attribute == primitive.attributes.end()) {
+				return;
+			}
+			const tinygltf::Accessor& accessor = model.accessors[attribute->second];
+			if (accessor.bufferView < 0 || accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT) {
+				return;
+			}
+			const tinygltf::BufferView& view = model.bufferViews[accessor.bufferView];
+			data = &model.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset];
+			stride = view.byteStride > 0 ? view.byteStride : components * sizeof(float);
+			count = accessor.count;
+		}
+
+		const float* operator[](size_t index) const { return reinterpret_cast<const float*>(data + index * stride); }
+		explicit operator bool() const { return data != nullptr; }
+	};
+
+	// Keeps the encoded bytes, the cooker only references images
+	bool keepImageBytes(tinygltf::Image* image, const int /*imageIndex*/, std::string* /*error*/, std::string* /*warning*/, int /*requestedWidth*/, int /*requestedHeight*/, const unsigned char* bytes, int size, void* /*userData*/)
+	{
+		image->image.assign(bytes, bytes + size);
+		return true;
+	}
+
+	void importglTFNode(const tinygltf::Model& model, int nodeIndex, const glm::mat4& parentMatrix, MeshFile::Data& data)
+	{
+		const tinygltf::Node& node = model.nodes[nodeIndex];
+		glm::mat4 matrix = parentMatrix;
+		if (node.matrix.size() == 16) {
+			matrix *= glm::mat4(glm::make_mat4x4(node.matrix.data()));
+		}
+		else {
+			if (node.translation.size() == 3) {
+				matrix = glm::translate(matrix, glm::vec3(glm::make_vec3(node.translation.data())));
+			}
+			if (node.rotation.size() == 4) {
+				matrix *= glm::mat4(glm::quat(glm::make_quat(node.rotation.data())));
+			}
+			if (node.scale.size() == 3) {
+				matrix = glm::scale(matrix, glm::vec3(glm::make_vec3(node.scale.data())));
+			}
+		}
+		glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(matrix)));
+
+		if (node.mesh > -1) {
+			for (const tinygltf::Primitive& primitive : model.meshes[node.mesh].primitives) {
+				if (primitive.mode != TINYGLTF_MODE_TRIANGLES) {
+					continue;
+				}
+				size_t vertexCount = 0, unused = 0;
+				AttributeReader positions{ model, primitive, "POSITION", 3, vertexCount };
+				AttributeReader normals{ model, primitive, "NORMAL", 3, unused };
+				AttributeReader texCoords{ model, primitive, "TEXCOORD_0", 2, unused };
+				if (!positions) {
+					continue;
+				}
+
+				uint32_t vertexStart = static_cast<uint32_t>(data.vertices.size());
+				uint32_t firstIndex = static_cast<uint32_t>(data.indices.size());
+				for (size_t v = 0; v < vertexCount; v++) {
+					MeshFile::Vertex vertex{};
+					vertex.pos = glm::vec3(matrix * glm::vec4(glm::make_vec3(positions[v]), 1.0f));
+					vertex.normal = normals ? glm::normalize(normalMatrix * glm::make_vec3(normals[v])) : glm::vec3(0.0f);
+					vertex.uv = texCoords ? glm::make_vec2(texCoords[v]) : glm::vec2(0.0f);
+					vertex.color = glm::vec3(1.0f);
+					data.vertices.push_back(vertex);
+				}
+
+				if (primitive.indices > -1) {
+					const tinygltf::Accessor& accessor = model.accessors[primitive.indices];
+					const tinygltf::BufferView& view = model.bufferViews[accessor.bufferView];
+					const unsigned char* indices = &model.buffers[view.buffer].data[accessor.byteOffset + view.byteOffset];
+					for (size_t i = 0; i < accessor.count; i++) {
+						switch (accessor.componentType) {
+						case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT:
+							data.indices.push_back(reinterpret_cast<const uint32_t*>(indices)[i] + vertexStart);
+							break;
+						case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT:
+							data.indices.push_back(reinterpret_cast<const uint16_t*>(indices)[i] + vertexStart);
+							break;
+						case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE:
+							data.indices.push_back(indices[i] + vertexStart);
+							break;
+						default:
+							throw std::runtime_error("failed to import glTF, unsupported index type!");
+						}
+					}
+				}
+				else {
+					for (uint32_t i = 0; i < vertexCount; i++) {
+						data.indices.push_back(vertexStart + i);
+					}
+				}
+				data.submeshes.push_back(makeSubmesh(data, firstIndex, static_cast<uint32_t>(data.indices.size()) - firstIndex, primitive.material));
+			}
+		}
+
+		for (int child : node.children) {
+			importglTFNode(model, child, matrix, data);
+		}
+	}
+}
+
+bool Magnet::EngineBase::Assets::MeshImporter::isSupported(const std::string& path)
+{
+	std::string extension = getExtension(path);
+	return extension == ".obj" || extension == ".gltf" || extension == ".glb";
+}
+
+Magnet::EngineBase::Assets::MeshImporter::Result Magnet::EngineBase::Assets::MeshImporter::importOBJ(const std::string& path)
+{
+	OBJFile file{ path, OBJFile::Settings{} };
+
+	Result result;
+	MeshFile::Data& data = result.data;
+	for (const auto& material : file.getMaterials()) {
+		data.materials.push_back(makeMaterial(material.diffuse, material.diffuseTexture));
+	}
+	// Faces without material
+	int32_t defaultMaterial = static_cast<int32_t>(data.materials.size());
+	data.materials.push_back(makeMaterial(glm::vec4(1.0f), ""));
+
+	data.vertices = std::move(file.getVertices());
+	data.indices = std::move(file.getIndices());
+	for (const auto& submesh : file.getSubmeshes()) {
+		data.submeshes.push_back(makeSubmesh(data, submesh.firstIndex, submesh.indexCount, submesh.material >= 0 ? submesh.material : defaultMaterial));
+	}
+	return result;
+}
+
+Magnet::EngineBase::Assets::MeshImporter::Result Magnet::EngineBase::Assets::MeshImporter::importglTF(const std::string& path)
+{
+	tinygltf::Model model;
+	tinygltf::TinyGLTF context;
+	std::string error, warning;
+	context.SetImageLoader(keepImageBytes, nullptr);
+	bool loaded = getExtension(path) == ".glb"
+		? context.LoadBinaryFromFile(&model, &error, &warning, path)
+		: context.LoadASCIIFromFile(&model, &error, &warning, path);
+	if (!loaded) {
+		throw std::runtime_error("failed to load glTF file: " + path + " " + error);
+	}
+
+	Result result;
+	MeshFile::Data& data = result.data;
+
+	// Images are referenced by path, embedded ones are extracted next to the cooked mesh
+	std::vector<std::string> imagePaths(model.images.size());
+	std::filesystem::path source{ path };
+	for (size_t i = 0; i < model.images.size(); i++) {
+		const tinygltf::Image& image = model.images[i];
+		bool embedded = image.uri.empty() || image.uri.rfind("data:", 0) == 0;
+		if (!embedded) {
+			imagePaths[i] = image.uri;
+			continue;
+		}
+		std::string extension = image.mimeType == "image/jpeg" ? ".jpg" : image.mimeType == "image/ktx2" ? ".ktx2" : ".png";
+		imagePaths[i] = source.stem().string() + ".image" + std::to_string(i) + extension;
+		result.images.push_back({ (source.parent_path() / imagePaths[i]).string(), image.image });
+	}
+
+	for (const tinygltf::Material& glTFMaterial : model.materials) {
+		glm::vec4 baseColor{ 1.0f };
+		std::string texture;
+		const auto& pbr = glTFMaterial.pbrMetallicRoughness;
+		if (pbr.baseColorFactor.size() == 4) {
+			baseColor = glm::make_vec4(pbr.baseColorFactor.data());
+		}
+		if (pbr.baseColorTexture.index > -1) {
+			const tinygltf::Texture& glTFTexture = model.textures[pbr.baseColorTexture.index];
+			int imageIndex = glTFTexture.source;
+			auto basisu = glTFTexture.extensions.find("KHR_texture_basisu");
+			if (basisu != glTFTexture.extensions.end() && basisu->second.Has("source")) {
+				imageIndex = basisu->second.Get("source").GetNumberAsInt();
+			}
+			if (imageIndex > -1) {
+				texture = imagePaths[imageIndex];
+			}
+		}
+		data.materials.push_back(makeMaterial(baseColor, texture));
+	}
+	// Primitives without material
+	int32_t defaultMaterial = static_cast<int32_t>(data.materials.size());
+	data.materials.push_back(makeMaterial(glm::vec4(1.0f), ""));
+
+	int sceneIndex = model.defaultScene > -1 ? model.defaultScene : 0;
+	if (model.scenes.empty()) {
+		throw std::runtime_error("failed to import glTF file, no scene: " + path);
+	}
+	for (int node : model.scenes[sceneIndex].nodes) {
+		importglTFNode(model, node, glm::mat4(1.0f), data);
+	}
+	for (auto& submesh : data.submeshes) {
+		if (submesh.materialIndex < 0) {
+			submesh.materialIndex = defaultMaterial;
+		}
+	}
+	return result;
+}
+
+Magnet::EngineBase::Assets::MeshImporter::Result Magnet::EngineBase::Assets::MeshImporter::import(const std::string& path)
+{
+	if (getExtension(path) == ".obj") {
+		return importOBJ(path);
+	}
+	if (isSupported(path)) {
+		return importglTF(path);
+	}
+	throw std::runtime_error("failed to import mesh, unsupported format: " + path);
+}
+
+std::string Magnet::EngineBase::Assets::MeshImporter::cookToCache(const std::string& sourcePath, bool force, MeshOptimizer* optimizer, MeshSimplifier* simplifier)
+{
+	std::string cookedPath = MeshFile::getCookedPath(sourcePath);
+	if (!force && MeshFile::isUpToDate(sourcePath)) {
+		return cookedPath;
+	}
+
+	Result result = import(sourcePath);
+	for (const auto& image : result.images) {
+		std::ofstream output{ image.path, std::ios::binary | std::ios::trunc };
+		if (!output.is_open()) {
+			throw std::runtime_error("failed to open file: " + image.path);
+		}
+		output.write(reinterpret_cast<const char*>(image.bytes.data()), image.bytes.size());
+	}
+	if (simplifier) {
+		simplifier->generateLods(result.data);
+	}
+	if (optimizer) {
+		optimizer->optimize(result.data);
+	}
+	MeshFile::write(cookedPath, result.data);
+	return cookedPath;
+}
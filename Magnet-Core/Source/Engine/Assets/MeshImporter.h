@@ -0,0 +1,39 @@
+#pragma once
+#include "../../Commons.h"
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+
+namespace Magnet {
+	namespace EngineBase {
+		namespace Assets {
+
+			// Converts OBJ and glTF (.gltf and .glb) files to the cooked mesh format.
+			// glTF node transforms are baked into the vertices, every primitive becomes a submesh. OBJ files are parsed
+			// by OBJFile, faces are split by object or group and material, and vertices shared by faces are deduplicated.
+			class MeshImporter {
+			public:
+				// Images embedded in a glTF file, written next to the cooked mesh
+				struct EmbeddedImage {
+					std::string path;
+					std::vector<unsigned char> bytes;
+				};
+
+				struct Result {
+					MeshFile::Data data;
+					std::vector<EmbeddedImage> images;
+				};
+
+				static bool isSupported(const std::string& path);
+
+				static Result importOBJ(const std::string& path);
+				static Result importglTF(const std::string& path);
+				static Result import(const std::string& path);
+
+				// Path of the cooked file, imported and written when missing, older than the source or forced.
+				// Geometry gets its LOD chain from the simplifier, then goes through the optimizer, when there are ones
+				static std::string cookToCache(const std::string& sourcePath, bool force = false, MeshOptimizer* optimizer = nullptr, MeshSimplifier* simplifier = nullptr);
+			};
+		}
+	}
+}
@@ -0,0 +1,321 @@
+#include "MeshOptimizer.h"
+#include "../Parallel.h"
+
+namespace {
+	// Forsyth's tuned constants, the cache being modelled as LRU for scoring only
+	constexpr uint32_t SCORE_CACHE_SIZE = 32;
+	constexpr uint32_t SCORE_VALENCE_SIZE = 32;
+	constexpr float CACHE_DECAY_POWER = 1.5f;
+	constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+	constexpr float VALENCE_BOOST_SCALE = 2.0f;
+	constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+	struct ScoreTable {
+		float cache[SCORE_CACHE_SIZE];
+		float valence[SCORE_VALENCE_SIZE];
+
+		ScoreTable()
+		{
+			for (uint32_t i = 0; i < SCORE_CACHE_SIZE; i++) {
+				// The three vertices of the last triangle get a fixed score, so it isn't reused right away
+				cache[i] = i < 3 ? LAST_TRIANGLE_SCORE : std::pow(1.0f - float(i - 3) / (SCORE_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+			}
+			valence[0] = 0.0f;
+			for (uint32_t i = 1; i < SCORE_VALENCE_SIZE; i++) {
+				valence[i] = VALENCE_BOOST_SCALE * std::pow(float(i), -VALENCE_BOOST_POWER);
+			}
+		}
+
+		// Vertices with few triangles left are favoured, so isolated triangles don't linger
+		float getScore(int32_t cachePosition, uint32_t remaining) const
+		{
+			if (remaining == 0) {
+				return -1.0f;
+			}
+			float score = cachePosition >= 0 ? cache[cachePosition] : 0.0f;
+			return score + (remaining < SCORE_VALENCE_SIZE ? valence[remaining] : VALENCE_BOOST_SCALE * std::pow(float(remaining), -VALENCE_BOOST_POWER));
+		}
+	};
+
+	const ScoreTable scoreTable;
+}
+
+void Magnet::EngineBase::Assets::MeshOptimizer::optimize(MeshFile::Data& data)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	// Submeshes and their LOD levels own disjoint index ranges
+	std::vector<std::pair<uint32_t, uint32_t>> ranges;
+	for (const auto& submesh : data.submeshes) {
+		ranges.emplace_back(submesh.firstIndex, submesh.indexCount);
+	}
+	for (const auto& lod : data.lods) {
+		ranges.emplace_back(lod.firstIndex, lod.indexCount);
+	}
+	auto analyze = [&](CacheStats& total) {
+		for (const auto& [firstIndex, indexCount] : ranges) {
+			CacheStats rangeStats = analyzeVertexCache(data.indices.data() + firstIndex, indexCount, data.vertices.size(), settings.cacheSize);
+			total.triangles += rangeStats.triangles;
+			total.vertices += rangeStats.vertices;
+			total.misses += rangeStats.misses;
+		}
+	};
+	analyze(stats.before);
+
+	parallelFor(ranges.size(), [&](size_t i) {
+		uint32_t* indices = data.indices.data() + ranges[i].first;
+		optimizeVertexCache(indices, ranges[i].second, data.vertices.size());
+		if (settings.overdraw) {
+			optimizeOverdraw(indices, ranges[i].second, data.vertices.data(), data.vertices.size(), settings.overdrawThreshold, settings.cacheSize);
+		}
+	});
+	optimizeVertexFetch(data.vertices, data.indices);
+
+	analyze(stats.after);
+	stats.meshes++;
+	stats.optimizeTimeMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void Magnet::EngineBase::Assets::MeshOptimizer::optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount)
+{
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount < 2) {
+		return;
+	}
+
+	// Triangles of each vertex, the first remaining[v] entries being the ones not emitted yet
+	std::vector<uint32_t> remaining(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; i++) {
+		remaining[indices[i]]++;
+	}
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; v++) {
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remaining[v];
+	}
+	std::vector<uint32_t> adjacency(triangleCount * 3);
+	std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (size_t i = 0; i < triangleCount * 3; i++) {
+		adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	std::vector<int32_t> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++) {
+		vertexScores[v] = scoreTable.getScore(-1, remaining[v]);
+	}
+	std::vector<float> triangleScores(triangleCount);
+	for (size_t t = 0; t < triangleCount; t++) {
+		triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+	}
+
+	std::vector<uint32_t> output(triangleCount * 3);
+	std::vector<uint8_t> emitted(triangleCount, 0);
+	std::array<uint32_t, SCORE_CACHE_SIZE + 3> cache;
+	std::array<uint32_t, SCORE_CACHE_SIZE + 3> newCache;
+	size_t cacheCount = 0;
+	size_t cursor = 0;
+	int64_t best = -1;
+	for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+		// Nothing left around the cache, restart from the next triangle in input order
+		if (best < 0) {
+			while (emitted[cursor]) {
+				cursor++;
+			}
+			best = static_cast<int64_t>(cursor);
+		}
+		const uint32_t* triangle = indices + best * 3;
+		memcpy(&output[emittedCount * 3], triangle, 3 * sizeof(uint32_t));
+		emitted[best] = 1;
+
+		// Drop the triangle from the remaining lists and put its vertices in front of the cache
+		size_t newCount = 0;
+		for (uint32_t corner = 0; corner < 3; corner++) {
+			uint32_t vertex = triangle[corner];
+			uint32_t* triangles = &adjacency[adjacencyOffsets[vertex]];
+			for (uint32_t i = 0; i < remaining[vertex]; i++) {
+				if (triangles[i] == best) {
+					std::swap(triangles[i], triangles[remaining[vertex] - 1]);
+					remaining[vertex]--;
+					break;
+				}
+			}
+			if (std::find(newCache.begin(), newCache.begin() + newCount, vertex) == newCache.begin() + newCount) {
+				newCache[newCount++] = vertex;
+			}
+		}
+		for (size_t i = 0; i < cacheCount; i++) {
+			if (std::find(triangle, triangle + 3, cache[i]) == triangle + 3) {
+				newCache[newCount++] = cache[i];
+			}
+		}
+
+		// Rescore every vertex whose position changed, including the ones pushed out, then their triangles
+		for (size_t i = 0; i < newCount; i++) {
+			uint32_t vertex = newCache[i];
+			cachePositions[vertex] = i < SCORE_CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+			vertexScores[vertex] = scoreTable.getScore(cachePositions[vertex], remaining[vertex]);
+		}
+		best = -1;
+		float bestScore = -std::numeric_limits<float>::max();
+		for (size_t i = 0; i < newCount; i++) {
+			uint32_t vertex = newCache[i];
+			const uint32_t* triangles = &adjacency[adjacencyOffsets[vertex]];
+			for (uint32_t j = 0; j < remaining[vertex]; j++) {
+				uint32_t t = triangles[j];
+				triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+				if (triangleScores[t] > bestScore) {
+					bestScore = triangleScores[t];
+					best = t;
+				}
+			}
+		}
+		cacheCount = std::min<size_t>(newCount, SCORE_CACHE_SIZE);
+		std::copy(newCache.begin(), newCache.begin() + cacheCount, cache.begin());
+	}
+	memcpy(indices, output.data(), output.size() * sizeof(uint32_t));
+}
+
+void Magnet::EngineBase::Assets::MeshOptimizer::optimizeOverdraw(uint32_t* indices, size_t indexCount, const MeshFile::Vertex* vertices, size_t vertexCount, float threshold, uint32_t cacheSize)
+{
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount < 2) {
+		return;
+	}
+
+	// FIFO cache, a vertex is cached while fewer than cacheSize misses happened since it was loaded
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	uint32_t time = cacheSize + 1;
+	auto countMisses = [&](size_t t) {
+		uint32_t misses = 0;
+		for (uint32_t corner = 0; corner < 3; corner++) {
+			uint32_t vertex = indices[t * 3 + corner];
+			if (time - timestamps[vertex] > cacheSize) {
+				timestamps[vertex] = time++;
+				misses++;
+			}
+		}
+		return misses;
+	};
+
+	// Hard boundaries : the cache optimized order restarts from scratch, every vertex missing
+	std::vector<size_t> hardBoundaries;
+	uint64_t totalMisses = 0;
+	for (size_t t = 0; t < triangleCount; t++) {
+		uint32_t misses = countMisses(t);
+		if (t == 0 || misses == 3) {
+			hardBoundaries.push_back(t);
+		}
+		totalMisses += misses;
+	}
+	hardBoundaries.push_back(triangleCount);
+	double targetACMR = threshold * double(totalMisses) / triangleCount;
+
+	// Soft boundaries : clusters drawn in any order start with a cold cache, cut once that costs little enough
+	std::vector<size_t> clusters;
+	for (size_t h = 0; h + 1 < hardBoundaries.size(); h++) {
+		size_t clusterStart = hardBoundaries[h];
+		clusters.push_back(clusterStart);
+		time += cacheSize + 1;
+		uint64_t clusterMisses = 0;
+		for (size_t t = clusterStart; t < hardBoundaries[h + 1]; t++) {
+			clusterMisses += countMisses(t);
+			if (t + 1 < hardBoundaries[h + 1] && clusterMisses <= targetACMR * (t + 1 - clusterStart)) {
+				clusterStart = t + 1;
+				clusters.push_back(clusterStart);
+				time += cacheSize + 1;
+				clusterMisses = 0;
+			}
+		}
+	}
+	clusters.push_back(triangleCount);
+
+	// Clusters facing away from the mesh center are on its outer shell, they go first
+	struct Cluster {
+		size_t start;
+		size_t end;
+		float sortKey;
+	};
+	std::vector<Cluster> sorted(clusters.size() - 1);
+	std::vector<glm::vec3> centroids(sorted.size(), glm::vec3(0.0f));
+	std::vector<glm::vec3> normals(sorted.size(), glm::vec3(0.0f));
+	std::vector<float> areas(sorted.size(), 0.0f);
+	glm::vec3 meshCentroid{ 0.0f };
+	float meshArea = 0.0f;
+	for (size_t c = 0; c < sorted.size(); c++) {
+		sorted[c] = { clusters[c], clusters[c + 1], 0.0f };
+		for (size_t t = clusters[c]; t < clusters[c + 1]; t++) {
+			const glm::vec3& a = vertices[indices[t * 3]].pos;
+			const glm::vec3& b = vertices[indices[t * 3 + 1]].pos;
+			const glm::vec3& d = vertices[indices[t * 3 + 2]].pos;
+			// Twice the area weighted normal
+			glm::vec3 normal = glm::cross(b - a, d - a);
+			float area = glm::length(normal);
+			centroids[c] += (a + b + d) * (area / 3.0f);
+			normals[c] += normal;
+			areas[c] += area;
+		}
+		meshCentroid += centroids[c];
+		meshArea += areas[c];
+	}
+	meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : glm::vec3(0.0f);
+	for (size_t c = 0; c < sorted.size(); c++) {
+		float normalLength = glm::length(normals[c]);
+		if (areas[c] > 0.0f && normalLength > 0.0f) {
+			sorted[c].sortKey = glm::dot(centroids[c] / areas[c] - meshCentroid, normals[c] / normalLength);
+		}
+	}
+	std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+	std::vector<uint32_t> output;
+	output.reserve(triangleCount * 3);
+	for (const Cluster& cluster : sorted) {
+		output.insert(output.end(), indices + cluster.start * 3, indices + cluster.end * 3);
+	}
+	memcpy(indices, output.data(), output.size() * sizeof(uint32_t));
+}
+
+void Magnet::EngineBase::Assets::MeshOptimizer::optimizeVertexFetch(std::vector<MeshFile::Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	constexpr uint32_t UNUSED = std::numeric_limits<uint32_t>::max();
+	std::vector<uint32_t> remap(vertices.size(), UNUSED);
+	std::vector<MeshFile::Vertex> remapped;
+	remapped.reserve(vertices.size());
+	for (uint32_t& index : indices) {
+		if (remap[index] == UNUSED) {
+			remap[index] = static_cast<uint32_t>(remapped.size());
+			remapped.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+	vertices = std::move(remapped);
+}
+
+Magnet::EngineBase::Assets::MeshOptimizer::CacheStats Magnet::EngineBase::Assets::MeshOptimizer::analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+{
+	CacheStats cacheStats;
+	cacheStats.triangles = indexCount / 3;
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	std::vector<uint8_t> referenced(vertexCount, 0);
+	uint32_t time = cacheSize + 1;
+	for (size_t i = 0; i < cacheStats.triangles * 3; i++) {
+		uint32_t vertex = indices[i];
+		if (time - timestamps[vertex] > cacheSize) {
+			timestamps[vertex] = time++;
+			cacheStats.misses++;
+		}
+		if (!referenced[vertex]) {
+			referenced[vertex] = 1;
+			cacheStats.vertices++;
+		}
+	}
+	return cacheStats;
+}
+
+void Magnet::EngineBase::Assets::MeshOptimizer::printStats() const
+{
+	std::cout << "\nMesh optimization :" << std::endl;
+	std::cout << "------------------------------" << std::endl;
+	std::cout << "\t- Meshes : " << stats.meshes << ", triangles : " << stats.after.triangles << (settings.overdraw ? " (overdraw ordered)" : "") << std::endl;
+	std::cout << "\t- ACMR : " << stats.before.getACMR() << " -> " << stats.after.getACMR() << " (FIFO " << settings.cacheSize << ")" << std::endl;
+	std::cout << "\t- ATVR : " << stats.before.getATVR() << " -> " << stats.after.getATVR() << std::endl;
+	std::cout << "\t- Time : " << stats.optimizeTimeMs << " ms" << std::endl;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "../../Commons.h"
+#include "MeshFile.h"
+
+namespace Magnet {
+	namespace EngineBase {
+		namespace Assets {
+
+			// Reorders cooked geometry for the GPU, in three passes run at cook time :
+			//  - triangles of each submesh are sorted for the post-transform vertex cache with Tom Forsyth's greedy
+			//    "linear speed vertex cache optimisation", scoring vertices by cache position and remaining valence
+			//  - optionally, the cache ordered triangles are cut into clusters (where the cache restarts, then wherever the
+			//    cluster ACMR stays under overdrawThreshold times the submesh ACMR) and clusters facing away from the
+			//    submesh center are drawn first, so the convex outer shell hides the rest
+			//  - vertices are renumbered in order of first use, so vertex fetches walk memory linearly
+			// ACMR (cache misses per triangle) and ATVR (cache misses per referenced vertex, 1 at best) are measured on a
+			// FIFO cache before and after.
+			class MeshOptimizer {
+			public:
+				struct Settings {
+					bool overdraw = true;
+					// Cluster ACMR allowed above the cache optimized ACMR, larger values make fewer, bigger clusters
+					float overdrawThreshold = 1.05f;
+					// Entries of the simulated FIFO cache used for the ACMR/ATVR metrics and the cluster boundaries
+					uint32_t cacheSize = 16;
+				};
+
+				struct CacheStats {
+					uint64_t triangles = 0;
+					uint64_t vertices = 0;
+					uint64_t misses = 0;
+
+					double getACMR() const { return triangles > 0 ? double(misses) / triangles : 0.0; }
+					double getATVR() const { return vertices > 0 ? double(misses) / vertices : 0.0; }
+				};
+
+				struct Stats {
+					uint32_t meshes = 0;
+					CacheStats before;
+					CacheStats after;
+					double optimizeTimeMs = 0.0;
+				};
+
+				explicit MeshOptimizer(const Settings& settings) : settings{ settings } {}
+
+				// Every pass on every submesh and LOD level, then the vertex fetch remap. Submesh bounds are unchanged
+				void optimize(MeshFile::Data& data);
+
+				// In place, indices point into a vertex array of vertexCount entries
+				static void optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+				static void optimizeOverdraw(uint32_t* indices, size_t indexCount, const MeshFile::Vertex* vertices, size_t vertexCount, float threshold, uint32_t cacheSize);
+				// Renumbers vertices by first use in indices, unreferenced vertices are dropped
+				static void optimizeVertexFetch(std::vector<MeshFile::Vertex>& vertices, std::vector<uint32_t>& indices);
+				static CacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize);
+
+				const Stats& getStats() const { return stats; }
+				void printStats() const;
+
+			private:
+				Settings settings;
+				Stats stats{};
+			};
+		}
+	}
+}
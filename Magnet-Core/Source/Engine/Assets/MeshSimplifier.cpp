@@ -0,0 +1,444 @@
+#include "MeshSimplifier.h"
+#include "../Parallel.h"
+#include "../../Utils.h"
+
+namespace {
+	using Magnet::EngineBase::Assets::MeshFile;
+	using Magnet::EngineBase::Assets::MeshSimplifier;
+
+	constexpr uint32_t INVALID = std::numeric_limits<uint32_t>::max();
+	// Smallest cosine between a triangle's normal before and after a collapse
+	constexpr float FLIP_THRESHOLD = 0.1f;
+
+	// Symmetric 4x4 quadric of squared distances to planes, weighted by triangle area
+	struct Quadric {
+		double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+		double b0 = 0, b1 = 0, b2 = 0, c = 0;
+		double weight = 0;
+
+		static Quadric fromPlane(const glm::dvec3& normal, double distance, double weight)
+		{
+			Quadric q;
+			q.a00 = weight * normal.x * normal.x; q.a01 = weight * normal.x * normal.y; q.a02 = weight * normal.x * normal.z;
+			q.a11 = weight * normal.y * normal.y; q.a12 = weight * normal.y * normal.z; q.a22 = weight * normal.z * normal.z;
+			q.b0 = weight * normal.x * distance; q.b1 = weight * normal.y * distance; q.b2 = weight * normal.z * distance;
+			q.c = weight * distance * distance;
+			q.weight = weight;
+			return q;
+		}
+
+		Quadric& operator+=(const Quadric& other)
+		{
+			a00 += other.a00; a01 += other.a01; a02 += other.a02; a11 += other.a11; a12 += other.a12; a22 += other.a22;
+			b0 += other.b0; b1 += other.b1; b2 += other.b2; c += other.c;
+			weight += other.weight;
+			return *this;
+		}
+
+		// Area weighted mean of the squared distances to the planes
+		double evaluate(const glm::vec3& point) const
+		{
+			double x = point.x, y = point.y, z = point.z;
+			double error = x * (a00 * x + 2.0 * (a01 * y + a02 * z + b0)) + y * (a11 * y + 2.0 * (a12 * z + b1)) + z * (a22 * z + 2.0 * b2) + c;
+			return weight > 0.0 ? std::max(error, 0.0) / weight : 0.0;
+		}
+	};
+
+	template<typename T>
+	size_t hashBytes(const T& value)
+	{
+		uint32_t words[sizeof(T) / sizeof(uint32_t)];
+		memcpy(words, &value, sizeof(words));
+		size_t seed = 0;
+		for (uint32_t word : words) {
+			Magnet::hashCombine(seed, word);
+		}
+		return seed;
+	}
+
+	// Collapse state of one submesh. Vertex ids are local, triangles point to the first of identical vertices and
+	// topology, quadrics and collapses use the first vertex at each position (its "position vertex")
+	class Collapser {
+	public:
+		Collapser(const uint32_t* indices, size_t indexCount, const MeshFile::Vertex* vertices, size_t vertexCount, float normalWeight, float uvWeight)
+			: normalWeight{ normalWeight }, uvWeight{ uvWeight }
+		{
+			// Local copies of the referenced vertices, identical ones welded
+			std::vector<uint32_t> localOf(vertexCount, INVALID);
+			auto vertexHash = [](const MeshFile::Vertex& v) { return hashBytes(v); };
+			auto vertexEqual = [](const MeshFile::Vertex& a, const MeshFile::Vertex& b) { return memcmp(&a, &b, sizeof(MeshFile::Vertex)) == 0; };
+			std::unordered_map<MeshFile::Vertex, uint32_t, decltype(vertexHash), decltype(vertexEqual)> uniqueVertices(indexCount / 3, vertexHash, vertexEqual);
+			triangles.resize(indexCount);
+			for (size_t i = 0; i < indexCount; i++) {
+				uint32_t index = indices[i];
+				if (localOf[index] == INVALID) {
+					auto unique = uniqueVertices.emplace(vertices[index], static_cast<uint32_t>(this->vertices.size()));
+					if (unique.second) {
+						this->vertices.push_back(vertices[index]);
+						sourceIndices.push_back(index);
+					}
+					localOf[index] = unique.first->second;
+				}
+				triangles[i] = localOf[index];
+			}
+
+			// Vertices sharing a position only by their normal are a crease and collapse together, UV or color seams are locked
+			size_t localCount = this->vertices.size();
+			auto positionHash = [](const glm::vec3& p) { return hashBytes(p); };
+			std::unordered_map<glm::vec3, uint32_t, decltype(positionHash)> positions(localCount, positionHash);
+			positionVertex.resize(localCount);
+			copies.resize(localCount);
+			locked.assign(localCount, false);
+			for (uint32_t v = 0; v < localCount; v++) {
+				uint32_t position = positions.emplace(this->vertices[v].pos, v).first->second;
+				positionVertex[v] = position;
+				copies[position].push_back(v);
+				if (this->vertices[v].uv != this->vertices[position].uv || this->vertices[v].color != this->vertices[position].color) {
+					locked[position] = true;
+				}
+			}
+
+			// Borders are directed edges without their opposite, edges used twice in one direction are non manifold
+			std::unordered_map<uint64_t, uint32_t> edges(indexCount);
+			auto edgeKey = [](uint32_t from, uint32_t to) { return (uint64_t(from) << 32) | to; };
+			removed.assign(indexCount / 3, false);
+			for (size_t t = 0; t < indexCount / 3; t++) {
+				uint32_t p[3] = { positionOf(uint32_t(t * 3)), positionOf(uint32_t(t * 3 + 1)), positionOf(uint32_t(t * 3 + 2)) };
+				if (p[0] == p[1] || p[1] == p[2] || p[0] == p[2]) {
+					removed[t] = true;
+					continue;
+				}
+				for (uint32_t e = 0; e < 3; e++) {
+					edges[edgeKey(p[e], p[(e + 1) % 3])]++;
+				}
+			}
+			for (const auto& [key, count] : edges) {
+				uint32_t from = uint32_t(key >> 32), to = uint32_t(key);
+				if (count > 1 || edges.find(edgeKey(to, from)) == edges.end()) {
+					locked[from] = true;
+					locked[to] = true;
+				}
+			}
+
+			// Plane quadrics and triangle lists per position vertex
+			quadrics.resize(localCount);
+			adjacency.resize(localCount);
+			for (uint32_t t = 0; t < removed.size(); t++) {
+				if (removed[t]) {
+					continue;
+				}
+				glm::dvec3 p0 = this->vertices[triangles[t * 3]].pos, p1 = this->vertices[triangles[t * 3 + 1]].pos, p2 = this->vertices[triangles[t * 3 + 2]].pos;
+				glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+				double area = glm::length(normal);
+				Quadric quadric = area > 0.0 ? Quadric::fromPlane(normal / area, -glm::dot(normal / area, p0), area * 0.5) : Quadric{};
+				for (uint32_t corner = 0; corner < 3; corner++) {
+					quadrics[positionOf(t * 3 + corner)] += quadric;
+					adjacency[positionOf(t * 3 + corner)].push_back(t);
+				}
+				triangleCount++;
+			}
+		}
+
+		size_t getTriangleCount() const { return triangleCount; }
+
+		// Collapses the cheapest edges in passes until targetTriangles remain, no collapse stays under maxError or
+		// a pass makes no progress
+		void collapse(size_t targetTriangles, float maxError)
+		{
+			double maxErrorSquared = double(maxError) * maxError;
+			while (triangleCount > targetTriangles) {
+				struct Candidate {
+					uint32_t from;
+					uint32_t to;
+					double positionError;
+					double cost;
+				};
+				std::vector<Candidate> candidates;
+				for (uint32_t t = 0; t < removed.size(); t++) {
+					if (removed[t]) {
+						continue;
+					}
+					for (uint32_t e = 0; e < 3; e++) {
+						uint32_t from = positionOf(t * 3 + e), to = positionOf(t * 3 + (e + 1) % 3);
+						if (!locked[from]) {
+							candidates.push_back({ from, to, 0.0, 0.0 });
+						}
+						if (!locked[to]) {
+							candidates.push_back({ to, from, 0.0, 0.0 });
+						}
+					}
+				}
+				std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.from != b.from ? a.from < b.from : a.to < b.to; });
+				candidates.erase(std::unique(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.from == b.from && a.to == b.to; }), candidates.end());
+				for (Candidate& candidate : candidates) {
+					candidate.positionError = getPositionError(candidate.from, candidate.to);
+					candidate.cost = candidate.positionError + getAttributeError(candidate.from, candidate.to);
+				}
+				std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.cost < b.cost; });
+
+				// Endpoints are used once per pass so the costs computed above stay valid
+				std::vector<bool> touched(vertices.size(), false);
+				size_t collapsed = 0;
+				for (const Candidate& candidate : candidates) {
+					if (triangleCount <= targetTriangles) {
+						break;
+					}
+					if (touched[candidate.from] || touched[candidate.to] || candidate.positionError > maxErrorSquared) {
+						continue;
+					}
+					if (!isCollapseValid(candidate.from, candidate.to)) {
+						continue;
+					}
+					apply(candidate.from, candidate.to);
+					error = std::max(error, std::sqrt(candidate.positionError));
+					touched[candidate.from] = true;
+					touched[candidate.to] = true;
+					collapsed++;
+				}
+				if (collapsed == 0) {
+					break;
+				}
+			}
+		}
+
+		MeshSimplifier::Level getLevel() const
+		{
+			MeshSimplifier::Level level;
+			level.error = float(error);
+			for (uint32_t t = 0; t < removed.size(); t++) {
+				if (!removed[t]) {
+					for (uint32_t corner = 0; corner < 3; corner++) {
+						level.indices.push_back(sourceIndices[triangles[t * 3 + corner]]);
+					}
+				}
+			}
+			return level;
+		}
+
+	private:
+		uint32_t positionOf(uint32_t corner) const { return positionVertex[triangles[corner]]; }
+
+		double getPositionError(uint32_t from, uint32_t to) const
+		{
+			Quadric quadric = quadrics[from];
+			quadric += quadrics[to];
+			return quadric.evaluate(vertices[to].pos);
+		}
+
+		double getAttributeDistance(uint32_t a, uint32_t b) const
+		{
+			glm::vec3 normal = vertices[a].normal - vertices[b].normal;
+			glm::vec2 uv = vertices[a].uv - vertices[b].uv;
+			return double(normalWeight) * normalWeight * glm::dot(normal, normal) + double(uvWeight) * uvWeight * glm::dot(uv, uv);
+		}
+
+		// The copy of position vertex to whose attributes are the closest to vertex's
+		uint32_t getClosestCopy(uint32_t to, uint32_t vertex) const
+		{
+			uint32_t closest = to;
+			double closestDistance = std::numeric_limits<double>::max();
+			for (uint32_t copy : copies[to]) {
+				double distance = getAttributeDistance(vertex, copy);
+				if (distance < closestDistance) {
+					closest = copy;
+					closestDistance = distance;
+				}
+			}
+			return closest;
+		}
+
+		// Every copy of from takes the attributes of its closest copy of to, the worst one is the error
+		double getAttributeError(uint32_t from, uint32_t to) const
+		{
+			double error = 0.0;
+			for (uint32_t copy : copies[from]) {
+				error = std::max(error, getAttributeDistance(copy, getClosestCopy(to, copy)));
+			}
+			return error;
+		}
+
+		void collectNeighbours(uint32_t vertex, std::vector<uint32_t>& neighbours) const
+		{
+			neighbours.clear();
+			for (uint32_t t : adjacency[vertex]) {
+				if (removed[t]) {
+					continue;
+				}
+				for (uint32_t corner = 0; corner < 3; corner++) {
+					uint32_t neighbour = positionOf(t * 3 + corner);
+					if (neighbour != vertex) {
+						neighbours.push_back(neighbour);
+					}
+				}
+			}
+			std::sort(neighbours.begin(), neighbours.end());
+			neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+		}
+
+		bool isCollapseValid(uint32_t fromPosition, uint32_t toPosition)
+		{
+			// Link condition : the edge's two triangles are the only ones whose vertices neighbour both ends
+			collectNeighbours(fromPosition, fromNeighbours);
+			collectNeighbours(toPosition, toNeighbours);
+			size_t shared = 0;
+			for (size_t i = 0, j = 0; i < fromNeighbours.size() && j < toNeighbours.size();) {
+				if (fromNeighbours[i] == toNeighbours[j]) {
+					shared++;
+					i++;
+					j++;
+				}
+				else if (fromNeighbours[i] < toNeighbours[j]) {
+					i++;
+				}
+				else {
+					j++;
+				}
+			}
+			if (shared != 2) {
+				return false;
+			}
+
+			// Triangles that stay must keep their orientation
+			for (uint32_t t : adjacency[fromPosition]) {
+				if (removed[t]) {
+					continue;
+				}
+				uint32_t corners[3] = { positionOf(t * 3), positionOf(t * 3 + 1), positionOf(t * 3 + 2) };
+				if (corners[0] == toPosition || corners[1] == toPosition || corners[2] == toPosition) {
+					continue;
+				}
+				glm::vec3 before[3], after[3];
+				for (uint32_t corner = 0; corner < 3; corner++) {
+					before[corner] = vertices[triangles[t * 3 + corner]].pos;
+					after[corner] = corners[corner] == fromPosition ? vertices[toPosition].pos : before[corner];
+				}
+				glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+				glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+				float lengths = glm::length(normalBefore) * glm::length(normalAfter);
+				if (lengths <= 0.0f || glm::dot(normalBefore, normalAfter) < FLIP_THRESHOLD * lengths) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// from is unlocked so its copies only differ by their normal, each moves to the closest copy of to
+		void apply(uint32_t fromPosition, uint32_t toPosition)
+		{
+			for (uint32_t t : adjacency[fromPosition]) {
+				if (removed[t]) {
+					continue;
+				}
+				bool degenerate = false;
+				for (uint32_t corner = 0; corner < 3; corner++) {
+					degenerate |= positionOf(t * 3 + corner) == toPosition;
+				}
+				if (degenerate) {
+					removed[t] = true;
+					triangleCount--;
+					continue;
+				}
+				for (uint32_t corner = 0; corner < 3; corner++) {
+					if (positionOf(t * 3 + corner) == fromPosition) {
+						triangles[t * 3 + corner] = getClosestCopy(toPosition, triangles[t * 3 + corner]);
+					}
+				}
+				adjacency[toPosition].push_back(t);
+			}
+			adjacency[fromPosition].clear();
+			quadrics[toPosition] += quadrics[fromPosition];
+		}
+
+		float normalWeight;
+		float uvWeight;
+		std::vector<MeshFile::Vertex> vertices;
+		std::vector<uint32_t> sourceIndices;
+		std::vector<uint32_t> positionVertex;
+		// Vertices at each position vertex
+		std::vector<std::vector<uint32_t>> copies;
+		std::vector<bool> locked;
+		std::vector<Quadric> quadrics;
+		std::vector<std::vector<uint32_t>> adjacency;
+		std::vector<uint32_t> triangles;
+		std::vector<bool> removed;
+		size_t triangleCount = 0;
+		double error = 0.0;
+		std::vector<uint32_t> fromNeighbours, toNeighbours;
+	};
+}
+
+std::vector<Magnet::EngineBase::Assets::MeshSimplifier::Level> Magnet::EngineBase::Assets::MeshSimplifier::simplify(const uint32_t* indices, size_t indexCount, const MeshFile::Vertex* vertices, size_t vertexCount,
+	const std::vector<size_t>& targetIndexCounts, float maxError, float normalWeight, float uvWeight)
+{
+	std::vector<Level> levels;
+	Collapser collapser{ indices, indexCount, vertices, vertexCount, normalWeight, uvWeight };
+	for (size_t target : targetIndexCounts) {
+		collapser.collapse(target / 3, maxError);
+		levels.push_back(collapser.getLevel());
+		if (collapser.getTriangleCount() > target / 3) {
+			break;
+		}
+	}
+	return levels;
+}
+
+void Magnet::EngineBase::Assets::MeshSimplifier::generateLods(MeshFile::Data& data)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::vector<std::vector<Level>> submeshLevels(data.submeshes.size());
+	parallelFor(data.submeshes.size(), [&](size_t i) {
+		const auto& submesh = data.submeshes[i];
+		std::vector<size_t> targets;
+		size_t triangles = submesh.indexCount / 3;
+		for (uint32_t level = 0; level < settings.maxLevels; level++) {
+			triangles = static_cast<size_t>(triangles * settings.reduction);
+			if (triangles < settings.minTriangles) {
+				break;
+			}
+			targets.push_back(triangles * 3);
+		}
+		if (targets.empty()) {
+			return;
+		}
+
+		float size = glm::length(submesh.boundsMax - submesh.boundsMin);
+		std::vector<Level> levels = simplify(data.indices.data() + submesh.firstIndex, submesh.indexCount, data.vertices.data(), data.vertices.size(),
+			targets, settings.maxError * size, settings.normalWeight * size, settings.uvWeight * size);
+		// Levels barely smaller than the previous one would cost memory for no speedup
+		size_t previousCount = submesh.indexCount;
+		for (Level& level : levels) {
+			if (level.indices.empty() || level.indices.size() > previousCount * (1.0f - settings.minReduction)) {
+				break;
+			}
+			previousCount = level.indices.size();
+			submeshLevels[i].push_back(std::move(level));
+		}
+	});
+
+	for (size_t i = 0; i < data.submeshes.size(); i++) {
+		auto& submesh = data.submeshes[i];
+		submesh.firstLod = static_cast<uint32_t>(data.lods.size());
+		submesh.lodCount = static_cast<uint32_t>(submeshLevels[i].size());
+		stats.sourceTriangles += submesh.indexCount / 3;
+		for (const Level& level : submeshLevels[i]) {
+			data.lods.push_back({ static_cast<uint32_t>(data.indices.size()), static_cast<uint32_t>(level.indices.size()), level.error, 0 });
+			data.indices.insert(data.indices.end(), level.indices.begin(), level.indices.end());
+			stats.lodTriangles += level.indices.size() / 3;
+		}
+		stats.levels += submesh.lodCount;
+	}
+
+	stats.meshes++;
+	stats.submeshes += static_cast<uint32_t>(data.submeshes.size());
+	stats.simplifyTimeMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void Magnet::EngineBase::Assets::MeshSimplifier::printStats() const
+{
+	std::cout << "\nMesh simplification :" << std::endl;
+	std::cout << "------------------------------" << std::endl;
+	std::cout << "\t- Meshes : " << stats.meshes << ", submeshes : " << stats.submeshes << ", LOD levels : " << stats.levels << std::endl;
+	std::cout << "\t- Triangles : " << stats.sourceTriangles << " source, " << stats.lodTriangles << " in LODs" << std::endl;
+	std::cout << "\t- Time : " << stats.simplifyTimeMs << " ms" << std::endl;
+}
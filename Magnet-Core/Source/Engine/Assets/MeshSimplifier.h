@@ -0,0 +1,71 @@
+#pragma once
+#include "../../Commons.h"
+#include "MeshFile.h"
+
+namespace Magnet {
+	namespace EngineBase {
+		namespace Assets {
+
+			// Builds the LOD chain of cooked submeshes with quadric error metric edge collapses (Garland and Heckbert) :
+			//  - vertices with the same position are welded for topology, so attribute seams don't read as holes
+			//  - every vertex accumulates the area weighted quadrics of its triangles' planes, a collapse moves a vertex
+			//    onto a neighbour (half edge collapse) so levels reuse the source vertices and only add indices
+			//  - the collapse cost adds normal and UV deviation to the position error, scaled by the mesh size, so
+			//    creases and texture mapping are preserved until geometry can't be reduced otherwise
+			//  - border vertices (on open edges) and seam vertices are locked in place, collapses that flip a triangle
+			//    or make the surface non manifold are rejected
+			// Collapses run in passes sorted by cost, the simplification continues from one level to the next so the
+			// quadrics, and the error of each level, accumulate.
+			class MeshSimplifier {
+			public:
+				struct Settings {
+					// Levels below the source, each targeting reduction times the triangles of the previous one
+					uint32_t maxLevels = 4;
+					float reduction = 0.5f;
+					// Levels removing less than this fraction of the previous one's triangles end the chain
+					float minReduction = 0.15f;
+					uint32_t minTriangles = 32;
+					// Largest error of a level, as a fraction of the submesh bounds diagonal
+					float maxError = 0.05f;
+					// Attribute deviation against the position error, as fractions of the bounds diagonal
+					float normalWeight = 0.05f;
+					float uvWeight = 0.05f;
+				};
+
+				// One simplification target of simplify
+				struct Level {
+					std::vector<uint32_t> indices;
+					// Largest distance a collapse moved the surface by, in the vertices' space
+					float error = 0.0f;
+				};
+
+				struct Stats {
+					uint32_t meshes = 0;
+					uint32_t submeshes = 0;
+					uint32_t levels = 0;
+					uint64_t sourceTriangles = 0;
+					uint64_t lodTriangles = 0;
+					double simplifyTimeMs = 0.0;
+				};
+
+				explicit MeshSimplifier(const Settings& settings) : settings{ settings } {}
+
+				// Appends the LOD indices of every submesh to data, with their entries in the LOD table
+				void generateLods(MeshFile::Data& data);
+
+				// One level per target index count, in decreasing order, each continuing from the previous one. Collapses
+				// stop at maxError, the first level that can't get under its target ends the list. The weights are the
+				// distances a unit normal or UV deviation costs as much as
+				static std::vector<Level> simplify(const uint32_t* indices, size_t indexCount, const MeshFile::Vertex* vertices, size_t vertexCount,
+					const std::vector<size_t>& targetIndexCounts, float maxError, float normalWeight, float uvWeight);
+
+				const Stats& getStats() const { return stats; }
+				void printStats() const;
+
+			private:
+				Settings settings;
+				Stats stats{};
+			};
+		}
+	}
+}
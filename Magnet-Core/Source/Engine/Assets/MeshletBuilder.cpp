@@ -0,0 +1,266 @@
+#include "MeshletBuilder.h"
+#include "../../Utils.h"
+
+namespace {
+	constexpr uint32_t INVALID = std::numeric_limits<uint32_t>::max();
+	// Cone cutoffs past this (cosine of the largest angle between the axis and a triangle normal) never cull
+	constexpr float MIN_CONE_SPREAD = 0.1f;
+	// Widens the cutoff past float rounding, so the test stays conservative
+	constexpr float CONE_CUTOFF_MARGIN = 1e-3f;
+	// Weight of the normal deviation against the vertices a candidate triangle adds
+	constexpr float NORMAL_WEIGHT = 0.5f;
+}
+
+void Magnet::EngineBase::Assets::MeshletBuilder::build(const TriangleList& triangleList, Meshlets& output)
+{
+	size_t triangleCount = triangleList.indexCount / 3;
+	if (triangleCount == 0) {
+		return;
+	}
+
+	// Per vertex state is sized to the range the indices span, slots count from its first vertex
+	uint32_t firstVertex = 0, lastVertex = 0;
+	triangleList.getVertexBounds(firstVertex, lastVertex);
+	size_t vertexCount = size_t(lastVertex) - firstVertex + 1;
+	uint32_t slotOrigin = firstVertex - triangleList.baseVertex;
+	auto slot = [&](size_t i) { return triangleList.getIndex(i) - slotOrigin; };
+	auto positionOf = [&](size_t i) { return triangleList.getPosition(triangleList.getIndex(i)); };
+
+	// Vertices split by attribute seams share one position, triangles are adjacent through positions
+	std::vector<uint32_t> positionIds(vertexCount, INVALID);
+	auto positionHash = [](const glm::vec3& position) {
+		size_t seed = 0;
+		Magnet::hashCombine(seed, position.x, position.y, position.z);
+		return seed;
+	};
+	std::unordered_map<glm::vec3, uint32_t, decltype(positionHash)> positionMap(vertexCount, positionHash);
+	for (size_t i = 0; i < triangleCount * 3; i++) {
+		uint32_t& id = positionIds[slot(i)];
+		if (id == INVALID) {
+			id = positionMap.emplace(positionOf(i), static_cast<uint32_t>(positionMap.size())).first->second;
+		}
+	}
+	size_t positionCount = positionMap.size();
+
+	// Triangles around each position (compressed rows), those not emitted yet counted in liveTriangles
+	std::vector<uint32_t> adjacencyOffsets(positionCount + 1, 0);
+	std::vector<uint32_t> liveTriangles(positionCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; i++) {
+		liveTriangles[positionIds[slot(i)]]++;
+	}
+	for (size_t p = 0; p < positionCount; p++) {
+		adjacencyOffsets[p + 1] = adjacencyOffsets[p] + liveTriangles[p];
+	}
+	std::vector<uint32_t> adjacency(triangleCount * 3);
+	std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (size_t t = 0; t < triangleCount; t++) {
+		for (uint32_t corner = 0; corner < 3; corner++) {
+			adjacency[fill[positionIds[slot(t * 3 + corner)]]++] = static_cast<uint32_t>(t);
+		}
+	}
+
+	std::vector<glm::vec3> normals(triangleCount);
+	for (size_t t = 0; t < triangleCount; t++) {
+		glm::vec3 p0 = positionOf(t * 3);
+		glm::vec3 normal = glm::cross(positionOf(t * 3 + 1) - p0, positionOf(t * 3 + 2) - p0);
+		float length = glm::length(normal);
+		normals[t] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+	}
+
+	std::vector<bool> emitted(triangleCount, false);
+	// Local index of each vertex slot in the meshlet being built
+	std::vector<uint32_t> localIndex(vertexCount, INVALID);
+
+	Meshlet meshlet{ static_cast<uint32_t>(output.vertices.size()), static_cast<uint32_t>(output.triangles.size()), 0, 0 };
+	glm::vec3 normalSum{ 0.0f };
+	size_t nextUnemitted = 0;
+	uint32_t seed = INVALID;
+
+	auto finishMeshlet = [&]() {
+		const uint32_t* meshletVertices = output.vertices.data() + meshlet.vertexOffset;
+		output.bounds.push_back(computeBounds(meshletVertices, output.triangles.data() + meshlet.triangleOffset, meshlet.triangleCount, triangleList));
+		output.meshlets.push_back(meshlet);
+		for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+			localIndex[meshletVertices[i] - firstVertex] = INVALID;
+		}
+		meshlet = { static_cast<uint32_t>(output.vertices.size()), static_cast<uint32_t>(output.triangles.size()), 0, 0 };
+		normalSum = glm::vec3(0.0f);
+	};
+
+	for (size_t remaining = triangleCount; remaining > 0; remaining--) {
+		uint32_t best = INVALID;
+		if (meshlet.triangleCount == 0) {
+			// Left out of the previous meshlet, or the first triangle not emitted yet
+			if (seed != INVALID && !emitted[seed]) {
+				best = seed;
+			}
+			else {
+				while (emitted[nextUnemitted]) {
+					nextUnemitted++;
+				}
+				best = static_cast<uint32_t>(nextUnemitted);
+			}
+			seed = INVALID;
+		}
+		else {
+			// Triangles around the meshlet's vertices, fewest new vertices first, then closest to the average normal
+			float bestScore = std::numeric_limits<float>::max();
+			float seedScore = std::numeric_limits<float>::max();
+			glm::vec3 axis = glm::length(normalSum) > 0.0f ? glm::normalize(normalSum) : glm::vec3(0.0f);
+			const uint32_t* meshletVertices = output.vertices.data() + meshlet.vertexOffset;
+			for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+				uint32_t p = positionIds[meshletVertices[i] - firstVertex];
+				if (liveTriangles[p] == 0) {
+					continue;
+				}
+				for (uint32_t a = adjacencyOffsets[p]; a < adjacencyOffsets[p + 1]; a++) {
+					uint32_t t = adjacency[a];
+					if (emitted[t]) {
+						continue;
+					}
+					uint32_t newVertices = 0;
+					bool closesPosition = false;
+					for (uint32_t corner = 0; corner < 3; corner++) {
+						uint32_t vertex = slot(t * 3 + corner);
+						newVertices += localIndex[vertex] == INVALID ? 1 : 0;
+						closesPosition |= liveTriangles[positionIds[vertex]] == 1;
+					}
+					// Triangles left last around a position come right after those adding no vertex, so no isolated
+					// triangles are left behind to make tiny meshlets
+					float priority = newVertices == 0 ? 0.0f : (closesPosition ? 1.0f : 1.0f + newVertices);
+					float score = priority + NORMAL_WEIGHT * (1.0f - glm::dot(normals[t], axis));
+					if (meshlet.vertexCount + newVertices > MAX_VERTICES) {
+						if (score < seedScore) {
+							seedScore = score;
+							seed = t;
+						}
+						continue;
+					}
+					if (score < bestScore) {
+						bestScore = score;
+						best = t;
+					}
+				}
+			}
+			if (best == INVALID) {
+				// Closed off, or every neighbour overflows the vertex limit
+				finishMeshlet();
+				remaining++;
+				continue;
+			}
+		}
+
+		uint32_t local[3];
+		for (uint32_t corner = 0; corner < 3; corner++) {
+			uint32_t vertex = slot(size_t(best) * 3 + corner);
+			uint32_t& localSlot = localIndex[vertex];
+			if (localSlot == INVALID) {
+				localSlot = meshlet.vertexCount++;
+				output.vertices.push_back(firstVertex + vertex);
+			}
+			local[corner] = localSlot;
+			liveTriangles[positionIds[vertex]]--;
+		}
+		output.triangles.push_back(packTriangle(local[0], local[1], local[2]));
+		meshlet.triangleCount++;
+		normalSum += normals[best];
+		emitted[best] = true;
+
+		if (meshlet.triangleCount == MAX_TRIANGLES) {
+			finishMeshlet();
+		}
+	}
+	if (meshlet.triangleCount > 0) {
+		finishMeshlet();
+	}
+}
+
+Magnet::EngineBase::Assets::MeshletBuilder::Bounds Magnet::EngineBase::Assets::MeshletBuilder::computeBounds(const uint32_t* meshletVertices, const uint32_t* triangles, uint32_t triangleCount, const TriangleList& triangleList)
+{
+	Bounds bounds{};
+	if (triangleCount == 0) {
+		return bounds;
+	}
+
+	// Meshlet vertices are in the vertex buffer, positions relative to the list's base vertex
+	auto position = [&](uint32_t t, uint32_t corner) {
+		return triangleList.getPosition(meshletVertices[unpackTriangle(triangles[t], corner)] - triangleList.baseVertex);
+	};
+
+	// Sphere around the box of the referenced vertices
+	glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+	glm::vec3 boundsMax{ std::numeric_limits<float>::lowest() };
+	for (uint32_t t = 0; t < triangleCount; t++) {
+		for (uint32_t corner = 0; corner < 3; corner++) {
+			glm::vec3 p = position(t, corner);
+			boundsMin = glm::min(boundsMin, p);
+			boundsMax = glm::max(boundsMax, p);
+		}
+	}
+	glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+	float radius = 0.0f;
+	for (uint32_t t = 0; t < triangleCount; t++) {
+		for (uint32_t corner = 0; corner < 3; corner++) {
+			radius = std::max(radius, glm::length(position(t, corner) - center));
+		}
+	}
+	bounds.sphere = glm::vec4(center, radius);
+	bounds.coneApex = glm::vec4(center, 1.0f);
+
+	// Axis is the average triangle normal, degenerate triangles face nowhere
+	std::vector<glm::vec3> normals(triangleCount);
+	glm::vec3 normalSum{ 0.0f };
+	for (uint32_t t = 0; t < triangleCount; t++) {
+		glm::vec3 p0 = position(t, 0);
+		glm::vec3 p1 = position(t, 1);
+		glm::vec3 p2 = position(t, 2);
+		glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		float length = glm::length(normal);
+		normals[t] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+		normalSum += normals[t];
+	}
+	float axisLength = glm::length(normalSum);
+	if (axisLength == 0.0f) {
+		return bounds;
+	}
+	glm::vec3 axis = normalSum / axisLength;
+
+	float minDot = 1.0f;
+	for (uint32_t t = 0; t < triangleCount; t++) {
+		if (normals[t] != glm::vec3(0.0f)) {
+			minDot = std::min(minDot, glm::dot(axis, normals[t]));
+		}
+	}
+	if (minDot <= MIN_CONE_SPREAD) {
+		bounds.cone = glm::vec4(axis, 1.0f);
+		return bounds;
+	}
+
+	// The apex moves back along the axis until every triangle plane is in front of it, so a camera inside the cone
+	// behind the apex sees every triangle from behind
+	float maxT = 0.0f;
+	for (uint32_t t = 0; t < triangleCount; t++) {
+		if (normals[t] == glm::vec3(0.0f)) {
+			continue;
+		}
+		glm::vec3 p0 = position(t, 0);
+		maxT = std::max(maxT, glm::dot(center - p0, normals[t]) / glm::dot(axis, normals[t]));
+	}
+	bounds.coneApex = glm::vec4(center - axis * maxT, 1.0f);
+	bounds.cone = glm::vec4(axis, std::min(1.0f, std::sqrt(1.0f - minDot * minDot) + CONE_CUTOFF_MARGIN));
+	return bounds;
+}
+
+void Magnet::EngineBase::Assets::MeshletBuilder::append(Meshlets& output, const Meshlets& other)
+{
+	uint32_t vertexOffset = static_cast<uint32_t>(output.vertices.size());
+	uint32_t triangleOffset = static_cast<uint32_t>(output.triangles.size());
+	for (Meshlet meshlet : other.meshlets) {
+		meshlet.vertexOffset += vertexOffset;
+		meshlet.triangleOffset += triangleOffset;
+		output.meshlets.push_back(meshlet);
+	}
+	output.bounds.insert(output.bounds.end(), other.bounds.begin(), other.bounds.end());
+	output.vertices.insert(output.vertices.end(), other.vertices.begin(), other.vertices.end());
+	output.triangles.insert(output.triangles.end(), other.triangles.begin(), other.triangles.end());
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "../../Commons.h"
+#include "TriangleList.h"
+
+namespace Magnet {
+	namespace EngineBase {
+		namespace Assets {
+
+			// Splits triangle lists into meshlets, clusters of at most MAX_VERTICES vertices and MAX_TRIANGLES triangles
+			// small enough for one mesh shader workgroup :
+			//  - triangles are added greedily, favouring those sharing the most vertices with the meshlet or the last
+			//    ones left around a position, then those facing the same way so the normal cone stays narrow
+			//  - a full meshlet starts the next one from a triangle it had to leave out, so meshlets stay connected
+			//  - each meshlet gets a bounding sphere and a normal cone (axis, cutoff and apex), every triangle facing
+			//    away from a camera inside the cone behind the apex
+			// Meshlet vertices are indices into the source vertices, triangles three local indices packed in 8 bits each.
+			class MeshletBuilder {
+			public:
+				// Must match meshlet.mesh
+				static constexpr uint32_t MAX_VERTICES = 64;
+				static constexpr uint32_t MAX_TRIANGLES = 124;
+
+				// std430 layout, matches Meshlet in meshlet.glsl
+				struct Meshlet {
+					uint32_t vertexOffset;
+					uint32_t triangleOffset;
+					uint32_t vertexCount;
+					uint32_t triangleCount;
+				};
+
+				// std430 layout, matches MeshletBounds in meshlet.glsl
+				struct Bounds {
+					glm::vec4 sphere{ 0.0f };   // w is the radius
+					glm::vec4 coneApex{ 0.0f };
+					glm::vec4 cone{ 0.0f, 0.0f, 1.0f, 1.0f }; // xyz is the axis, w the cutoff, 1 never culls
+				};
+
+				struct Meshlets {
+					std::vector<Meshlet> meshlets;
+					std::vector<Bounds> bounds;
+					std::vector<uint32_t> vertices;
+					std::vector<uint32_t> triangles;
+				};
+
+				// Appends the meshlets of one triangle list, meshlet vertices point into the vertex buffer. Bounds are in the space
+				// of the list's positions
+				static void build(const TriangleList& triangleList, Meshlets& output);
+				// Sphere and cone of triangleCount triangles given by local indices into meshletVertices
+				static Bounds computeBounds(const uint32_t* meshletVertices, const uint32_t* triangles, uint32_t triangleCount, const TriangleList& triangleList);
+				// Appends other, offsetting its meshlets past the vertices and triangles already in output
+				static void append(Meshlets& output, const Meshlets& other);
+
+				static uint32_t packTriangle(uint32_t a, uint32_t b, uint32_t c) { return a | (b << 8) | (c << 16); }
+				static uint32_t unpackTriangle(uint32_t triangle, uint32_t corner) { return (triangle >> (corner * 8)) & 0xFF; }
+			};
+		}
+	}
+}
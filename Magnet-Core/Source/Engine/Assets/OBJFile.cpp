@@ -0,0 +1,526 @@
+#include "OBJFile.h"
+#include "MappedFile.h"
+#include "../Parallel.h"
+
+#include <charconv>
+#include <string_view>
+
+namespace {
+	constexpr int32_t MISSING = std::numeric_limits<int32_t>::min();
+
+	constexpr uint32_t RELATIVE_POSITION = 1;
+	constexpr uint32_t RELATIVE_TEXCOORD = 2;
+	constexpr uint32_t RELATIVE_NORMAL = 4;
+
+	// Attribute indices of a face corner, 0 based. Relative ones count from the start of their chunk until resolved
+	struct Corner {
+		int32_t position = MISSING;
+		int32_t texCoord = MISSING;
+		int32_t normal = MISSING;
+		uint32_t relative = 0;
+	};
+
+	// o, g or usemtl statement, applies from a triangle of its chunk on
+	struct StateChange {
+		uint32_t firstTriangle;
+		bool material;
+		std::string name;
+	};
+
+	struct Chunk {
+		std::vector<glm::vec3> positions;
+		// Empty until a position of the chunk has a color, then one per position
+		std::vector<glm::vec3> colors;
+		std::vector<glm::vec3> normals;
+		std::vector<glm::vec2> texCoords;
+		// Three per triangle
+		std::vector<Corner> corners;
+		std::vector<StateChange> changes;
+		std::vector<std::string> materialLibraries;
+	};
+
+	// Cursor over one line, without its end of line
+	struct Line {
+		const char* current;
+		const char* end;
+
+		void skipSpaces()
+		{
+			while (current < end && (*current == ' ' || *current == '\t')) {
+				current++;
+			}
+		}
+
+		bool atEnd()
+		{
+			skipSpaces();
+			return current == end;
+		}
+
+		std::string_view token()
+		{
+			skipSpaces();
+			const char* begin = current;
+			while (current < end && *current != ' ' && *current != '\t') {
+				current++;
+			}
+			return { begin, static_cast<size_t>(current - begin) };
+		}
+
+		// Rest of the line without surrounding spaces, names may contain some
+		std::string rest()
+		{
+			skipSpaces();
+			const char* last = end;
+			while (last > current && (last[-1] == ' ' || last[-1] == '\t')) {
+				last--;
+			}
+			return std::string(current, last);
+		}
+
+		template<typename T>
+		T number()
+		{
+			skipSpaces();
+			// from_chars takes no leading plus sign
+			if (current < end && *current == '+') {
+				current++;
+			}
+			T value{};
+			auto result = std::from_chars(current, end, value);
+			if (result.ec != std::errc{}) {
+				throw std::runtime_error("failed to parse OBJ file, invalid number!");
+			}
+			current = result.ptr;
+			return value;
+		}
+	};
+
+	int32_t toIndex(int32_t index, size_t count, uint32_t relativeFlag, Corner& corner)
+	{
+		if (index > 0) {
+			return index - 1;
+		}
+		if (index == 0) {
+			throw std::runtime_error("failed to parse OBJ file, index 0!");
+		}
+		// Negative indices count back from the last attribute read so far
+		corner.relative |= relativeFlag;
+		return static_cast<int32_t>(count) + index;
+	}
+
+	// v, v/vt, v//vn or v/vt/vn
+	Corner parseCorner(Line& line, const Chunk& chunk)
+	{
+		Corner corner;
+		corner.position = toIndex(line.number<int32_t>(), chunk.positions.size(), RELATIVE_POSITION, corner);
+		if (line.current < line.end && *line.current == '/') {
+			line.current++;
+			if (line.current < line.end && *line.current != '/') {
+				corner.texCoord = toIndex(line.number<int32_t>(), chunk.texCoords.size(), RELATIVE_TEXCOORD, corner);
+			}
+			if (line.current < line.end && *line.current == '/') {
+				line.current++;
+				corner.normal = toIndex(line.number<int32_t>(), chunk.normals.size(), RELATIVE_NORMAL, corner);
+			}
+		}
+		return corner;
+	}
+
+	// Calls statement(line) for every line of [begin, end), positioned after its keyword
+	template<typename Function>
+	void forEachLine(const char* begin, const char* end, Function statement)
+	{
+		while (begin < end) {
+			const char* lineEnd = static_cast<const char*>(memchr(begin, '\n', end - begin));
+			const char* next = lineEnd != nullptr ? lineEnd + 1 : end;
+			if (lineEnd == nullptr) {
+				lineEnd = end;
+			}
+			if (lineEnd > begin && lineEnd[-1] == '\r') {
+				lineEnd--;
+			}
+			Line line{ begin, lineEnd };
+			begin = next;
+			std::string_view keyword = line.token();
+			if (!keyword.empty() && keyword[0] != '#') {
+				statement(keyword, line);
+			}
+		}
+	}
+
+	void parseChunk(const char* begin, const char* end, Chunk& chunk)
+	{
+		std::vector<Corner> polygon;
+		forEachLine(begin, end, [&](std::string_view keyword, Line& line) {
+			if (keyword == "v") {
+				glm::vec3 position;
+				position.x = line.number<float>();
+				position.y = line.number<float>();
+				position.z = line.number<float>();
+				chunk.positions.push_back(position);
+				// Either an optional w or an RGB color
+				float extra[3];
+				uint32_t extraCount = 0;
+				while (extraCount < 3 && !line.atEnd()) {
+					extra[extraCount++] = line.number<float>();
+				}
+				if (extraCount == 3) {
+					chunk.colors.resize(chunk.positions.size() - 1, glm::vec3(1.0f));
+					chunk.colors.push_back({ extra[0], extra[1], extra[2] });
+				}
+				else if (!chunk.colors.empty()) {
+					chunk.colors.push_back(glm::vec3(1.0f));
+				}
+			}
+			else if (keyword == "vt") {
+				glm::vec2 texCoord;
+				texCoord.x = line.number<float>();
+				texCoord.y = line.atEnd() ? 0.0f : line.number<float>();
+				chunk.texCoords.push_back(texCoord);
+			}
+			else if (keyword == "vn") {
+				glm::vec3 normal;
+				normal.x = line.number<float>();
+				normal.y = line.number<float>();
+				normal.z = line.number<float>();
+				chunk.normals.push_back(normal);
+			}
+			else if (keyword == "f") {
+				polygon.clear();
+				while (!line.atEnd()) {
+					polygon.push_back(parseCorner(line, chunk));
+				}
+				// Triangle fan around the first corner
+				for (size_t i = 1; i + 1 < polygon.size(); i++) {
+					chunk.corners.push_back(polygon[0]);
+					chunk.corners.push_back(polygon[i]);
+					chunk.corners.push_back(polygon[i + 1]);
+				}
+			}
+			else if (keyword == "o" || keyword == "g") {
+				chunk.changes.push_back({ static_cast<uint32_t>(chunk.corners.size() / 3), false, line.rest() });
+			}
+			else if (keyword == "usemtl") {
+				chunk.changes.push_back({ static_cast<uint32_t>(chunk.corners.size() / 3), true, line.rest() });
+			}
+			else if (keyword == "mtllib") {
+				while (!line.atEnd()) {
+					chunk.materialLibraries.emplace_back(line.token());
+				}
+			}
+			// Smoothing groups, lines, points and free form geometry are ignored
+		});
+	}
+
+	// Vertex of every distinct v/vt/vn triplet, linear probing in a power of two table kept at most half full
+	class VertexTable {
+	public:
+		explicit VertexTable(size_t expectedCount)
+		{
+			size_t capacity = 1024;
+			while (capacity < expectedCount * 2) {
+				capacity *= 2;
+			}
+			entries.assign(capacity, Entry{});
+		}
+
+		// Existing vertex of the corner, or vertex once stored when inserted is set
+		uint32_t insert(const Corner& corner, uint32_t vertex, bool& inserted)
+		{
+			if ((count + 1) * 2 > entries.size()) {
+				grow();
+			}
+			size_t mask = entries.size() - 1;
+			for (size_t slot = hash(corner) & mask;; slot = (slot + 1) & mask) {
+				Entry& entry = entries[slot];
+				if (entry.vertex == EMPTY) {
+					entry = { corner.position, corner.texCoord, corner.normal, vertex };
+					count++;
+					inserted = true;
+					return vertex;
+				}
+				if (entry.position == corner.position && entry.texCoord == corner.texCoord && entry.normal == corner.normal) {
+					inserted = false;
+					return entry.vertex;
+				}
+			}
+		}
+
+	private:
+		static constexpr uint32_t EMPTY = ~0u;
+
+		struct Entry {
+			int32_t position = 0;
+			int32_t texCoord = 0;
+			int32_t normal = 0;
+			uint32_t vertex = EMPTY;
+		};
+
+		static size_t hash(int32_t position, int32_t texCoord, int32_t normal)
+		{
+			uint64_t h = uint32_t(position) * 0x9E3779B97F4A7C15ull;
+			h ^= uint32_t(texCoord) * 0xC2B2AE3D27D4EB4Full;
+			h ^= uint32_t(normal) * 0x165667B19E3779F9ull;
+			// Final mix, the table is indexed by the low bits
+			h ^= h >> 31;
+			h *= 0xBF58476D1CE4E5B9ull;
+			h ^= h >> 29;
+			return static_cast<size_t>(h);
+		}
+
+		static size_t hash(const Corner& corner) { return hash(corner.position, corner.texCoord, corner.normal); }
+
+		void grow()
+		{
+			std::vector<Entry> old(entries.size() * 2, Entry{});
+			old.swap(entries);
+			size_t mask = entries.size() - 1;
+			for (const Entry& entry : old) {
+				if (entry.vertex == EMPTY) {
+					continue;
+				}
+				size_t slot = hash(entry.position, entry.texCoord, entry.normal) & mask;
+				while (entries[slot].vertex != EMPTY) {
+					slot = (slot + 1) & mask;
+				}
+				entries[slot] = entry;
+			}
+		}
+
+		std::vector<Entry> entries;
+		size_t count = 0;
+	};
+
+	void checkIndex(int32_t index, size_t count, bool optional)
+	{
+		if (optional && index == MISSING) {
+			return;
+		}
+		if (index < 0 || static_cast<size_t>(index) >= count) {
+			throw std::runtime_error("failed to parse OBJ file, index out of range!");
+		}
+	}
+}
+
+Magnet::EngineBase::Assets::OBJFile::OBJFile(const std::string& path, const Settings& settings)
+{
+	std::vector<Chunk> chunks;
+	{
+		MappedFile file{ path };
+		fileSize = file.size();
+		const char* text = reinterpret_cast<const char*>(file.data());
+
+		// Chunks end after a line feed, the last one at the end of the file
+		std::vector<std::pair<size_t, size_t>> ranges;
+		size_t chunkSize = std::max<size_t>(settings.chunkSize, 1);
+		for (size_t begin = 0; begin < fileSize;) {
+			size_t end = std::min(begin + chunkSize, fileSize);
+			if (end < fileSize) {
+				const void* lineFeed = memchr(text + end, '\n', fileSize - end);
+				end = lineFeed != nullptr ? static_cast<const char*>(lineFeed) - text + 1 : fileSize;
+			}
+			ranges.push_back({ begin, end });
+			begin = end;
+		}
+		chunkCount = static_cast<uint32_t>(ranges.size());
+
+		chunks.resize(ranges.size());
+		parallelFor(ranges.size(), [&](size_t i) {
+			parseChunk(text + ranges[i].first, text + ranges[i].second, chunks[i]);
+		}, settings.threadCount);
+	}
+
+	// Where the attributes and triangles of every chunk start once appended
+	struct Bases {
+		size_t position = 0;
+		size_t texCoord = 0;
+		size_t normal = 0;
+		size_t triangle = 0;
+	};
+	std::vector<Bases> bases(chunks.size() + 1);
+	bool hasColors = false;
+	for (size_t i = 0; i < chunks.size(); i++) {
+		bases[i + 1].position = bases[i].position + chunks[i].positions.size();
+		bases[i + 1].texCoord = bases[i].texCoord + chunks[i].texCoords.size();
+		bases[i + 1].normal = bases[i].normal + chunks[i].normals.size();
+		bases[i + 1].triangle = bases[i].triangle + chunks[i].corners.size() / 3;
+		hasColors = hasColors || !chunks[i].colors.empty();
+	}
+	const Bases& totals = bases.back();
+
+	std::vector<glm::vec3> positions(totals.position);
+	std::vector<glm::vec3> colors(hasColors ? totals.position : 0);
+	std::vector<glm::vec2> texCoords(totals.texCoord);
+	std::vector<glm::vec3> normals(totals.normal);
+	std::vector<Corner> corners(totals.triangle * 3);
+	parallelFor(chunks.size(), [&](size_t i) {
+		Chunk& chunk = chunks[i];
+		const Bases& base = bases[i];
+		std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + base.position);
+		if (hasColors) {
+			if (chunk.colors.empty()) {
+				std::fill_n(colors.begin() + base.position, chunk.positions.size(), glm::vec3(1.0f));
+			}
+			else {
+				std::copy(chunk.colors.begin(), chunk.colors.end(), colors.begin() + base.position);
+			}
+		}
+		std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), texCoords.begin() + base.texCoord);
+		std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + base.normal);
+
+		Corner* output = corners.data() + base.triangle * 3;
+		for (size_t c = 0; c < chunk.corners.size(); c++) {
+			Corner corner = chunk.corners[c];
+			corner.position += (corner.relative & RELATIVE_POSITION) ? static_cast<int32_t>(base.position) : 0;
+			corner.texCoord += (corner.relative & RELATIVE_TEXCOORD) ? static_cast<int32_t>(base.texCoord) : 0;
+			corner.normal += (corner.relative & RELATIVE_NORMAL) ? static_cast<int32_t>(base.normal) : 0;
+			checkIndex(corner.position, totals.position, false);
+			checkIndex(corner.texCoord, totals.texCoord, true);
+			checkIndex(corner.normal, totals.normal, true);
+			output[c] = corner;
+		}
+		chunk.positions = {};
+		chunk.colors = {};
+		chunk.texCoords = {};
+		chunk.normals = {};
+		chunk.corners = {};
+	});
+
+	// Libraries in order of first mention, later definitions of a name win like in tinyobj
+	std::vector<std::string> libraries;
+	for (const auto& chunk : chunks) {
+		for (const auto& library : chunk.materialLibraries) {
+			if (std::find(libraries.begin(), libraries.end(), library) == libraries.end()) {
+				libraries.push_back(library);
+			}
+		}
+	}
+	std::filesystem::path directory = std::filesystem::path(path).parent_path();
+	for (const auto& library : libraries) {
+		loadMaterials(directory / library);
+	}
+	std::unordered_map<std::string, int32_t> materialIndices;
+	for (size_t i = 0; i < materials.size(); i++) {
+		materialIndices[materials[i].name] = static_cast<int32_t>(i);
+	}
+
+	// Runs of triangles sharing a group and a material, in file order
+	struct Span {
+		size_t firstTriangle;
+		size_t triangleCount;
+		uint32_t group;
+		int32_t material;
+	};
+	std::vector<Span> spans;
+	uint32_t group = 0;
+	int32_t material = -1;
+	size_t spanStart = 0;
+	auto closeSpan = [&](size_t end) {
+		if (end > spanStart) {
+			spans.push_back({ spanStart, end - spanStart, group, material });
+		}
+		spanStart = end;
+	};
+	for (size_t i = 0; i < chunks.size(); i++) {
+		for (const auto& change : chunks[i].changes) {
+			closeSpan(bases[i].triangle + change.firstTriangle);
+			if (change.material) {
+				auto found = materialIndices.find(change.name);
+				material = found != materialIndices.end() ? found->second : -1;
+			}
+			else {
+				group++;
+			}
+		}
+	}
+	closeSpan(totals.triangle);
+
+	// Submeshes by group then material in order of first use, vertices numbered as their corners come
+	VertexTable table{ totals.position };
+	vertices.reserve(totals.position);
+	indices.reserve(corners.size());
+	for (size_t groupBegin = 0; groupBegin < spans.size();) {
+		size_t groupEnd = groupBegin;
+		std::vector<int32_t> groupMaterials;
+		while (groupEnd < spans.size() && spans[groupEnd].group == spans[groupBegin].group) {
+			if (std::find(groupMaterials.begin(), groupMaterials.end(), spans[groupEnd].material) == groupMaterials.end()) {
+				groupMaterials.push_back(spans[groupEnd].material);
+			}
+			groupEnd++;
+		}
+
+		for (int32_t groupMaterial : groupMaterials) {
+			uint32_t firstIndex = static_cast<uint32_t>(indices.size());
+			for (size_t s = groupBegin; s < groupEnd; s++) {
+				if (spans[s].material != groupMaterial) {
+					continue;
+				}
+				const Corner* spanCorners = corners.data() + spans[s].firstTriangle * 3;
+				for (size_t c = 0; c < spans[s].triangleCount * 3; c++) {
+					const Corner& corner = spanCorners[c];
+					bool inserted;
+					uint32_t vertexIndex = table.insert(corner, static_cast<uint32_t>(vertices.size()), inserted);
+					if (inserted) {
+						MeshFile::Vertex vertex{};
+						vertex.pos = positions[corner.position];
+						vertex.color = hasColors ? colors[corner.position] : glm::vec3(1.0f);
+						if (corner.normal != MISSING) {
+							vertex.normal = normals[corner.normal];
+						}
+						if (corner.texCoord != MISSING) {
+							// OBJ has its origin at the bottom left
+							vertex.uv = { texCoords[corner.texCoord].x, 1.0f - texCoords[corner.texCoord].y };
+						}
+						vertices.push_back(vertex);
+					}
+					indices.push_back(vertexIndex);
+				}
+			}
+			submeshes.push_back({ firstIndex, static_cast<uint32_t>(indices.size()) - firstIndex, groupMaterial });
+		}
+		groupBegin = groupEnd;
+	}
+}
+
+void Magnet::EngineBase::Assets::OBJFile::loadMaterials(const std::filesystem::path& path)
+{
+	// A missing library leaves its faces without material, as tinyobj does
+	if (!std::filesystem::exists(path)) {
+		return;
+	}
+	MappedFile file{ path.string() };
+	const char* text = reinterpret_cast<const char*>(file.data());
+	bool dissolveSet = false;
+	forEachLine(text, text + file.size(), [&](std::string_view keyword, Line& line) {
+		if (keyword == "newmtl") {
+			materials.emplace_back().name = line.rest();
+			dissolveSet = false;
+			return;
+		}
+		if (materials.empty()) {
+			return;
+		}
+		Material& material = materials.back();
+		if (keyword == "Kd") {
+			material.diffuse.r = line.number<float>();
+			material.diffuse.g = line.number<float>();
+			material.diffuse.b = line.number<float>();
+		}
+		else if (keyword == "d") {
+			material.diffuse.a = line.number<float>();
+			dissolveSet = true;
+		}
+		else if (keyword == "Tr" && !dissolveSet) {
+			material.diffuse.a = 1.0f - line.number<float>();
+		}
+		else if (keyword == "map_Kd") {
+			// Options come first, the file name is the last token
+			std::string texture = line.rest();
+			if (!texture.empty() && texture[0] == '-') {
+				texture = texture.substr(texture.find_last_of(" \t") + 1);
+			}
+			material.diffuseTexture = texture;
+		}
+	});
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "../../Commons.h"
+#include "MeshFile.h"
+
+namespace Magnet {
+	namespace EngineBase {
+		namespace Assets {
+
+			// Wavefront OBJ mapped in memory and parsed in parallel straight into an indexed mesh :
+			//  - the file is split into line aligned chunks, each parsed by a worker with std::from_chars into its own
+			//    attribute and face lists, appended in file order once all are done. Relative (negative) indices are
+			//    resolved against the attribute counts of the preceding chunks
+			//  - polygons are triangulated as fans, triangles are grouped by object or group (o, g) then by material in
+			//    order of first use, every non empty group becomes a submesh
+			//  - each distinct v/vt/vn triplet becomes one vertex, looked up in an open addressing hash table
+			// Materials are read from the mtllib files next to the OBJ, only the diffuse color, dissolve and diffuse
+			// texture. Texture coordinates are flipped to a top left origin, vertices without color are white.
+			class OBJFile {
+			public:
+				struct Settings {
+					// Approximate bytes of a parsed chunk, chunks end on a line
+					size_t chunkSize = size_t(256) << 10;
+					// Workers parsing chunks, 0 for all
+					uint32_t threadCount = 0;
+				};
+
+				struct Material {
+					std::string name;
+					glm::vec4 diffuse{ 0.0f, 0.0f, 0.0f, 1.0f };
+					std::string diffuseTexture;
+				};
+
+				// Triangles of one group using one material, -1 without material or with an unknown one
+				struct Submesh {
+					uint32_t firstIndex = 0;
+					uint32_t indexCount = 0;
+					int32_t material = -1;
+				};
+
+				OBJFile(const std::string& path, const Settings& settings);
+
+				// Not const so the mesh can be moved out
+				std::vector<MeshFile::Vertex>& getVertices() { return vertices; }
+				std::vector<uint32_t>& getIndices() { return indices; }
+				const std::vector<Submesh>& getSubmeshes() const { return submeshes; }
+				const std::vector<Material>& getMaterials() const { return materials; }
+
+				size_t getFileSize() const { return fileSize; }
+				uint32_t getChunkCount() const { return chunkCount; }
+
+			private:
+				void loadMaterials(const std::filesystem::path& path);
+
+				std::vector<MeshFile::Vertex> vertices;
+				std::vector<uint32_t> indices;
+				std::vector<Submesh> submeshes;
+				std::vector<Material> materials;
+				size_t fileSize = 0;
+				uint32_t chunkCount = 0;
+			};
+		}
+	}
+}
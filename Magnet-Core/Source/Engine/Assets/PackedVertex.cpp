@@ -0,0 +1,125 @@
+#include "PackedVertex.h"
+
+#include <glm/gtc/packing.hpp>
+
+namespace {
+	int16_t toSnorm16(float value)
+	{
+		return static_cast<int16_t>(std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+	}
+
+	uint16_t toUnorm16(float value)
+	{
+		return static_cast<uint16_t>(std::round(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+	}
+}
+
+glm::vec4 Magnet::EngineBase::Assets::PackedVertex::getQuantization(const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	// Empty bounds (min above max) still make a valid box
+	glm::vec3 extent = glm::max(boundsMax - boundsMin, glm::vec3(0.0f));
+	float size = std::max({ extent.x, extent.y, extent.z, std::numeric_limits<float>::min() });
+	return glm::vec4(glm::min(boundsMin, boundsMax), size);
+}
+
+glm::mat4 Magnet::EngineBase::Assets::PackedVertex::getDequantizationMatrix(const glm::vec4& quantization)
+{
+	return glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(quantization)), glm::vec3(quantization.w));
+}
+
+glm::vec2 Magnet::EngineBase::Assets::PackedVertex::encodeOctahedral(const glm::vec3& normal)
+{
+	float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+	if (length == 0.0f) {
+		return glm::vec2(0.0f);
+	}
+	glm::vec3 n = normal / length;
+	glm::vec2 encoded{ n.x, n.y };
+	// The lower hemisphere is folded over the diagonals
+	if (n.z < 0.0f) {
+		encoded = (1.0f - glm::abs(glm::vec2(n.y, n.x))) * glm::vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+	}
+	return encoded;
+}
+
+glm::vec3 Magnet::EngineBase::Assets::PackedVertex::decodeOctahedral(const glm::vec2& encoded)
+{
+	glm::vec3 n{ encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y) };
+	float t = std::max(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	return glm::normalize(n);
+}
+
+Magnet::EngineBase::Assets::PackedVertex Magnet::EngineBase::Assets::PackedVertex::pack(const MeshFile::Vertex& vertex, const glm::vec4& quantization)
+{
+	return pack(vertex.pos, vertex.normal, vertex.uv, quantization);
+}
+
+Magnet::EngineBase::Assets::PackedVertex Magnet::EngineBase::Assets::PackedVertex::pack(const glm::vec3& position, const glm::vec3& normal, const glm::vec2& uv, const glm::vec4& quantization)
+{
+	PackedVertex packed;
+	glm::vec3 boxPosition = (position - glm::vec3(quantization)) / quantization.w;
+	packed.position[0] = toUnorm16(boxPosition.x);
+	packed.position[1] = toUnorm16(boxPosition.y);
+	packed.position[2] = toUnorm16(boxPosition.z);
+	packed.position[3] = 65535;
+	// Octahedral encoding divides by the L1 norm, so any length works
+	glm::vec2 encoded = encodeOctahedral(normal);
+	packed.normal[0] = toSnorm16(encoded.x);
+	packed.normal[1] = toSnorm16(encoded.y);
+	packed.uv[0] = glm::packHalf1x16(uv.x);
+	packed.uv[1] = glm::packHalf1x16(uv.y);
+	return packed;
+}
+
+uint32_t Magnet::EngineBase::Assets::PackedVertex::packColor(const glm::vec3& color)
+{
+	return glm::packUnorm4x8(glm::vec4(color, 1.0f));
+}
+
+void Magnet::EngineBase::Assets::PackedVertex::pack(const MeshFile::Vertex* vertices, size_t count, const glm::vec4& quantization, PackedVertex* output)
+{
+	for (size_t i = 0; i < count; i++) {
+		output[i] = pack(vertices[i], quantization);
+	}
+}
+
+std::vector<uint32_t> Magnet::EngineBase::Assets::PackedVertex::packColors(const MeshFile::Vertex* vertices, size_t count)
+{
+	const uint32_t white = packColor(glm::vec3(1.0f));
+	std::vector<uint32_t> colors;
+	for (size_t i = 0; i < count; i++) {
+		uint32_t color = packColor(vertices[i].color);
+		if (color != white && colors.empty()) {
+			colors.resize(count);
+			for (size_t j = 0; j < i; j++) {
+				colors[j] = white;
+			}
+		}
+		if (!colors.empty()) {
+			colors[i] = color;
+		}
+	}
+	if (colors.empty()) {
+		colors.push_back(white);
+	}
+	return colors;
+}
+
+std::vector<VkVertexInputBindingDescription> Magnet::EngineBase::Assets::PackedVertex::getBindingDescriptions(bool perVertexColors)
+{
+	return {
+		{ 0, sizeof(PackedVertex), VK_VERTEX_INPUT_RATE_VERTEX },
+		{ 1, COLOR_STRIDE, perVertexColors ? VK_VERTEX_INPUT_RATE_VERTEX : VK_VERTEX_INPUT_RATE_INSTANCE } };
+}
+
+std::vector<VkVertexInputAttributeDescription> Magnet::EngineBase::Assets::PackedVertex::getAttributeDescriptions()
+{
+	return {
+		{ 0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(PackedVertex, position) },
+		{ 1, 1, VK_FORMAT_R8G8B8A8_UNORM, 0 },
+		{ 2, 0, VK_FORMAT_R16G16_SNORM, offsetof(PackedVertex, normal) },
+		{ 3, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(PackedVertex, uv) },
+	};
+}
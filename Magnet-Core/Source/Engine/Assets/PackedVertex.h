@@ -0,0 +1,45 @@
+#pragma once
+#include "../../Commons.h"
+#include "MeshFile.h"
+
+namespace Magnet {
+	namespace EngineBase {
+		namespace Assets {
+
+			// GPU vertex, 16 bytes instead of the 44 of MeshFile::Vertex :
+			//  - position as unorm16 inside the mesh's quantization box, w being 1 so the box transform folds into the model matrix
+			//  - normal octahedral encoded in two snorm16
+			//  - UV as two half floats
+			// Colors are a separate stream of RGBA8 (binding 1), per vertex only when they vary. Constant colors use a single
+			// entry read at instance rate. Must match shader.vert and packed_vertex.glsl.
+			struct PackedVertex {
+				uint16_t position[4];
+				int16_t normal[2];
+				uint16_t uv[2];
+
+				static constexpr uint32_t COLOR_STRIDE = sizeof(uint32_t);
+
+				// xyz is the box origin and w its size. The box is a cube, its scale being uniform the folded matrix
+				// still transforms normals correctly
+				static glm::vec4 getQuantization(const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+				static glm::mat4 getDequantizationMatrix(const glm::vec4& quantization);
+
+				static PackedVertex pack(const MeshFile::Vertex& vertex, const glm::vec4& quantization);
+				// From attributes read in place, normals need not be normalized
+				static PackedVertex pack(const glm::vec3& position, const glm::vec3& normal, const glm::vec2& uv, const glm::vec4& quantization);
+				static uint32_t packColor(const glm::vec3& color);
+				static glm::vec2 encodeOctahedral(const glm::vec3& normal);
+				static glm::vec3 decodeOctahedral(const glm::vec2& encoded);
+
+				static void pack(const MeshFile::Vertex* vertices, size_t count, const glm::vec4& quantization, PackedVertex* output);
+				// The stream is white and a single entry when every color is
+				static std::vector<uint32_t> packColors(const MeshFile::Vertex* vertices, size_t count);
+
+				static std::vector<VkVertexInputBindingDescription> getBindingDescriptions(bool perVertexColors);
+				// Locations match the inputs of shader.vert
+				static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+			};
+			static_assert(sizeof(PackedVertex) == 16, "PackedVertex must stay 16 bytes");
+		}
+	}
+}
@@ -0,0 +1,71 @@
+#include "TriangleList.h"
+#include "Kernels.h"
+
+void Magnet::EngineBase::Assets::TriangleList::getVertexBounds(uint32_t& minVertex, uint32_t& maxVertex) const
+{
+	if (indices == nullptr) {
+		minVertex = baseVertex;
+		maxVertex = baseVertex + static_cast<uint32_t>(indexCount) - 1;
+		return;
+	}
+	auto bounds = [&](const auto* typed) {
+		auto [lowest, highest] = std::minmax_element(typed, typed + indexCount);
+		minVertex = baseVertex + *lowest;
+		maxVertex = baseVertex + *highest;
+	};
+	switch (indexSize) {
+	case sizeof(uint8_t): bounds(static_cast<const uint8_t*>(indices)); break;
+	case sizeof(uint16_t): bounds(static_cast<const uint16_t*>(indices)); break;
+	default: bounds(static_cast<const uint32_t*>(indices)); break;
+	}
+}
+
+void Magnet::EngineBase::Assets::TriangleList::write(uint32_t base, uint32_t* destination) const
+{
+	// Offsets wrap, base is never past the lowest index
+	uint32_t offset = baseVertex - base;
+	switch (indices ? indexSize : 0) {
+	case 0:
+		for (size_t i = 0; i < indexCount; i++) {
+			destination[i] = offset + static_cast<uint32_t>(i);
+		}
+		break;
+	case sizeof(uint8_t): Kernels::widenIndices(static_cast<const uint8_t*>(indices), indexCount, offset, destination); break;
+	case sizeof(uint16_t): Kernels::widenIndices(static_cast<const uint16_t*>(indices), indexCount, offset, destination); break;
+	default: Kernels::widenIndices(static_cast<const uint32_t*>(indices), indexCount, offset, destination); break;
+	}
+}
+
+void Magnet::EngineBase::Assets::TriangleList::write(uint32_t base, uint16_t* destination) const
+{
+	uint32_t offset = baseVertex - base;
+	switch (indices ? indexSize : 0) {
+	case 0:
+		for (size_t i = 0; i < indexCount; i++) {
+			destination[i] = static_cast<uint16_t>(offset + i);
+		}
+		break;
+	case sizeof(uint8_t): {
+		const auto* source = static_cast<const uint8_t*>(indices);
+		for (size_t i = 0; i < indexCount; i++) {
+			destination[i] = static_cast<uint16_t>(offset + source[i]);
+		}
+		break;
+	}
+	case sizeof(uint16_t): {
+		// glTF 16-bit indices usually start at the primitive's first vertex, and are copied as is
+		const auto* source = static_cast<const uint16_t*>(indices);
+		if (offset == 0) {
+			memcpy(destination, source, indexCount * sizeof(uint16_t));
+			break;
+		}
+		for (size_t i = 0; i < indexCount; i++) {
+			destination[i] = static_cast<uint16_t>(offset + source[i]);
+		}
+		break;
+	}
+	default:
+		Kernels::narrowIndices(static_cast<const uint32_t*>(indices), indexCount, base - baseVertex, destination);
+		break;
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "../../Commons.h"
+
+namespace Magnet {
+	namespace EngineBase {
+		namespace Assets {
+
+			// Triangle list read in place from a loader's source : 8, 16 or 32-bit indices (sequential without), relative to
+			// baseVertex in the vertex buffer being built, and the positions they index. Positions are floats, or the unorm16
+			// positions of PackedVertex read in the unit cube of their quantization box.
+			struct TriangleList {
+				const void* indices = nullptr;
+				uint32_t indexSize = sizeof(uint32_t);
+				size_t indexCount = 0;
+				uint32_t baseVertex = 0;
+				const unsigned char* positions = nullptr;
+				size_t positionStride = 0;
+				bool quantized = false;
+
+				// Relative to baseVertex
+				uint32_t getIndex(size_t i) const
+				{
+					switch (indexSize) {
+					case sizeof(uint8_t): return static_cast<const uint8_t*>(indices)[i];
+					case sizeof(uint16_t): return static_cast<const uint16_t*>(indices)[i];
+					default: return indices ? static_cast<const uint32_t*>(indices)[i] : static_cast<uint32_t>(i);
+					}
+				}
+
+				glm::vec3 getPosition(uint32_t index) const
+				{
+					const unsigned char* position = positions + index * positionStride;
+					if (quantized) {
+						const auto* unorm = reinterpret_cast<const uint16_t*>(position);
+						return glm::vec3(unorm[0], unorm[1], unorm[2]) / 65535.0f;
+					}
+					return *reinterpret_cast<const glm::vec3*>(position);
+				}
+
+				// Lowest and highest index in the vertex buffer, the list must not be empty
+				void getVertexBounds(uint32_t& minVertex, uint32_t& maxVertex) const;
+				// Indices in the vertex buffer minus base, every one of them within 65535 of base for the 16-bit destination
+				void write(uint32_t base, uint32_t* destination) const;
+				void write(uint32_t base, uint16_t* destination) const;
+			};
+		}
+	}
+}
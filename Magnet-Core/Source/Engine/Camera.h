@@ -85,6 +85,11 @@ namespace Magnet {
 				return zfar;
 			}
 
+			// Vertical, in degrees
+			float getFov() {
+				return fov;
+			}
+
 			void setPerspective(float fov, float aspect, float znear, float zfar)
 			{
 				glm::mat4 currentMatrix = matrices.perspective;
@@ -0,0 +1,48 @@
+#include "Parallel.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+uint32_t Magnet::EngineBase::getWorkerCount()
+{
+	return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+void Magnet::EngineBase::parallelFor(size_t count, const std::function<void(size_t)>& job, uint32_t threadCount)
+{
+	if (count == 0) {
+		return;
+	}
+	threadCount = static_cast<uint32_t>(std::min<size_t>(threadCount > 0 ? threadCount : getWorkerCount(), count));
+
+	std::atomic<size_t> next{ 0 };
+	std::atomic<bool> failed{ false };
+	std::exception_ptr exception;
+	std::mutex exceptionMutex;
+	auto worker = [&]() {
+		for (size_t i = next++; i < count && !failed; i = next++) {
+			try {
+				job(i);
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock{ exceptionMutex };
+				if (!exception) {
+					exception = std::current_exception();
+				}
+				failed = true;
+			}
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (uint32_t i = 1; i < threadCount; i++) {
+		workers.emplace_back(worker);
+	}
+	worker();
+	for (auto& thread : workers) {
+		thread.join();
+	}
+	if (exception) {
+		std::rethrow_exception(exception);
+	}
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include "../Commons.h"
+#include <functional>
+
+namespace Magnet {
+
+	namespace EngineBase {
+
+		// Worker threads available for parallel loops, at least 1
+		uint32_t getWorkerCount();
+
+		// Runs job(i) for every i in [0, count), workers pull indices from a shared counter so uneven jobs balance out.
+		// The calling thread takes part, the first exception thrown by a job is rethrown once every worker is done
+		void parallelFor(size_t count, const std::function<void(size_t)>& job, uint32_t threadCount = 0);
+	}
+}
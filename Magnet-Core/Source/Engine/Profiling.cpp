@@ -0,0 +1,34 @@
+#include "Profiling.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+size_t Magnet::EngineBase::getPeakResidentBytes()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters{};
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+		return counters.PeakWorkingSetSize;
+	}
+	return 0;
+#else
+	struct rusage usage {};
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return 0;
+	}
+#ifdef __APPLE__
+	return static_cast<size_t>(usage.ru_maxrss);
+#else
+	// Kilobytes on Linux
+	return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "../Commons.h"
+
+namespace Magnet {
+
+	namespace EngineBase {
+
+		// Collects CPU timings of a recurring operation (frames, pipeline creation...) and reports
+		// average, percentiles and hitches, i.e. samples above a fixed threshold.
+		class TimingStats {
+		public:
+			TimingStats(std::string name, double hitchThresholdMs = 4.0) : name{ name }, hitchThresholdMs{ hitchThresholdMs } {}
+
+			void add(double ms) {
+				samples.push_back(ms);
+				total += ms;
+				if (ms > hitchThresholdMs) {
+					hitchCount++;
+				}
+			}
+
+			void reset() {
+				samples.clear();
+				total = 0.0;
+				hitchCount = 0;
+			}
+
+			size_t count() const { return samples.size(); }
+			size_t hitches() const { return hitchCount; }
+			double sum() const { return total; }
+			double average() const { return samples.empty() ? 0.0 : total / samples.size(); }
+			double max() const { return samples.empty() ? 0.0 : *std::max_element(samples.begin(), samples.end()); }
+
+			double percentile(double p) const {
+				if (samples.empty()) {
+					return 0.0;
+				}
+				std::vector<double> sorted = samples;
+				size_t index = std::min(sorted.size() - 1, static_cast<size_t>(p / 100.0 * sorted.size()));
+				std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+				return sorted[index];
+			}
+
+			void print() const {
+				std::cout << "\t- " << name << " : " << count() << " samples, avg " << average() << " ms, p99 " << percentile(99.0)
+					<< " ms, max " << max() << " ms, " << hitches() << " hitches (> " << hitchThresholdMs << " ms)" << std::endl;
+			}
+
+		private:
+			std::string name;
+			double hitchThresholdMs;
+			std::vector<double> samples;
+			double total = 0.0;
+			size_t hitchCount = 0;
+		};
+
+		// Peak resident memory of the process since it started, 0 when unavailable
+		size_t getPeakResidentBytes();
+
+		// Adds the lifetime of the scope to a TimingStats
+		class ScopedTimer {
+		public:
+			ScopedTimer(TimingStats& stats) : stats{ stats }, start{ std::chrono::high_resolution_clock::now() } {}
+			~ScopedTimer() {
+				stats.add(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+			}
+
+			ScopedTimer(const ScopedTimer&) = delete;
+			ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+		private:
+			TimingStats& stats;
+			std::chrono::high_resolution_clock::time_point start;
+		};
+	}
+}
@@ -0,0 +1,207 @@
+#include "ClusteredLighting.h"
+#include "../../VK/Pipeline.h"
+
+#include <random>
+
+Magnet::EngineBase::Rendering::ClusteredLighting::ClusteredLighting(VKBase::Device& device, const std::string& cullShaderPath, uint32_t frameCount) : device{ device }
+{
+	createBuffers(frameCount);
+	createDescriptors();
+	createCullPipeline(cullShaderPath);
+}
+
+Magnet::EngineBase::Rendering::ClusteredLighting::~ClusteredLighting()
+{
+	vkDestroyPipeline(device.device(), cullPipeline, nullptr);
+	vkDestroyPipelineLayout(device.device(), cullPipelineLayout, nullptr);
+}
+
+void Magnet::EngineBase::Rendering::ClusteredLighting::createBuffers(uint32_t frameCount)
+{
+	// Parameters change every frame, one aligned instance per frame in flight selected with a dynamic offset
+	paramsBuffer = std::make_unique<VKBase::Buffer>(
+		device,
+		sizeof(ClusterParams),
+		frameCount,
+		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		device.properties.limits.minUniformBufferOffsetAlignment);
+	paramsBuffer->map();
+
+	// Rewritten when the lights change while the previous frames still read their own copy
+	lightBuffer = std::make_unique<VKBase::Buffer>(
+		device,
+		sizeof(PointLight) * MAX_LIGHTS,
+		frameCount,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		device.properties.limits.minStorageBufferOffsetAlignment);
+	lightBuffer->map();
+
+	// Written by the binning pass, read by the fragment shader
+	lightGridBuffer = std::make_unique<VKBase::Buffer>(
+		device,
+		sizeof(uint32_t),
+		CLUSTER_COUNT,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	lightIndexBuffer = std::make_unique<VKBase::Buffer>(
+		device,
+		sizeof(uint32_t),
+		CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+}
+
+void Magnet::EngineBase::Rendering::ClusteredLighting::createDescriptors()
+{
+	VkShaderStageFlags stages = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+	setLayout = VKBase::DescriptorSetLayout::Builder(device)
+		.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, stages)
+		.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, stages)
+		.addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages)
+		.addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages)
+		.build();
+
+	descriptorPool = VKBase::DescriptorPool::Builder(device)
+		.setMaxSets(1)
+		.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1)
+		.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1)
+		.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2)
+		.build();
+
+	auto paramsInfo = paramsBuffer->descriptorInfo(sizeof(ClusterParams), 0);
+	auto lightInfo = lightBuffer->descriptorInfo(sizeof(PointLight) * MAX_LIGHTS, 0);
+	auto lightGridInfo = lightGridBuffer->descriptorInfo();
+	auto lightIndexInfo = lightIndexBuffer->descriptorInfo();
+
+	bool built = VKBase::DescriptorWriter(*setLayout, *descriptorPool)
+		.writeBuffer(0, &paramsInfo)
+		.writeBuffer(1, &lightInfo)
+		.writeBuffer(2, &lightGridInfo)
+		.writeBuffer(3, &lightIndexInfo)
+		.build(descriptorSet);
+	if (!built) {
+		throw std::runtime_error("failed to allocate clustered lighting descriptor set!");
+	}
+}
+
+void Magnet::EngineBase::Rendering::ClusteredLighting::createCullPipeline(const std::string& cullShaderPath)
+{
+	VkDescriptorSetLayout layout = setLayout->getDescriptorSetLayout();
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &layout;
+
+	if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &cullPipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create light culling pipeline layout!");
+	}
+
+	auto code = VKBase::Pipeline::readFile(cullShaderPath);
+	VkShaderModuleCreateInfo moduleInfo{};
+	moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	moduleInfo.codeSize = code.size();
+	moduleInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+	VkShaderModule shaderModule;
+	if (vkCreateShaderModule(device.device(), &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create shader module!");
+	}
+
+	VkComputePipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = shaderModule;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = cullPipelineLayout;
+
+	VkResult result = vkCreateComputePipelines(device.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &cullPipeline);
+	vkDestroyShaderModule(device.device(), shaderModule, nullptr);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to create light culling pipeline!");
+	}
+}
+
+void Magnet::EngineBase::Rendering::ClusteredLighting::setLights(const std::vector<PointLight>& lights)
+{
+	assert(lights.size() <= MAX_LIGHTS && "Cannot set lights: more than MAX_LIGHTS");
+
+	this->lights = lights;
+	lightCount = static_cast<uint32_t>(lights.size());
+	staleFrames = (1u << lightBuffer->getInstanceCount()) - 1;
+}
+
+void Magnet::EngineBase::Rendering::ClusteredLighting::update(Camera& camera, VkExtent2D extent, uint32_t frameIndex)
+{
+	float zNear = camera.getNearClip();
+	float zFar = camera.getFarClip();
+	float logRatio = std::log(zFar / zNear);
+
+	ClusterParams params{};
+	params.inverseProjection = glm::inverse(camera.matrices.perspective);
+	params.view = camera.matrices.view;
+	params.gridSize = glm::uvec4(GRID_X, GRID_Y, GRID_Z, lightCount);
+	params.screenSize = glm::vec4(
+		static_cast<float>(extent.width),
+		static_cast<float>(extent.height),
+		std::ceil(static_cast<float>(extent.width) / GRID_X),
+		std::ceil(static_cast<float>(extent.height) / GRID_Y));
+	// slice = log(viewDepth) * scale + bias, so slices grow exponentially with the distance
+	params.depthParams = glm::vec4(zNear, zFar, GRID_Z / logRatio, -GRID_Z * std::log(zNear) / logRatio);
+	params.options = glm::uvec4(mode == Mode::Clustered ? 1u : 0u, 0u, 0u, 0u);
+
+	paramsBuffer->writeToIndex(&params, frameIndex);
+
+	// The fence of this frame was waited on, its copy of the lights is no longer read
+	if (staleFrames & (1u << frameIndex)) {
+		if (lightCount > 0) {
+			lightBuffer->writeToBuffer(lights.data(), lightCount * sizeof(PointLight), frameIndex * lightBuffer->getAlignmentSize());
+		}
+		staleFrames &= ~(1u << frameIndex);
+	}
+}
+
+void Magnet::EngineBase::Rendering::ClusteredLighting::cull(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+	if (mode == Mode::BruteForce) {
+		return;
+	}
+
+	std::array<uint32_t, 2> dynamicOffsets = getDynamicOffsets(frameIndex);
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipelineLayout, 0, 1, &descriptorSet,
+		static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data());
+	// One workgroup per depth slice, one invocation per screen tile
+	vkCmdDispatch(commandBuffer, 1, 1, GRID_Z);
+}
+
+void Magnet::EngineBase::Rendering::ClusteredLighting::bind(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, uint32_t set, uint32_t frameIndex)
+{
+	std::array<uint32_t, 2> dynamicOffsets = getDynamicOffsets(frameIndex);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, set, 1, &descriptorSet,
+		static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data());
+}
+
+std::array<uint32_t, 2> Magnet::EngineBase::Rendering::ClusteredLighting::getDynamicOffsets(uint32_t frameIndex) const
+{
+	return {
+		static_cast<uint32_t>(frameIndex * paramsBuffer->getAlignmentSize()),
+		static_cast<uint32_t>(frameIndex * lightBuffer->getAlignmentSize()) };
+}
+
+std::vector<Magnet::EngineBase::Rendering::ClusteredLighting::PointLight> Magnet::EngineBase::Rendering::ClusteredLighting::randomLights(uint32_t count, glm::vec3 boundsMin, glm::vec3 boundsMax, float radius, uint32_t seed)
+{
+	std::mt19937 generator{ seed };
+	std::uniform_real_distribution<float> unit{ 0.0f, 1.0f };
+
+	std::vector<PointLight> lights(count);
+	for (auto& light : lights) {
+		glm::vec3 position = glm::mix(boundsMin, boundsMax, glm::vec3(unit(generator), unit(generator), unit(generator)));
+		light.positionRadius = glm::vec4(position, radius * (0.5f + unit(generator)));
+		light.colorIntensity = glm::vec4(unit(generator), unit(generator), unit(generator), 1.0f);
+	}
+	return lights;
+}
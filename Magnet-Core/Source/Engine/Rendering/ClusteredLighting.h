@@ -0,0 +1,98 @@
+#pragma once
+#include "../../Commons.h"
+#include "../../VK/Device.h"
+#include "../../VK/Buffer.h"
+#include "../../VK/Descriptors.h"
+#include "../Camera.h"
+
+namespace Magnet {
+	namespace EngineBase {
+		namespace Rendering {
+
+			// Clustered forward lighting : a compute pass bins the point lights into a froxel grid
+			// (screen tiles times exponential depth slices between the camera near and far planes),
+			// the fragment shader then only evaluates the lights of its cluster.
+			class ClusteredLighting {
+			public:
+				static constexpr uint32_t GRID_X = 16;
+				static constexpr uint32_t GRID_Y = 9;
+				static constexpr uint32_t GRID_Z = 24;
+				static constexpr uint32_t CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+				static constexpr uint32_t MAX_LIGHTS = 4096;
+				// Must match MAX_LIGHTS_PER_CLUSTER in cluster.comp and lighting.glsl
+				static constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 256;
+
+				enum class Mode { BruteForce, Clustered };
+
+				// std430 layout, matches PointLight in the shaders
+				struct PointLight {
+					glm::vec4 positionRadius{ 0.f, 0.f, 0.f, 1.f };  // w is the influence radius
+					glm::vec4 colorIntensity{ 1.f };               // w is intensity
+				};
+
+				// std140 layout, matches ClusterParams in the shaders
+				struct ClusterParams {
+					glm::mat4 inverseProjection{ 1.f };
+					glm::mat4 view{ 1.f };
+					glm::uvec4 gridSize{ 0 };     // w is the light count
+					glm::vec4 screenSize{ 0.f };  // zw is the tile size in pixels
+					glm::vec4 depthParams{ 0.f }; // near, far, slice scale, slice bias
+					glm::uvec4 options{ 0 };      // x is 1 when clustered
+				};
+
+				ClusteredLighting(VKBase::Device& device, const std::string& cullShaderPath, uint32_t frameCount);
+				~ClusteredLighting();
+
+				ClusteredLighting(const ClusteredLighting&) = delete;
+				ClusteredLighting& operator=(const ClusteredLighting&) = delete;
+
+				// Uploaded by update() into the light buffer copy of each frame in flight, frames being rendered keep their own copy
+				void setLights(const std::vector<PointLight>& lights);
+				uint32_t getLightCount() const { return lightCount; }
+
+				void setMode(Mode mode) { this->mode = mode; }
+				Mode getMode() const { return mode; }
+
+				void update(Camera& camera, VkExtent2D extent, uint32_t frameIndex);
+				// Records the light binning, a render graph compute pass writing the light grid and index buffers
+				void cull(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+				void bind(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, uint32_t set, uint32_t frameIndex);
+
+				VkDescriptorSetLayout getDescriptorSetLayout() const { return setLayout->getDescriptorSetLayout(); }
+				VKBase::Buffer& getLightBuffer() const { return *lightBuffer; }
+				VKBase::Buffer& getLightGridBuffer() const { return *lightGridBuffer; }
+				VKBase::Buffer& getLightIndexBuffer() const { return *lightIndexBuffer; }
+
+				static std::vector<PointLight> randomLights(uint32_t count, glm::vec3 boundsMin, glm::vec3 boundsMax, float radius, uint32_t seed = 1337);
+
+			private:
+				void createBuffers(uint32_t frameCount);
+				void createDescriptors();
+				void createCullPipeline(const std::string& cullShaderPath);
+				// Params then lights, in binding order
+				std::array<uint32_t, 2> getDynamicOffsets(uint32_t frameIndex) const;
+
+				VKBase::Device& device;
+
+				std::unique_ptr<VKBase::Buffer> paramsBuffer;
+				// One copy of the lights per frame in flight selected with a dynamic offset
+				std::unique_ptr<VKBase::Buffer> lightBuffer;
+				std::unique_ptr<VKBase::Buffer> lightGridBuffer;
+				std::unique_ptr<VKBase::Buffer> lightIndexBuffer;
+
+				std::unique_ptr<VKBase::DescriptorSetLayout> setLayout;
+				std::unique_ptr<VKBase::DescriptorPool> descriptorPool;
+				VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+				VkPipelineLayout cullPipelineLayout = VK_NULL_HANDLE;
+				VkPipeline cullPipeline = VK_NULL_HANDLE;
+
+				std::vector<PointLight> lights;
+				// One bit per frame in flight whose copy of the lights is outdated
+				uint32_t staleFrames = 0;
+				uint32_t lightCount = 0;
+				Mode mode = Mode::Clustered;
+			};
+		}
+	}
+}
@@ -0,0 +1,392 @@
+#include "GeometryArena.h"
+
+namespace {
+	using PackedVertex = Magnet::EngineBase::Assets::PackedVertex;
+}
+
+Magnet::EngineBase::Rendering::GeometryArena::RangeAllocator::RangeAllocator(VkDeviceSize capacity) : capacity{ capacity }, freeSize{ capacity }
+{
+	if (capacity > 0) {
+		freeRanges.emplace(0, capacity);
+	}
+}
+
+VkDeviceSize Magnet::EngineBase::Rendering::GeometryArena::RangeAllocator::allocate(VkDeviceSize size)
+{
+	// First fit keeps the allocations packed towards the start, the tail stays one large range
+	for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+		if (it->second < size) {
+			continue;
+		}
+		VkDeviceSize offset = it->first;
+		VkDeviceSize remaining = it->second - size;
+		freeRanges.erase(it);
+		if (remaining > 0) {
+			freeRanges.emplace(offset + size, remaining);
+		}
+		freeSize -= size;
+		return offset;
+	}
+	return INVALID_OFFSET;
+}
+
+void Magnet::EngineBase::Rendering::GeometryArena::RangeAllocator::release(VkDeviceSize offset, VkDeviceSize size)
+{
+	if (size == 0) {
+		return;
+	}
+	freeSize += size;
+
+	// Merged with the free ranges ending at offset and starting right after it
+	auto next = freeRanges.lower_bound(offset);
+	if (next != freeRanges.begin()) {
+		auto previous = std::prev(next);
+		if (previous->first + previous->second == offset) {
+			offset = previous->first;
+			size += previous->second;
+			freeRanges.erase(previous);
+		}
+	}
+	if (next != freeRanges.end() && offset + size == next->first) {
+		size += next->second;
+		freeRanges.erase(next);
+	}
+	freeRanges.emplace(offset, size);
+}
+
+VkDeviceSize Magnet::EngineBase::Rendering::GeometryArena::RangeAllocator::getLargestFreeRange() const
+{
+	VkDeviceSize largest = 0;
+	for (const auto& [offset, size] : freeRanges) {
+		largest = std::max(largest, size);
+	}
+	return largest;
+}
+
+Magnet::EngineBase::Rendering::GeometryArena::GeometryArena(VKBase::Device& device, uint32_t frameCount, const Settings& settings)
+	: device{ device }, settings{ settings }, frameCount{ frameCount },
+	vertexRanges{ settings.vertexCapacity }, indexRanges{ settings.indexCapacity & ~(INDEX_ALIGNMENT - 1) }
+{
+	if (settings.vertexCapacity == 0 || indexRanges.getCapacity() == 0) {
+		throw std::runtime_error("failed to create geometry arena, empty capacity!");
+	}
+	buffers = createBuffers();
+}
+
+Magnet::EngineBase::Rendering::GeometryArena::~GeometryArena()
+{
+	if (compaction) {
+		vkWaitForFences(device.device(), 1, &compaction->fence, VK_TRUE, UINT64_MAX);
+		vkDestroyFence(device.device(), compaction->fence, nullptr);
+		vkFreeCommandBuffers(device.device(), device.getCommandPool(), 1, &compaction->commandBuffer);
+		destroyBuffers(compaction->buffers);
+		compaction.reset();
+	}
+	releaseRetiredBuffers(true);
+	destroyBuffers(buffers);
+}
+
+Magnet::EngineBase::Rendering::GeometryArena::Buffers Magnet::EngineBase::Rendering::GeometryArena::createBuffers()
+{
+	// Also read as storage buffers by the visibility buffer resolve and the meshlet renderer, and copied from by compaction
+	constexpr VkBufferUsageFlags copyUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	// Vertices and colors are pulled through their address when it is supported
+	bool addressable = device.capabilities().bufferDeviceAddress;
+	VkBufferUsageFlags vertexUsage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | copyUsage | (addressable ? VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT : 0);
+	Buffers created{};
+	device.createBuffer(
+		VkDeviceSize(vertexRanges.getCapacity()) * sizeof(PackedVertex),
+		vertexUsage,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		created.vertices,
+		created.vertexMemory);
+	device.createBuffer(
+		VkDeviceSize(vertexRanges.getCapacity()) * PackedVertex::COLOR_STRIDE,
+		vertexUsage,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		created.colors,
+		created.colorMemory);
+	device.createBuffer(
+		indexRanges.getCapacity(),
+		VK_BUFFER_USAGE_INDEX_BUFFER_BIT | copyUsage,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		created.indices,
+		created.indexMemory);
+	if (addressable) {
+		created.vertexAddress = device.getBufferAddress(created.vertices);
+		created.colorAddress = device.getBufferAddress(created.colors);
+	}
+	return created;
+}
+
+void Magnet::EngineBase::Rendering::GeometryArena::destroyBuffers(Buffers& destroyed)
+{
+	vkDestroyBuffer(device.device(), destroyed.vertices, nullptr);
+	vkFreeMemory(device.device(), destroyed.vertexMemory, nullptr);
+	vkDestroyBuffer(device.device(), destroyed.colors, nullptr);
+	vkFreeMemory(device.device(), destroyed.colorMemory, nullptr);
+	vkDestroyBuffer(device.device(), destroyed.indices, nullptr);
+	vkFreeMemory(device.device(), destroyed.indexMemory, nullptr);
+	destroyed = {};
+}
+
+Magnet::EngineBase::Rendering::GeometryArena::Handle Magnet::EngineBase::Rendering::GeometryArena::allocate(uint32_t vertexCount, VkDeviceSize indexBytes)
+{
+	// Ranges are only handed out from the free lists of the current buffers
+	completeCompaction(true);
+
+	VkDeviceSize alignedIndexBytes = (indexBytes + INDEX_ALIGNMENT - 1) & ~(INDEX_ALIGNMENT - 1);
+	Allocation allocation{ 0, vertexCount, 0, indexBytes };
+	for (uint32_t attempt = 0; ; attempt++) {
+		VkDeviceSize firstVertex = vertexCount > 0 ? vertexRanges.allocate(vertexCount) : 0;
+		VkDeviceSize indexOffset = alignedIndexBytes > 0 ? indexRanges.allocate(alignedIndexBytes) : 0;
+		if (firstVertex != RangeAllocator::INVALID_OFFSET && indexOffset != RangeAllocator::INVALID_OFFSET) {
+			allocation.firstVertex = static_cast<uint32_t>(firstVertex);
+			allocation.indexOffset = indexOffset;
+			break;
+		}
+		if (firstVertex != RangeAllocator::INVALID_OFFSET) {
+			vertexRanges.release(firstVertex, vertexCount);
+		}
+		if (indexOffset != RangeAllocator::INVALID_OFFSET) {
+			indexRanges.release(indexOffset, alignedIndexBytes);
+		}
+
+		// Compacting also drops the frees still waiting on frames in flight, their ranges live on in the old buffers
+		bool reclaimable = !pendingFrees.empty() || vertexRanges.getLargestFreeRange() < vertexRanges.getFreeSize() || indexRanges.getLargestFreeRange() < indexRanges.getFreeSize();
+		if (attempt > 0 || !reclaimable) {
+			throw std::runtime_error("failed to allocate geometry, arena is full!");
+		}
+		startCompaction();
+		completeCompaction(true);
+	}
+
+	Handle handle;
+	if (!freeHandles.empty()) {
+		handle = freeHandles.back();
+		freeHandles.pop_back();
+	}
+	else {
+		handle = static_cast<Handle>(slots.size());
+		slots.emplace_back();
+	}
+	slots[handle] = { allocation, true };
+
+	stats.allocations++;
+	stats.peakVertices = std::max(stats.peakVertices, static_cast<uint32_t>(vertexRanges.getCapacity() - vertexRanges.getFreeSize()));
+	stats.peakIndexBytes = std::max(stats.peakIndexBytes, indexRanges.getCapacity() - indexRanges.getFreeSize());
+	return handle;
+}
+
+void Magnet::EngineBase::Rendering::GeometryArena::free(Handle handle)
+{
+	if (handle >= slots.size() || !slots[handle].live) {
+		return;
+	}
+	slots[handle].live = false;
+	pendingFrees.push_back({ handle, frameCounter + frameCount });
+	stats.frees++;
+}
+
+void Magnet::EngineBase::Rendering::GeometryArena::upload(VkCommandBuffer commandBuffer, Handle handle, VkBuffer stagingBuffer, VkDeviceSize vertexOffset, VkDeviceSize colorOffset, VkDeviceSize indexOffset)
+{
+	const Allocation& allocation = slots[handle].allocation;
+	if (allocation.vertexCount > 0) {
+		VkBufferCopy copyRegion{ vertexOffset, VkDeviceSize(allocation.firstVertex) * sizeof(PackedVertex), VkDeviceSize(allocation.vertexCount) * sizeof(PackedVertex) };
+		vkCmdCopyBuffer(commandBuffer, stagingBuffer, buffers.vertices, 1, &copyRegion);
+		copyRegion = { colorOffset, VkDeviceSize(allocation.firstVertex) * PackedVertex::COLOR_STRIDE, VkDeviceSize(allocation.vertexCount) * PackedVertex::COLOR_STRIDE };
+		vkCmdCopyBuffer(commandBuffer, stagingBuffer, buffers.colors, 1, &copyRegion);
+	}
+	if (allocation.indexBytes > 0) {
+		VkBufferCopy copyRegion{ indexOffset, allocation.indexOffset, allocation.indexBytes };
+		vkCmdCopyBuffer(commandBuffer, stagingBuffer, buffers.indices, 1, &copyRegion);
+	}
+}
+
+bool Magnet::EngineBase::Rendering::GeometryArena::update()
+{
+	// A signaled compaction is swapped in, none of it waits
+	completeCompaction(false);
+	releaseRetiredBuffers(false);
+	if (!compaction) {
+		releaseFrees();
+		if (isFragmented()) {
+			startCompaction();
+		}
+	}
+	frameCounter++;
+
+	bool moved = allocationsMoved;
+	allocationsMoved = false;
+	return moved;
+}
+
+void Magnet::EngineBase::Rendering::GeometryArena::bindVertexBuffers(VkCommandBuffer commandBuffer) const
+{
+	VkBuffer vertexBuffers[2] = { buffers.vertices, buffers.colors };
+	VkDeviceSize offsets[2] = { 0, 0 };
+	vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers, offsets);
+}
+
+void Magnet::EngineBase::Rendering::GeometryArena::bindIndexBuffer(VkCommandBuffer commandBuffer, VkIndexType indexType) const
+{
+	vkCmdBindIndexBuffer(commandBuffer, buffers.indices, 0, indexType);
+}
+
+bool Magnet::EngineBase::Rendering::GeometryArena::isFragmented() const
+{
+	auto holes = [](const RangeAllocator& ranges) {
+		return static_cast<double>(ranges.getFreeSize() - ranges.getLargestFreeRange()) / static_cast<double>(ranges.getCapacity());
+	};
+	return holes(vertexRanges) >= settings.compactionThreshold || holes(indexRanges) >= settings.compactionThreshold;
+}
+
+void Magnet::EngineBase::Rendering::GeometryArena::startCompaction()
+{
+	// Nothing draws the freed ranges from the new buffers, their handles can be reused right away
+	for (const PendingFree& pending : pendingFrees) {
+		freeHandles.push_back(pending.handle);
+	}
+	pendingFrees.clear();
+
+	compaction = std::make_unique<Compaction>(Compaction{ createBuffers(), RangeAllocator{ vertexRanges.getCapacity() }, RangeAllocator{ indexRanges.getCapacity() }, {} });
+
+	// Packed in their current order, so the copies read the old buffers front to back
+	std::vector<Handle> live;
+	for (Handle handle = 0; handle < slots.size(); handle++) {
+		if (slots[handle].live) {
+			live.push_back(handle);
+		}
+	}
+	std::sort(live.begin(), live.end(), [this](Handle a, Handle b) { return slots[a].allocation.firstVertex < slots[b].allocation.firstVertex; });
+
+	std::vector<VkBufferCopy> vertexCopies;
+	std::vector<VkBufferCopy> colorCopies;
+	std::vector<VkBufferCopy> indexCopies;
+	for (Handle handle : live) {
+		const Allocation& allocation = slots[handle].allocation;
+		Allocation moved = allocation;
+		if (allocation.vertexCount > 0) {
+			moved.firstVertex = static_cast<uint32_t>(compaction->vertexRanges.allocate(allocation.vertexCount));
+			vertexCopies.push_back({ VkDeviceSize(allocation.firstVertex) * sizeof(PackedVertex), VkDeviceSize(moved.firstVertex) * sizeof(PackedVertex), VkDeviceSize(allocation.vertexCount) * sizeof(PackedVertex) });
+			colorCopies.push_back({ VkDeviceSize(allocation.firstVertex) * PackedVertex::COLOR_STRIDE, VkDeviceSize(moved.firstVertex) * PackedVertex::COLOR_STRIDE, VkDeviceSize(allocation.vertexCount) * PackedVertex::COLOR_STRIDE });
+		}
+		if (allocation.indexBytes > 0) {
+			VkDeviceSize alignedIndexBytes = (allocation.indexBytes + INDEX_ALIGNMENT - 1) & ~(INDEX_ALIGNMENT - 1);
+			moved.indexOffset = compaction->indexRanges.allocate(alignedIndexBytes);
+			indexCopies.push_back({ allocation.indexOffset, moved.indexOffset, allocation.indexBytes });
+		}
+		compaction->moved.push_back({ handle, moved });
+		stats.bytesMoved += VkDeviceSize(allocation.vertexCount) * (sizeof(PackedVertex) + PackedVertex::COLOR_STRIDE) + allocation.indexBytes;
+	}
+
+	VkCommandBufferAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandPool = device.getCommandPool();
+	allocInfo.commandBufferCount = 1;
+	if (vkAllocateCommandBuffers(device.device(), &allocInfo, &compaction->commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate geometry compaction command buffer!");
+	}
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(compaction->commandBuffer, &beginInfo);
+	if (!vertexCopies.empty()) {
+		vkCmdCopyBuffer(compaction->commandBuffer, buffers.vertices, compaction->buffers.vertices, static_cast<uint32_t>(vertexCopies.size()), vertexCopies.data());
+		vkCmdCopyBuffer(compaction->commandBuffer, buffers.colors, compaction->buffers.colors, static_cast<uint32_t>(colorCopies.size()), colorCopies.data());
+	}
+	if (!indexCopies.empty()) {
+		vkCmdCopyBuffer(compaction->commandBuffer, buffers.indices, compaction->buffers.indices, static_cast<uint32_t>(indexCopies.size()), indexCopies.data());
+	}
+
+	// The frames drawing from the new buffers are submitted after the fence signaled, on the same queue
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+	vkCmdPipelineBarrier(compaction->commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	vkEndCommandBuffer(compaction->commandBuffer);
+
+	VkFenceCreateInfo fenceInfo{};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	if (vkCreateFence(device.device(), &fenceInfo, nullptr, &compaction->fence) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create geometry compaction fence!");
+	}
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &compaction->commandBuffer;
+	if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, compaction->fence) != VK_SUCCESS) {
+		throw std::runtime_error("failed to submit geometry compaction!");
+	}
+	stats.compactions++;
+}
+
+bool Magnet::EngineBase::Rendering::GeometryArena::completeCompaction(bool wait)
+{
+	if (!compaction) {
+		return false;
+	}
+	if (wait) {
+		vkWaitForFences(device.device(), 1, &compaction->fence, VK_TRUE, UINT64_MAX);
+	}
+	else if (vkGetFenceStatus(device.device(), compaction->fence) != VK_SUCCESS) {
+		return false;
+	}
+	vkDestroyFence(device.device(), compaction->fence, nullptr);
+	vkFreeCommandBuffers(device.device(), device.getCommandPool(), 1, &compaction->commandBuffer);
+
+	// Frames in flight still draw from the old buffers. Frees made meanwhile move along, their release stays deferred
+	retiredBuffers.push_back({ buffers, frameCounter + frameCount });
+	buffers = compaction->buffers;
+	vertexRanges = compaction->vertexRanges;
+	indexRanges = compaction->indexRanges;
+	for (const auto& [handle, allocation] : compaction->moved) {
+		slots[handle].allocation = allocation;
+	}
+	compaction.reset();
+	allocationsMoved = true;
+	return true;
+}
+
+void Magnet::EngineBase::Rendering::GeometryArena::releaseFrees()
+{
+	auto released = std::remove_if(pendingFrees.begin(), pendingFrees.end(), [this](const PendingFree& pending) {
+		if (pending.releaseFrame > frameCounter) {
+			return false;
+		}
+		const Allocation& allocation = slots[pending.handle].allocation;
+		vertexRanges.release(allocation.firstVertex, allocation.vertexCount);
+		indexRanges.release(allocation.indexOffset, (allocation.indexBytes + INDEX_ALIGNMENT - 1) & ~(INDEX_ALIGNMENT - 1));
+		freeHandles.push_back(pending.handle);
+		return true;
+	});
+	pendingFrees.erase(released, pendingFrees.end());
+}
+
+void Magnet::EngineBase::Rendering::GeometryArena::releaseRetiredBuffers(bool all)
+{
+	auto released = std::remove_if(retiredBuffers.begin(), retiredBuffers.end(), [this, all](RetiredBuffers& retired) {
+		if (!all && retired.releaseFrame > frameCounter) {
+			return false;
+		}
+		destroyBuffers(retired.buffers);
+		return true;
+	});
+	retiredBuffers.erase(released, retiredBuffers.end());
+}
+
+void Magnet::EngineBase::Rendering::GeometryArena::printStats() const
+{
+	VkDeviceSize usedVertices = vertexRanges.getCapacity() - vertexRanges.getFreeSize();
+	VkDeviceSize usedIndexBytes = indexRanges.getCapacity() - indexRanges.getFreeSize();
+	std::cout << "\nGeometry Arena :" << std::endl;
+	std::cout << "------------------------------" << std::endl;
+	std::cout << "\t- Vertices : " << usedVertices << " of " << vertexRanges.getCapacity() << " (peak " << stats.peakVertices << ")" << std::endl;
+	std::cout << "\t- Indices : " << usedIndexBytes / 1024 << " KB of " << indexRanges.getCapacity() / (1024 * 1024) << " MB (peak " << stats.peakIndexBytes / 1024 << " KB)" << std::endl;
+	std::cout << "\t- Allocations : " << stats.allocations << ", " << stats.frees << " freed" << std::endl;
+	std::cout << "\t- Compactions : " << stats.compactions << " (" << stats.bytesMoved / (1024 * 1024) << " MB moved)" << std::endl;
+}
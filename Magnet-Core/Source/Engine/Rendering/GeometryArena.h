@@ -0,0 +1,170 @@
+#pragma once
+#include "../../Commons.h"
+#include "../../VK/Device.h"
+#include "../Assets/PackedVertex.h"
+
+#include <map>
+
+namespace Magnet {
+	namespace EngineBase {
+		namespace Rendering {
+
+			// Global vertex and index storage every mesh is sub-allocated from, so all static geometry draws with a
+			// single bind and draws only differ by their first index and vertex offset :
+			//  - three device local buffers, packed vertices and RGBA8 colors indexed by vertex, and indices. Colors are
+			//    always per vertex, a constant stream can't be shared by meshes drawn from one binding
+			//  - vertex and index ranges come from free lists sorted by offset, first fit with neighbours merged on free,
+			//    and are only reused once the frames in flight that may draw them are complete
+			//  - once the holes between allocations grow past a share of the capacity, the live ranges are copied packed
+			//    into fresh buffers by a background submit with its own fence. The frame never waits on it, the new
+			//    buffers are swapped in once it signaled and the old ones released after the frames in flight
+			// Index ranges are 4 byte aligned, both 16 and 32-bit indices are drawn with the buffer bound at offset 0.
+			class GeometryArena {
+			public:
+				using Handle = uint32_t;
+				static constexpr Handle INVALID_HANDLE = ~0u;
+				static constexpr VkDeviceSize INDEX_ALIGNMENT = 4;
+
+				struct Settings {
+					uint32_t vertexCapacity = 4u << 20;
+					VkDeviceSize indexCapacity = VkDeviceSize(64) << 20;
+					// Share of either capacity left in holes (free space outside the largest free range) that starts a compaction
+					float compactionThreshold = 0.125f;
+				};
+
+				struct Allocation {
+					uint32_t firstVertex = 0;
+					uint32_t vertexCount = 0;
+					// In bytes
+					VkDeviceSize indexOffset = 0;
+					VkDeviceSize indexBytes = 0;
+				};
+
+				struct Stats {
+					uint32_t allocations = 0;
+					uint32_t frees = 0;
+					uint32_t compactions = 0;
+					VkDeviceSize bytesMoved = 0;
+					uint32_t peakVertices = 0;
+					VkDeviceSize peakIndexBytes = 0;
+				};
+
+				GeometryArena(VKBase::Device& device, uint32_t frameCount, const Settings& settings);
+				~GeometryArena();
+
+				GeometryArena(const GeometryArena&) = delete;
+				GeometryArena& operator=(const GeometryArena&) = delete;
+
+				// Waits for a compaction in flight, and compacts right away when only the holes could hold the ranges
+				Handle allocate(uint32_t vertexCount, VkDeviceSize indexBytes);
+				// The ranges are reused once the frames in flight are complete, the handle must not be drawn anymore
+				void free(Handle handle);
+				// Records the copies of the packed vertices, colors and indices of handle from offsets of a staging buffer
+				void upload(VkCommandBuffer commandBuffer, Handle handle, VkBuffer stagingBuffer, VkDeviceSize vertexOffset, VkDeviceSize colorOffset, VkDeviceSize indexOffset);
+
+				// Must be called once per frame after the frame slot's fence was waited on. Returns true when a compaction
+				// completed : allocations moved and the buffers changed, anything holding either must fetch them again
+				bool update();
+
+				// Vertex bindings 0 and 1 of PackedVertex, colors per vertex
+				void bindVertexBuffers(VkCommandBuffer commandBuffer) const;
+				void bindIndexBuffer(VkCommandBuffer commandBuffer, VkIndexType indexType) const;
+
+				const Allocation& getAllocation(Handle handle) const { return slots[handle].allocation; }
+				VkBuffer getVertexBuffer() const { return buffers.vertices; }
+				VkBuffer getColorBuffer() const { return buffers.colors; }
+				VkBuffer getIndexBuffer() const { return buffers.indices; }
+				// Zero without the bufferDeviceAddress capability
+				VkDeviceAddress getVertexAddress() const { return buffers.vertexAddress; }
+				VkDeviceAddress getColorAddress() const { return buffers.colorAddress; }
+
+				const Stats& getStats() const { return stats; }
+				void printStats() const;
+
+			private:
+				// Free ranges by offset, in vertices or bytes
+				class RangeAllocator {
+				public:
+					static constexpr VkDeviceSize INVALID_OFFSET = ~VkDeviceSize(0);
+
+					explicit RangeAllocator(VkDeviceSize capacity);
+
+					VkDeviceSize allocate(VkDeviceSize size);
+					void release(VkDeviceSize offset, VkDeviceSize size);
+
+					VkDeviceSize getCapacity() const { return capacity; }
+					VkDeviceSize getFreeSize() const { return freeSize; }
+					VkDeviceSize getLargestFreeRange() const;
+
+				private:
+					std::map<VkDeviceSize, VkDeviceSize> freeRanges;
+					VkDeviceSize capacity;
+					VkDeviceSize freeSize;
+				};
+
+				struct Buffers {
+					VkBuffer vertices = VK_NULL_HANDLE;
+					VkDeviceMemory vertexMemory = VK_NULL_HANDLE;
+					VkBuffer colors = VK_NULL_HANDLE;
+					VkDeviceMemory colorMemory = VK_NULL_HANDLE;
+					VkBuffer indices = VK_NULL_HANDLE;
+					VkDeviceMemory indexMemory = VK_NULL_HANDLE;
+					VkDeviceAddress vertexAddress = 0;
+					VkDeviceAddress colorAddress = 0;
+				};
+
+				struct Slot {
+					Allocation allocation;
+					bool live = false;
+				};
+
+				struct PendingFree {
+					Handle handle;
+					uint64_t releaseFrame;
+				};
+
+				// Live allocations at the start of the compaction, with their offsets in the new buffers
+				struct Compaction {
+					Buffers buffers;
+					RangeAllocator vertexRanges;
+					RangeAllocator indexRanges;
+					std::vector<std::pair<Handle, Allocation>> moved;
+					VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+					VkFence fence = VK_NULL_HANDLE;
+				};
+
+				struct RetiredBuffers {
+					Buffers buffers;
+					uint64_t releaseFrame;
+				};
+
+				Buffers createBuffers();
+				void destroyBuffers(Buffers& buffers);
+				bool isFragmented() const;
+				void startCompaction();
+				// Waits for the copies when wait is set, otherwise only completes a signaled compaction
+				bool completeCompaction(bool wait);
+				void releaseFrees();
+				void releaseRetiredBuffers(bool all);
+
+				VKBase::Device& device;
+				Settings settings;
+				uint32_t frameCount;
+				uint64_t frameCounter = 0;
+
+				Buffers buffers;
+				RangeAllocator vertexRanges;
+				RangeAllocator indexRanges;
+				std::vector<Slot> slots;
+				std::vector<Handle> freeHandles;
+				std::vector<PendingFree> pendingFrees;
+				std::unique_ptr<Compaction> compaction;
+				std::vector<RetiredBuffers> retiredBuffers;
+				// Set by completeCompaction, reported by the next update
+				bool allocationsMoved = false;
+
+				Stats stats{};
+			};
+		}
+	}
+}
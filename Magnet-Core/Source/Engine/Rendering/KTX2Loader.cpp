@@ -0,0 +1,262 @@
+#include "KTX2Loader.h"
+
+#ifdef MAGNET_WITH_BASISU
+#include <basisu/transcoder/basisu_transcoder.h>
+#include <basisu/zstd/zstd.h>
+#endif
+
+namespace {
+	const unsigned char KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+	// Identifier, header and index, followed by the level index
+	constexpr size_t KTX2_LEVEL_INDEX_OFFSET = 80;
+	constexpr size_t KTX2_LEVEL_INDEX_SIZE = 24;
+
+	constexpr uint32_t SUPERCOMPRESSION_NONE = 0;
+	constexpr uint32_t SUPERCOMPRESSION_BASISLZ = 1;
+	constexpr uint32_t SUPERCOMPRESSION_ZSTD = 2;
+
+	uint32_t read32(const unsigned char* data)
+	{
+		uint32_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	uint64_t read64(const unsigned char* data)
+	{
+		uint64_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+}
+
+Magnet::EngineBase::Rendering::KTX2Loader::KTX2Loader(VKBase::Device& device) : device{ device }
+{
+#ifdef MAGNET_WITH_BASISU
+	static std::once_flag transcoderInitialized;
+	std::call_once(transcoderInitialized, []() { basist::basisu_transcoder_init(); });
+#endif
+
+	// ETC1S has no alpha and BC1 keeps its quality, UASTC and alpha go to BC7 or its equivalents
+	opaqueTarget = selectTarget({
+		{ VK_FORMAT_BC1_RGB_UNORM_BLOCK, TranscodeFormat::BC1 },
+		{ VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, TranscodeFormat::ETC1 },
+		{ VK_FORMAT_ASTC_4x4_UNORM_BLOCK, TranscodeFormat::ASTC4x4 },
+		{ VK_FORMAT_R8G8B8A8_UNORM, TranscodeFormat::RGBA32 } });
+	alphaTarget = selectTarget({
+		{ VK_FORMAT_BC7_UNORM_BLOCK, TranscodeFormat::BC7 },
+		{ VK_FORMAT_ASTC_4x4_UNORM_BLOCK, TranscodeFormat::ASTC4x4 },
+		{ VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, TranscodeFormat::ETC2 },
+		{ VK_FORMAT_R8G8B8A8_UNORM, TranscodeFormat::RGBA32 } });
+	normalTarget = selectTarget({
+		{ VK_FORMAT_BC5_UNORM_BLOCK, TranscodeFormat::BC5 },
+		{ VK_FORMAT_EAC_R11G11_UNORM_BLOCK, TranscodeFormat::EACRG11 },
+		{ VK_FORMAT_ASTC_4x4_UNORM_BLOCK, TranscodeFormat::ASTC4x4 },
+		{ VK_FORMAT_R8G8B8A8_UNORM, TranscodeFormat::RGBA32 } });
+}
+
+bool Magnet::EngineBase::Rendering::KTX2Loader::isKTX2(const unsigned char* data, size_t size)
+{
+	return size >= KTX2_LEVEL_INDEX_OFFSET && memcmp(data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0;
+}
+
+bool Magnet::EngineBase::Rendering::KTX2Loader::isFormatEnabled(VkFormat format) const
+{
+	// Block compressed formats also need their device feature
+	if (format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK) {
+		return device.features.textureCompressionBC;
+	}
+	if (format >= VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK && format <= VK_FORMAT_EAC_R11G11_SNORM_BLOCK) {
+		return device.features.textureCompressionETC2;
+	}
+	if (format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK && format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK) {
+		return device.features.textureCompressionASTC_LDR;
+	}
+	return true;
+}
+
+Magnet::EngineBase::Rendering::KTX2Loader::Target Magnet::EngineBase::Rendering::KTX2Loader::selectTarget(const std::vector<Target>& candidates) const
+{
+	std::vector<VkFormat> formats;
+	for (const auto& candidate : candidates) {
+		if (isFormatEnabled(candidate.format)) {
+			formats.push_back(candidate.format);
+		}
+	}
+	VkFormat format = device.findSupportedFormat(formats, VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT);
+	return *std::find_if(candidates.begin(), candidates.end(), [format](const Target& candidate) { return candidate.format == format; });
+}
+
+Magnet::EngineBase::Rendering::MipChain Magnet::EngineBase::Rendering::KTX2Loader::loadFile(const std::string& filename, Usage usage)
+{
+	std::ifstream file{ filename, std::ios::ate | std::ios::binary };
+	if (!file.is_open()) {
+		throw std::runtime_error("failed to open file: " + filename);
+	}
+	size_t fileSize = static_cast<size_t>(file.tellg());
+	std::vector<unsigned char> buffer(fileSize);
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(buffer.data()), fileSize);
+	file.close();
+
+	return load(buffer.data(), buffer.size(), usage);
+}
+
+Magnet::EngineBase::Rendering::MipChain Magnet::EngineBase::Rendering::KTX2Loader::load(const unsigned char* data, size_t size, Usage usage)
+{
+	if (!isKTX2(data, size)) {
+		throw std::runtime_error("failed to load KTX2 texture, invalid identifier!");
+	}
+
+	Header header{};
+	header.format = static_cast<VkFormat>(read32(data + 12));
+	header.width = read32(data + 20);
+	header.height = read32(data + 24);
+	header.depth = read32(data + 28);
+	header.layerCount = read32(data + 32);
+	header.faceCount = read32(data + 36);
+	header.levelCount = read32(data + 40);
+	header.supercompressionScheme = read32(data + 44);
+
+	if (header.depth > 0 || header.layerCount > 1 || header.faceCount != 1) {
+		throw std::runtime_error("failed to load KTX2 texture, only 2D textures are supported!");
+	}
+
+	// Basis Universal payloads have no Vulkan format, they are transcoded
+	if (header.format == VK_FORMAT_UNDEFINED || header.supercompressionScheme == SUPERCOMPRESSION_BASISLZ) {
+		MipChain mipChain = transcode(data, size, usage);
+		addStats(mipChain, true);
+		return mipChain;
+	}
+
+	if (!isFormatEnabled(header.format) || !(device.getFormatProperties(header.format).optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)) {
+		throw std::runtime_error("failed to load KTX2 texture, format not supported by the device!");
+	}
+	if (header.supercompressionScheme != SUPERCOMPRESSION_NONE && header.supercompressionScheme != SUPERCOMPRESSION_ZSTD) {
+		throw std::runtime_error("failed to load KTX2 texture, unsupported supercompression scheme!");
+	}
+
+	// A level count of 0 asks for generated mipmaps, only the base level is stored
+	uint32_t levelCount = std::max(header.levelCount, 1u);
+	if (size < KTX2_LEVEL_INDEX_OFFSET + levelCount * KTX2_LEVEL_INDEX_SIZE) {
+		throw std::runtime_error("failed to load KTX2 texture, truncated level index!");
+	}
+
+	MipChain mipChain{ header.format, header.width, header.height, {} };
+	mipChain.levels.resize(levelCount);
+	for (uint32_t level = 0; level < levelCount; level++) {
+		const unsigned char* entry = data + KTX2_LEVEL_INDEX_OFFSET + level * KTX2_LEVEL_INDEX_SIZE;
+		uint64_t byteOffset = read64(entry);
+		uint64_t byteLength = read64(entry + 8);
+		uint64_t uncompressedByteLength = read64(entry + 16);
+		if (byteOffset + byteLength > size) {
+			throw std::runtime_error("failed to load KTX2 texture, truncated level data!");
+		}
+
+		auto& levelData = mipChain.levels[level];
+		if (header.supercompressionScheme == SUPERCOMPRESSION_NONE) {
+			levelData.assign(data + byteOffset, data + byteOffset + byteLength);
+			continue;
+		}
+#ifdef MAGNET_WITH_BASISU
+		levelData.resize(uncompressedByteLength);
+		size_t decompressed = ZSTD_decompress(levelData.data(), levelData.size(), data + byteOffset, byteLength);
+		if (ZSTD_isError(decompressed) || decompressed != uncompressedByteLength) {
+			throw std::runtime_error("failed to decompress KTX2 level!");
+		}
+#else
+		(void)uncompressedByteLength;
+		throw std::runtime_error("failed to load KTX2 texture, Zstandard needs MAGNET_WITH_BASISU!");
+#endif
+	}
+
+	addStats(mipChain, false);
+	return mipChain;
+}
+
+#ifdef MAGNET_WITH_BASISU
+Magnet::EngineBase::Rendering::MipChain Magnet::EngineBase::Rendering::KTX2Loader::transcode(const unsigned char* data, size_t size, Usage usage)
+{
+	basist::ktx2_transcoder transcoder;
+	if (!transcoder.init(data, static_cast<uint32_t>(size)) || !transcoder.start_transcoding()) {
+		throw std::runtime_error("failed to initialize KTX2 transcoding!");
+	}
+
+	Target target = alphaTarget;
+	if (usage == Usage::NormalMap) {
+		target = normalTarget;
+	}
+	else if (transcoder.is_etc1s() && !transcoder.get_has_alpha()) {
+		target = opaqueTarget;
+	}
+
+	basist::transcoder_texture_format format;
+	switch (target.transcodeFormat) {
+	case TranscodeFormat::BC1: format = basist::transcoder_texture_format::cTFBC1_RGB; break;
+	case TranscodeFormat::BC5: format = basist::transcoder_texture_format::cTFBC5_RG; break;
+	case TranscodeFormat::BC7: format = basist::transcoder_texture_format::cTFBC7_RGBA; break;
+	case TranscodeFormat::ASTC4x4: format = basist::transcoder_texture_format::cTFASTC_4x4_RGBA; break;
+	case TranscodeFormat::ETC1: format = basist::transcoder_texture_format::cTFETC1_RGB; break;
+	case TranscodeFormat::ETC2: format = basist::transcoder_texture_format::cTFETC2_RGBA; break;
+	case TranscodeFormat::EACRG11: format = basist::transcoder_texture_format::cTFETC2_EAC_RG11; break;
+	default: format = basist::transcoder_texture_format::cTFRGBA32; break;
+	}
+	bool uncompressed = basist::basis_transcoder_format_is_uncompressed(format);
+	uint32_t bytesPerBlock = basist::basis_get_bytes_per_block_or_pixel(format);
+
+	MipChain mipChain{ target.format, transcoder.get_width(), transcoder.get_height(), {} };
+	mipChain.levels.resize(transcoder.get_levels());
+	for (uint32_t level = 0; level < mipChain.levels.size(); level++) {
+		basist::ktx2_image_level_info levelInfo;
+		if (!transcoder.get_image_level_info(levelInfo, level, 0, 0)) {
+			throw std::runtime_error("failed to read KTX2 level info!");
+		}
+		// Uncompressed targets are sized in pixels, the others in blocks
+		uint32_t units = uncompressed ? levelInfo.m_orig_width * levelInfo.m_orig_height : levelInfo.m_total_blocks;
+		auto& levelData = mipChain.levels[level];
+		levelData.resize(size_t(units) * bytesPerBlock);
+		if (!transcoder.transcode_image_level(level, 0, 0, levelData.data(), units, format)) {
+			throw std::runtime_error("failed to transcode KTX2 level!");
+		}
+	}
+	return mipChain;
+}
+#else
+Magnet::EngineBase::Rendering::MipChain Magnet::EngineBase::Rendering::KTX2Loader::transcode(const unsigned char* /*data*/, size_t /*size*/, Usage /*usage*/)
+{
+	throw std::runtime_error("failed to load KTX2 texture, Basis Universal transcoding needs MAGNET_WITH_BASISU!");
+}
+#endif
+
+void Magnet::EngineBase::Rendering::KTX2Loader::addStats(const MipChain& mipChain, bool transcoded)
+{
+	std::lock_guard<std::mutex> lock{ statsMutex };
+	stats.images++;
+	if (transcoded) {
+		stats.transcoded++;
+	}
+	for (size_t level = 0; level < mipChain.levels.size(); level++) {
+		stats.gpuBytes += mipChain.levels[level].size();
+		stats.rgbaBytes += VkDeviceSize(std::max(mipChain.width >> level, 1u)) * std::max(mipChain.height >> level, 1u) * 4;
+	}
+}
+
+Magnet::EngineBase::Rendering::KTX2Loader::Stats Magnet::EngineBase::Rendering::KTX2Loader::getStats() const
+{
+	std::lock_guard<std::mutex> lock{ statsMutex };
+	return stats;
+}
+
+void Magnet::EngineBase::Rendering::KTX2Loader::printStats() const
+{
+	Stats current = getStats();
+	std::cout << "\nKTX2 Textures :" << std::endl;
+	std::cout << "------------------------------" << std::endl;
+	std::cout << "\t- Images : " << current.images << " (" << current.transcoded << " transcoded)" << std::endl;
+	std::cout << "\t- Target formats : opaque " << opaqueTarget.format << ", alpha " << alphaTarget.format << ", normal " << normalTarget.format << std::endl;
+	std::cout << "\t- Size : " << current.gpuBytes / 1024 << " KB (" << current.rgbaBytes / 1024 << " KB as RGBA8";
+	if (current.gpuBytes > 0) {
+		std::cout << ", " << static_cast<double>(current.rgbaBytes) / current.gpuBytes << "x smaller";
+	}
+	std::cout << ")" << std::endl;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "../../Commons.h"
+#include "../../VK/Device.h"
+#include "Texture.h"
+
+#include <mutex>
+
+namespace Magnet {
+	namespace EngineBase {
+		namespace Rendering {
+
+			// KTX2 container loading with its pre-built mip chain. Levels stored in a GPU format are used as is,
+			// Basis Universal payloads (ETC1S and UASTC) are transcoded to the best block format the device samples :
+			// BC7, BC1 or BC5, then ASTC 4x4, then ETC2, and RGBA8 as a last resort.
+			// Transcoding and Zstandard supercompression need the Basis Universal transcoder, built with MAGNET_WITH_BASISU
+			// when the solution is generated with --with-basisu.
+			class KTX2Loader {
+			public:
+				// Normal maps only keep two channels, BC5 or EAC RG11
+				enum class Usage { Color, NormalMap };
+
+				struct Stats {
+					uint32_t images = 0;
+					uint32_t transcoded = 0;
+					// Bytes of every level as loaded, and as uncompressed RGBA8
+					VkDeviceSize gpuBytes = 0;
+					VkDeviceSize rgbaBytes = 0;
+				};
+
+				explicit KTX2Loader(VKBase::Device& device);
+
+				static bool isKTX2(const unsigned char* data, size_t size);
+
+				// Thread safe, images are meant to be loaded on worker threads
+				MipChain load(const unsigned char* data, size_t size, Usage usage = Usage::Color);
+				MipChain loadFile(const std::string& filename, Usage usage = Usage::Color);
+
+				Stats getStats() const;
+				void printStats() const;
+
+			private:
+				enum class TranscodeFormat { BC1, BC5, BC7, ASTC4x4, ETC1, ETC2, EACRG11, RGBA32 };
+
+				struct Target {
+					VkFormat format;
+					TranscodeFormat transcodeFormat;
+				};
+
+				struct Header {
+					VkFormat format;
+					uint32_t width;
+					uint32_t height;
+					uint32_t depth;
+					uint32_t layerCount;
+					uint32_t faceCount;
+					uint32_t levelCount;
+					uint32_t supercompressionScheme;
+				};
+
+				// First candidate the device can sample, the last one must always be supported
+				Target selectTarget(const std::vector<Target>& candidates) const;
+				bool isFormatEnabled(VkFormat format) const;
+				MipChain transcode(const unsigned char* data, size_t size, Usage usage);
+				void addStats(const MipChain& mipChain, bool transcoded);
+
+				VKBase::Device& device;
+				Target opaqueTarget;
+				Target alphaTarget;
+				Target normalTarget;
+
+				mutable std::mutex statsMutex;
+				Stats stats{};
+			};
+		}
+	}
+}
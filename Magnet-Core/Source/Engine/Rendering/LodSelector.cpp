@@ -0,0 +1,24 @@
+#include "LodSelector.h"
+
+float Magnet::EngineBase::Rendering::LodSelector::getPixelsPerUnit(float fovY, float screenHeight, float distance)
+{
+	return screenHeight / (2.0f * std::tan(glm::radians(fovY) * 0.5f) * std::max(distance, std::numeric_limits<float>::min()));
+}
+
+uint32_t Magnet::EngineBase::Rendering::LodSelector::select(const float* errors, uint32_t levelCount, uint32_t currentLevel, float pixelsPerUnit)
+{
+	stats.objects++;
+	uint32_t level = std::min(currentLevel, levelCount - 1);
+	// Refined as soon as the current level is visibly wrong
+	while (level > 0 && errors[level] * pixelsPerUnit > settings.pixelError) {
+		level--;
+	}
+	// Coarsened only with margin
+	float coarsenError = settings.pixelError * (1.0f - settings.hysteresis);
+	while (level + 1 < levelCount && errors[level + 1] * pixelsPerUnit <= coarsenError) {
+		level++;
+	}
+	stats.coarsened += level > currentLevel ? 1 : 0;
+	stats.refined += level < currentLevel ? 1 : 0;
+	return level;
+}
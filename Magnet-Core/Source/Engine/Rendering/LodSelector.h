@@ -0,0 +1,42 @@
+#pragma once
+#include "../../Commons.h"
+
+namespace Magnet {
+	namespace EngineBase {
+		namespace Rendering {
+
+			// Chooses the level of detail of an object from the size its simplification error projects to on screen.
+			// The coarsest level under pixelError is drawn, but a coarser level is only taken once its error falls
+			// under pixelError * (1 - hysteresis), so objects near a threshold don't switch back and forth.
+			class LodSelector {
+			public:
+				struct Settings {
+					float pixelError = 1.0f;
+					float hysteresis = 0.3f;
+				};
+
+				struct Stats {
+					uint32_t objects = 0;
+					uint32_t coarsened = 0;
+					uint32_t refined = 0;
+				};
+
+				explicit LodSelector(const Settings& settings) : settings{ settings } {}
+
+				// Pixels covered by one unit at distance, for a vertical field of view in degrees
+				static float getPixelsPerUnit(float fovY, float screenHeight, float distance);
+
+				// errors are in object units, increasing from level 0 which has none
+				uint32_t select(const float* errors, uint32_t levelCount, uint32_t currentLevel, float pixelsPerUnit);
+
+				// Counts selections and switches, from the last reset
+				const Stats& getStats() const { return stats; }
+				void resetStats() { stats = {}; }
+
+			private:
+				Settings settings;
+				Stats stats{};
+			};
+		}
+	}
+}
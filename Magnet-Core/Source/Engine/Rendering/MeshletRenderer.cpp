@@ -0,0 +1,520 @@
+#include "MeshletRenderer.h"
+
+Magnet::EngineBase::Rendering::MeshletRenderer::MeshletRenderer(
+	VKBase::Device& device,
+	const Shaders& shaders,
+	std::vector<VkDescriptorSetLayout> setLayouts,
+	VkFormat colorFormat,
+	VkFormat depthFormat,
+	uint32_t frameCount,
+	const Settings& settings) : device{ device }, settings{ settings }, frameCount{ frameCount }
+{
+	mode = device.capabilities().meshShader && device.capabilities().dynamicRendering ? Mode::MeshShader : Mode::ComputeIndirect;
+	frameMeshlets.assign(frameCount, 0);
+
+	createBuffers(frameCount);
+	createDescriptors();
+	createPipelines(shaders, setLayouts, colorFormat, depthFormat);
+}
+
+Magnet::EngineBase::Rendering::MeshletRenderer::~MeshletRenderer()
+{
+	vkDestroyPipeline(device.device(), meshPipeline, nullptr);
+	vkDestroyPipeline(device.device(), cullPipeline, nullptr);
+	vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+	vkDestroyPipelineLayout(device.device(), cullPipelineLayout, nullptr);
+}
+
+void Magnet::EngineBase::Rendering::MeshletRenderer::createBuffers(uint32_t frameCount)
+{
+	paramsBuffer = std::make_unique<VKBase::Buffer>(
+		device,
+		sizeof(MeshletParams),
+		frameCount,
+		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		device.properties.limits.minUniformBufferOffsetAlignment);
+	paramsBuffer->map();
+
+	// Written by the task shader or the culling pass, read back a frame later
+	statsBuffer = std::make_unique<VKBase::Buffer>(
+		device,
+		sizeof(uint32_t),
+		frameCount,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		device.properties.limits.minStorageBufferOffsetAlignment);
+	statsBuffer->map();
+	for (uint32_t i = 0; i < frameCount; i++) {
+		uint32_t zero = 0;
+		statsBuffer->writeToIndex(&zero, i);
+	}
+
+	reserve(64, 1024);
+}
+
+void Magnet::EngineBase::Rendering::MeshletRenderer::reserve(uint32_t drawCount, uint32_t commandCount)
+{
+	VkDeviceSize alignment = device.properties.limits.minStorageBufferOffsetAlignment;
+	bool grown = false;
+
+	if (!drawBuffer || drawBuffer->getInstanceSize() < drawCount * sizeof(DrawRecord)) {
+		uint32_t capacity = drawBuffer ? static_cast<uint32_t>(drawBuffer->getInstanceSize() / sizeof(DrawRecord)) : 0;
+		while (capacity < drawCount) {
+			capacity = std::max(capacity * 2, 64u);
+		}
+		if (drawBuffer) {
+			vkDeviceWaitIdle(device.device());
+		}
+		drawBuffer = std::make_unique<VKBase::Buffer>(
+			device,
+			capacity * sizeof(DrawRecord),
+			frameCount,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			alignment);
+		drawBuffer->map();
+		grown = true;
+	}
+
+	if (mode == Mode::ComputeIndirect && (!indirectBuffer || indirectBuffer->getInstanceSize() < commandCount * sizeof(VkDrawIndexedIndirectCommand))) {
+		uint32_t capacity = indirectBuffer ? static_cast<uint32_t>(indirectBuffer->getInstanceSize() / sizeof(VkDrawIndexedIndirectCommand)) : 0;
+		while (capacity < commandCount) {
+			capacity = std::max(capacity * 2, 1024u);
+		}
+		if (indirectBuffer) {
+			vkDeviceWaitIdle(device.device());
+		}
+		// Offsets of indirect draws only need 4 byte alignment, the storage alignment covers it
+		indirectBuffer = std::make_unique<VKBase::Buffer>(
+			device,
+			capacity * sizeof(VkDrawIndexedIndirectCommand),
+			frameCount,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			alignment);
+		grown = true;
+	}
+
+	if (grown && setLayout) {
+		writeDescriptors();
+	}
+}
+
+void Magnet::EngineBase::Rendering::MeshletRenderer::createDescriptors()
+{
+	// Task and mesh stages are only valid with the mesh shader features enabled
+	VkShaderStageFlags stages = mode == Mode::MeshShader
+		? VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT | VK_SHADER_STAGE_FRAGMENT_BIT
+		: VK_SHADER_STAGE_COMPUTE_BIT;
+	VKBase::DescriptorSetLayout::Builder layoutBuilder{ device };
+	layoutBuilder
+		.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, stages)
+		.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, stages)
+		.addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages)
+		.addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages)
+		.addBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages)
+		.addBinding(5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages)
+		.addBinding(6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages)
+		.addBinding(7, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages)
+		.addBinding(9, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, stages);
+	// Indirect commands only exist in the fallback
+	if (mode == Mode::ComputeIndirect) {
+		layoutBuilder.addBinding(8, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, stages);
+	}
+	setLayout = layoutBuilder.build();
+
+	descriptorPool = VKBase::DescriptorPool::Builder(device)
+		.setMaxSets(1)
+		.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1)
+		.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 3)
+		.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 6)
+		.build();
+
+	auto paramsInfo = paramsBuffer->descriptorInfo(sizeof(MeshletParams), 0);
+	bool built = VKBase::DescriptorWriter(*setLayout, *descriptorPool)
+		.writeBuffer(0, &paramsInfo)
+		.build(descriptorSet);
+	if (!built) {
+		throw std::runtime_error("failed to allocate meshlet descriptor set!");
+	}
+	writeDescriptors();
+}
+
+void Magnet::EngineBase::Rendering::MeshletRenderer::writeDescriptors()
+{
+	VKBase::DescriptorWriter writer{ *setLayout, *descriptorPool };
+
+	// Dynamic bindings cover one frame, selected with the frame's offset
+	auto paramsInfo = paramsBuffer->descriptorInfo(sizeof(MeshletParams), 0);
+	auto drawInfo = drawBuffer->descriptorInfo(drawBuffer->getInstanceSize(), 0);
+	auto statsInfo = statsBuffer->descriptorInfo(sizeof(uint32_t), 0);
+	writer.writeBuffer(0, &paramsInfo).writeBuffer(1, &drawInfo).writeBuffer(9, &statsInfo);
+
+	VkDescriptorBufferInfo commandInfo{};
+	if (indirectBuffer) {
+		commandInfo = indirectBuffer->descriptorInfo(indirectBuffer->getInstanceSize(), 0);
+		writer.writeBuffer(8, &commandInfo);
+	}
+
+	VkDescriptorBufferInfo meshletInfo{}, boundsInfo{}, meshletVertexInfo{}, triangleInfo{};
+	VkDescriptorBufferInfo vertexInfo{ geometry.vertexBuffer, 0, VK_WHOLE_SIZE };
+	VkDescriptorBufferInfo colorInfo{ geometry.colorBuffer, 0, VK_WHOLE_SIZE };
+	if (meshletBuffer) {
+		meshletInfo = meshletBuffer->descriptorInfo();
+		boundsInfo = boundsBuffer->descriptorInfo();
+		meshletVertexInfo = meshletVertexBuffer->descriptorInfo();
+		triangleInfo = triangleBuffer->descriptorInfo();
+		writer.writeBuffer(2, &meshletInfo).writeBuffer(3, &boundsInfo).writeBuffer(4, &meshletVertexInfo).writeBuffer(5, &triangleInfo);
+	}
+	if (geometry.vertexBuffer != VK_NULL_HANDLE && geometry.colorBuffer != VK_NULL_HANDLE) {
+		writer.writeBuffer(6, &vertexInfo).writeBuffer(7, &colorInfo);
+	}
+
+	writer.overwrite(descriptorSet);
+}
+
+VkShaderModule Magnet::EngineBase::Rendering::MeshletRenderer::createShaderModule(const std::string& filepath)
+{
+	auto code = VKBase::Pipeline::readFile(filepath);
+	VkShaderModuleCreateInfo moduleInfo{};
+	moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	moduleInfo.codeSize = code.size();
+	moduleInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+	VkShaderModule shaderModule;
+	if (vkCreateShaderModule(device.device(), &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create shader module!");
+	}
+	return shaderModule;
+}
+
+void Magnet::EngineBase::Rendering::MeshletRenderer::createPipelines(const Shaders& shaders, std::vector<VkDescriptorSetLayout> setLayouts, VkFormat colorFormat, VkFormat depthFormat)
+{
+	VkDescriptorSetLayout meshletSetLayout = setLayout->getDescriptorSetLayout();
+
+	if (mode == Mode::ComputeIndirect) {
+		// Culling pass : the meshlet set alone at set 0
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &meshletSetLayout;
+
+		if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &cullPipelineLayout) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create meshlet culling pipeline layout!");
+		}
+
+		VkComputePipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		pipelineInfo.stage.module = createShaderModule(shaders.cull);
+		pipelineInfo.stage.pName = "main";
+		pipelineInfo.layout = cullPipelineLayout;
+
+		VkResult result = vkCreateComputePipelines(device.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &cullPipeline);
+		vkDestroyShaderModule(device.device(), pipelineInfo.stage.module, nullptr);
+		if (result != VK_SUCCESS) {
+			throw std::runtime_error("failed to create meshlet culling pipeline!");
+		}
+		return;
+	}
+
+	// Mesh pass : shares the lighting and shadow sets of the forward layout
+	assert(setLayouts.size() > 1 && "Meshlet set layouts must contain the forward sets");
+	setLayouts[1] = meshletSetLayout;
+	VkPushConstantRange pushConstantRange{ VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT, 0, sizeof(MeshletPush) };
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+	pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create meshlet pipeline layout!");
+	}
+
+	// Same fixed function state as the forward pipeline, there is no vertex input or input assembly
+	VKBase::PipelineConfigInfo config{};
+	VKBase::Pipeline::defaultPipelineConfigInfo(config);
+	config.rasterizationInfo.cullMode = VK_CULL_MODE_BACK_BIT;
+	config.colorAttachmentFormats = { colorFormat };
+	config.depthAttachmentFormat = depthFormat;
+
+	std::array<VkPipelineShaderStageCreateInfo, 3> shaderStages{};
+	const std::array<std::pair<VkShaderStageFlagBits, const std::string*>, 3> stageFiles = { {
+		{ VK_SHADER_STAGE_TASK_BIT_EXT, &shaders.task },
+		{ VK_SHADER_STAGE_MESH_BIT_EXT, &shaders.mesh },
+		{ VK_SHADER_STAGE_FRAGMENT_BIT, &shaders.frag } } };
+	for (size_t i = 0; i < shaderStages.size(); i++) {
+		shaderStages[i].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shaderStages[i].stage = stageFiles[i].first;
+		shaderStages[i].module = createShaderModule(*stageFiles[i].second);
+		shaderStages[i].pName = "main";
+	}
+
+	VkPipelineRenderingCreateInfoKHR renderingInfo = VKBase::Pipeline::renderingCreateInfo(config);
+	VkGraphicsPipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.pNext = &renderingInfo;
+	pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+	pipelineInfo.pStages = shaderStages.data();
+	pipelineInfo.pViewportState = &config.viewportInfo;
+	pipelineInfo.pRasterizationState = &config.rasterizationInfo;
+	pipelineInfo.pMultisampleState = &config.multisampleInfo;
+	pipelineInfo.pColorBlendState = &config.colorBlendInfo;
+	pipelineInfo.pDynamicState = &config.dynamicStateInfo;
+	pipelineInfo.pDepthStencilState = &config.depthStencilInfo;
+	pipelineInfo.layout = pipelineLayout;
+	pipelineInfo.basePipelineIndex = -1;
+
+	VkResult result = vkCreateGraphicsPipelines(device.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &meshPipeline);
+	for (const auto& stage : shaderStages) {
+		vkDestroyShaderModule(device.device(), stage.module, nullptr);
+	}
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to create meshlet pipeline!");
+	}
+}
+
+void Magnet::EngineBase::Rendering::MeshletRenderer::setGeometry(const Geometry& geometry, const Assets::MeshletBuilder::Meshlets& meshlets)
+{
+	vkDeviceWaitIdle(device.device());
+
+	this->geometry = geometry;
+	meshletBuffer.reset();
+	boundsBuffer.reset();
+	meshletVertexBuffer.reset();
+	triangleBuffer.reset();
+	indexBuffer.reset();
+	if (meshlets.meshlets.empty()) {
+		writeDescriptors();
+		return;
+	}
+
+	// The fallback draws the meshlet triangles as indexed draws, one index range per meshlet
+	std::vector<uint32_t> indices;
+	if (mode == Mode::ComputeIndirect) {
+		indices.resize(meshlets.triangles.size() * 3);
+		for (const auto& meshlet : meshlets.meshlets) {
+			for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+				uint32_t triangle = meshlets.triangles[meshlet.triangleOffset + t];
+				for (uint32_t corner = 0; corner < 3; corner++) {
+					indices[(size_t(meshlet.triangleOffset) + t) * 3 + corner] = meshlets.vertices[meshlet.vertexOffset + Assets::MeshletBuilder::unpackTriangle(triangle, corner)];
+				}
+			}
+		}
+	}
+
+	struct Upload {
+		std::unique_ptr<VKBase::Buffer>* buffer;
+		const void* data;
+		VkDeviceSize size;
+		VkBufferUsageFlags usage;
+	};
+	std::vector<Upload> uploads = {
+		{ &meshletBuffer, meshlets.meshlets.data(), meshlets.meshlets.size() * sizeof(Assets::MeshletBuilder::Meshlet), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT },
+		{ &boundsBuffer, meshlets.bounds.data(), meshlets.bounds.size() * sizeof(Assets::MeshletBuilder::Bounds), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT },
+		{ &meshletVertexBuffer, meshlets.vertices.data(), meshlets.vertices.size() * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT },
+		{ &triangleBuffer, meshlets.triangles.data(), meshlets.triangles.size() * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT } };
+	if (!indices.empty()) {
+		uploads.push_back({ &indexBuffer, indices.data(), indices.size() * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT });
+	}
+
+	VkDeviceSize stagingSize = 0;
+	for (const auto& upload : uploads) {
+		stagingSize += upload.size;
+	}
+	VKBase::Buffer stagingBuffer{
+		device,
+		stagingSize,
+		1,
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+	stagingBuffer.map();
+
+	VkCommandBuffer copyCommands = device.beginSingleTimeCommands();
+	VkDeviceSize offset = 0;
+	for (const auto& upload : uploads) {
+		stagingBuffer.writeToBuffer(const_cast<void*>(upload.data), upload.size, offset);
+		*upload.buffer = std::make_unique<VKBase::Buffer>(
+			device,
+			upload.size,
+			1,
+			upload.usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		VkBufferCopy copyRegion{ offset, 0, upload.size };
+		vkCmdCopyBuffer(copyCommands, stagingBuffer.getBuffer(), (*upload.buffer)->getBuffer(), 1, &copyRegion);
+		offset += upload.size;
+	}
+	device.endSingleTimeCommands(copyCommands);
+
+	writeDescriptors();
+}
+
+void Magnet::EngineBase::Rendering::MeshletRenderer::setVertexBuffers(const Geometry& geometry)
+{
+	vkDeviceWaitIdle(device.device());
+
+	this->geometry = geometry;
+	writeDescriptors();
+}
+
+void Magnet::EngineBase::Rendering::MeshletRenderer::getFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6])
+{
+	glm::mat4 rows = glm::transpose(viewProjection);
+	planes[0] = rows[3] + rows[0];
+	planes[1] = rows[3] - rows[0];
+	planes[2] = rows[3] + rows[1];
+	planes[3] = rows[3] - rows[1];
+	// Vulkan clip space depth goes from 0 to w
+	planes[4] = rows[2];
+	planes[5] = rows[3] - rows[2];
+	for (uint32_t i = 0; i < 6; i++) {
+		planes[i] /= glm::length(glm::vec3(planes[i]));
+	}
+}
+
+void Magnet::EngineBase::Rendering::MeshletRenderer::update(const std::vector<DrawInput>& inputs, const glm::mat4& viewProjection, glm::vec3 cameraPosition, glm::vec4 ambientLight, uint32_t frameIndex)
+{
+	// The frame slot's fence was waited on, its visible count is final
+	auto* visible = reinterpret_cast<uint32_t*>(static_cast<char*>(statsBuffer->getMappedMemory()) + frameIndex * statsBuffer->getAlignmentSize());
+	if (frameMeshlets[frameIndex] > 0) {
+		stats.frames++;
+		stats.meshlets += frameMeshlets[frameIndex];
+		stats.visibleMeshlets += *visible;
+	}
+	*visible = 0;
+
+	draws.clear();
+	commandCount = 0;
+	maxMeshletsPerDraw = 0;
+	if (meshletBuffer) {
+		for (const auto& input : inputs) {
+			if (input.meshletCount == 0) {
+				continue;
+			}
+			DrawRecord record{};
+			record.modelMatrix = input.modelMatrix;
+			record.firstMeshlet = input.firstMeshlet;
+			record.meshletCount = input.meshletCount;
+			record.firstCommand = commandCount;
+			record.vertexOffset = input.vertexOffset;
+			// Cones hold under uniform scale only, mirroring also flips which side is culled
+			glm::vec3 scale{ glm::length(glm::vec3(input.modelMatrix[0])), glm::length(glm::vec3(input.modelMatrix[1])), glm::length(glm::vec3(input.modelMatrix[2])) };
+			float maxScale = std::max({ scale.x, scale.y, scale.z });
+			float minScale = std::min({ scale.x, scale.y, scale.z });
+			bool uniform = maxScale - minScale <= maxScale * 1e-3f && glm::determinant(glm::mat3(input.modelMatrix)) > 0.0f;
+			record.scale = uniform ? maxScale : -maxScale;
+			draws.push_back(record);
+			commandCount += input.meshletCount;
+			maxMeshletsPerDraw = std::max(maxMeshletsPerDraw, input.meshletCount);
+		}
+	}
+	frameMeshlets[frameIndex] = commandCount;
+	reserve(static_cast<uint32_t>(draws.size()), commandCount);
+	if (!draws.empty()) {
+		drawBuffer->writeToBuffer(draws.data(), draws.size() * sizeof(DrawRecord), frameIndex * drawBuffer->getAlignmentSize());
+	}
+
+	MeshletParams params{};
+	params.viewProjection = viewProjection;
+	getFrustumPlanes(viewProjection, params.frustumPlanes);
+	params.cameraPosition = glm::vec4(cameraPosition, 1.0f);
+	params.ambientLight = ambientLight;
+	params.options = glm::uvec4(
+		static_cast<uint32_t>(draws.size()),
+		settings.frustumCulling ? 1u : 0u,
+		settings.coneCulling ? 1u : 0u,
+		geometry.perVertexColors ? 1u : 0u);
+	paramsBuffer->writeToIndex(&params, frameIndex);
+}
+
+void Magnet::EngineBase::Rendering::MeshletRenderer::cull(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+	if (mode != Mode::ComputeIndirect || draws.empty()) {
+		return;
+	}
+
+	std::array<uint32_t, 4> dynamicOffsets = {
+		static_cast<uint32_t>(frameIndex * paramsBuffer->getAlignmentSize()),
+		static_cast<uint32_t>(frameIndex * drawBuffer->getAlignmentSize()),
+		static_cast<uint32_t>(frameIndex * indirectBuffer->getAlignmentSize()),
+		static_cast<uint32_t>(frameIndex * statsBuffer->getAlignmentSize()) };
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipelineLayout, 0, 1, &descriptorSet, static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data());
+	// One row of workgroups per draw, one invocation per meshlet
+	vkCmdDispatch(commandBuffer, (maxMeshletsPerDraw + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, static_cast<uint32_t>(draws.size()), 1);
+
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void Magnet::EngineBase::Rendering::MeshletRenderer::draw(VkCommandBuffer commandBuffer, VkExtent2D extent, uint32_t frameIndex)
+{
+	if (mode != Mode::MeshShader || draws.empty()) {
+		return;
+	}
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, meshPipeline);
+	VkViewport viewport{ 0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f };
+	VkRect2D scissor{ { 0, 0 }, extent };
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+	// Dynamic offsets follow the binding order, there is no command binding in this mode
+	std::array<uint32_t, 3> dynamicOffsets = {
+		static_cast<uint32_t>(frameIndex * paramsBuffer->getAlignmentSize()),
+		static_cast<uint32_t>(frameIndex * drawBuffer->getAlignmentSize()),
+		static_cast<uint32_t>(frameIndex * statsBuffer->getAlignmentSize()) };
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 1, 1, &descriptorSet, static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data());
+
+	auto drawMeshTasks = device.functions().vkCmdDrawMeshTasksEXT;
+	for (uint32_t i = 0; i < draws.size(); i++) {
+		MeshletPush push{ i };
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT, 0, sizeof(MeshletPush), &push);
+		drawMeshTasks(commandBuffer, (draws[i].meshletCount + TASK_GROUP_SIZE - 1) / TASK_GROUP_SIZE, 1, 1);
+	}
+}
+
+void Magnet::EngineBase::Rendering::MeshletRenderer::drawIndirect(VkCommandBuffer commandBuffer, VkPipelineLayout forwardLayout, uint32_t frameIndex)
+{
+	if (mode != Mode::ComputeIndirect || draws.empty()) {
+		return;
+	}
+
+	vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+	VkDeviceSize frameOffset = frameIndex * indirectBuffer->getAlignmentSize();
+	constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+	bool multiDraw = device.features.multiDrawIndirect == VK_TRUE;
+	for (const auto& draw : draws) {
+		vkCmdPushConstants(commandBuffer, forwardLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &draw.modelMatrix);
+		VkDeviceSize offset = frameOffset + VkDeviceSize(draw.firstCommand) * stride;
+		if (multiDraw) {
+			vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffer->getBuffer(), offset, draw.meshletCount, stride);
+		}
+		else {
+			for (uint32_t i = 0; i < draw.meshletCount; i++) {
+				vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffer->getBuffer(), offset + VkDeviceSize(i) * stride, 1, stride);
+			}
+		}
+	}
+}
+
+void Magnet::EngineBase::Rendering::MeshletRenderer::printStats() const
+{
+	std::cout << "\nMeshlet Renderer :" << std::endl;
+	std::cout << "------------------------------" << std::endl;
+	std::cout << "\t- Mode : " << (mode == Mode::MeshShader ? "Mesh shaders" : "Compute culled indirect draws") << std::endl;
+	std::cout << "\t- Frames : " << stats.frames << std::endl;
+	if (stats.frames > 0) {
+		std::cout << "\t- Meshlets per frame : " << stats.meshlets / stats.frames << std::endl;
+		std::cout << "\t- Visible per frame : " << stats.visibleMeshlets / stats.frames
+			<< " (" << 100.0 * (1.0 - double(stats.visibleMeshlets) / double(std::max<uint64_t>(stats.meshlets, 1))) << "% culled)" << std::endl;
+	}
+}
@@ -0,0 +1,179 @@
+#pragma once
+#include "../../Commons.h"
+#include "../../VK/Device.h"
+#include "../../VK/Buffer.h"
+#include "../../VK/Descriptors.h"
+#include "../../VK/Pipeline.h"
+#include "../Assets/MeshletBuilder.h"
+
+namespace Magnet {
+	namespace EngineBase {
+		namespace Rendering {
+
+			// Draws the scene as meshlets (see MeshletBuilder), culled one cluster at a time against the view frustum
+			// (bounding sphere) and their normal cone, so clusters facing away from the camera are never rasterized :
+			//  - MeshShader : a task shader workgroup tests TASK_GROUP_SIZE meshlets and launches a mesh shader workgroup
+			//    per visible one, which fetches its vertices from the packed vertex buffer and emits its triangles
+			//  - ComputeIndirect : without VK_EXT_mesh_shader a compute pass writes one indexed indirect command per
+			//    meshlet, with no instance when it is culled, drawn by the forward pipeline from an index buffer of the
+			//    meshlet triangles
+			// Draws, commands and the visible count are per frame in flight.
+			class MeshletRenderer {
+			public:
+				enum class Mode { MeshShader, ComputeIndirect };
+
+				// Must match meshlet.task and meshlet_cull.comp
+				static constexpr uint32_t TASK_GROUP_SIZE = 32;
+				static constexpr uint32_t CULL_GROUP_SIZE = 64;
+
+				struct Settings {
+					bool frustumCulling = true;
+					bool coneCulling = true;
+				};
+
+				// The meshlets of one primitive drawn with one model matrix, which includes the dequantization. The
+				// meshlet vertices are offset by vertexOffset, the first vertex of the mesh in the vertex buffer
+				struct DrawInput {
+					glm::mat4 modelMatrix{ 1.f };
+					uint32_t firstMeshlet = 0;
+					uint32_t meshletCount = 0;
+					int32_t vertexOffset = 0;
+				};
+
+				// Global buffers of the scene, vertices are PackedVertex and colors RGBA8, either one per vertex or a
+				// single entry for the whole scene
+				struct Geometry {
+					VkBuffer vertexBuffer = VK_NULL_HANDLE;
+					VkBuffer colorBuffer = VK_NULL_HANDLE;
+					bool perVertexColors = false;
+				};
+
+				struct Shaders {
+					std::string task;
+					std::string mesh;
+					std::string frag;
+					std::string cull;
+				};
+
+				struct Stats {
+					uint32_t frames = 0;
+					uint64_t meshlets = 0;
+					uint64_t visibleMeshlets = 0;
+				};
+
+				// setLayouts are the sets of the forward pipeline layout, set 1 is replaced by the meshlet inputs. Mesh
+				// shaders are used when the device supports them and dynamic rendering
+				MeshletRenderer(
+					VKBase::Device& device,
+					const Shaders& shaders,
+					std::vector<VkDescriptorSetLayout> setLayouts,
+					VkFormat colorFormat,
+					VkFormat depthFormat,
+					uint32_t frameCount,
+					const Settings& settings);
+				~MeshletRenderer();
+
+				MeshletRenderer(const MeshletRenderer&) = delete;
+				MeshletRenderer& operator=(const MeshletRenderer&) = delete;
+
+				// Waits for the device and uploads the meshlets
+				void setGeometry(const Geometry& geometry, const Assets::MeshletBuilder::Meshlets& meshlets);
+				// Waits for the device and points the descriptors at new vertex buffers, the meshlets are kept
+				void setVertexBuffers(const Geometry& geometry);
+
+				// Draws of this frame, grows the per frame buffers when needed. Reads back the visible count of the
+				// last frame recorded in frameIndex, whose fence has been waited on
+				void update(const std::vector<DrawInput>& draws, const glm::mat4& viewProjection, glm::vec3 cameraPosition, glm::vec4 ambientLight, uint32_t frameIndex);
+
+				// ComputeIndirect only, must be recorded outside rendering before drawIndirect
+				void cull(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+
+				// MeshShader only, inside a dynamic rendering pass. Sets 2 and 3 are bound by the caller with getPipelineLayout
+				void draw(VkCommandBuffer commandBuffer, VkExtent2D extent, uint32_t frameIndex);
+				// ComputeIndirect only, with the forward pipeline and the model vertex buffers bound. Binds the meshlet
+				// index buffer and pushes each model matrix to forwardLayout
+				void drawIndirect(VkCommandBuffer commandBuffer, VkPipelineLayout forwardLayout, uint32_t frameIndex);
+
+				Mode getMode() const { return mode; }
+				VkPipelineLayout getPipelineLayout() const { return pipelineLayout; }
+				const Stats& getStats() const { return stats; }
+				void printStats() const;
+
+			private:
+				// std430 layout, matches DrawRecord in meshlet.glsl
+				struct DrawRecord {
+					glm::mat4 modelMatrix{ 1.f };
+					uint32_t firstMeshlet = 0;
+					uint32_t meshletCount = 0;
+					// First indirect command of the draw
+					uint32_t firstCommand = 0;
+					// Largest axis scale of the model matrix, negative when it is not uniform and cones can't be used
+					float scale = 1.0f;
+					int32_t vertexOffset = 0;
+					uint32_t padding[3]{};
+				};
+
+				// std140 layout, matches MeshletParams in meshlet.glsl
+				struct MeshletParams {
+					glm::mat4 viewProjection{ 1.f };
+					glm::vec4 frustumPlanes[6]{};
+					glm::vec4 cameraPosition{ 0.f };
+					glm::vec4 ambientLight{ 0.f }; // w is intensity
+					// Draw count, frustum culling, cone culling, color stride
+					glm::uvec4 options{ 0u };
+				};
+
+				struct MeshletPush {
+					uint32_t drawIndex;
+				};
+
+				void createBuffers(uint32_t frameCount);
+				void createDescriptors();
+				void createPipelines(const Shaders& shaders, std::vector<VkDescriptorSetLayout> setLayouts, VkFormat colorFormat, VkFormat depthFormat);
+				VkShaderModule createShaderModule(const std::string& filepath);
+				void writeDescriptors();
+				// Reallocates the per frame draws and commands to hold at least drawCount draws and commandCount meshlets
+				void reserve(uint32_t drawCount, uint32_t commandCount);
+
+				// Planes of the clip space volume (0 to 1 depth), normals point inside
+				static void getFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]);
+
+				VKBase::Device& device;
+				Mode mode;
+				Settings settings;
+				uint32_t frameCount;
+				Stats stats{};
+
+				Geometry geometry{};
+				std::vector<DrawRecord> draws;
+				uint32_t commandCount = 0;
+				uint32_t maxMeshletsPerDraw = 0;
+				// Draw count recorded in each frame in flight, for the visible count read back
+				std::vector<uint32_t> frameMeshlets;
+
+				// Device local, uploaded by setGeometry
+				std::unique_ptr<VKBase::Buffer> meshletBuffer;
+				std::unique_ptr<VKBase::Buffer> boundsBuffer;
+				std::unique_ptr<VKBase::Buffer> meshletVertexBuffer;
+				std::unique_ptr<VKBase::Buffer> triangleBuffer;
+				// Meshlet triangles as 32-bit indices into the vertex buffer, ComputeIndirect only
+				std::unique_ptr<VKBase::Buffer> indexBuffer;
+
+				std::unique_ptr<VKBase::Buffer> paramsBuffer;
+				std::unique_ptr<VKBase::Buffer> drawBuffer;
+				// VkDrawIndexedIndirectCommand per meshlet of the frame's draws, ComputeIndirect only
+				std::unique_ptr<VKBase::Buffer> indirectBuffer;
+				std::unique_ptr<VKBase::Buffer> statsBuffer;
+
+				std::unique_ptr<VKBase::DescriptorSetLayout> setLayout;
+				std::unique_ptr<VKBase::DescriptorPool> descriptorPool;
+				VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+				VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+				VkPipeline meshPipeline = VK_NULL_HANDLE;
+				VkPipelineLayout cullPipelineLayout = VK_NULL_HANDLE;
+				VkPipeline cullPipeline = VK_NULL_HANDLE;
+			};
+		}
+	}
+}
@@ -0,0 +1,333 @@
+#include "MipmapGenerator.h"
+#include "../../VK/Pipeline.h"
+
+namespace {
+	VkImageMemoryBarrier levelBarrier(VkImage image, uint32_t baseLevel, uint32_t levelCount, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask)
+	{
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = srcAccessMask;
+		barrier.dstAccessMask = dstAccessMask;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, baseLevel, levelCount, 0, 1 };
+		return barrier;
+	}
+
+	void submitBarriers(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, const std::vector<VkImageMemoryBarrier>& barriers)
+	{
+		if (barriers.empty()) {
+			return;
+		}
+		vkCmdPipelineBarrier(commandBuffer, srcStageMask, dstStageMask, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+	}
+}
+
+Magnet::EngineBase::Rendering::MipmapGenerator::MipmapGenerator(VKBase::Device& device, const std::string& computeShaderPath) : device{ device }, computeShaderPath{ computeShaderPath }
+{
+}
+
+Magnet::EngineBase::Rendering::MipmapGenerator::~MipmapGenerator()
+{
+	releaseComputeResources();
+	vkDestroyPipeline(device.device(), pipeline, nullptr);
+	vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+	vkDestroySampler(device.device(), sampler, nullptr);
+}
+
+uint32_t Magnet::EngineBase::Rendering::MipmapGenerator::fullMipLevels(uint32_t width, uint32_t height)
+{
+	return static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+}
+
+Magnet::EngineBase::Rendering::MipmapGenerator::Method Magnet::EngineBase::Rendering::MipmapGenerator::selectMethod(VkFormat format)
+{
+	VkFormatFeatureFlags formatFeatures = device.getFormatProperties(format).optimalTilingFeatures;
+
+	VkFormatFeatureFlags blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+	if ((formatFeatures & blitFeatures) == blitFeatures) {
+		return Method::Blit;
+	}
+
+	// The downsampler reads and writes its levels through unformatted, dynamically indexed storage images
+	VkFormatFeatureFlags computeFeatures = VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+	if ((formatFeatures & computeFeatures) == computeFeatures &&
+		device.features.shaderStorageImageReadWithoutFormat &&
+		device.features.shaderStorageImageWriteWithoutFormat &&
+		device.features.shaderStorageImageArrayDynamicIndexing) {
+		return Method::Compute;
+	}
+	return Method::None;
+}
+
+uint32_t Magnet::EngineBase::Rendering::MipmapGenerator::supportedMipLevels(VkFormat format, uint32_t width, uint32_t height)
+{
+	switch (selectMethod(format)) {
+	case Method::Blit:
+		return fullMipLevels(width, height);
+	case Method::Compute:
+		// Larger images stop at MAX_COMPUTE_LEVELS, the last workgroup reduces every 64x64 tile of level 6
+		return std::min(fullMipLevels(width, height), MAX_COMPUTE_LEVELS + 1);
+	default:
+		return 1;
+	}
+}
+
+VkImageUsageFlags Magnet::EngineBase::Rendering::MipmapGenerator::requiredUsage(VkFormat format)
+{
+	switch (selectMethod(format)) {
+	case Method::Blit:
+		return VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	case Method::Compute:
+		return VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	default:
+		return VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	}
+}
+
+void Magnet::EngineBase::Rendering::MipmapGenerator::generate(VkCommandBuffer commandBuffer, const std::vector<Job>& jobs)
+{
+	std::vector<Job> blitJobs;
+	std::vector<Job> computeJobs;
+	for (const auto& job : jobs) {
+		assert(job.mipLevels <= supportedMipLevels(job.format, job.width, job.height) && "Cannot generate mipmaps: too many levels for this format");
+		if (job.mipLevels > 1 && selectMethod(job.format) == Method::Compute) {
+			computeJobs.push_back(job);
+		}
+		else {
+			blitJobs.push_back(job);
+		}
+	}
+
+	generateBlit(commandBuffer, blitJobs);
+	generateCompute(commandBuffer, computeJobs);
+}
+
+void Magnet::EngineBase::Rendering::MipmapGenerator::generateBlit(VkCommandBuffer commandBuffer, const std::vector<Job>& jobs)
+{
+	uint32_t maxLevels = 1;
+	std::vector<VkImageMemoryBarrier> barriers;
+	for (const auto& job : jobs) {
+		maxLevels = std::max(maxLevels, job.mipLevels);
+		if (job.mipLevels > 1) {
+			barriers.push_back(levelBarrier(job.image, 1, job.mipLevels - 1,
+				VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT));
+		}
+	}
+	submitBarriers(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, barriers);
+
+	// Level by level, every image advancing together so each level costs one barrier batch
+	for (uint32_t level = 1; level < maxLevels; level++) {
+		barriers.clear();
+		for (const auto& job : jobs) {
+			if (level < job.mipLevels) {
+				barriers.push_back(levelBarrier(job.image, level - 1, 1,
+					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT));
+			}
+		}
+		submitBarriers(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, barriers);
+
+		for (const auto& job : jobs) {
+			if (level >= job.mipLevels) {
+				continue;
+			}
+			VkImageBlit blit{};
+			blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1 };
+			blit.srcOffsets[1] = { std::max(int32_t(job.width >> (level - 1)), 1), std::max(int32_t(job.height >> (level - 1)), 1), 1 };
+			blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+			blit.dstOffsets[1] = { std::max(int32_t(job.width >> level), 1), std::max(int32_t(job.height >> level), 1), 1 };
+			vkCmdBlitImage(commandBuffer, job.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, job.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+		}
+	}
+
+	// Every level but the last was a blit source
+	barriers.clear();
+	for (const auto& job : jobs) {
+		if (job.mipLevels > 1) {
+			barriers.push_back(levelBarrier(job.image, 0, job.mipLevels - 1,
+				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, job.finalLayout, VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT));
+		}
+		barriers.push_back(levelBarrier(job.image, job.mipLevels - 1, 1,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, job.finalLayout, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT));
+	}
+	submitBarriers(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, barriers);
+}
+
+void Magnet::EngineBase::Rendering::MipmapGenerator::createComputePipeline()
+{
+	setLayout = VKBase::DescriptorSetLayout::Builder(device)
+		.addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+		.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT, MAX_COMPUTE_LEVELS)
+		.addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+		.build();
+
+	VkDescriptorSetLayout layout = setLayout->getDescriptorSetLayout();
+	// Level count, workgroup count, counter index
+	VkPushConstantRange pushConstantRange{ VK_SHADER_STAGE_COMPUTE_BIT, 0, 3 * sizeof(uint32_t) };
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &layout;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create mipmap pipeline layout!");
+	}
+
+	auto code = VKBase::Pipeline::readFile(computeShaderPath);
+	VkShaderModuleCreateInfo moduleInfo{};
+	moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	moduleInfo.codeSize = code.size();
+	moduleInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+	VkShaderModule shaderModule;
+	if (vkCreateShaderModule(device.device(), &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create shader module!");
+	}
+
+	VkComputePipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = shaderModule;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = pipelineLayout;
+
+	VkResult result = vkCreateComputePipelines(device.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+	vkDestroyShaderModule(device.device(), shaderModule, nullptr);
+	if (result != VK_SUCCESS) {
+		throw std::runtime_error("failed to create mipmap pipeline!");
+	}
+
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+	if (vkCreateSampler(device.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create mipmap sampler!");
+	}
+}
+
+void Magnet::EngineBase::Rendering::MipmapGenerator::releaseComputeResources()
+{
+	for (auto view : imageViews) {
+		vkDestroyImageView(device.device(), view, nullptr);
+	}
+	imageViews.clear();
+	descriptorPool.reset();
+	counterBuffer.reset();
+}
+
+void Magnet::EngineBase::Rendering::MipmapGenerator::generateCompute(VkCommandBuffer commandBuffer, const std::vector<Job>& jobs)
+{
+	releaseComputeResources();
+	if (jobs.empty()) {
+		return;
+	}
+	if (pipeline == VK_NULL_HANDLE) {
+		createComputePipeline();
+	}
+
+	uint32_t jobCount = static_cast<uint32_t>(jobs.size());
+	descriptorPool = VKBase::DescriptorPool::Builder(device)
+		.setMaxSets(jobCount)
+		.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, jobCount)
+		.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, jobCount * MAX_COMPUTE_LEVELS)
+		.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, jobCount)
+		.build();
+
+	// One completion counter per image for the last workgroup election
+	counterBuffer = std::make_unique<VKBase::Buffer>(
+		device,
+		sizeof(uint32_t),
+		jobCount,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	vkCmdFillBuffer(commandBuffer, counterBuffer->getBuffer(), 0, VK_WHOLE_SIZE, 0);
+	auto counterInfo = counterBuffer->descriptorInfo();
+
+	auto createView = [this](const Job& job, uint32_t level) {
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = job.image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = job.format;
+		viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1 };
+
+		VkImageView view;
+		if (vkCreateImageView(device.device(), &viewInfo, nullptr, &view) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create mipmap image view!");
+		}
+		imageViews.push_back(view);
+		return view;
+	};
+
+	std::vector<VkDescriptorSet> descriptorSets(jobCount);
+	std::vector<VkImageMemoryBarrier> barriers;
+	for (uint32_t i = 0; i < jobCount; i++) {
+		const Job& job = jobs[i];
+
+		VkDescriptorImageInfo sourceInfo{ sampler, createView(job, 0), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		// Unused entries repeat the last level, the shader never touches them
+		std::array<VkDescriptorImageInfo, MAX_COMPUTE_LEVELS> levelInfos{};
+		for (uint32_t level = 1; level <= MAX_COMPUTE_LEVELS; level++) {
+			levelInfos[level - 1] = level < job.mipLevels
+				? VkDescriptorImageInfo{ VK_NULL_HANDLE, createView(job, level), VK_IMAGE_LAYOUT_GENERAL }
+				: levelInfos[job.mipLevels - 2];
+		}
+
+		bool built = VKBase::DescriptorWriter(*setLayout, *descriptorPool)
+			.writeImage(0, &sourceInfo)
+			.writeImages(1, levelInfos.data())
+			.writeBuffer(2, &counterInfo)
+			.build(descriptorSets[i]);
+		if (!built) {
+			throw std::runtime_error("failed to allocate mipmap descriptor set!");
+		}
+
+		barriers.push_back(levelBarrier(job.image, 0, 1,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT));
+		barriers.push_back(levelBarrier(job.image, 1, job.mipLevels - 1,
+			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, 0, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT));
+	}
+
+	// Covers the counter clear as well
+	VkMemoryBarrier counterBarrier{};
+	counterBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	counterBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	counterBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+		1, &counterBarrier, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+	for (uint32_t i = 0; i < jobCount; i++) {
+		const Job& job = jobs[i];
+		// Each workgroup covers 32x32 texels of level 1
+		uint32_t groupsX = (std::max(job.width >> 1, 1u) + 31) / 32;
+		uint32_t groupsY = (std::max(job.height >> 1, 1u) + 31) / 32;
+		std::array<uint32_t, 3> push = { job.mipLevels - 1, groupsX * groupsY, i };
+
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSets[i], 0, nullptr);
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), push.data());
+		vkCmdDispatch(commandBuffer, groupsX, groupsY, 1);
+	}
+
+	barriers.clear();
+	for (const auto& job : jobs) {
+		barriers.push_back(levelBarrier(job.image, 0, 1,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, job.finalLayout, VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_SHADER_READ_BIT));
+		barriers.push_back(levelBarrier(job.image, 1, job.mipLevels - 1,
+			VK_IMAGE_LAYOUT_GENERAL, job.finalLayout, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT));
+	}
+	submitBarriers(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, barriers);
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "../../Commons.h"
+#include "../../VK/Device.h"
+#include "../../VK/Buffer.h"
+#include "../../VK/Descriptors.h"
+
+namespace Magnet {
+	namespace EngineBase {
+		namespace Rendering {
+
+			// Generates mip chains on the GPU for many images in one command buffer.
+			// Formats with linear blit support are reduced level by level with vkCmdBlitImage, one batched barrier
+			// per level for every image; the others use a single dispatch compute downsampler per image.
+			class MipmapGenerator {
+			public:
+				// Must match MAX_LEVELS in mipmap.comp
+				static constexpr uint32_t MAX_COMPUTE_LEVELS = 12;
+
+				struct Job {
+					VkImage image = VK_NULL_HANDLE;
+					VkFormat format = VK_FORMAT_UNDEFINED;
+					uint32_t width = 0;
+					uint32_t height = 0;
+					uint32_t mipLevels = 1;
+					VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				};
+
+				enum class Method { None, Blit, Compute };
+
+				MipmapGenerator(VKBase::Device& device, const std::string& computeShaderPath);
+				~MipmapGenerator();
+
+				MipmapGenerator(const MipmapGenerator&) = delete;
+				MipmapGenerator& operator=(const MipmapGenerator&) = delete;
+
+				static uint32_t fullMipLevels(uint32_t width, uint32_t height);
+				// Levels the generator can produce for this format, 1 when it cannot generate any
+				uint32_t supportedMipLevels(VkFormat format, uint32_t width, uint32_t height);
+				Method selectMethod(VkFormat format);
+				// Usage flags the images need for the selected method
+				VkImageUsageFlags requiredUsage(VkFormat format);
+
+				// Level 0 of every image must be in TRANSFER_DST_OPTIMAL with its upload visible to transfers,
+				// the other levels in UNDEFINED. Every level ends in the job's finalLayout.
+				// Compute resources stay alive until the next call, the command buffer must complete before.
+				void generate(VkCommandBuffer commandBuffer, const std::vector<Job>& jobs);
+
+			private:
+				void generateBlit(VkCommandBuffer commandBuffer, const std::vector<Job>& jobs);
+				void generateCompute(VkCommandBuffer commandBuffer, const std::vector<Job>& jobs);
+				void createComputePipeline();
+				void releaseComputeResources();
+
+				VKBase::Device& device;
+				std::string computeShaderPath;
+
+				// Created on the first compute job
+				std::unique_ptr<VKBase::DescriptorSetLayout> setLayout;
+				VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+				VkPipeline pipeline = VK_NULL_HANDLE;
+				VkSampler sampler = VK_NULL_HANDLE;
+
+				// Per generate call
+				std::unique_ptr<VKBase::DescriptorPool> descriptorPool;
+				std::unique_ptr<VKBase::Buffer> counterBuffer;
+				std::vector<VkImageView> imageViews;
+			};
+		}
+	}
+}
@@ -0,0 +1,825 @@
+#include "RenderGraph.h"
+
+namespace {
+	using Magnet::EngineBase::Rendering::RGAccess;
+
+	struct AccessInfo {
+		VkPipelineStageFlags2KHR stageMask;
+		VkAccessFlags2KHR accessMask;
+		VkImageLayout layout;
+		VkImageUsageFlags imageUsage;
+		VkBufferUsageFlags bufferUsage;
+	};
+
+	// Only stage and access bits that also exist in the 32 bit masks are used, so barriers can fall back
+	// to vkCmdPipelineBarrier when VK_KHR_synchronization2 is not available
+	AccessInfo getAccessInfo(RGAccess access)
+	{
+		constexpr VkPipelineStageFlags2KHR depthTests = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR;
+		constexpr VkPipelineStageFlags2KHR shaders = VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT_KHR | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+
+		switch (access) {
+		case RGAccess::ColorAttachmentWrite:
+			return { VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR, VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR,
+				VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, 0 };
+		case RGAccess::DepthAttachmentWrite:
+			return { depthTests, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR,
+				VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 0 };
+		case RGAccess::DepthAttachmentRead:
+			return { depthTests, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR,
+				VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 0 };
+		case RGAccess::SampledRead:
+			return { shaders, VK_ACCESS_2_SHADER_READ_BIT_KHR,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT, 0 };
+		case RGAccess::StorageRead:
+			return { shaders, VK_ACCESS_2_SHADER_READ_BIT_KHR,
+				VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT };
+		case RGAccess::StorageWrite:
+			return { shaders, VK_ACCESS_2_SHADER_READ_BIT_KHR | VK_ACCESS_2_SHADER_WRITE_BIT_KHR,
+				VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT };
+		case RGAccess::TransferRead:
+			return { VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR, VK_ACCESS_2_TRANSFER_READ_BIT_KHR,
+				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT };
+		case RGAccess::TransferWrite:
+			return { VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_BUFFER_USAGE_TRANSFER_DST_BIT };
+		case RGAccess::UniformRead:
+			return { shaders, VK_ACCESS_2_UNIFORM_READ_BIT_KHR,
+				VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT };
+		case RGAccess::VertexBufferRead:
+			return { VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT_KHR, VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT_KHR,
+				VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT };
+		case RGAccess::IndexBufferRead:
+			return { VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT_KHR, VK_ACCESS_2_INDEX_READ_BIT_KHR,
+				VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_INDEX_BUFFER_BIT };
+		case RGAccess::IndirectRead:
+			return { VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT_KHR, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT_KHR,
+				VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT };
+		case RGAccess::Present:
+			return { VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT_KHR, 0,
+				VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, 0, 0 };
+		}
+		throw std::runtime_error("unknown render graph access!");
+	}
+
+	const char* getAccessName(RGAccess access)
+	{
+		switch (access) {
+		case RGAccess::ColorAttachmentWrite: return "color attachment";
+		case RGAccess::DepthAttachmentWrite: return "depth attachment";
+		case RGAccess::DepthAttachmentRead: return "depth read only";
+		case RGAccess::SampledRead: return "sampled";
+		case RGAccess::StorageRead: return "storage read";
+		case RGAccess::StorageWrite: return "storage write";
+		case RGAccess::TransferRead: return "transfer src";
+		case RGAccess::TransferWrite: return "transfer dst";
+		case RGAccess::UniformRead: return "uniform";
+		case RGAccess::VertexBufferRead: return "vertex buffer";
+		case RGAccess::IndexBufferRead: return "index buffer";
+		case RGAccess::IndirectRead: return "indirect";
+		case RGAccess::Present: return "present";
+		}
+		return "unknown";
+	}
+
+	VkImageAspectFlags getAspectMask(VkFormat format)
+	{
+		switch (format) {
+		case VK_FORMAT_D16_UNORM:
+		case VK_FORMAT_X8_D24_UNORM_PACK32:
+		case VK_FORMAT_D32_SFLOAT:
+			return VK_IMAGE_ASPECT_DEPTH_BIT;
+		case VK_FORMAT_D16_UNORM_S8_UINT:
+		case VK_FORMAT_D24_UNORM_S8_UINT:
+		case VK_FORMAT_D32_SFLOAT_S8_UINT:
+			return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+		case VK_FORMAT_S8_UINT:
+			return VK_IMAGE_ASPECT_STENCIL_BIT;
+		default:
+			return VK_IMAGE_ASPECT_COLOR_BIT;
+		}
+	}
+
+	const char* getLayoutName(VkImageLayout layout)
+	{
+		switch (layout) {
+		case VK_IMAGE_LAYOUT_UNDEFINED: return "UNDEFINED";
+		case VK_IMAGE_LAYOUT_GENERAL: return "GENERAL";
+		case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL: return "COLOR_ATTACHMENT";
+		case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL: return "DEPTH_STENCIL_ATTACHMENT";
+		case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL: return "DEPTH_STENCIL_READ_ONLY";
+		case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL: return "SHADER_READ_ONLY";
+		case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL: return "TRANSFER_SRC";
+		case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL: return "TRANSFER_DST";
+		case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR: return "PRESENT_SRC";
+		default: return "OTHER";
+		}
+	}
+
+	bool lifetimesOverlap(uint32_t firstA, uint32_t lastA, uint32_t firstB, uint32_t lastB)
+	{
+		return firstA <= lastB && firstB <= lastA;
+	}
+}
+
+Magnet::EngineBase::Rendering::RGResource Magnet::EngineBase::Rendering::RenderGraph::PassBuilder::read(RGResource resource, RGAccess access)
+{
+	assert(resource.valid() && resource.index < graph.resources.size() && "Cannot read resource: invalid handle");
+	graph.passes[pass].usages.push_back({ resource.index, access, false });
+	return resource;
+}
+
+Magnet::EngineBase::Rendering::RGResource Magnet::EngineBase::Rendering::RenderGraph::PassBuilder::write(RGResource resource, RGAccess access)
+{
+	assert(resource.valid() && resource.index < graph.resources.size() && "Cannot write resource: invalid handle");
+	graph.passes[pass].usages.push_back({ resource.index, access, true });
+	return resource;
+}
+
+Magnet::EngineBase::Rendering::RenderGraph::RenderGraph(VKBase::Device& device) : device{ device }
+{
+}
+
+Magnet::EngineBase::Rendering::RenderGraph::~RenderGraph()
+{
+	destroyTransientResources();
+}
+
+Magnet::EngineBase::Rendering::RGResource Magnet::EngineBase::Rendering::RenderGraph::createImage(const std::string& name, const RGImageDesc& desc)
+{
+	Resource resource{};
+	resource.name = name;
+	resource.imageDesc = desc;
+	resources.push_back(resource);
+	return { static_cast<uint32_t>(resources.size() - 1) };
+}
+
+Magnet::EngineBase::Rendering::RGResource Magnet::EngineBase::Rendering::RenderGraph::createBuffer(const std::string& name, const RGBufferDesc& desc)
+{
+	Resource resource{};
+	resource.name = name;
+	resource.isImage = false;
+	resource.bufferDesc = desc;
+	resources.push_back(resource);
+	return { static_cast<uint32_t>(resources.size() - 1) };
+}
+
+Magnet::EngineBase::Rendering::RGResource Magnet::EngineBase::Rendering::RenderGraph::importImage(const std::string& name, VkImage image, VkImageView imageView, const RGImageDesc& desc, VkImageLayout initialLayout, RGAccess finalAccess)
+{
+	Resource resource{};
+	resource.name = name;
+	resource.imported = true;
+	resource.imageDesc = desc;
+	resource.image = image;
+	resource.imageView = imageView;
+	resource.initialLayout = initialLayout;
+	resource.finalAccess = finalAccess;
+	resources.push_back(resource);
+	return { static_cast<uint32_t>(resources.size() - 1) };
+}
+
+Magnet::EngineBase::Rendering::RGResource Magnet::EngineBase::Rendering::RenderGraph::importBuffer(const std::string& name, VkBuffer buffer, const RGBufferDesc& desc)
+{
+	Resource resource{};
+	resource.name = name;
+	resource.isImage = false;
+	resource.imported = true;
+	resource.bufferDesc = desc;
+	resource.buffer = buffer;
+	resources.push_back(resource);
+	return { static_cast<uint32_t>(resources.size() - 1) };
+}
+
+void Magnet::EngineBase::Rendering::RenderGraph::setImportedImage(RGResource resource, VkImage image, VkImageView imageView)
+{
+	assert(resources[resource.index].imported && resources[resource.index].isImage && "Cannot rebind image: resource is not an imported image");
+	resources[resource.index].image = image;
+	resources[resource.index].imageView = imageView;
+}
+
+void Magnet::EngineBase::Rendering::RenderGraph::setImportedBuffer(RGResource resource, VkBuffer buffer)
+{
+	assert(resources[resource.index].imported && !resources[resource.index].isImage && "Cannot rebind buffer: resource is not an imported buffer");
+	resources[resource.index].buffer = buffer;
+}
+
+void Magnet::EngineBase::Rendering::RenderGraph::addPass(const std::string& name, const SetupFunction& setup, const ExecuteFunction& execute)
+{
+	assert(!compiled && "Cannot add pass: render graph is already compiled");
+
+	Pass pass{};
+	pass.name = name;
+	pass.execute = execute;
+	passes.push_back(pass);
+
+	PassBuilder builder{ *this, static_cast<uint32_t>(passes.size() - 1) };
+	setup(builder);
+}
+
+void Magnet::EngineBase::Rendering::RenderGraph::compile()
+{
+	assert(!compiled && "Cannot compile: render graph is already compiled");
+
+	cullPasses();
+	computeLifetimes();
+	createTransientResources();
+	computeBarriers();
+	compiled = true;
+}
+
+void Magnet::EngineBase::Rendering::RenderGraph::execute(VkCommandBuffer commandBuffer) const
+{
+	assert(compiled && "Cannot execute: render graph is not compiled");
+
+	for (const auto& pass : passes) {
+		if (pass.culled) {
+			continue;
+		}
+		recordBarriers(commandBuffer, pass.barriers);
+		pass.execute(commandBuffer, *this);
+	}
+	recordBarriers(commandBuffer, finalBarriers);
+}
+
+void Magnet::EngineBase::Rendering::RenderGraph::reset()
+{
+	destroyTransientResources();
+	passes.clear();
+	resources.clear();
+	finalBarriers.clear();
+	unaliasedSize = 0;
+	compiled = false;
+}
+
+VkImage Magnet::EngineBase::Rendering::RenderGraph::getImage(RGResource resource) const
+{
+	assert(resources[resource.index].isImage && "Cannot get image: resource is a buffer");
+	return resources[resource.index].image;
+}
+
+VkImageView Magnet::EngineBase::Rendering::RenderGraph::getImageView(RGResource resource) const
+{
+	assert(resources[resource.index].isImage && "Cannot get image view: resource is a buffer");
+	return resources[resource.index].imageView;
+}
+
+VkBuffer Magnet::EngineBase::Rendering::RenderGraph::getBuffer(RGResource resource) const
+{
+	assert(!resources[resource.index].isImage && "Cannot get buffer: resource is an image");
+	return resources[resource.index].buffer;
+}
+
+VkExtent2D Magnet::EngineBase::Rendering::RenderGraph::getExtent(RGResource resource) const
+{
+	return resources[resource.index].imageDesc.extent;
+}
+
+void Magnet::EngineBase::Rendering::RenderGraph::cullPasses()
+{
+	// Walk the passes backwards: a pass survives if it has a side effect or writes something a surviving pass,
+	// or the outside world through an imported resource, needs
+	std::vector<bool> needed(resources.size(), false);
+	for (size_t i = 0; i < resources.size(); i++) {
+		needed[i] = resources[i].imported;
+	}
+
+	for (auto pass = passes.rbegin(); pass != passes.rend(); ++pass) {
+		bool alive = pass->sideEffect;
+		for (const auto& usage : pass->usages) {
+			alive = alive || (usage.write && needed[usage.resource]);
+		}
+
+		pass->culled = !alive;
+		if (!alive) {
+			continue;
+		}
+		for (const auto& usage : pass->usages) {
+			if (!usage.write) {
+				needed[usage.resource] = true;
+			}
+		}
+	}
+}
+
+void Magnet::EngineBase::Rendering::RenderGraph::computeLifetimes()
+{
+	for (uint32_t i = 0; i < passes.size(); i++) {
+		if (passes[i].culled) {
+			continue;
+		}
+		for (const auto& usage : passes[i].usages) {
+			Resource& resource = resources[usage.resource];
+			resource.firstPass = std::min(resource.firstPass, i);
+			resource.lastPass = std::max(resource.lastPass, i);
+		}
+	}
+}
+
+void Magnet::EngineBase::Rendering::RenderGraph::createTransientResources()
+{
+	VkDevice vkDevice = device.device();
+	std::vector<uint32_t> transients;
+
+	for (uint32_t i = 0; i < resources.size(); i++) {
+		Resource& resource = resources[i];
+		if (resource.imported || resource.firstPass == ~0u) {
+			continue;
+		}
+
+		VkImageUsageFlags imageUsage = resource.imageDesc.usage;
+		VkBufferUsageFlags bufferUsage = resource.bufferDesc.usage;
+		for (const auto& pass : passes) {
+			if (pass.culled) {
+				continue;
+			}
+			for (const auto& usage : pass.usages) {
+				if (usage.resource == i) {
+					AccessInfo info = getAccessInfo(usage.access);
+					imageUsage |= info.imageUsage;
+					bufferUsage |= info.bufferUsage;
+				}
+			}
+		}
+
+		if (resource.isImage) {
+			VkImageCreateInfo imageInfo{};
+			imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			imageInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageInfo.extent = { resource.imageDesc.extent.width, resource.imageDesc.extent.height, 1 };
+			imageInfo.mipLevels = 1;
+			imageInfo.arrayLayers = 1;
+			imageInfo.format = resource.imageDesc.format;
+			imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			imageInfo.usage = imageUsage;
+			imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+			imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+			if (vkCreateImage(vkDevice, &imageInfo, nullptr, &resource.image) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create render graph image!");
+			}
+			vkGetImageMemoryRequirements(vkDevice, resource.image, &resource.memoryRequirements);
+		}
+		else {
+			VkBufferCreateInfo bufferInfo{};
+			bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferInfo.size = resource.bufferDesc.size;
+			bufferInfo.usage = bufferUsage;
+			bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+			if (vkCreateBuffer(vkDevice, &bufferInfo, nullptr, &resource.buffer) != VK_SUCCESS) {
+				throw std::runtime_error("failed to create render graph buffer!");
+			}
+			vkGetBufferMemoryRequirements(vkDevice, resource.buffer, &resource.memoryRequirements);
+		}
+
+		unaliasedSize += resource.memoryRequirements.size;
+		transients.push_back(i);
+	}
+
+	// Largest first, each resource goes into the first block whose occupants are all dead or not yet born
+	std::sort(transients.begin(), transients.end(), [this](uint32_t a, uint32_t b) {
+		return resources[a].memoryRequirements.size > resources[b].memoryRequirements.size;
+	});
+
+	for (uint32_t index : transients) {
+		Resource& resource = resources[index];
+		for (uint32_t b = 0; b < memoryBlocks.size() && resource.memoryBlock == ~0u; b++) {
+			MemoryBlock& block = memoryBlocks[b];
+			if ((block.memoryTypeBits & resource.memoryRequirements.memoryTypeBits) == 0) {
+				continue;
+			}
+			bool overlaps = std::any_of(block.resources.begin(), block.resources.end(), [&](uint32_t other) {
+				return lifetimesOverlap(resource.firstPass, resource.lastPass, resources[other].firstPass, resources[other].lastPass);
+			});
+			if (!overlaps) {
+				resource.memoryBlock = b;
+			}
+		}
+
+		if (resource.memoryBlock == ~0u) {
+			memoryBlocks.push_back({});
+			resource.memoryBlock = static_cast<uint32_t>(memoryBlocks.size() - 1);
+		}
+
+		MemoryBlock& block = memoryBlocks[resource.memoryBlock];
+		block.size = std::max(block.size, resource.memoryRequirements.size);
+		block.memoryTypeBits &= resource.memoryRequirements.memoryTypeBits;
+		block.resources.push_back(index);
+	}
+
+	for (auto& block : memoryBlocks) {
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = block.size;
+		allocInfo.memoryTypeIndex = device.findMemoryType(block.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		if (vkAllocateMemory(vkDevice, &allocInfo, nullptr, &block.memory) != VK_SUCCESS) {
+			throw std::runtime_error("failed to allocate render graph memory!");
+		}
+
+		// Every occupant starts at offset 0, so the largest alignment requirement is always met
+		for (uint32_t index : block.resources) {
+			Resource& resource = resources[index];
+			VkResult result = resource.isImage
+				? vkBindImageMemory(vkDevice, resource.image, block.memory, 0)
+				: vkBindBufferMemory(vkDevice, resource.buffer, block.memory, 0);
+			if (result != VK_SUCCESS) {
+				throw std::runtime_error("failed to bind render graph memory!");
+			}
+		}
+	}
+
+	for (uint32_t index : transients) {
+		Resource& resource = resources[index];
+		if (!resource.isImage) {
+			continue;
+		}
+
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = resource.image;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = resource.imageDesc.format;
+		viewInfo.subresourceRange.aspectMask = getAspectMask(resource.imageDesc.format);
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		if (vkCreateImageView(vkDevice, &viewInfo, nullptr, &resource.imageView) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create render graph image view!");
+		}
+	}
+}
+
+void Magnet::EngineBase::Rendering::RenderGraph::computeBarriers()
+{
+	std::vector<State> initialStates(resources.size());
+	for (size_t i = 0; i < resources.size(); i++) {
+		initialStates[i].layout = resources[i].imported ? resources[i].initialLayout : VK_IMAGE_LAYOUT_UNDEFINED;
+	}
+
+	std::vector<State> states = initialStates;
+	computePassBarriers(states);
+
+	// Transient resources and imported resources other than swapchain images are shared by the frames in flight,
+	// their first access in a frame waits for the last accesses of the previous one. The first transition still
+	// starts from UNDEFINED for transient resources and from the initial layout for imported ones
+	for (size_t i = 0; i < resources.size(); i++) {
+		if (!isSwapchainImage(resources[i])) {
+			initialStates[i].writeStages = states[i].writeStages;
+			initialStates[i].writeAccess = states[i].writeAccess;
+			initialStates[i].readStages = states[i].readStages;
+		}
+	}
+	// Aliased resources also wait for the other occupants of their memory, the previous ones in the frame or the
+	// later ones of the previous frame
+	for (const auto& block : memoryBlocks) {
+		if (block.resources.size() < 2) {
+			continue;
+		}
+		for (uint32_t index : block.resources) {
+			initialStates[index].readStages |= VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR;
+			initialStates[index].writeAccess |= VK_ACCESS_2_MEMORY_WRITE_BIT_KHR;
+		}
+	}
+	// The acquire semaphore of a swapchain image is waited on at color attachment output, the transition out of
+	// its initial layout must come after that wait
+	for (size_t i = 0; i < resources.size(); i++) {
+		if (isSwapchainImage(resources[i])) {
+			initialStates[i].readStages |= VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR;
+		}
+	}
+
+	states = initialStates;
+	computePassBarriers(states);
+
+	finalBarriers.clear();
+	for (uint32_t i = 0; i < resources.size(); i++) {
+		const Resource& resource = resources[i];
+		if (!resource.imported || !resource.isImage || resource.firstPass == ~0u) {
+			continue;
+		}
+
+		AccessInfo info = getAccessInfo(resource.finalAccess);
+		const State& state = states[i];
+		if (state.layout == info.layout && state.writeStages == 0) {
+			continue;
+		}
+
+		Barrier barrier{};
+		barrier.resource = i;
+		barrier.srcStageMask = state.writeStages | state.readStages;
+		barrier.srcAccessMask = state.writeAccess;
+		barrier.dstStageMask = info.stageMask;
+		barrier.dstAccessMask = info.accessMask;
+		barrier.oldLayout = state.layout;
+		barrier.newLayout = info.layout;
+		finalBarriers.push_back(barrier);
+	}
+}
+
+void Magnet::EngineBase::Rendering::RenderGraph::computePassBarriers(std::vector<State>& states)
+{
+	for (auto& pass : passes) {
+		pass.barriers.clear();
+		if (pass.culled) {
+			continue;
+		}
+
+		// Merge every usage of the same resource within the pass
+		std::vector<Usage> merged;
+		std::vector<AccessInfo> needs;
+		for (const auto& usage : pass.usages) {
+			AccessInfo info = getAccessInfo(usage.access);
+			auto it = std::find_if(merged.begin(), merged.end(), [&](const Usage& other) { return other.resource == usage.resource; });
+			if (it == merged.end()) {
+				merged.push_back(usage);
+				needs.push_back(info);
+				continue;
+			}
+			AccessInfo& need = needs[it - merged.begin()];
+			need.stageMask |= info.stageMask;
+			need.accessMask |= info.accessMask;
+			if (need.layout != info.layout) {
+				need.layout = VK_IMAGE_LAYOUT_GENERAL;
+			}
+			it->write = it->write || usage.write;
+		}
+
+		for (size_t u = 0; u < merged.size(); u++) {
+			const Usage& usage = merged[u];
+			const AccessInfo& need = needs[u];
+			State& state = states[usage.resource];
+			bool isImage = resources[usage.resource].isImage;
+			bool layoutChange = isImage && state.layout != need.layout;
+
+			Barrier barrier{};
+			barrier.resource = usage.resource;
+			barrier.dstStageMask = need.stageMask;
+			barrier.dstAccessMask = need.accessMask;
+			barrier.oldLayout = isImage ? state.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = isImage ? need.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+
+			if (usage.write || layoutChange) {
+				// Write after write, write after read or a layout transition : wait for everything before
+				barrier.srcStageMask = state.writeStages | state.readStages;
+				barrier.srcAccessMask = state.writeAccess;
+				if (barrier.srcStageMask != 0 || layoutChange) {
+					pass.barriers.push_back(barrier);
+				}
+
+				if (usage.write) {
+					state.writeStages = need.stageMask;
+					state.writeAccess = need.accessMask;
+					state.visibleStages = 0;
+					state.readStages = 0;
+				}
+				else {
+					state.visibleStages = need.stageMask;
+					state.readStages = need.stageMask;
+				}
+			}
+			else {
+				// Read after write, only needed once per stage the write has not been made visible to
+				if (state.writeStages != 0 && (need.stageMask & ~state.visibleStages) != 0) {
+					barrier.srcStageMask = state.writeStages | state.readStages;
+					barrier.srcAccessMask = state.writeAccess;
+					pass.barriers.push_back(barrier);
+					state.visibleStages |= need.stageMask;
+				}
+				state.readStages |= need.stageMask;
+			}
+			state.layout = isImage ? need.layout : state.layout;
+		}
+	}
+}
+
+void Magnet::EngineBase::Rendering::RenderGraph::recordBarriers(VkCommandBuffer commandBuffer, const std::vector<Barrier>& barriers) const
+{
+	if (barriers.empty()) {
+		return;
+	}
+
+	if (device.capabilities().synchronization2) {
+		std::vector<VkImageMemoryBarrier2KHR> imageBarriers;
+		std::vector<VkBufferMemoryBarrier2KHR> bufferBarriers;
+
+		for (const auto& barrier : barriers) {
+			const Resource& resource = resources[barrier.resource];
+			if (resource.isImage) {
+				VkImageMemoryBarrier2KHR imageBarrier{};
+				imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+				imageBarrier.srcStageMask = barrier.srcStageMask;
+				imageBarrier.srcAccessMask = barrier.srcAccessMask;
+				imageBarrier.dstStageMask = barrier.dstStageMask;
+				imageBarrier.dstAccessMask = barrier.dstAccessMask;
+				imageBarrier.oldLayout = barrier.oldLayout;
+				imageBarrier.newLayout = barrier.newLayout;
+				imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				imageBarrier.image = resource.image;
+				imageBarrier.subresourceRange = { getAspectMask(resource.imageDesc.format), 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+				imageBarriers.push_back(imageBarrier);
+			}
+			else {
+				VkBufferMemoryBarrier2KHR bufferBarrier{};
+				bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR;
+				bufferBarrier.srcStageMask = barrier.srcStageMask;
+				bufferBarrier.srcAccessMask = barrier.srcAccessMask;
+				bufferBarrier.dstStageMask = barrier.dstStageMask;
+				bufferBarrier.dstAccessMask = barrier.dstAccessMask;
+				bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				bufferBarrier.buffer = resource.buffer;
+				bufferBarrier.offset = 0;
+				bufferBarrier.size = VK_WHOLE_SIZE;
+				bufferBarriers.push_back(bufferBarrier);
+			}
+		}
+
+		VkDependencyInfoKHR dependencyInfo{};
+		dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+		dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size());
+		dependencyInfo.pImageMemoryBarriers = imageBarriers.data();
+		dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(bufferBarriers.size());
+		dependencyInfo.pBufferMemoryBarriers = bufferBarriers.data();
+		device.functions().vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+		return;
+	}
+
+	// Legacy path, the stage and access bits we use have the same values in the 32 bit masks
+	std::vector<VkImageMemoryBarrier> imageBarriers;
+	std::vector<VkBufferMemoryBarrier> bufferBarriers;
+	VkPipelineStageFlags srcStageMask = 0;
+	VkPipelineStageFlags dstStageMask = 0;
+
+	for (const auto& barrier : barriers) {
+		const Resource& resource = resources[barrier.resource];
+		srcStageMask |= static_cast<VkPipelineStageFlags>(barrier.srcStageMask);
+		dstStageMask |= static_cast<VkPipelineStageFlags>(barrier.dstStageMask);
+
+		if (resource.isImage) {
+			VkImageMemoryBarrier imageBarrier{};
+			imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			imageBarrier.srcAccessMask = static_cast<VkAccessFlags>(barrier.srcAccessMask);
+			imageBarrier.dstAccessMask = static_cast<VkAccessFlags>(barrier.dstAccessMask);
+			imageBarrier.oldLayout = barrier.oldLayout;
+			imageBarrier.newLayout = barrier.newLayout;
+			imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageBarrier.image = resource.image;
+			imageBarrier.subresourceRange = { getAspectMask(resource.imageDesc.format), 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+			imageBarriers.push_back(imageBarrier);
+		}
+		else {
+			VkBufferMemoryBarrier bufferBarrier{};
+			bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			bufferBarrier.srcAccessMask = static_cast<VkAccessFlags>(barrier.srcAccessMask);
+			bufferBarrier.dstAccessMask = static_cast<VkAccessFlags>(barrier.dstAccessMask);
+			bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			bufferBarrier.buffer = resource.buffer;
+			bufferBarrier.offset = 0;
+			bufferBarrier.size = VK_WHOLE_SIZE;
+			bufferBarriers.push_back(bufferBarrier);
+		}
+	}
+
+	vkCmdPipelineBarrier(
+		commandBuffer,
+		srcStageMask != 0 ? srcStageMask : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT),
+		dstStageMask != 0 ? dstStageMask : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT),
+		0,
+		0, nullptr,
+		static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+		static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+}
+
+void Magnet::EngineBase::Rendering::RenderGraph::destroyTransientResources()
+{
+	VkDevice vkDevice = device.device();
+	for (auto& resource : resources) {
+		if (resource.imported) {
+			continue;
+		}
+		if (resource.imageView != VK_NULL_HANDLE) {
+			vkDestroyImageView(vkDevice, resource.imageView, nullptr);
+		}
+		if (resource.image != VK_NULL_HANDLE) {
+			vkDestroyImage(vkDevice, resource.image, nullptr);
+		}
+		if (resource.buffer != VK_NULL_HANDLE) {
+			vkDestroyBuffer(vkDevice, resource.buffer, nullptr);
+		}
+		resource.imageView = VK_NULL_HANDLE;
+		resource.image = VK_NULL_HANDLE;
+		resource.buffer = VK_NULL_HANDLE;
+		resource.memoryBlock = ~0u;
+	}
+
+	for (auto& block : memoryBlocks) {
+		vkFreeMemory(vkDevice, block.memory, nullptr);
+	}
+	memoryBlocks.clear();
+}
+
+size_t Magnet::EngineBase::Rendering::RenderGraph::culledPassCount() const
+{
+	return std::count_if(passes.begin(), passes.end(), [](const Pass& pass) { return pass.culled; });
+}
+
+size_t Magnet::EngineBase::Rendering::RenderGraph::barrierCount() const
+{
+	size_t count = finalBarriers.size();
+	for (const auto& pass : passes) {
+		count += pass.barriers.size();
+	}
+	return count;
+}
+
+VkDeviceSize Magnet::EngineBase::Rendering::RenderGraph::transientMemorySize() const
+{
+	VkDeviceSize size = 0;
+	for (const auto& block : memoryBlocks) {
+		size += block.size;
+	}
+	return size;
+}
+
+void Magnet::EngineBase::Rendering::RenderGraph::dump(std::ostream& out) const
+{
+	auto printBarrier = [&](const Barrier& barrier) {
+		const Resource& resource = resources[barrier.resource];
+		out << "\t\t~ barrier " << resource.name;
+		if (resource.isImage) {
+			out << " " << getLayoutName(barrier.oldLayout) << " -> " << getLayoutName(barrier.newLayout);
+		}
+		out << " (stages 0x" << std::hex << barrier.srcStageMask << " -> 0x" << barrier.dstStageMask << std::dec << ")" << std::endl;
+	};
+
+	out << "\nRender Graph :" << std::endl;
+	out << "------------------------------" << std::endl;
+	for (uint32_t i = 0; i < passes.size(); i++) {
+		const Pass& pass = passes[i];
+		out << "\t- Pass " << i << " : " << pass.name << (pass.culled ? " (culled)" : "") << std::endl;
+		if (pass.culled) {
+			continue;
+		}
+		for (const auto& barrier : pass.barriers) {
+			printBarrier(barrier);
+		}
+		for (const auto& usage : pass.usages) {
+			out << "\t\t" << (usage.write ? "writes " : "reads ") << resources[usage.resource].name << " as " << getAccessName(usage.access) << std::endl;
+		}
+	}
+	if (!finalBarriers.empty()) {
+		out << "\t- Final transitions" << std::endl;
+		for (const auto& barrier : finalBarriers) {
+			printBarrier(barrier);
+		}
+	}
+
+	out << "\nRender Graph Resources :" << std::endl;
+	out << "------------------------------" << std::endl;
+	for (const auto& resource : resources) {
+		out << "\t- " << resource.name << (resource.isImage ? " [image" : " [buffer") << (resource.imported ? ", imported]" : "]");
+		if (resource.firstPass == ~0u) {
+			out << " unused" << std::endl;
+			continue;
+		}
+		out << " passes " << resource.firstPass << "-" << resource.lastPass;
+		if (resource.memoryBlock != ~0u) {
+			out << ", block " << resource.memoryBlock << ", " << resource.memoryRequirements.size / 1024 << " KiB";
+		}
+		out << std::endl;
+	}
+
+	out << "\t- Passes : " << passes.size() - culledPassCount() << " (" << culledPassCount() << " culled)" << std::endl;
+	out << "\t- Barriers : " << barrierCount() << std::endl;
+	out << "\t- Transient memory : " << transientMemorySize() / 1024 << " KiB (" << unaliasedSize / 1024 << " KiB without aliasing)" << std::endl;
+}
+
+void Magnet::EngineBase::Rendering::RenderGraph::dumpGraphviz(std::ostream& out) const
+{
+	out << "digraph RenderGraph {" << std::endl;
+	out << "\trankdir=LR;" << std::endl;
+	for (uint32_t i = 0; i < passes.size(); i++) {
+		out << "\tpass" << i << " [shape=box, label=\"" << passes[i].name << "\"" << (passes[i].culled ? ", style=dashed" : "") << "];" << std::endl;
+	}
+	for (uint32_t i = 0; i < resources.size(); i++) {
+		out << "\tresource" << i << " [shape=ellipse, label=\"" << resources[i].name << "\"" << (resources[i].imported ? ", style=bold" : "") << "];" << std::endl;
+	}
+	for (uint32_t i = 0; i < passes.size(); i++) {
+		for (const auto& usage : passes[i].usages) {
+			if (usage.write) {
+				out << "\tpass" << i << " -> resource" << usage.resource << ";" << std::endl;
+			}
+			else {
+				out << "\tresource" << usage.resource << " -> pass" << i << ";" << std::endl;
+			}
+		}
+	}
+	out << "}" << std::endl;
+}
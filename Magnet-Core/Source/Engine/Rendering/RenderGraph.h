@@ -0,0 +1,195 @@
+#pragma once
+#include "../../Commons.h"
+#include "../../VK/Device.h"
+
+#include <functional>
+#include <ostream>
+
+namespace Magnet {
+	namespace EngineBase {
+		namespace Rendering {
+
+			// Index of a virtual resource inside its render graph
+			struct RGResource {
+				uint32_t index = ~0u;
+				bool valid() const { return index != ~0u; }
+			};
+
+			// How a pass touches a resource, decides stages, access masks, image layout and usage flags
+			enum class RGAccess {
+				ColorAttachmentWrite,
+				DepthAttachmentWrite,
+				DepthAttachmentRead,
+				SampledRead,
+				StorageRead,
+				StorageWrite,
+				TransferRead,
+				TransferWrite,
+				UniformRead,
+				VertexBufferRead,
+				IndexBufferRead,
+				IndirectRead,
+				Present
+			};
+
+			struct RGImageDesc {
+				VkFormat format = VK_FORMAT_UNDEFINED;
+				VkExtent2D extent{};
+				// Added to the usage inferred from the accesses of the passes
+				VkImageUsageFlags usage = 0;
+			};
+
+			struct RGBufferDesc {
+				VkDeviceSize size = 0;
+				VkBufferUsageFlags usage = 0;
+			};
+
+			// Frame graph of passes declaring reads and writes of virtual resources.
+			// compile() culls passes that do not contribute to an imported resource or a side effect,
+			// creates transient resources, aliasing their memory when their lifetimes do not overlap,
+			// and computes the barriers between passes. The compiled graph is executed every frame,
+			// imported resources (e.g. the swapchain image) can be rebound in between.
+			class RenderGraph {
+			public:
+				class PassBuilder {
+				public:
+					RGResource read(RGResource resource, RGAccess access);
+					RGResource write(RGResource resource, RGAccess access);
+					// Keeps the pass alive even if nothing reads what it writes
+					void setSideEffect() { graph.passes[pass].sideEffect = true; }
+
+				private:
+					friend class RenderGraph;
+					PassBuilder(RenderGraph& graph, uint32_t pass) : graph{ graph }, pass{ pass } {}
+
+					RenderGraph& graph;
+					uint32_t pass;
+				};
+
+				using SetupFunction = std::function<void(PassBuilder&)>;
+				using ExecuteFunction = std::function<void(VkCommandBuffer, const RenderGraph&)>;
+
+				RenderGraph(VKBase::Device& device);
+				~RenderGraph();
+
+				RenderGraph(const RenderGraph&) = delete;
+				RenderGraph& operator=(const RenderGraph&) = delete;
+
+				RGResource createImage(const std::string& name, const RGImageDesc& desc);
+				RGResource createBuffer(const std::string& name, const RGBufferDesc& desc);
+				// External resources are never culled and are left in finalAccess after the last pass.
+				// Except for swapchain images (finalAccess Present) they persist across frames, the first access of a frame waits for the previous one
+				RGResource importImage(const std::string& name, VkImage image, VkImageView imageView, const RGImageDesc& desc,
+					VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED, RGAccess finalAccess = RGAccess::Present);
+				RGResource importBuffer(const std::string& name, VkBuffer buffer, const RGBufferDesc& desc);
+				void setImportedImage(RGResource resource, VkImage image, VkImageView imageView);
+				void setImportedBuffer(RGResource resource, VkBuffer buffer);
+
+				void addPass(const std::string& name, const SetupFunction& setup, const ExecuteFunction& execute);
+
+				void compile();
+				void execute(VkCommandBuffer commandBuffer) const;
+				// Releases passes and transient resources so the graph can be rebuilt
+				void reset();
+
+				VkImage getImage(RGResource resource) const;
+				VkImageView getImageView(RGResource resource) const;
+				VkBuffer getBuffer(RGResource resource) const;
+				VkExtent2D getExtent(RGResource resource) const;
+
+				void dump(std::ostream& out) const;
+				void dumpGraphviz(std::ostream& out) const;
+
+				size_t culledPassCount() const;
+				size_t barrierCount() const;
+				VkDeviceSize transientMemorySize() const;
+				VkDeviceSize unaliasedMemorySize() const { return unaliasedSize; }
+
+			private:
+				struct Usage {
+					uint32_t resource;
+					RGAccess access;
+					bool write;
+				};
+
+				struct Barrier {
+					uint32_t resource;
+					VkPipelineStageFlags2KHR srcStageMask;
+					VkAccessFlags2KHR srcAccessMask;
+					VkPipelineStageFlags2KHR dstStageMask;
+					VkAccessFlags2KHR dstAccessMask;
+					VkImageLayout oldLayout;
+					VkImageLayout newLayout;
+				};
+
+				// Synchronization state of a resource while walking the passes
+				struct State {
+					VkPipelineStageFlags2KHR writeStages = 0;
+					VkAccessFlags2KHR writeAccess = 0;
+					// Stages the last write has already been made visible to
+					VkPipelineStageFlags2KHR visibleStages = 0;
+					VkPipelineStageFlags2KHR readStages = 0;
+					VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+				};
+
+				struct Pass {
+					std::string name;
+					ExecuteFunction execute;
+					std::vector<Usage> usages;
+					bool sideEffect = false;
+					bool culled = false;
+					std::vector<Barrier> barriers;
+				};
+
+				struct Resource {
+					std::string name;
+					bool isImage = true;
+					bool imported = false;
+					RGImageDesc imageDesc{};
+					RGBufferDesc bufferDesc{};
+					VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+					RGAccess finalAccess = RGAccess::Present;
+
+					VkImage image = VK_NULL_HANDLE;
+					VkImageView imageView = VK_NULL_HANDLE;
+					VkBuffer buffer = VK_NULL_HANDLE;
+
+					// Lifetime in pass indices, only over passes that survived culling
+					uint32_t firstPass = ~0u;
+					uint32_t lastPass = 0;
+					VkMemoryRequirements memoryRequirements{};
+					uint32_t memoryBlock = ~0u;
+				};
+
+				// Transient resources with disjoint lifetimes share one allocation
+				struct MemoryBlock {
+					VkDeviceMemory memory = VK_NULL_HANDLE;
+					VkDeviceSize size = 0;
+					uint32_t memoryTypeBits = ~0u;
+					std::vector<uint32_t> resources;
+				};
+
+				// Imported and presented, a different image every frame
+				static bool isSwapchainImage(const Resource& resource) { return resource.imported && resource.isImage && resource.finalAccess == RGAccess::Present; }
+
+				void cullPasses();
+				void computeLifetimes();
+				void createTransientResources();
+				void computeBarriers();
+				// Barriers of every pass from the given states, left as they are after the last pass
+				void computePassBarriers(std::vector<State>& states);
+				void destroyTransientResources();
+				void recordBarriers(VkCommandBuffer commandBuffer, const std::vector<Barrier>& barriers) const;
+
+				VKBase::Device& device;
+				std::vector<Pass> passes;
+				std::vector<Resource> resources;
+				std::vector<MemoryBlock> memoryBlocks;
+				// Transitions of imported resources to their final access, recorded after the last pass
+				std::vector<Barrier> finalBarriers;
+				VkDeviceSize unaliasedSize = 0;
+				bool compiled = false;
+			};
+		}
+	}
+}
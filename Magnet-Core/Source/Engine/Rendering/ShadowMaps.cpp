@@ -0,0 +1,499 @@
+#include "ShadowMaps.h"
+#include "../../VK/DynamicRendering.h"
+
+Magnet::EngineBase::Rendering::CascadedShadowMaps::CascadedShadowMaps(
+	VKBase::Device& device,
+	const std::string& vertFilepath,
+	const std::string& fragFilepath,
+	const std::vector<VkVertexInputBindingDescription>& bindingDescriptions,
+	const std::vector<VkVertexInputAttributeDescription>& positionAttribute,
+	uint32_t frameCount,
+	const Settings& settings) : device{ device }, settings{ settings }
+{
+	depthFormat = device.findSupportedFormat(
+		{ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D16_UNORM },
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+
+	createImages();
+	createRenderPasses();
+	createPipeline(vertFilepath, fragFilepath, bindingDescriptions, positionAttribute);
+	createDescriptors(frameCount);
+}
+
+Magnet::EngineBase::Rendering::CascadedShadowMaps::~CascadedShadowMaps()
+{
+	VkDevice vkDevice = device.device();
+
+	pipeline.reset();
+	vkDestroyPipelineLayout(vkDevice, pipelineLayout, nullptr);
+
+	for (auto framebuffer : shadowFramebuffers) {
+		vkDestroyFramebuffer(vkDevice, framebuffer, nullptr);
+	}
+	for (auto framebuffer : staticFramebuffers) {
+		vkDestroyFramebuffer(vkDevice, framebuffer, nullptr);
+	}
+	vkDestroyRenderPass(vkDevice, clearRenderPass, nullptr);
+	vkDestroyRenderPass(vkDevice, loadRenderPass, nullptr);
+
+	vkDestroySampler(vkDevice, sampler, nullptr);
+	for (auto view : shadowLayerViews) {
+		vkDestroyImageView(vkDevice, view, nullptr);
+	}
+	for (auto view : staticLayerViews) {
+		vkDestroyImageView(vkDevice, view, nullptr);
+	}
+	vkDestroyImageView(vkDevice, shadowArrayView, nullptr);
+	vkDestroyImage(vkDevice, shadowImage, nullptr);
+	vkFreeMemory(vkDevice, shadowMemory, nullptr);
+	vkDestroyImage(vkDevice, staticImage, nullptr);
+	vkFreeMemory(vkDevice, staticMemory, nullptr);
+}
+
+void Magnet::EngineBase::Rendering::CascadedShadowMaps::createImages()
+{
+	VkImageCreateInfo imageInfo{};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.extent = { settings.resolution, settings.resolution, 1 };
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = CASCADE_COUNT;
+	imageInfo.format = depthFormat;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, shadowImage, shadowMemory);
+
+	imageInfo.arrayLayers = CASCADE_COUNT - FIRST_CACHED_CASCADE;
+	imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, staticImage, staticMemory);
+
+	// The render graph imports the static caches in TRANSFER_SRC_OPTIMAL, the layout they keep between frames
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = staticImage;
+	barrier.subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, imageInfo.arrayLayers };
+
+	VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	device.endSingleTimeCommands(commandBuffer);
+
+	auto createView = [this](VkImage image, VkImageViewType viewType, uint32_t baseLayer, uint32_t layerCount) {
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = image;
+		viewInfo.viewType = viewType;
+		viewInfo.format = depthFormat;
+		viewInfo.subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, baseLayer, layerCount };
+
+		VkImageView view;
+		if (vkCreateImageView(device.device(), &viewInfo, nullptr, &view) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create shadow map image view!");
+		}
+		return view;
+	};
+
+	shadowArrayView = createView(shadowImage, VK_IMAGE_VIEW_TYPE_2D_ARRAY, 0, CASCADE_COUNT);
+	for (uint32_t i = 0; i < CASCADE_COUNT; i++) {
+		shadowLayerViews[i] = createView(shadowImage, VK_IMAGE_VIEW_TYPE_2D, i, 1);
+	}
+	for (uint32_t i = 0; i < staticLayerViews.size(); i++) {
+		staticLayerViews[i] = createView(staticImage, VK_IMAGE_VIEW_TYPE_2D, i, 1);
+	}
+
+	// Hardware depth comparison, outside of the map is lit
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+	samplerInfo.compareEnable = VK_TRUE;
+	samplerInfo.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+	samplerInfo.maxLod = 1.0f;
+
+	if (vkCreateSampler(device.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create shadow map sampler!");
+	}
+}
+
+void Magnet::EngineBase::Rendering::CascadedShadowMaps::createRenderPasses()
+{
+	if (device.capabilities().dynamicRendering) {
+		return;
+	}
+
+	// The render graph transitions the images around the shadow passes, the render passes keep the attachment layout
+	auto createRenderPass = [this](VkAttachmentLoadOp loadOp) {
+		VkAttachmentDescription depthAttachment{};
+		depthAttachment.format = depthFormat;
+		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		depthAttachment.loadOp = loadOp;
+		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentReference depthAttachmentRef{ 0, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+
+		VkSubpassDescription subpass{};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+		VkRenderPassCreateInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = 1;
+		renderPassInfo.pAttachments = &depthAttachment;
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+
+		VkRenderPass renderPass;
+		if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create shadow render pass!");
+		}
+		return renderPass;
+	};
+	clearRenderPass = createRenderPass(VK_ATTACHMENT_LOAD_OP_CLEAR);
+	loadRenderPass = createRenderPass(VK_ATTACHMENT_LOAD_OP_LOAD);
+
+	auto createFramebuffer = [this](VkImageView view) {
+		VkFramebufferCreateInfo framebufferInfo{};
+		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferInfo.renderPass = clearRenderPass;
+		framebufferInfo.attachmentCount = 1;
+		framebufferInfo.pAttachments = &view;
+		framebufferInfo.width = settings.resolution;
+		framebufferInfo.height = settings.resolution;
+		framebufferInfo.layers = 1;
+
+		VkFramebuffer framebuffer;
+		if (vkCreateFramebuffer(device.device(), &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create shadow framebuffer!");
+		}
+		return framebuffer;
+	};
+	for (uint32_t i = 0; i < CASCADE_COUNT; i++) {
+		shadowFramebuffers[i] = createFramebuffer(shadowLayerViews[i]);
+	}
+	for (uint32_t i = 0; i < staticFramebuffers.size(); i++) {
+		staticFramebuffers[i] = createFramebuffer(staticLayerViews[i]);
+	}
+}
+
+void Magnet::EngineBase::Rendering::CascadedShadowMaps::createPipeline(
+	const std::string& vertFilepath,
+	const std::string& fragFilepath,
+	const std::vector<VkVertexInputBindingDescription>& bindingDescriptions,
+	const std::vector<VkVertexInputAttributeDescription>& positionAttribute)
+{
+	// Model matrix from the caster, light view projection from the cascade
+	VkPushConstantRange pushConstantRange{ VK_SHADER_STAGE_VERTEX_BIT, 0, 2 * sizeof(glm::mat4) };
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create shadow pipeline layout!");
+	}
+
+	VKBase::Pipeline::defaultPipelineConfigInfo(pipelineConfig);
+	pipelineConfig.bindingDescriptions = bindingDescriptions;
+	pipelineConfig.attributeDescriptions = positionAttribute;
+	pipelineConfig.colorBlendInfo.attachmentCount = 0;
+	pipelineConfig.colorBlendInfo.pAttachments = nullptr;
+	// Slope scaled bias against shadow acne, no culling so single sided geometry still casts
+	pipelineConfig.rasterizationInfo.cullMode = VK_CULL_MODE_NONE;
+	pipelineConfig.rasterizationInfo.depthBiasEnable = VK_TRUE;
+	pipelineConfig.rasterizationInfo.depthBiasConstantFactor = settings.depthBiasConstant;
+	pipelineConfig.rasterizationInfo.depthBiasSlopeFactor = settings.depthBiasSlope;
+	pipelineConfig.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+	pipelineConfig.pipelineLayout = pipelineLayout;
+	if (device.capabilities().dynamicRendering) {
+		pipelineConfig.depthAttachmentFormat = depthFormat;
+	}
+	else {
+		pipelineConfig.renderPass = clearRenderPass;
+	}
+
+	pipeline = std::make_unique<VKBase::Pipeline>(device, vertFilepath, fragFilepath, pipelineConfig);
+}
+
+void Magnet::EngineBase::Rendering::CascadedShadowMaps::createDescriptors(uint32_t frameCount)
+{
+	paramsBuffer = std::make_unique<VKBase::Buffer>(
+		device,
+		sizeof(ShadowParams),
+		frameCount,
+		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		device.properties.limits.minUniformBufferOffsetAlignment);
+	paramsBuffer->map();
+
+	setLayout = VKBase::DescriptorSetLayout::Builder(device)
+		.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_FRAGMENT_BIT)
+		.addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+		.build();
+
+	descriptorPool = VKBase::DescriptorPool::Builder(device)
+		.setMaxSets(1)
+		.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1)
+		.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1)
+		.build();
+
+	auto paramsInfo = paramsBuffer->descriptorInfo(sizeof(ShadowParams), 0);
+	VkDescriptorImageInfo imageInfo{ sampler, shadowArrayView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+
+	bool built = VKBase::DescriptorWriter(*setLayout, *descriptorPool)
+		.writeBuffer(0, &paramsInfo)
+		.writeImage(1, &imageInfo)
+		.build(descriptorSet);
+	if (!built) {
+		throw std::runtime_error("failed to allocate shadow map descriptor set!");
+	}
+}
+
+void Magnet::EngineBase::Rendering::CascadedShadowMaps::markStaticDirty()
+{
+	for (uint32_t i = FIRST_CACHED_CASCADE; i < CASCADE_COUNT; i++) {
+		cascades[i].staticDirty = true;
+	}
+}
+
+void Magnet::EngineBase::Rendering::CascadedShadowMaps::update(Camera& camera, glm::vec3 lightDirection, glm::vec4 lightColor, uint32_t frameIndex)
+{
+	lightDirection = glm::normalize(lightDirection);
+	if (glm::dot(lightDirection, this->lightDirection) < 0.99999f) {
+		markStaticDirty();
+	}
+	this->lightDirection = lightDirection;
+
+	float nearClip = camera.getNearClip();
+	float farClip = camera.getFarClip();
+	float shadowFar = std::min(farClip, settings.shadowDistance);
+	float range = shadowFar - nearClip;
+	float ratio = shadowFar / nearClip;
+
+	// Practical split scheme : blend of logarithmic and uniform split distances
+	for (uint32_t i = 0; i < CASCADE_COUNT; i++) {
+		float p = (i + 1) / static_cast<float>(CASCADE_COUNT);
+		float logSplit = nearClip * std::pow(ratio, p);
+		float uniformSplit = nearClip + range * p;
+		cascades[i].splitDepth = settings.splitLambda * (logSplit - uniformSplit) + uniformSplit;
+	}
+
+	// Camera frustum corners in world space, near plane first
+	glm::mat4 inverseViewProjection = glm::inverse(camera.matrices.perspective * camera.matrices.view);
+	std::array<glm::vec3, 8> frustumCorners;
+	for (uint32_t i = 0; i < 8; i++) {
+		glm::vec4 corner = inverseViewProjection * glm::vec4((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : 0.0f, 1.0f);
+		frustumCorners[i] = glm::vec3(corner) / corner.w;
+	}
+
+	float previousSplit = nearClip;
+	for (uint32_t i = 0; i < CASCADE_COUNT; i++) {
+		std::array<glm::vec3, 8> sliceCorners;
+		float sliceNear = (previousSplit - nearClip) / (farClip - nearClip);
+		float sliceFar = (cascades[i].splitDepth - nearClip) / (farClip - nearClip);
+		for (uint32_t j = 0; j < 4; j++) {
+			glm::vec3 edge = frustumCorners[j + 4] - frustumCorners[j];
+			sliceCorners[j] = frustumCorners[j] + edge * sliceNear;
+			sliceCorners[j + 4] = frustumCorners[j] + edge * sliceFar;
+		}
+		fitCascade(cascades[i], sliceCorners, isCached(i));
+		previousSplit = cascades[i].splitDepth;
+	}
+
+	ShadowParams params{};
+	for (uint32_t i = 0; i < CASCADE_COUNT; i++) {
+		params.cascadeViewProjection[i] = cascades[i].viewProjection;
+		params.splitDepths[i] = cascades[i].splitDepth;
+	}
+	params.lightDirection = glm::vec4(lightDirection, 0.0f);
+	params.lightColor = lightColor;
+	paramsBuffer->writeToIndex(&params, frameIndex);
+}
+
+void Magnet::EngineBase::Rendering::CascadedShadowMaps::fitCascade(Cascade& cascade, const std::array<glm::vec3, 8>& sliceCorners, bool cached)
+{
+	// A bounding sphere keeps the cascade size constant when the camera rotates
+	glm::vec3 center{ 0.0f };
+	for (const auto& corner : sliceCorners) {
+		center += corner;
+	}
+	center /= 8.0f;
+
+	float radius = 0.0f;
+	for (const auto& corner : sliceCorners) {
+		radius = std::max(radius, glm::length(corner - center));
+	}
+	radius = std::ceil(radius * 16.0f) / 16.0f;
+
+	if (cached && !cascade.staticDirty) {
+		// Keep the cached matrices while the slice stays inside the cached area
+		glm::vec3 current = glm::vec3(cascade.view * glm::vec4(center, 1.0f));
+		glm::vec3 cachedCenter = glm::vec3(cascade.view * glm::vec4(cascade.cachedCenter, 1.0f));
+		if (glm::length(glm::vec2(current - cachedCenter)) + radius <= cascade.extent) {
+			return;
+		}
+		cascade.staticDirty = true;
+	}
+
+	cascade.extent = cached ? radius * settings.cacheMargin : radius;
+	cascade.cachedCenter = center;
+
+	glm::vec3 up = std::abs(lightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	// Pull the eye back so casters between the light and the slice are inside the depth range
+	float pullBack = cascade.extent + settings.shadowDistance;
+	cascade.view = glm::lookAt(center - lightDirection * pullBack, center, up);
+	cascade.projection = glm::ortho(-cascade.extent, cascade.extent, -cascade.extent, cascade.extent, 0.0f, pullBack + cascade.extent);
+
+	// Snap the projection to whole texels so the map does not shimmer when the camera moves
+	glm::mat4 shadowMatrix = cascade.projection * cascade.view;
+	float halfResolution = settings.resolution * 0.5f;
+	glm::vec4 origin = shadowMatrix * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f) * halfResolution;
+	glm::vec4 offset = (glm::round(origin) - origin) / halfResolution;
+	cascade.projection[3][0] += offset.x;
+	cascade.projection[3][1] += offset.y;
+
+	cascade.viewProjection = cascade.projection * cascade.view;
+}
+
+bool Magnet::EngineBase::Rendering::CascadedShadowMaps::isVisible(const Cascade& cascade, const ShadowCaster& caster) const
+{
+	glm::vec3 lightMin{ std::numeric_limits<float>::max() };
+	glm::vec3 lightMax{ std::numeric_limits<float>::lowest() };
+	for (uint32_t i = 0; i < 8; i++) {
+		glm::vec3 corner{
+			(i & 1) ? caster.boundsMax.x : caster.boundsMin.x,
+			(i & 2) ? caster.boundsMax.y : caster.boundsMin.y,
+			(i & 4) ? caster.boundsMax.z : caster.boundsMin.z };
+		glm::vec3 lightSpace = glm::vec3(cascade.view * glm::vec4(corner, 1.0f));
+		lightMin = glm::min(lightMin, lightSpace);
+		lightMax = glm::max(lightMax, lightSpace);
+	}
+
+	// Padded by a texel for the snapping offset, the light looks down -z
+	float extent = cascade.extent * (1.0f + 2.0f / settings.resolution);
+	float farPlane = cascade.extent * 2.0f + settings.shadowDistance;
+	return lightMax.x >= -extent && lightMin.x <= extent &&
+		lightMax.y >= -extent && lightMin.y <= extent &&
+		lightMin.z <= 0.0f && lightMax.z >= -farPlane;
+}
+
+void Magnet::EngineBase::Rendering::CascadedShadowMaps::drawCascade(VkCommandBuffer commandBuffer, const Cascade& cascade, VkImageView imageView, VkFramebuffer framebuffer, bool clear,
+	const std::vector<ShadowCaster>& casters, bool drawStatic, bool drawDynamic, const DrawCasterFunction& drawCaster)
+{
+	VkExtent2D extent{ settings.resolution, settings.resolution };
+	VKBase::RenderingInfo renderingInfo{ extent };
+
+	if (device.capabilities().dynamicRendering) {
+		renderingInfo
+			.setDepthAttachment(imageView, clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_STORE)
+			.begin(device, commandBuffer);
+	}
+	else {
+		VkClearValue clearValue{};
+		clearValue.depthStencil = { 1.0f, 0 };
+
+		VkRenderPassBeginInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassInfo.renderPass = clear ? clearRenderPass : loadRenderPass;
+		renderPassInfo.framebuffer = framebuffer;
+		renderPassInfo.renderArea = { { 0, 0 }, extent };
+		renderPassInfo.clearValueCount = 1;
+		renderPassInfo.pClearValues = &clearValue;
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	}
+
+	pipeline->bind(commandBuffer);
+	VkViewport viewport{ 0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f };
+	VkRect2D scissor{ { 0, 0 }, extent };
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, sizeof(glm::mat4), sizeof(glm::mat4), &cascade.viewProjection);
+
+	for (uint32_t i = 0; i < casters.size(); i++) {
+		const ShadowCaster& caster = casters[i];
+		if ((caster.isStatic && !drawStatic) || (!caster.isStatic && !drawDynamic)) {
+			continue;
+		}
+		if (!isVisible(cascade, caster)) {
+			stats.castersCulled++;
+			continue;
+		}
+		drawCaster(commandBuffer, i);
+		stats.castersDrawn++;
+	}
+
+	if (device.capabilities().dynamicRendering) {
+		renderingInfo.end(device, commandBuffer);
+	}
+	else {
+		vkCmdEndRenderPass(commandBuffer);
+	}
+}
+
+void Magnet::EngineBase::Rendering::CascadedShadowMaps::renderStaticCaches(VkCommandBuffer commandBuffer, const std::vector<ShadowCaster>& casters, const DrawCasterFunction& drawCaster)
+{
+	for (uint32_t i = FIRST_CACHED_CASCADE; i < CASCADE_COUNT; i++) {
+		Cascade& cascade = cascades[i];
+		if (!cascade.staticDirty) {
+			continue;
+		}
+		uint32_t layer = i - FIRST_CACHED_CASCADE;
+		drawCascade(commandBuffer, cascade, staticLayerViews[layer], staticFramebuffers[layer], true, casters, true, false, drawCaster);
+		cascade.staticDirty = false;
+		stats.staticRedraws++;
+	}
+}
+
+void Magnet::EngineBase::Rendering::CascadedShadowMaps::copyStaticCaches(VkCommandBuffer commandBuffer)
+{
+	std::array<VkImageCopy, CASCADE_COUNT - FIRST_CACHED_CASCADE> regions{};
+	for (uint32_t layer = 0; layer < regions.size(); layer++) {
+		regions[layer].srcSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, layer, 1 };
+		regions[layer].dstSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, FIRST_CACHED_CASCADE + layer, 1 };
+		regions[layer].extent = { settings.resolution, settings.resolution, 1 };
+	}
+	vkCmdCopyImage(commandBuffer, staticImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, shadowImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		static_cast<uint32_t>(regions.size()), regions.data());
+}
+
+void Magnet::EngineBase::Rendering::CascadedShadowMaps::renderCascades(VkCommandBuffer commandBuffer, const std::vector<ShadowCaster>& casters, const DrawCasterFunction& drawCaster)
+{
+	for (uint32_t i = 0; i < CASCADE_COUNT; i++) {
+		// Cached cascades start from the copied static casters and only draw the dynamic ones on top
+		bool cached = isCached(i);
+		drawCascade(commandBuffer, cascades[i], shadowLayerViews[i], shadowFramebuffers[i], !cached, casters, !cached, true, drawCaster);
+	}
+}
+
+void Magnet::EngineBase::Rendering::CascadedShadowMaps::bind(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, uint32_t set, uint32_t frameIndex)
+{
+	uint32_t dynamicOffset = static_cast<uint32_t>(frameIndex * paramsBuffer->getAlignmentSize());
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, set, 1, &descriptorSet, 1, &dynamicOffset);
+}
+
+void Magnet::EngineBase::Rendering::CascadedShadowMaps::printStats() const
+{
+	std::cout << "\nCascaded Shadow Maps :" << std::endl;
+	std::cout << "------------------------------" << std::endl;
+	std::cout << "\t- Cascades : " << CASCADE_COUNT << " (" << CASCADE_COUNT - FIRST_CACHED_CASCADE << " cached)" << std::endl;
+	std::cout << "\t- Static cache redraws : " << stats.staticRedraws << std::endl;
+	std::cout << "\t- Casters drawn : " << stats.castersDrawn << std::endl;
+	std::cout << "\t- Casters culled : " << stats.castersCulled << std::endl;
+}
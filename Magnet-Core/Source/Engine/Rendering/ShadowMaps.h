@@ -0,0 +1,163 @@
+#pragma once
+#include "../../Commons.h"
+#include "../../VK/Device.h"
+#include "../../VK/Buffer.h"
+#include "../../VK/Descriptors.h"
+#include "../../VK/Pipeline.h"
+#include "../Camera.h"
+
+#include <functional>
+
+namespace Magnet {
+	namespace EngineBase {
+		namespace Rendering {
+
+			// World space bounds of something that casts shadows
+			struct ShadowCaster {
+				glm::vec3 boundsMin;
+				glm::vec3 boundsMax;
+				bool isStatic = true;
+			};
+
+			// Cascaded shadow maps of a directional light. Splits blend logarithmic and uniform distributions
+			// between the camera near plane and the shadow distance, cascades are fitted to the bounding sphere
+			// of their frustum slice and snapped to shadow map texels so they do not shimmer.
+			// The far cascades keep static casters in a cache that is only re-rendered when the light moves,
+			// the camera leaves the cached area or static casters change; only dynamic casters are drawn on top every frame.
+			class CascadedShadowMaps {
+			public:
+				static constexpr uint32_t CASCADE_COUNT = 4;
+				static constexpr uint32_t FIRST_CACHED_CASCADE = 2;
+
+				struct Settings {
+					uint32_t resolution = 2048;
+					// 0 is a uniform split, 1 a logarithmic one
+					float splitLambda = 0.9f;
+					float shadowDistance = 64.0f;
+					// Cached cascades cover this much more than their slice so the camera can move without a redraw
+					float cacheMargin = 1.5f;
+					float depthBiasConstant = 1.25f;
+					float depthBiasSlope = 1.75f;
+				};
+
+				struct Stats {
+					uint32_t staticRedraws = 0;
+					uint32_t castersDrawn = 0;
+					uint32_t castersCulled = 0;
+				};
+
+				// std140 layout, matches ShadowParams in lighting.glsl
+				struct ShadowParams {
+					glm::mat4 cascadeViewProjection[CASCADE_COUNT];
+					glm::vec4 splitDepths{ 0.f };
+					glm::vec4 lightDirection{ 0.f };
+					glm::vec4 lightColor{ 1.f };  // w is intensity
+				};
+
+				// Draws one caster, the model matrix goes to push constant offset 0 of getPipelineLayout()
+				using DrawCasterFunction = std::function<void(VkCommandBuffer, uint32_t casterIndex)>;
+
+				CascadedShadowMaps(
+					VKBase::Device& device,
+					const std::string& vertFilepath,
+					const std::string& fragFilepath,
+					const std::vector<VkVertexInputBindingDescription>& bindingDescriptions,
+					const std::vector<VkVertexInputAttributeDescription>& positionAttribute,
+					uint32_t frameCount,
+					const Settings& settings);
+				~CascadedShadowMaps();
+
+				CascadedShadowMaps(const CascadedShadowMaps&) = delete;
+				CascadedShadowMaps& operator=(const CascadedShadowMaps&) = delete;
+
+				void update(Camera& camera, glm::vec3 lightDirection, glm::vec4 lightColor, uint32_t frameIndex);
+				// Render graph passes, recorded in this order every frame.
+				// Redraws the invalidated static caches, the cache image is in DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+				void renderStaticCaches(VkCommandBuffer commandBuffer, const std::vector<ShadowCaster>& casters, const DrawCasterFunction& drawCaster);
+				// Copies the static caches (TRANSFER_SRC_OPTIMAL) into the cached layers of the shadow image (TRANSFER_DST_OPTIMAL)
+				void copyStaticCaches(VkCommandBuffer commandBuffer);
+				// Draws every cascade into the shadow image in DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+				void renderCascades(VkCommandBuffer commandBuffer, const std::vector<ShadowCaster>& casters, const DrawCasterFunction& drawCaster);
+				// Static casters moved, were added or removed
+				void markStaticDirty();
+
+				void bind(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, uint32_t set, uint32_t frameIndex);
+
+				VkPipelineLayout getPipelineLayout() const { return pipelineLayout; }
+				VkDescriptorSetLayout getDescriptorSetLayout() const { return setLayout->getDescriptorSetLayout(); }
+				VkImage getShadowImage() const { return shadowImage; }
+				VkImageView getShadowView() const { return shadowArrayView; }
+				// Kept in TRANSFER_SRC_OPTIMAL between frames
+				VkImage getStaticImage() const { return staticImage; }
+				VkFormat getDepthFormat() const { return depthFormat; }
+				VkExtent2D getExtent() const { return { settings.resolution, settings.resolution }; }
+				const Stats& getStats() const { return stats; }
+				void printStats() const;
+
+			private:
+				struct Cascade {
+					float splitDepth = 0.0f;
+					glm::mat4 view{ 1.f };
+					glm::mat4 projection{ 1.f };
+					glm::mat4 viewProjection{ 1.f };
+					float extent = 0.0f;
+
+					// Cached cascades only
+					glm::vec3 cachedCenter{ 0.f };
+					bool staticDirty = true;
+				};
+
+				void createImages();
+				void createRenderPasses();
+				void createPipeline(
+					const std::string& vertFilepath,
+					const std::string& fragFilepath,
+					const std::vector<VkVertexInputBindingDescription>& bindingDescriptions,
+					const std::vector<VkVertexInputAttributeDescription>& positionAttribute);
+				void createDescriptors(uint32_t frameCount);
+
+				void fitCascade(Cascade& cascade, const std::array<glm::vec3, 8>& sliceCorners, bool cached);
+				bool isVisible(const Cascade& cascade, const ShadowCaster& caster) const;
+				void drawCascade(VkCommandBuffer commandBuffer, const Cascade& cascade, VkImageView imageView, VkFramebuffer framebuffer, bool clear,
+					const std::vector<ShadowCaster>& casters, bool drawStatic, bool drawDynamic, const DrawCasterFunction& drawCaster);
+
+				static bool isCached(uint32_t cascadeIndex) { return cascadeIndex >= FIRST_CACHED_CASCADE; }
+
+				VKBase::Device& device;
+				Settings settings;
+				VkFormat depthFormat;
+
+				std::array<Cascade, CASCADE_COUNT> cascades;
+				glm::vec3 lightDirection{ 0.f, -1.f, 0.f };
+
+				// Sampled by the scene, one layer per cascade
+				VkImage shadowImage = VK_NULL_HANDLE;
+				VkDeviceMemory shadowMemory = VK_NULL_HANDLE;
+				VkImageView shadowArrayView = VK_NULL_HANDLE;
+				std::array<VkImageView, CASCADE_COUNT> shadowLayerViews{};
+				// Static casters of the cached cascades, copied into the shadow image every frame
+				VkImage staticImage = VK_NULL_HANDLE;
+				VkDeviceMemory staticMemory = VK_NULL_HANDLE;
+				std::array<VkImageView, CASCADE_COUNT - FIRST_CACHED_CASCADE> staticLayerViews{};
+				VkSampler sampler = VK_NULL_HANDLE;
+
+				// Only used without VK_KHR_dynamic_rendering
+				VkRenderPass clearRenderPass = VK_NULL_HANDLE;
+				VkRenderPass loadRenderPass = VK_NULL_HANDLE;
+				std::array<VkFramebuffer, CASCADE_COUNT> shadowFramebuffers{};
+				std::array<VkFramebuffer, CASCADE_COUNT - FIRST_CACHED_CASCADE> staticFramebuffers{};
+
+				VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+				VKBase::PipelineConfigInfo pipelineConfig{};
+				std::unique_ptr<VKBase::Pipeline> pipeline;
+
+				std::unique_ptr<VKBase::Buffer> paramsBuffer;
+				std::unique_ptr<VKBase::DescriptorSetLayout> setLayout;
+				std::unique_ptr<VKBase::DescriptorPool> descriptorPool;
+				VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+				Stats stats{};
+			};
+		}
+	}
+}
@@ -0,0 +1,268 @@
+#include "Texture.h"
+#include "KTX2Loader.h"
+#include "TextureCompressor.h"
+#include "../../VK/Buffer.h"
+
+#include <stb/stb_image.h>
+
+void Magnet::EngineBase::Rendering::Texture::updateDescriptor()
+{
+	descriptor.sampler = sampler;
+	descriptor.imageView = view;
+	descriptor.imageLayout = imageLayout;
+}
+
+void Magnet::EngineBase::Rendering::Texture::destroy()
+{
+	vkDestroyImageView(device->device(), view, nullptr);
+	vkDestroyImage(device->device(), image, nullptr);
+	if (sampler) {
+		vkDestroySampler(device->device(), sampler, nullptr);
+	}
+	vkFreeMemory(device->device(), deviceMemory, nullptr);
+}
+
+void Magnet::EngineBase::Rendering::Texture2D::loadFromFile(
+	std::string filename,
+	VKBase::Device* device,
+	VkFilter filter,
+	VkImageUsageFlags imageUsageFlags,
+	VkImageLayout imageLayout)
+{
+	if (std::filesystem::path(filename).extension() != ".ktx2") {
+		if (!device->features.textureCompressionBC) {
+			int texWidth, texHeight, texChannels;
+			stbi_uc* pixels = stbi_load(filename.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+			if (!pixels) {
+				throw std::runtime_error("failed to load texture image: " + filename);
+			}
+			fromBuffer(pixels, VkDeviceSize(texWidth) * texHeight * 4, VK_FORMAT_R8G8B8A8_UNORM, texWidth, texHeight, device, filter, imageUsageFlags, imageLayout);
+			stbi_image_free(pixels);
+			return;
+		}
+		// Compressed once, later runs load the cached file
+		TextureCompressor compressor{ TextureCompressor::Settings{} };
+		filename = compressor.compressToCache(filename);
+	}
+
+	KTX2Loader loader{ *device };
+	MipChain mipChain = loader.loadFile(filename);
+
+	TextureUploadBatch batch{ *device };
+	batch.add(*this, mipChain, filter, imageUsageFlags, imageLayout);
+	batch.submit();
+}
+
+void Magnet::EngineBase::Rendering::Texture2D::fromBuffer(
+	void* buffer,
+	VkDeviceSize bufferSize,
+	VkFormat format,
+	uint32_t texWidth,
+	uint32_t texHeight,
+	VKBase::Device* device,
+	VkFilter filter,
+	VkImageUsageFlags imageUsageFlags,
+	VkImageLayout imageLayout,
+	bool generateMipmaps)
+{
+	TextureUploadBatch batch{ *device };
+	batch.add(*this, buffer, bufferSize, format, texWidth, texHeight, filter, imageUsageFlags, imageLayout, generateMipmaps);
+	batch.submit();
+}
+
+void Magnet::EngineBase::Rendering::TextureUploadBatch::add(
+	Texture2D& texture,
+	const void* buffer,
+	VkDeviceSize bufferSize,
+	VkFormat format,
+	uint32_t texWidth,
+	uint32_t texHeight,
+	VkFilter filter,
+	VkImageUsageFlags imageUsageFlags,
+	VkImageLayout imageLayout,
+	bool generateMipmaps)
+{
+	assert(buffer && bufferSize > 0 && "Cannot upload texture: no data");
+
+	texture.device = &device;
+	texture.width = texWidth;
+	texture.height = texHeight;
+	texture.layerCount = 1;
+	texture.mipLevels = generateMipmaps ? mipmapGenerator.supportedMipLevels(format, texWidth, texHeight) : 1;
+
+	entries.push_back({ &texture, buffer, bufferSize, format, filter, imageUsageFlags, imageLayout, nullptr, {} });
+}
+
+void Magnet::EngineBase::Rendering::TextureUploadBatch::add(
+	Texture2D& texture,
+	const MipChain& mipChain,
+	VkFilter filter,
+	VkImageUsageFlags imageUsageFlags,
+	VkImageLayout imageLayout)
+{
+	assert(!mipChain.levels.empty() && "Cannot upload texture: no levels");
+
+	texture.device = &device;
+	texture.width = mipChain.width;
+	texture.height = mipChain.height;
+	texture.layerCount = 1;
+	texture.mipLevels = static_cast<uint32_t>(mipChain.levels.size());
+
+	entries.push_back({ &texture, nullptr, 0, mipChain.format, filter, imageUsageFlags, imageLayout, &mipChain, {} });
+}
+
+void Magnet::EngineBase::Rendering::TextureUploadBatch::createTexture(Entry& entry)
+{
+	Texture2D& texture = *entry.texture;
+
+	VkImageCreateInfo imageInfo{};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = entry.format;
+	imageInfo.mipLevels = texture.mipLevels;
+	imageInfo.arrayLayers = 1;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageInfo.extent = { texture.width, texture.height, 1 };
+	imageInfo.usage = entry.usage | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	if (!entry.mipChain && texture.mipLevels > 1) {
+		imageInfo.usage |= mipmapGenerator.requiredUsage(entry.format);
+	}
+	device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, texture.image, texture.deviceMemory);
+
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = entry.filter;
+	samplerInfo.minFilter = entry.filter;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = static_cast<float>(texture.mipLevels);
+	samplerInfo.anisotropyEnable = VK_TRUE;
+	samplerInfo.maxAnisotropy = device.properties.limits.maxSamplerAnisotropy;
+	samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+	if (vkCreateSampler(device.device(), &samplerInfo, nullptr, &texture.sampler) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create texture sampler!");
+	}
+
+	VkImageViewCreateInfo viewInfo{};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = entry.format;
+	viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, texture.mipLevels, 0, 1 };
+	viewInfo.image = texture.image;
+	if (vkCreateImageView(device.device(), &viewInfo, nullptr, &texture.view) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create texture image view!");
+	}
+
+	texture.imageLayout = entry.layout;
+	texture.updateDescriptor();
+}
+
+void Magnet::EngineBase::Rendering::TextureUploadBatch::submit()
+{
+	if (entries.empty()) {
+		return;
+	}
+
+	// One staging buffer for every uploaded level, offsets aligned for any texel or block size
+	VkDeviceSize stagingSize = 0;
+	auto reserve = [&stagingSize](VkDeviceSize size) {
+		VkDeviceSize offset = stagingSize;
+		stagingSize += (size + 15) & ~VkDeviceSize(15);
+		return offset;
+	};
+	for (auto& entry : entries) {
+		entry.levelOffsets.clear();
+		if (entry.mipChain) {
+			for (const auto& level : entry.mipChain->levels) {
+				entry.levelOffsets.push_back(reserve(level.size()));
+			}
+		}
+		else {
+			entry.levelOffsets.push_back(reserve(entry.bufferSize));
+		}
+	}
+
+	VKBase::Buffer stagingBuffer{
+		device,
+		stagingSize,
+		1,
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+	stagingBuffer.map();
+	for (auto& entry : entries) {
+		if (entry.mipChain) {
+			for (size_t level = 0; level < entry.mipChain->levels.size(); level++) {
+				auto& data = entry.mipChain->levels[level];
+				stagingBuffer.writeToBuffer(const_cast<unsigned char*>(data.data()), data.size(), entry.levelOffsets[level]);
+			}
+		}
+		else {
+			stagingBuffer.writeToBuffer(const_cast<void*>(entry.buffer), entry.bufferSize, entry.levelOffsets[0]);
+		}
+		createTexture(entry);
+	}
+
+	VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+
+	// Every uploaded level becomes a copy destination with a single barrier
+	auto layoutBarrier = [](VkImage image, uint32_t levelCount, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask) {
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = srcAccessMask;
+		barrier.dstAccessMask = dstAccessMask;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount, 0, 1 };
+		return barrier;
+	};
+	std::vector<VkImageMemoryBarrier> barriers;
+	for (const auto& entry : entries) {
+		barriers.push_back(layoutBarrier(entry.texture->image, static_cast<uint32_t>(entry.levelOffsets.size()),
+			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT));
+	}
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+		static_cast<uint32_t>(barriers.size()), barriers.data());
+
+	for (const auto& entry : entries) {
+		std::vector<VkBufferImageCopy> regions(entry.levelOffsets.size());
+		for (uint32_t level = 0; level < regions.size(); level++) {
+			regions[level].bufferOffset = entry.levelOffsets[level];
+			regions[level].imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+			regions[level].imageExtent = { std::max(entry.texture->width >> level, 1u), std::max(entry.texture->height >> level, 1u), 1 };
+		}
+		vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.getBuffer(), entry.texture->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			static_cast<uint32_t>(regions.size()), regions.data());
+	}
+
+	// Pre-built chains are complete, the others get their levels generated
+	barriers.clear();
+	std::vector<MipmapGenerator::Job> jobs;
+	for (const auto& entry : entries) {
+		const Texture2D& texture = *entry.texture;
+		if (entry.mipChain) {
+			barriers.push_back(layoutBarrier(texture.image, texture.mipLevels,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, entry.layout, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT));
+		}
+		else {
+			jobs.push_back({ texture.image, entry.format, texture.width, texture.height, texture.mipLevels, entry.layout });
+		}
+	}
+	if (!barriers.empty()) {
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr,
+			static_cast<uint32_t>(barriers.size()), barriers.data());
+	}
+	mipmapGenerator.generate(commandBuffer, jobs);
+
+	device.endSingleTimeCommands(commandBuffer);
+	entries.clear();
+}
@@ -1,50 +1,114 @@
 #pragma once
 #include "../../Commons.h"
+#include "../../VK/Device.h"
+#include "MipmapGenerator.h"
 
 namespace Magnet {
 	namespace EngineBase{
 		namespace Rendering {
+
+			// Every level of a 2D texture, levels[0] is the full resolution and each level is tightly packed
+			struct MipChain {
+				VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+				uint32_t width = 0;
+				uint32_t height = 0;
+				std::vector<std::vector<unsigned char>> levels;
+			};
+
 			class Texture
 			{
 			public:
-				vks::VulkanDevice* device;
-				VkImage               image;
+				VKBase::Device*       device = nullptr;
+				VkImage               image = VK_NULL_HANDLE;
 				VkImageLayout         imageLayout;
-				VkDeviceMemory        deviceMemory;
-				VkImageView           view;
+				VkDeviceMemory        deviceMemory = VK_NULL_HANDLE;
+				VkImageView           view = VK_NULL_HANDLE;
 				uint32_t              width, height;
 				uint32_t              mipLevels;
 				uint32_t              layerCount;
 				VkDescriptorImageInfo descriptor;
-				VkSampler             sampler;
+				VkSampler             sampler = VK_NULL_HANDLE;
 
 				void      updateDescriptor();
 				void      destroy();
-				ktxResult loadKTXFile(std::string filename, ktxTexture** target);
 			};
 
 			class Texture2D : public Texture
 			{
 			public:
+				// KTX2 file, the format and mip chain come from the file (see KTX2Loader). Other images are compressed to BC7
+				// by TextureCompressor and cached next to the source, or uploaded as RGBA8 without BC support
 				void loadFromFile(
 					std::string        filename,
-					VkFormat           format,
-					vks::VulkanDevice* device,
-					VkQueue            copyQueue,
+					VKBase::Device*    device,
+					VkFilter           filter = VK_FILTER_LINEAR,
 					VkImageUsageFlags  imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT,
-					VkImageLayout      imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-					bool               forceLinear = false);
+					VkImageLayout      imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 				void fromBuffer(
 					void* buffer,
 					VkDeviceSize       bufferSize,
 					VkFormat           format,
 					uint32_t           texWidth,
 					uint32_t           texHeight,
-					vks::VulkanDevice* device,
-					VkQueue            copyQueue,
+					VKBase::Device*    device,
+					VkFilter           filter = VK_FILTER_LINEAR,
+					VkImageUsageFlags  imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT,
+					VkImageLayout      imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+					bool               generateMipmaps = true);
+			};
+
+			// Uploads many textures through one staging buffer and one command buffer, with batched layout
+			// transitions and their mip chains generated on the GPU (see MipmapGenerator)
+			class TextureUploadBatch
+			{
+			public:
+				static constexpr const char* MIPMAP_SHADER = "assets/defaults/shaders/mipmap.comp.spv";
+
+				TextureUploadBatch(VKBase::Device& device) : device{ device }, mipmapGenerator{ device, MIPMAP_SHADER } {}
+
+				// Level 0 data must stay valid until submit, the texture is usable once submit returns
+				void add(
+					Texture2D&         texture,
+					const void*        buffer,
+					VkDeviceSize       bufferSize,
+					VkFormat           format,
+					uint32_t           texWidth,
+					uint32_t           texHeight,
+					VkFilter           filter = VK_FILTER_LINEAR,
+					VkImageUsageFlags  imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT,
+					VkImageLayout      imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+					bool               generateMipmaps = true);
+				// Every level of the chain is uploaded as is, it must stay valid until submit
+				void add(
+					Texture2D&         texture,
+					const MipChain&    mipChain,
 					VkFilter           filter = VK_FILTER_LINEAR,
 					VkImageUsageFlags  imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT,
 					VkImageLayout      imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+				// Records and submits every pending upload, then waits for the queue
+				void submit();
+
+				size_t size() const { return entries.size(); }
+
+			private:
+				struct Entry {
+					Texture2D* texture;
+					const void* buffer;
+					VkDeviceSize bufferSize;
+					VkFormat format;
+					VkFilter filter;
+					VkImageUsageFlags usage;
+					VkImageLayout layout;
+					// Pre-built levels, level 0 is buffer otherwise
+					const MipChain* mipChain;
+					std::vector<VkDeviceSize> levelOffsets;
+				};
+
+				void createTexture(Entry& entry);
+
+				VKBase::Device& device;
+				MipmapGenerator mipmapGenerator;
+				std::vector<Entry> entries;
 			};
 
 			class Texture2DArray : public Texture
@@ -53,7 +117,7 @@ namespace Magnet {
 				void loadFromFile(
 					std::string        filename,
 					VkFormat           format,
-					vks::VulkanDevice* device,
+					VKBase::Device*    device,
 					VkQueue            copyQueue,
 					VkImageUsageFlags  imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT,
 					VkImageLayout      imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
@@ -65,7 +129,7 @@ namespace Magnet {
 				void loadFromFile(
 					std::string        filename,
 					VkFormat           format,
-					vks::VulkanDevice* device,
+					VKBase::Device*    device,
 					VkQueue            copyQueue,
 					VkImageUsageFlags  imageUsageFlags = VK_IMAGE_USAGE_SAMPLED_BIT,
 					VkImageLayout      imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
@@ -0,0 +1,735 @@
+#include "TextureCompressor.h"
+#include "TextureStreamer.h"
+
+#include <stb/stb_image.h>
+
+#include <atomic>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MAGNET_COMPRESSOR_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+	using Color = std::array<float, 4>;
+
+	// Pixels of a 4x4 block, one array per channel so that four pixels share a SSE register
+	struct Block {
+		alignas(16) float channels[4][16];
+	};
+
+	const Color RGB_WEIGHTS = { 1.0f, 1.0f, 1.0f, 0.0f };
+	const Color RGBA_WEIGHTS = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+	// Interpolation factors of BC7 4-bit indices, in 64ths
+	const uint32_t BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	uint32_t refinementCount(Magnet::EngineBase::Rendering::TextureCompressor::Quality quality)
+	{
+		switch (quality) {
+		case Magnet::EngineBase::Rendering::TextureCompressor::Quality::Fast:
+			return 0;
+		case Magnet::EngineBase::Rendering::TextureCompressor::Quality::Normal:
+			return 1;
+		default:
+			return 3;
+		}
+	}
+
+	Color clampColor(Color color)
+	{
+		for (auto& channel : color) {
+			channel = std::clamp(channel, 0.0f, 255.0f);
+		}
+		return color;
+	}
+
+	// Nearest palette entry of every pixel under the channel weights, returns the summed squared error
+	float selectIndices(const Block& block, const Color* palette, uint32_t paletteSize, const Color& weights, uint8_t indices[16])
+	{
+#ifdef MAGNET_COMPRESSOR_SSE2
+		float totalError = 0.0f;
+		for (uint32_t group = 0; group < 16; group += 4) {
+			__m128 pixel[4];
+			for (uint32_t channel = 0; channel < 4; channel++) {
+				pixel[channel] = _mm_load_ps(&block.channels[channel][group]);
+			}
+			__m128 bestError = _mm_set1_ps(std::numeric_limits<float>::max());
+			__m128i bestIndex = _mm_setzero_si128();
+			for (uint32_t entry = 0; entry < paletteSize; entry++) {
+				__m128 error = _mm_setzero_ps();
+				for (uint32_t channel = 0; channel < 4; channel++) {
+					__m128 difference = _mm_sub_ps(pixel[channel], _mm_set1_ps(palette[entry][channel]));
+					error = _mm_add_ps(error, _mm_mul_ps(_mm_mul_ps(difference, difference), _mm_set1_ps(weights[channel])));
+				}
+				__m128i better = _mm_castps_si128(_mm_cmplt_ps(error, bestError));
+				bestError = _mm_min_ps(error, bestError);
+				bestIndex = _mm_or_si128(_mm_and_si128(better, _mm_set1_epi32(static_cast<int>(entry))), _mm_andnot_si128(better, bestIndex));
+			}
+			alignas(16) int32_t groupIndices[4];
+			alignas(16) float groupErrors[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(groupIndices), bestIndex);
+			_mm_store_ps(groupErrors, bestError);
+			for (uint32_t i = 0; i < 4; i++) {
+				indices[group + i] = static_cast<uint8_t>(groupIndices[i]);
+				totalError += groupErrors[i];
+			}
+		}
+		return totalError;
+#else
+		float totalError = 0.0f;
+		for (uint32_t i = 0; i < 16; i++) {
+			float bestError = std::numeric_limits<float>::max();
+			for (uint32_t entry = 0; entry < paletteSize; entry++) {
+				float error = 0.0f;
+				for (uint32_t channel = 0; channel < 4; channel++) {
+					float difference = block.channels[channel][i] - palette[entry][channel];
+					error += difference * difference * weights[channel];
+				}
+				if (error < bestError) {
+					bestError = error;
+					indices[i] = static_cast<uint8_t>(entry);
+				}
+			}
+			totalError += bestError;
+		}
+		return totalError;
+#endif
+	}
+
+	// Block bounds inset by a sixteenth, cheap and close to the principal axis for smooth blocks
+	void boundsEndpoints(const Block& block, const Color& weights, Color& endpoint0, Color& endpoint1)
+	{
+		for (uint32_t channel = 0; channel < 4; channel++) {
+			float minimum = *std::min_element(block.channels[channel], block.channels[channel] + 16);
+			float maximum = *std::max_element(block.channels[channel], block.channels[channel] + 16);
+			float inset = weights[channel] > 0.0f ? (maximum - minimum) / 16.0f : 0.0f;
+			endpoint0[channel] = minimum + inset;
+			endpoint1[channel] = maximum - inset;
+		}
+	}
+
+	// Endpoints on the principal axis through the block mean, spanning the projected pixels
+	void principalEndpoints(const Block& block, const Color& weights, Color& endpoint0, Color& endpoint1)
+	{
+		Color mean{};
+		for (uint32_t channel = 0; channel < 4; channel++) {
+			for (uint32_t i = 0; i < 16; i++) {
+				mean[channel] += block.channels[channel][i];
+			}
+			mean[channel] /= 16.0f;
+		}
+
+		float covariance[4][4]{};
+		for (uint32_t i = 0; i < 16; i++) {
+			Color offset;
+			for (uint32_t channel = 0; channel < 4; channel++) {
+				offset[channel] = (block.channels[channel][i] - mean[channel]) * weights[channel];
+			}
+			for (uint32_t a = 0; a < 4; a++) {
+				for (uint32_t b = 0; b < 4; b++) {
+					covariance[a][b] += offset[a] * offset[b];
+				}
+			}
+		}
+
+		// Power iteration, a handful of steps is enough for a 4x4 matrix
+		Color axis = weights;
+		for (uint32_t iteration = 0; iteration < 8; iteration++) {
+			Color next{};
+			for (uint32_t a = 0; a < 4; a++) {
+				for (uint32_t b = 0; b < 4; b++) {
+					next[a] += covariance[a][b] * axis[b];
+				}
+			}
+			float largest = std::max({ std::abs(next[0]), std::abs(next[1]), std::abs(next[2]), std::abs(next[3]) });
+			if (largest <= 0.0f) {
+				// Flat block
+				endpoint0 = mean;
+				endpoint1 = mean;
+				return;
+			}
+			for (uint32_t channel = 0; channel < 4; channel++) {
+				axis[channel] = next[channel] / largest;
+			}
+		}
+		float length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2] + axis[3] * axis[3]);
+		for (auto& channel : axis) {
+			channel /= length;
+		}
+
+		float minimum = std::numeric_limits<float>::max();
+		float maximum = std::numeric_limits<float>::lowest();
+		for (uint32_t i = 0; i < 16; i++) {
+			float projection = 0.0f;
+			for (uint32_t channel = 0; channel < 4; channel++) {
+				projection += (block.channels[channel][i] - mean[channel]) * axis[channel];
+			}
+			minimum = std::min(minimum, projection);
+			maximum = std::max(maximum, projection);
+		}
+		for (uint32_t channel = 0; channel < 4; channel++) {
+			endpoint0[channel] = mean[channel] + axis[channel] * minimum;
+			endpoint1[channel] = mean[channel] + axis[channel] * maximum;
+		}
+		endpoint0 = clampColor(endpoint0);
+		endpoint1 = clampColor(endpoint1);
+	}
+
+	// Endpoints minimizing the squared error for the chosen indices, factors are the weight of endpoint1 per index
+	bool refineEndpoints(const Block& block, const uint8_t indices[16], const float* factors, Color& endpoint0, Color& endpoint1)
+	{
+		float a = 0.0f, b = 0.0f, c = 0.0f;
+		Color x{}, y{};
+		for (uint32_t i = 0; i < 16; i++) {
+			float factor = factors[indices[i]];
+			a += (1.0f - factor) * (1.0f - factor);
+			b += (1.0f - factor) * factor;
+			c += factor * factor;
+			for (uint32_t channel = 0; channel < 4; channel++) {
+				x[channel] += (1.0f - factor) * block.channels[channel][i];
+				y[channel] += factor * block.channels[channel][i];
+			}
+		}
+		float determinant = a * c - b * b;
+		if (std::abs(determinant) < 1e-6f) {
+			return false;
+		}
+		for (uint32_t channel = 0; channel < 4; channel++) {
+			endpoint0[channel] = (c * x[channel] - b * y[channel]) / determinant;
+			endpoint1[channel] = (a * y[channel] - b * x[channel]) / determinant;
+		}
+		endpoint0 = clampColor(endpoint0);
+		endpoint1 = clampColor(endpoint1);
+		return true;
+	}
+
+	uint16_t toRGB565(const Color& color)
+	{
+		uint32_t r = static_cast<uint32_t>(std::lround(color[0] * 31.0f / 255.0f));
+		uint32_t g = static_cast<uint32_t>(std::lround(color[1] * 63.0f / 255.0f));
+		uint32_t b = static_cast<uint32_t>(std::lround(color[2] * 31.0f / 255.0f));
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	Color fromRGB565(uint16_t value)
+	{
+		uint32_t r = (value >> 11) & 31;
+		uint32_t g = (value >> 5) & 63;
+		uint32_t b = value & 31;
+		return { float((r << 3) | (r >> 2)), float((g << 2) | (g >> 4)), float((b << 3) | (b >> 2)), 255.0f };
+	}
+
+	void encodeBC1(const Block& block, Magnet::EngineBase::Rendering::TextureCompressor::Quality quality, unsigned char* output)
+	{
+		// Palette order of the 4 color mode, as factors of color1
+		const float factors[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+		Color endpoint0, endpoint1;
+		if (quality == Magnet::EngineBase::Rendering::TextureCompressor::Quality::Fast) {
+			boundsEndpoints(block, RGB_WEIGHTS, endpoint0, endpoint1);
+		}
+		else {
+			principalEndpoints(block, RGB_WEIGHTS, endpoint0, endpoint1);
+		}
+
+		uint16_t bestColors[2] = { 0, 0 };
+		uint8_t bestIndices[16]{};
+		float bestError = std::numeric_limits<float>::max();
+		for (uint32_t iteration = 0; iteration <= refinementCount(quality); iteration++) {
+			// color0 > color1 selects the 4 color mode
+			uint16_t color0 = toRGB565(endpoint0);
+			uint16_t color1 = toRGB565(endpoint1);
+			if (color0 < color1) {
+				std::swap(color0, color1);
+			}
+			Color palette[4];
+			palette[0] = fromRGB565(color0);
+			palette[1] = fromRGB565(color1);
+			for (uint32_t channel = 0; channel < 4; channel++) {
+				palette[2][channel] = (2.0f * palette[0][channel] + palette[1][channel]) / 3.0f;
+				palette[3][channel] = (palette[0][channel] + 2.0f * palette[1][channel]) / 3.0f;
+			}
+
+			uint8_t indices[16];
+			float error = selectIndices(block, palette, color0 == color1 ? 1 : 4, RGB_WEIGHTS, indices);
+			if (error < bestError) {
+				bestError = error;
+				bestColors[0] = color0;
+				bestColors[1] = color1;
+				memcpy(bestIndices, indices, sizeof(indices));
+			}
+
+			endpoint0 = palette[0];
+			endpoint1 = palette[1];
+			if (color0 == color1 || !refineEndpoints(block, indices, factors, endpoint0, endpoint1)) {
+				break;
+			}
+		}
+
+		uint32_t indexBits = 0;
+		for (uint32_t i = 0; i < 16; i++) {
+			indexBits |= uint32_t(bestIndices[i]) << (2 * i);
+		}
+		memcpy(output, &bestColors[0], 2);
+		memcpy(output + 2, &bestColors[1], 2);
+		memcpy(output + 4, &indexBits, 4);
+	}
+
+	void encodeBC4(const Block& block, uint32_t channel, Magnet::EngineBase::Rendering::TextureCompressor::Quality quality, unsigned char* output)
+	{
+		// Palette order of the 8 value mode, as factors of value1
+		const float factors[8] = { 0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f };
+		Color weights{};
+		weights[channel] = 1.0f;
+
+		Color endpoint0{}, endpoint1{};
+		endpoint0[channel] = *std::max_element(block.channels[channel], block.channels[channel] + 16);
+		endpoint1[channel] = *std::min_element(block.channels[channel], block.channels[channel] + 16);
+
+		uint8_t bestValues[2] = { 0, 0 };
+		uint8_t bestIndices[16]{};
+		float bestError = std::numeric_limits<float>::max();
+		for (uint32_t iteration = 0; iteration <= refinementCount(quality); iteration++) {
+			// value0 > value1 selects the 8 value mode
+			uint8_t value0 = static_cast<uint8_t>(std::lround(endpoint0[channel]));
+			uint8_t value1 = static_cast<uint8_t>(std::lround(endpoint1[channel]));
+			if (value0 < value1) {
+				std::swap(value0, value1);
+			}
+			Color palette[8]{};
+			palette[0][channel] = value0;
+			palette[1][channel] = value1;
+			for (uint32_t entry = 2; entry < 8; entry++) {
+				palette[entry][channel] = ((8.0f - entry) * value0 + (entry - 1.0f) * value1) / 7.0f;
+			}
+
+			uint8_t indices[16];
+			float error = selectIndices(block, palette, value0 == value1 ? 1 : 8, weights, indices);
+			if (error < bestError) {
+				bestError = error;
+				bestValues[0] = value0;
+				bestValues[1] = value1;
+				memcpy(bestIndices, indices, sizeof(indices));
+			}
+
+			endpoint0 = palette[0];
+			endpoint1 = palette[1];
+			if (value0 == value1 || !refineEndpoints(block, indices, factors, endpoint0, endpoint1)) {
+				break;
+			}
+		}
+
+		uint64_t indexBits = 0;
+		for (uint32_t i = 0; i < 16; i++) {
+			indexBits |= uint64_t(bestIndices[i]) << (3 * i);
+		}
+		output[0] = bestValues[0];
+		output[1] = bestValues[1];
+		for (uint32_t byte = 0; byte < 6; byte++) {
+			output[2 + byte] = static_cast<unsigned char>(indexBits >> (8 * byte));
+		}
+	}
+
+	// BC7 mode 6 endpoint : 7 bits per channel and a p-bit shared by the channels
+	struct Mode6Endpoint {
+		uint8_t channels[4];
+		uint8_t pBit;
+	};
+
+	Mode6Endpoint quantizeMode6(const Color& color, uint8_t pBit)
+	{
+		Mode6Endpoint endpoint{ {}, pBit };
+		for (uint32_t channel = 0; channel < 4; channel++) {
+			endpoint.channels[channel] = static_cast<uint8_t>(std::clamp(std::lround((color[channel] - pBit) / 2.0f), 0l, 127l));
+		}
+		return endpoint;
+	}
+
+	Color expandMode6(const Mode6Endpoint& endpoint)
+	{
+		Color color;
+		for (uint32_t channel = 0; channel < 4; channel++) {
+			color[channel] = float((endpoint.channels[channel] << 1) | endpoint.pBit);
+		}
+		return color;
+	}
+
+	float quantizationError(const Color& color, const Mode6Endpoint& endpoint)
+	{
+		Color expanded = expandMode6(endpoint);
+		float error = 0.0f;
+		for (uint32_t channel = 0; channel < 4; channel++) {
+			error += (color[channel] - expanded[channel]) * (color[channel] - expanded[channel]);
+		}
+		return error;
+	}
+
+	// Bits are written from the least significant bit of the first byte
+	void writeBits(unsigned char* output, uint32_t& offset, uint32_t count, uint32_t value)
+	{
+		for (uint32_t bit = 0; bit < count; bit++, offset++) {
+			if ((value >> bit) & 1) {
+				output[offset / 8] |= static_cast<unsigned char>(1u << (offset % 8));
+			}
+		}
+	}
+
+	void encodeBC7(const Block& block, Magnet::EngineBase::Rendering::TextureCompressor::Quality quality, unsigned char* output)
+	{
+		float factors[16];
+		for (uint32_t i = 0; i < 16; i++) {
+			factors[i] = BC7_WEIGHTS[i] / 64.0f;
+		}
+
+		Color endpoint0, endpoint1;
+		if (quality == Magnet::EngineBase::Rendering::TextureCompressor::Quality::Fast) {
+			boundsEndpoints(block, RGBA_WEIGHTS, endpoint0, endpoint1);
+		}
+		else {
+			principalEndpoints(block, RGBA_WEIGHTS, endpoint0, endpoint1);
+		}
+
+		Mode6Endpoint bestEndpoints[2]{};
+		uint8_t bestIndices[16]{};
+		float bestError = std::numeric_limits<float>::max();
+
+		auto evaluate = [&](const Mode6Endpoint& quantized0, const Mode6Endpoint& quantized1, uint8_t indices[16]) {
+			Color color0 = expandMode6(quantized0);
+			Color color1 = expandMode6(quantized1);
+			Color palette[16];
+			for (uint32_t entry = 0; entry < 16; entry++) {
+				for (uint32_t channel = 0; channel < 4; channel++) {
+					uint32_t interpolated = ((64 - BC7_WEIGHTS[entry]) * uint32_t(color0[channel]) + BC7_WEIGHTS[entry] * uint32_t(color1[channel]) + 32) >> 6;
+					palette[entry][channel] = float(interpolated);
+				}
+			}
+			float error = selectIndices(block, palette, 16, RGBA_WEIGHTS, indices);
+			if (error < bestError) {
+				bestError = error;
+				bestEndpoints[0] = quantized0;
+				bestEndpoints[1] = quantized1;
+				memcpy(bestIndices, indices, 16);
+			}
+		};
+
+		for (uint32_t iteration = 0; iteration <= refinementCount(quality); iteration++) {
+			uint8_t indices[16];
+			if (quality == Magnet::EngineBase::Rendering::TextureCompressor::Quality::High) {
+				for (uint8_t pBits = 0; pBits < 4; pBits++) {
+					evaluate(quantizeMode6(endpoint0, pBits & 1), quantizeMode6(endpoint1, pBits >> 1), indices);
+				}
+			}
+			else {
+				// Each endpoint takes the p-bit that rounds it best
+				auto quantize = [](const Color& color) {
+					Mode6Endpoint even = quantizeMode6(color, 0);
+					Mode6Endpoint odd = quantizeMode6(color, 1);
+					return quantizationError(color, even) <= quantizationError(color, odd) ? even : odd;
+				};
+				evaluate(quantize(endpoint0), quantize(endpoint1), indices);
+			}
+
+			// Refined from the best indices so far
+			endpoint0 = expandMode6(bestEndpoints[0]);
+			endpoint1 = expandMode6(bestEndpoints[1]);
+			if (!refineEndpoints(block, bestIndices, factors, endpoint0, endpoint1)) {
+				break;
+			}
+		}
+
+		// The anchor index is stored without its top bit, it must point to the first half of the palette
+		if (bestIndices[0] >= 8) {
+			std::swap(bestEndpoints[0], bestEndpoints[1]);
+			for (auto& index : bestIndices) {
+				index = static_cast<uint8_t>(15 - index);
+			}
+		}
+
+		memset(output, 0, 16);
+		uint32_t offset = 0;
+		writeBits(output, offset, 7, 1u << 6);
+		for (uint32_t channel = 0; channel < 4; channel++) {
+			writeBits(output, offset, 7, bestEndpoints[0].channels[channel]);
+			writeBits(output, offset, 7, bestEndpoints[1].channels[channel]);
+		}
+		writeBits(output, offset, 1, bestEndpoints[0].pBit);
+		writeBits(output, offset, 1, bestEndpoints[1].pBit);
+		for (uint32_t i = 0; i < 16; i++) {
+			writeBits(output, offset, i == 0 ? 3 : 4, bestIndices[i]);
+		}
+	}
+
+	void appendBytes(std::vector<unsigned char>& bytes, const void* data, size_t size)
+	{
+		const unsigned char* begin = static_cast<const unsigned char*>(data);
+		bytes.insert(bytes.end(), begin, begin + size);
+	}
+
+	template<typename T>
+	void append(std::vector<unsigned char>& bytes, T value)
+	{
+		appendBytes(bytes, &value, sizeof(T));
+	}
+}
+
+Magnet::EngineBase::Rendering::TextureCompressor::TextureCompressor(const Settings& settings) : settings{ settings }
+{
+}
+
+VkFormat Magnet::EngineBase::Rendering::TextureCompressor::getVkFormat(Format format)
+{
+	switch (format) {
+	case Format::BC1:
+		return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+	case Format::BC5:
+		return VK_FORMAT_BC5_UNORM_BLOCK;
+	default:
+		return VK_FORMAT_BC7_UNORM_BLOCK;
+	}
+}
+
+uint32_t Magnet::EngineBase::Rendering::TextureCompressor::getBlockSize(Format format)
+{
+	return format == Format::BC1 ? 8 : 16;
+}
+
+void Magnet::EngineBase::Rendering::TextureCompressor::compressBlock(const unsigned char* rgba, unsigned char* output) const
+{
+	Block block;
+	for (uint32_t i = 0; i < 16; i++) {
+		for (uint32_t channel = 0; channel < 4; channel++) {
+			block.channels[channel][i] = rgba[i * 4 + channel];
+		}
+	}
+
+	switch (settings.format) {
+	case Format::BC1:
+		encodeBC1(block, settings.quality, output);
+		break;
+	case Format::BC5:
+		encodeBC4(block, 0, settings.quality, output);
+		encodeBC4(block, 1, settings.quality, output + 8);
+		break;
+	case Format::BC7:
+		encodeBC7(block, settings.quality, output);
+		break;
+	}
+}
+
+Magnet::EngineBase::Rendering::MipChain Magnet::EngineBase::Rendering::TextureCompressor::compress(const MipChain& rgbaChain)
+{
+	assert(rgbaChain.format == VK_FORMAT_R8G8B8A8_UNORM && "Cannot compress texture: source must be RGBA8");
+	auto start = std::chrono::high_resolution_clock::now();
+
+	uint32_t blockSize = getBlockSize(settings.format);
+	MipChain compressed{ getVkFormat(settings.format), rgbaChain.width, rgbaChain.height, {} };
+	compressed.levels.resize(rgbaChain.levels.size());
+
+	// One job per block row of every level, taken by the workers in order
+	struct Job {
+		uint32_t level;
+		uint32_t row;
+	};
+	std::vector<Job> jobs;
+	for (uint32_t level = 0; level < rgbaChain.levels.size(); level++) {
+		uint32_t blocksX = (std::max(rgbaChain.width >> level, 1u) + 3) / 4;
+		uint32_t blocksY = (std::max(rgbaChain.height >> level, 1u) + 3) / 4;
+		compressed.levels[level].resize(size_t(blocksX) * blocksY * blockSize);
+		for (uint32_t row = 0; row < blocksY; row++) {
+			jobs.push_back({ level, row });
+		}
+		stats.blocks += uint64_t(blocksX) * blocksY;
+	}
+
+	std::atomic<size_t> nextJob{ 0 };
+	auto worker = [&]() {
+		unsigned char pixels[64];
+		for (size_t jobIndex = nextJob++; jobIndex < jobs.size(); jobIndex = nextJob++) {
+			const Job& job = jobs[jobIndex];
+			uint32_t width = std::max(rgbaChain.width >> job.level, 1u);
+			uint32_t height = std::max(rgbaChain.height >> job.level, 1u);
+			uint32_t blocksX = (width + 3) / 4;
+			const unsigned char* source = rgbaChain.levels[job.level].data();
+			unsigned char* destination = compressed.levels[job.level].data() + size_t(job.row) * blocksX * blockSize;
+
+			for (uint32_t blockX = 0; blockX < blocksX; blockX++) {
+				// Edge blocks repeat the last row and column
+				for (uint32_t y = 0; y < 4; y++) {
+					uint32_t sourceY = std::min(job.row * 4 + y, height - 1);
+					for (uint32_t x = 0; x < 4; x++) {
+						uint32_t sourceX = std::min(blockX * 4 + x, width - 1);
+						memcpy(&pixels[(y * 4 + x) * 4], &source[(size_t(sourceY) * width + sourceX) * 4], 4);
+					}
+				}
+				compressBlock(pixels, destination + size_t(blockX) * blockSize);
+			}
+		}
+	};
+
+	uint32_t threadCount = settings.threadCount > 0 ? settings.threadCount : std::max(std::thread::hardware_concurrency(), 1u);
+	std::vector<std::thread> workers;
+	for (uint32_t i = 1; i < threadCount; i++) {
+		workers.emplace_back(worker);
+	}
+	worker();
+	for (auto& thread : workers) {
+		thread.join();
+	}
+
+	stats.images++;
+	stats.compressTimeMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	return compressed;
+}
+
+std::string Magnet::EngineBase::Rendering::TextureCompressor::getCachePath(const std::string& sourcePath, Format format)
+{
+	const char* extensions[] = { ".bc1.ktx2", ".bc5.ktx2", ".bc7.ktx2" };
+	std::filesystem::path path{ sourcePath };
+	path.replace_extension(extensions[static_cast<uint32_t>(format)]);
+	return path.string();
+}
+
+std::string Magnet::EngineBase::Rendering::TextureCompressor::compressToCache(const std::string& sourcePath)
+{
+	std::string cachePath = getCachePath(sourcePath, settings.format);
+	if (std::filesystem::exists(cachePath) && std::filesystem::last_write_time(cachePath) >= std::filesystem::last_write_time(sourcePath)) {
+		stats.cacheHits++;
+		return cachePath;
+	}
+
+	int width, height, channels;
+	stbi_uc* pixels = stbi_load(sourcePath.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+	if (!pixels) {
+		throw std::runtime_error("failed to load texture image: " + sourcePath);
+	}
+	MipChain rgbaChain = TextureStreamer::buildMipChain(pixels, static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+	stbi_image_free(pixels);
+
+	writeKTX2(cachePath, compress(rgbaChain));
+	return cachePath;
+}
+
+void Magnet::EngineBase::Rendering::TextureCompressor::compressDirectory(const std::string& directory)
+{
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(directory)) {
+		if (!entry.is_regular_file()) {
+			continue;
+		}
+		std::string extension = entry.path().extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp") {
+			compressToCache(entry.path().string());
+		}
+	}
+}
+
+void Magnet::EngineBase::Rendering::TextureCompressor::writeKTX2(const std::string& path, const MipChain& mipChain)
+{
+	// Khronos data format descriptor of the block format, one 128 bit block or two 64 bit blocks for BC5
+	constexpr uint32_t KHR_DF_MODEL_BC1A = 128;
+	constexpr uint32_t KHR_DF_MODEL_BC5 = 132;
+	constexpr uint32_t KHR_DF_MODEL_BC7 = 134;
+	uint32_t colorModel;
+	uint32_t blockSize;
+	uint32_t sampleCount = 1;
+	switch (mipChain.format) {
+	case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		colorModel = KHR_DF_MODEL_BC1A;
+		blockSize = 8;
+		break;
+	case VK_FORMAT_BC5_UNORM_BLOCK:
+		colorModel = KHR_DF_MODEL_BC5;
+		blockSize = 16;
+		sampleCount = 2;
+		break;
+	case VK_FORMAT_BC7_UNORM_BLOCK:
+		colorModel = KHR_DF_MODEL_BC7;
+		blockSize = 16;
+		break;
+	default:
+		throw std::runtime_error("failed to write KTX2 file, unsupported format!");
+	}
+
+	std::vector<unsigned char> dfd;
+	uint32_t descriptorBlockSize = 24 + 16 * sampleCount;
+	append<uint32_t>(dfd, 4 + descriptorBlockSize);
+	append<uint32_t>(dfd, 0);                                        // Khronos vendor, basic descriptor type
+	append<uint32_t>(dfd, 2 | (descriptorBlockSize << 16));          // Version 1.3
+	append<uint32_t>(dfd, colorModel | (1 << 8) | (1 << 16));        // BT709 primaries, linear transfer
+	append<uint32_t>(dfd, 3 | (3 << 8));                             // 4x4 texel blocks
+	append<uint32_t>(dfd, blockSize);
+	append<uint32_t>(dfd, 0);
+	for (uint32_t sample = 0; sample < sampleCount; sample++) {
+		uint32_t bitLength = (blockSize / sampleCount) * 8;
+		append<uint32_t>(dfd, (sample * bitLength) | ((bitLength - 1) << 16) | (sample << 24));
+		append<uint32_t>(dfd, 0);
+		append<uint32_t>(dfd, 0);
+		append<uint32_t>(dfd, 0xFFFFFFFF);
+	}
+
+	const unsigned char identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+	uint32_t levelCount = static_cast<uint32_t>(mipChain.levels.size());
+	uint32_t levelIndexOffset = 80;
+	uint32_t dfdOffset = levelIndexOffset + levelCount * 24;
+
+	// Levels are stored from the smallest, each aligned to the block size
+	std::vector<uint64_t> levelOffsets(levelCount);
+	uint64_t offset = dfdOffset + dfd.size();
+	for (uint32_t level = levelCount; level-- > 0;) {
+		offset = (offset + blockSize - 1) / blockSize * blockSize;
+		levelOffsets[level] = offset;
+		offset += mipChain.levels[level].size();
+	}
+
+	std::vector<unsigned char> bytes;
+	appendBytes(bytes, identifier, sizeof(identifier));
+	append<uint32_t>(bytes, mipChain.format);
+	append<uint32_t>(bytes, 1);                   // Type size of block formats
+	append<uint32_t>(bytes, mipChain.width);
+	append<uint32_t>(bytes, mipChain.height);
+	append<uint32_t>(bytes, 0);                   // Depth
+	append<uint32_t>(bytes, 0);                   // Layers
+	append<uint32_t>(bytes, 1);                   // Faces
+	append<uint32_t>(bytes, levelCount);
+	append<uint32_t>(bytes, 0);                   // No supercompression
+	append<uint32_t>(bytes, dfdOffset);
+	append<uint32_t>(bytes, static_cast<uint32_t>(dfd.size()));
+	append<uint32_t>(bytes, 0);                   // No key/value data
+	append<uint32_t>(bytes, 0);
+	append<uint64_t>(bytes, 0);                   // No supercompression global data
+	append<uint64_t>(bytes, 0);
+	for (uint32_t level = 0; level < levelCount; level++) {
+		append<uint64_t>(bytes, levelOffsets[level]);
+		append<uint64_t>(bytes, mipChain.levels[level].size());
+		append<uint64_t>(bytes, mipChain.levels[level].size());
+	}
+	appendBytes(bytes, dfd.data(), dfd.size());
+	for (uint32_t level = levelCount; level-- > 0;) {
+		bytes.resize(levelOffsets[level], 0);
+		appendBytes(bytes, mipChain.levels[level].data(), mipChain.levels[level].size());
+	}
+
+	std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+	if (!file.is_open()) {
+		throw std::runtime_error("failed to open file: " + path);
+	}
+	file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+void Magnet::EngineBase::Rendering::TextureCompressor::printStats() const
+{
+	const char* formats[] = { "BC1", "BC5", "BC7" };
+	const char* qualities[] = { "fast", "normal", "high" };
+	std::cout << "\nTexture Compression :" << std::endl;
+	std::cout << "------------------------------" << std::endl;
+	std::cout << "\t- Format : " << formats[static_cast<uint32_t>(settings.format)] << " (" << qualities[static_cast<uint32_t>(settings.quality)] << ")" << std::endl;
+	std::cout << "\t- Images compressed : " << stats.images << " (" << stats.cacheHits << " cached)" << std::endl;
+	std::cout << "\t- Blocks : " << stats.blocks << std::endl;
+	std::cout << "\t- Time : " << stats.compressTimeMs << " ms";
+	if (stats.compressTimeMs > 0.0) {
+		std::cout << " (" << stats.blocks / stats.compressTimeMs / 1000.0 << " Mblocks/s)";
+	}
+	std::cout << std::endl;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "../../Commons.h"
+#include "Texture.h"
+
+namespace Magnet {
+	namespace EngineBase {
+		namespace Rendering {
+
+			// Block compression of RGBA8 images to BC1 (opaque color), BC5 (two channels, normal maps) and BC7 mode 6
+			// (color with alpha). Every 4x4 block of every mip level is encoded independently, so block rows are spread
+			// across all cores, and palette index searches process four pixels per SSE instruction.
+			// Compressed chains are cached next to their source image as KTX2 files, only rebuilt when the source is newer.
+			class TextureCompressor {
+			public:
+				enum class Format { BC1, BC5, BC7 };
+				// Fast fits endpoints to the block bounds, Normal to its principal axis with one least squares refinement,
+				// High refines three times and tries every BC7 p-bit combination
+				enum class Quality { Fast, Normal, High };
+
+				struct Settings {
+					Format format = Format::BC7;
+					Quality quality = Quality::Normal;
+					// 0 uses every hardware thread
+					uint32_t threadCount = 0;
+				};
+
+				struct Stats {
+					uint32_t images = 0;
+					uint32_t cacheHits = 0;
+					uint64_t blocks = 0;
+					double compressTimeMs = 0.0;
+				};
+
+				explicit TextureCompressor(const Settings& settings);
+
+				static VkFormat getVkFormat(Format format);
+				static uint32_t getBlockSize(Format format);
+
+				// Compresses every level, an RGBA8 chain from TextureStreamer::buildMipChain for example
+				MipChain compress(const MipChain& rgbaChain);
+				// Path of the KTX2 file, compressed from the source image when missing or older than it
+				std::string compressToCache(const std::string& sourcePath);
+				// Every PNG, JPG, TGA and BMP image under directory
+				void compressDirectory(const std::string& directory);
+
+				static std::string getCachePath(const std::string& sourcePath, Format format);
+				static void writeKTX2(const std::string& path, const MipChain& mipChain);
+
+				const Stats& getStats() const { return stats; }
+				void printStats() const;
+
+			private:
+				void compressBlock(const unsigned char* rgba, unsigned char* output) const;
+
+				Settings settings;
+				Stats stats{};
+			};
+		}
+	}
+}
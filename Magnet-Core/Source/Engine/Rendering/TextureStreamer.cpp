@@ -0,0 +1,466 @@
+#include "TextureStreamer.h"
+
+Magnet::EngineBase::Rendering::TextureStreamer::TextureStreamer(VKBase::Device& device, uint32_t frameCount, const Settings& settings) : device{ device }, settings{ settings }, frameCount{ frameCount }
+{
+	// Textures sample white until their tail is resident
+	unsigned char white[4] = { 255, 255, 255, 255 };
+	fallbackTexture.fromBuffer(white, sizeof(white), VK_FORMAT_R8G8B8A8_UNORM, 1, 1, &device,
+		VK_FILTER_LINEAR, VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false);
+
+	// Images only hold their resident levels, the hardware picks the level from the image size so no LOD clamp is needed
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+	samplerInfo.anisotropyEnable = VK_TRUE;
+	samplerInfo.maxAnisotropy = device.properties.limits.maxSamplerAnisotropy;
+	samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+	if (vkCreateSampler(device.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create texture streamer sampler!");
+	}
+
+	setLayout = VKBase::DescriptorSetLayout::Builder(device)
+		.addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+		.build();
+	descriptorPool = VKBase::DescriptorPool::Builder(device)
+		.setMaxSets(settings.maxTextures * frameCount)
+		.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, settings.maxTextures * frameCount)
+		.build();
+}
+
+Magnet::EngineBase::Rendering::TextureStreamer::~TextureStreamer()
+{
+	for (auto& upload : uploads) {
+		if (upload->staged.valid()) {
+			upload->staged.wait();
+		}
+		if (upload->fence) {
+			vkWaitForFences(device.device(), 1, &upload->fence, VK_TRUE, UINT64_MAX);
+			vkDestroyFence(device.device(), upload->fence, nullptr);
+			vkFreeCommandBuffers(device.device(), device.getCommandPool(), 1, &upload->commandBuffer);
+		}
+		vkDestroyImage(device.device(), upload->image, nullptr);
+		vkFreeMemory(device.device(), upload->memory, nullptr);
+	}
+	uploads.clear();
+
+	releaseRetiredImages(true);
+	for (auto& texture : textures) {
+		vkDestroyImageView(device.device(), texture.view, nullptr);
+		vkDestroyImage(device.device(), texture.image, nullptr);
+		vkFreeMemory(device.device(), texture.memory, nullptr);
+	}
+	vkDestroySampler(device.device(), sampler, nullptr);
+	fallbackTexture.destroy();
+}
+
+Magnet::EngineBase::Rendering::TextureStreamer::Source Magnet::EngineBase::Rendering::TextureStreamer::buildMipChain(const unsigned char* rgba, uint32_t width, uint32_t height)
+{
+	Source source{ VK_FORMAT_R8G8B8A8_UNORM, width, height, {} };
+	uint32_t mipCount = MipmapGenerator::fullMipLevels(width, height);
+	source.levels.resize(mipCount);
+	source.levels[0].assign(rgba, rgba + size_t(width) * height * 4);
+
+	for (uint32_t mip = 1; mip < mipCount; mip++) {
+		const auto& parent = source.levels[mip - 1];
+		uint32_t parentWidth = std::max(width >> (mip - 1), 1u);
+		uint32_t parentHeight = std::max(height >> (mip - 1), 1u);
+		uint32_t levelWidth = std::max(width >> mip, 1u);
+		uint32_t levelHeight = std::max(height >> mip, 1u);
+
+		auto& level = source.levels[mip];
+		level.resize(size_t(levelWidth) * levelHeight * 4);
+		for (uint32_t y = 0; y < levelHeight; y++) {
+			// Clamped so 1 texel wide parents are averaged with themselves
+			uint32_t y0 = std::min(y * 2, parentHeight - 1);
+			uint32_t y1 = std::min(y * 2 + 1, parentHeight - 1);
+			for (uint32_t x = 0; x < levelWidth; x++) {
+				uint32_t x0 = std::min(x * 2, parentWidth - 1);
+				uint32_t x1 = std::min(x * 2 + 1, parentWidth - 1);
+				for (uint32_t c = 0; c < 4; c++) {
+					uint32_t sum =
+						parent[(size_t(y0) * parentWidth + x0) * 4 + c] + parent[(size_t(y0) * parentWidth + x1) * 4 + c] +
+						parent[(size_t(y1) * parentWidth + x0) * 4 + c] + parent[(size_t(y1) * parentWidth + x1) * 4 + c];
+					level[(size_t(y) * levelWidth + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+				}
+			}
+		}
+	}
+	return source;
+}
+
+uint32_t Magnet::EngineBase::Rendering::TextureStreamer::mipForScreenSize(uint32_t textureSize, float screenSize)
+{
+	screenSize = std::max(screenSize, 1.0f);
+	float ratio = static_cast<float>(textureSize) / screenSize;
+	return ratio <= 1.0f ? 0 : static_cast<uint32_t>(std::floor(std::log2(ratio)));
+}
+
+Magnet::EngineBase::Rendering::TextureStreamer::Handle Magnet::EngineBase::Rendering::TextureStreamer::add(Source&& source)
+{
+	assert(!source.levels.empty() && "Cannot stream texture: no levels");
+	if (textures.size() >= settings.maxTextures) {
+		throw std::runtime_error("failed to add streamed texture, too many textures!");
+	}
+
+	StreamedTexture texture{};
+	texture.mipCount = static_cast<uint32_t>(source.levels.size());
+	texture.tailMip = texture.mipCount - 1;
+	for (uint32_t mip = 0; mip < texture.mipCount; mip++) {
+		if (std::max(source.width >> mip, source.height >> mip) <= settings.tailSize) {
+			texture.tailMip = mip;
+			break;
+		}
+	}
+	texture.residentMip = texture.mipCount;
+	texture.requestedMip = texture.mipCount;
+	texture.source = std::move(source);
+
+	texture.descriptorSets.resize(frameCount);
+	texture.writtenVersions.assign(frameCount, texture.version);
+	for (auto& descriptorSet : texture.descriptorSets) {
+		VKBase::DescriptorWriter(*setLayout, *descriptorPool)
+			.writeImage(0, &fallbackTexture.descriptor)
+			.build(descriptorSet);
+	}
+
+	textures.push_back(std::move(texture));
+	return static_cast<Handle>(textures.size() - 1);
+}
+
+void Magnet::EngineBase::Rendering::TextureStreamer::request(Handle handle, uint32_t mip)
+{
+	auto& texture = textures[handle];
+	texture.requestedMip = std::min(texture.requestedMip, std::min(mip, texture.mipCount - 1));
+	texture.lastRequestFrame = frameCounter;
+}
+
+void Magnet::EngineBase::Rendering::TextureStreamer::update(uint32_t frameIndex)
+{
+	// Staged uploads are submitted, completed ones swapped in, none of it waits
+	for (auto it = uploads.begin(); it != uploads.end();) {
+		Upload& upload = **it;
+		if (!upload.commandBuffer && upload.staged.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+			upload.staged.get();
+			submitUpload(upload);
+		}
+		if (upload.fence && vkGetFenceStatus(device.device(), upload.fence) == VK_SUCCESS) {
+			completeUpload(upload);
+			it = uploads.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+
+	releaseRetiredImages(false);
+	scheduleUploads();
+	writeDescriptors(frameIndex);
+
+	// Requests of the next frame start from the coarsest level
+	for (auto& texture : textures) {
+		texture.requestedMip = texture.mipCount;
+	}
+	frameCounter++;
+}
+
+VkDeviceSize Magnet::EngineBase::Rendering::TextureStreamer::levelBytes(const StreamedTexture& texture, uint32_t topMip) const
+{
+	VkDeviceSize bytes = 0;
+	for (uint32_t mip = topMip; mip < texture.mipCount; mip++) {
+		bytes += texture.source.levels[mip].size();
+	}
+	return bytes;
+}
+
+void Magnet::EngineBase::Rendering::TextureStreamer::scheduleUploads()
+{
+	// What each texture should hold : its tail at least, the requested level when it was used this frame
+	auto targetMip = [this](const StreamedTexture& texture) {
+		return std::min(texture.requestedMip, texture.tailMip);
+	};
+
+	std::vector<Handle> candidates;
+	for (Handle handle = 0; handle < textures.size(); handle++) {
+		const auto& texture = textures[handle];
+		if (!texture.uploading && targetMip(texture) < texture.residentMip) {
+			candidates.push_back(handle);
+		}
+	}
+
+	// Missing tails first, then the textures missing the most detail, then the most recently used
+	std::sort(candidates.begin(), candidates.end(), [this](Handle a, Handle b) {
+		const auto& textureA = textures[a];
+		const auto& textureB = textures[b];
+		bool emptyA = textureA.residentMip == textureA.mipCount;
+		bool emptyB = textureB.residentMip == textureB.mipCount;
+		if (emptyA != emptyB) {
+			return emptyA;
+		}
+		uint32_t missingA = textureA.residentMip - std::min(textureA.requestedMip, textureA.tailMip);
+		uint32_t missingB = textureB.residentMip - std::min(textureB.requestedMip, textureB.tailMip);
+		if (missingA != missingB) {
+			return missingA > missingB;
+		}
+		return textureA.lastRequestFrame > textureB.lastRequestFrame;
+	});
+
+	for (Handle handle : candidates) {
+		if (uploads.size() >= settings.maxUploadsInFlight) {
+			break;
+		}
+		auto& texture = textures[handle];
+		uint32_t topMip = targetMip(texture);
+
+		// Tails are always loaded, higher levels must fit in the budget
+		if (topMip < texture.tailMip) {
+			VkDeviceSize extraBytes = levelBytes(texture, topMip) - texture.bytes;
+			bool fits = true;
+			while (committedBytes + extraBytes > settings.memoryBudget) {
+				if (!evictLeastRecentlyUsed(handle)) {
+					fits = false;
+					break;
+				}
+			}
+			if (!fits) {
+				continue;
+			}
+		}
+		startUpload(handle, topMip, false);
+	}
+}
+
+bool Magnet::EngineBase::Rendering::TextureStreamer::evictLeastRecentlyUsed(Handle keep)
+{
+	Handle victim = INVALID_HANDLE;
+	for (Handle handle = 0; handle < textures.size(); handle++) {
+		const auto& texture = textures[handle];
+		// Textures used this frame are never evicted
+		if (handle == keep || texture.uploading || texture.residentMip >= texture.tailMip || texture.lastRequestFrame == frameCounter) {
+			continue;
+		}
+		if (victim == INVALID_HANDLE || texture.lastRequestFrame < textures[victim].lastRequestFrame) {
+			victim = handle;
+		}
+	}
+	if (victim == INVALID_HANDLE) {
+		return false;
+	}
+
+	// Shrinking is an upload of the tail, the larger image is released once it completes
+	startUpload(victim, textures[victim].tailMip, true);
+	return true;
+}
+
+void Magnet::EngineBase::Rendering::TextureStreamer::startUpload(Handle handle, uint32_t topMip, bool eviction)
+{
+	auto& texture = textures[handle];
+	auto upload = std::make_unique<Upload>();
+	upload->handle = handle;
+	upload->topMip = topMip;
+	upload->eviction = eviction;
+	upload->bytes = levelBytes(texture, topMip);
+
+	VkImageCreateInfo imageInfo{};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = texture.source.format;
+	imageInfo.mipLevels = texture.mipCount - topMip;
+	imageInfo.arrayLayers = 1;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageInfo.extent = { std::max(texture.source.width >> topMip, 1u), std::max(texture.source.height >> topMip, 1u), 1 };
+	imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, upload->image, upload->memory);
+
+	// Offsets aligned for any texel or block size
+	VkDeviceSize stagingSize = 0;
+	struct LevelCopy {
+		const unsigned char* data;
+		size_t size;
+		VkDeviceSize offset;
+	};
+	std::vector<LevelCopy> copies;
+	for (uint32_t mip = topMip; mip < texture.mipCount; mip++) {
+		const auto& level = texture.source.levels[mip];
+		upload->levelOffsets.push_back(stagingSize);
+		copies.push_back({ level.data(), level.size(), stagingSize });
+		stagingSize += (level.size() + 15) & ~VkDeviceSize(15);
+	}
+
+	upload->stagingBuffer = std::make_unique<VKBase::Buffer>(
+		device,
+		stagingSize,
+		1,
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	upload->stagingBuffer->map();
+
+	// Source levels live in their own allocations, moving the texture array does not invalidate them
+	unsigned char* mapped = static_cast<unsigned char*>(upload->stagingBuffer->getMappedMemory());
+	upload->staged = std::async(std::launch::async, [mapped, copies = std::move(copies)]() {
+		for (const auto& copy : copies) {
+			memcpy(mapped + copy.offset, copy.data, copy.size);
+		}
+	});
+
+	committedBytes = committedBytes + upload->bytes - texture.bytes;
+	texture.uploading = true;
+	uploads.push_back(std::move(upload));
+}
+
+void Magnet::EngineBase::Rendering::TextureStreamer::submitUpload(Upload& upload)
+{
+	const auto& texture = textures[upload.handle];
+	uint32_t levelCount = texture.mipCount - upload.topMip;
+
+	VkCommandBufferAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandPool = device.getCommandPool();
+	allocInfo.commandBufferCount = 1;
+	if (vkAllocateCommandBuffers(device.device(), &allocInfo, &upload.commandBuffer) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate texture streaming command buffer!");
+	}
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(upload.commandBuffer, &beginInfo);
+
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = upload.image;
+	barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount, 0, 1 };
+	vkCmdPipelineBarrier(upload.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	std::vector<VkBufferImageCopy> regions(levelCount);
+	for (uint32_t level = 0; level < levelCount; level++) {
+		uint32_t mip = upload.topMip + level;
+		regions[level].bufferOffset = upload.levelOffsets[level];
+		regions[level].imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+		regions[level].imageExtent = { std::max(texture.source.width >> mip, 1u), std::max(texture.source.height >> mip, 1u), 1 };
+	}
+	vkCmdCopyBufferToImage(upload.commandBuffer, upload.stagingBuffer->getBuffer(), upload.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		static_cast<uint32_t>(regions.size()), regions.data());
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	vkCmdPipelineBarrier(upload.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	vkEndCommandBuffer(upload.commandBuffer);
+
+	VkFenceCreateInfo fenceInfo{};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	if (vkCreateFence(device.device(), &fenceInfo, nullptr, &upload.fence) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create texture streaming fence!");
+	}
+
+	// The frame that first samples the new image is submitted after the fence signaled
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &upload.commandBuffer;
+	if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, upload.fence) != VK_SUCCESS) {
+		throw std::runtime_error("failed to submit texture streaming upload!");
+	}
+}
+
+void Magnet::EngineBase::Rendering::TextureStreamer::completeUpload(Upload& upload)
+{
+	auto& texture = textures[upload.handle];
+
+	VkImageViewCreateInfo viewInfo{};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = texture.source.format;
+	viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, texture.mipCount - upload.topMip, 0, 1 };
+	viewInfo.image = upload.image;
+	VkImageView view;
+	if (vkCreateImageView(device.device(), &viewInfo, nullptr, &view) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create streamed texture image view!");
+	}
+
+	// Frames in flight may still sample the previous image through their descriptor sets
+	if (texture.image) {
+		retiredImages.push_back({ texture.image, texture.memory, texture.view, frameCounter + frameCount });
+	}
+	residentBytes = residentBytes + upload.bytes - texture.bytes;
+	stats.peakResidentBytes = std::max(stats.peakResidentBytes, residentBytes);
+
+	texture.image = upload.image;
+	texture.memory = upload.memory;
+	texture.view = view;
+	texture.bytes = upload.bytes;
+	texture.residentMip = upload.topMip;
+	texture.uploading = false;
+	texture.version++;
+
+	if (upload.eviction) {
+		stats.evictions++;
+	}
+	else {
+		stats.uploads++;
+	}
+	stats.bytesUploaded += upload.bytes;
+
+	vkDestroyFence(device.device(), upload.fence, nullptr);
+	vkFreeCommandBuffers(device.device(), device.getCommandPool(), 1, &upload.commandBuffer);
+}
+
+void Magnet::EngineBase::Rendering::TextureStreamer::writeDescriptors(uint32_t frameIndex)
+{
+	// This frame slot's previous submission completed, its sets can be rewritten
+	for (auto& texture : textures) {
+		if (texture.writtenVersions[frameIndex] == texture.version) {
+			continue;
+		}
+		VkDescriptorImageInfo imageInfo{ sampler, texture.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+		VKBase::DescriptorWriter(*setLayout, *descriptorPool)
+			.writeImage(0, &imageInfo)
+			.overwrite(texture.descriptorSets[frameIndex]);
+		texture.writtenVersions[frameIndex] = texture.version;
+	}
+}
+
+void Magnet::EngineBase::Rendering::TextureStreamer::releaseRetiredImages(bool all)
+{
+	auto released = std::remove_if(retiredImages.begin(), retiredImages.end(), [this, all](const RetiredImage& retired) {
+		if (!all && retired.releaseFrame > frameCounter) {
+			return false;
+		}
+		vkDestroyImageView(device.device(), retired.view, nullptr);
+		vkDestroyImage(device.device(), retired.image, nullptr);
+		vkFreeMemory(device.device(), retired.memory, nullptr);
+		return true;
+	});
+	retiredImages.erase(released, retiredImages.end());
+}
+
+void Magnet::EngineBase::Rendering::TextureStreamer::printStats() const
+{
+	std::cout << "\nTexture Streaming :" << std::endl;
+	std::cout << "------------------------------" << std::endl;
+	std::cout << "\t- Textures : " << textures.size() << std::endl;
+	std::cout << "\t- Budget : " << settings.memoryBudget / (1024 * 1024) << " MB" << std::endl;
+	std::cout << "\t- Resident : " << residentBytes / (1024 * 1024) << " MB (peak " << stats.peakResidentBytes / (1024 * 1024) << " MB)" << std::endl;
+	std::cout << "\t- Uploads : " << stats.uploads << " (" << stats.bytesUploaded / (1024 * 1024) << " MB)" << std::endl;
+	std::cout << "\t- Evictions : " << stats.evictions << std::endl;
+}
@@ -0,0 +1,145 @@
+#pragma once
+#include "../../Commons.h"
+#include "../../VK/Device.h"
+#include "../../VK/Buffer.h"
+#include "../../VK/Descriptors.h"
+#include "Texture.h"
+
+#include <future>
+
+namespace Magnet {
+	namespace EngineBase {
+		namespace Rendering {
+
+			// Streams the mip levels of textures in and out of VRAM under a memory budget.
+			// The full mip chain of every texture stays in host memory, the GPU only holds the levels from
+			// residentMip down to the smallest one. Textures start with their low mip tail, callers request the
+			// mip they need every frame and higher levels are staged on worker threads, uploaded with their own
+			// fence and swapped in once complete, so the frame never waits on a transfer. When the budget is
+			// exceeded, the least recently requested textures fall back to their tail.
+			// Each texture owns one descriptor set per frame in flight, rewritten when that frame slot is reused.
+			class TextureStreamer {
+			public:
+				using Handle = uint32_t;
+				static constexpr Handle INVALID_HANDLE = ~0u;
+
+				struct Settings {
+					VkDeviceSize memoryBudget = VkDeviceSize(256) << 20;
+					// Levels this size and smaller are the tail, loaded first and never evicted
+					uint32_t tailSize = 64;
+					uint32_t maxUploadsInFlight = 4;
+					uint32_t maxTextures = 1024;
+				};
+
+				struct Stats {
+					uint32_t uploads = 0;
+					uint32_t evictions = 0;
+					VkDeviceSize bytesUploaded = 0;
+					VkDeviceSize peakResidentBytes = 0;
+				};
+
+				// Kept in host memory, any format (KTX2 files or buildMipChain)
+				using Source = MipChain;
+
+				TextureStreamer(VKBase::Device& device, uint32_t frameCount, const Settings& settings);
+				~TextureStreamer();
+
+				TextureStreamer(const TextureStreamer&) = delete;
+				TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+				// Box filtered mip chain of an RGBA8 image
+				static Source buildMipChain(const unsigned char* rgba, uint32_t width, uint32_t height);
+				// Mip whose texels roughly match the pixels covered on screen
+				static uint32_t mipForScreenSize(uint32_t textureSize, float screenSize);
+
+				// Nothing is resident until the next update, the texture samples white meanwhile
+				Handle add(Source&& source);
+				// Keeps the finest mip requested during the frame, also marks the texture as used
+				void request(Handle handle, uint32_t mip);
+
+				// Must be called once per frame after the frame slot's fence was waited on
+				void update(uint32_t frameIndex);
+
+				// Binding 0 is the combined image sampler, compatible with the glTF material set
+				VkDescriptorSet getDescriptorSet(Handle handle, uint32_t frameIndex) const { return textures[handle].descriptorSets[frameIndex]; }
+				VkDescriptorSetLayout getDescriptorSetLayout() const { return setLayout->getDescriptorSetLayout(); }
+				uint32_t getResidentMip(Handle handle) const { return textures[handle].residentMip; }
+				VkDeviceSize getResidentBytes() const { return residentBytes; }
+
+				const Stats& getStats() const { return stats; }
+				void printStats() const;
+
+			private:
+				struct StreamedTexture {
+					Source source;
+					uint32_t mipCount = 0;
+					uint32_t tailMip = 0;
+					// mipCount when nothing is resident yet
+					uint32_t residentMip = 0;
+					uint32_t requestedMip = 0;
+					uint64_t lastRequestFrame = 0;
+					bool uploading = false;
+
+					VkImage image = VK_NULL_HANDLE;
+					VkDeviceMemory memory = VK_NULL_HANDLE;
+					VkImageView view = VK_NULL_HANDLE;
+					VkDeviceSize bytes = 0;
+
+					uint32_t version = 0;
+					std::vector<uint32_t> writtenVersions;
+					std::vector<VkDescriptorSet> descriptorSets;
+				};
+
+				struct Upload {
+					Handle handle = INVALID_HANDLE;
+					uint32_t topMip = 0;
+					bool eviction = false;
+					VkImage image = VK_NULL_HANDLE;
+					VkDeviceMemory memory = VK_NULL_HANDLE;
+					VkDeviceSize bytes = 0;
+					std::unique_ptr<VKBase::Buffer> stagingBuffer;
+					std::vector<VkDeviceSize> levelOffsets;
+					// Filled by a worker, recorded and submitted once ready
+					std::future<void> staged;
+					VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+					VkFence fence = VK_NULL_HANDLE;
+				};
+
+				struct RetiredImage {
+					VkImage image;
+					VkDeviceMemory memory;
+					VkImageView view;
+					uint64_t releaseFrame;
+				};
+
+				VkDeviceSize levelBytes(const StreamedTexture& texture, uint32_t topMip) const;
+				void scheduleUploads();
+				bool evictLeastRecentlyUsed(Handle keep);
+				void startUpload(Handle handle, uint32_t topMip, bool eviction);
+				void submitUpload(Upload& upload);
+				void completeUpload(Upload& upload);
+				void writeDescriptors(uint32_t frameIndex);
+				void releaseRetiredImages(bool all);
+
+				VKBase::Device& device;
+				Settings settings;
+				uint32_t frameCount;
+				uint64_t frameCounter = 0;
+
+				std::vector<StreamedTexture> textures;
+				std::vector<std::unique_ptr<Upload>> uploads;
+				std::vector<RetiredImage> retiredImages;
+				// Resident and in flight levels, what the budget is checked against
+				VkDeviceSize committedBytes = 0;
+				VkDeviceSize residentBytes = 0;
+
+				Texture2D fallbackTexture;
+				VkSampler sampler = VK_NULL_HANDLE;
+				std::unique_ptr<VKBase::DescriptorSetLayout> setLayout;
+				std::unique_ptr<VKBase::DescriptorPool> descriptorPool;
+
+				Stats stats{};
+			};
+		}
+	}
+}
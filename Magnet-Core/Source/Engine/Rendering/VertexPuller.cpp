@@ -0,0 +1,123 @@
+#include "VertexPuller.h"
+
+Magnet::EngineBase::Rendering::VertexPuller::VertexPuller(VKBase::Device& device, uint32_t frameCount) : device{ device }, frameCount{ frameCount }
+{
+	if (!device.capabilities().bufferDeviceAddress) {
+		throw std::runtime_error("failed to create vertex puller, buffer device address unsupported!");
+	}
+	indirect = device.features.multiDrawIndirect == VK_TRUE && device.features.drawIndirectFirstInstance == VK_TRUE;
+	reserve(256);
+}
+
+void Magnet::EngineBase::Rendering::VertexPuller::reserve(uint32_t drawCount)
+{
+	if (drawBuffer && drawBuffer->getInstanceSize() >= drawCount * sizeof(DrawData)) {
+		return;
+	}
+	uint32_t capacity = drawBuffer ? static_cast<uint32_t>(drawBuffer->getInstanceSize() / sizeof(DrawData)) : 0;
+	while (capacity < drawCount) {
+		capacity = std::max(capacity * 2, 256u);
+	}
+	if (drawBuffer) {
+		vkDeviceWaitIdle(device.device());
+	}
+
+	// Addresses of the draw data are read as std430 structs, 16 byte aligned
+	drawBuffer = std::make_unique<VKBase::Buffer>(
+		device,
+		capacity * sizeof(DrawData),
+		frameCount,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		16);
+	drawBuffer->map();
+	indirectBuffer = std::make_unique<VKBase::Buffer>(
+		device,
+		capacity * sizeof(VkDrawIndexedIndirectCommand),
+		frameCount,
+		VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		sizeof(uint32_t));
+	indirectBuffer->map();
+}
+
+void Magnet::EngineBase::Rendering::VertexPuller::update(const std::vector<DrawInput>& inputs, uint32_t frameIndex)
+{
+	// One index buffer binding per type, so 16-bit draws come first
+	std::vector<const DrawInput*> sorted;
+	sorted.reserve(inputs.size());
+	for (const auto& input : inputs) {
+		if (input.indexCount > 0) {
+			sorted.push_back(&input);
+		}
+	}
+	std::stable_partition(sorted.begin(), sorted.end(), [](const DrawInput* input) { return input->indexType == VK_INDEX_TYPE_UINT16; });
+	reserve(static_cast<uint32_t>(sorted.size()));
+
+	std::vector<DrawData> drawData(sorted.size());
+	commands.resize(sorted.size());
+	commandCount16 = 0;
+	for (uint32_t i = 0; i < sorted.size(); i++) {
+		const DrawInput& input = *sorted[i];
+		drawData[i].modelMatrix = input.modelMatrix;
+		drawData[i].vertices = input.vertices;
+		drawData[i].colors = input.colors;
+		drawData[i].format = static_cast<uint32_t>(input.format);
+		drawData[i].colorStride = input.perVertexColors ? 1 : 0;
+		// The first instance is the draw index, gl_InstanceIndex includes it
+		commands[i] = { input.indexCount, 1, input.firstIndex, input.vertexOffset, i };
+		commandCount16 += input.indexType == VK_INDEX_TYPE_UINT16 ? 1 : 0;
+	}
+	if (!commands.empty()) {
+		drawBuffer->writeToBuffer(drawData.data(), drawData.size() * sizeof(DrawData), frameIndex * drawBuffer->getAlignmentSize());
+		indirectBuffer->writeToBuffer(commands.data(), commands.size() * sizeof(VkDrawIndexedIndirectCommand), frameIndex * indirectBuffer->getAlignmentSize());
+	}
+
+	stats.frames++;
+	stats.draws += commands.size();
+}
+
+void Magnet::EngineBase::Rendering::VertexPuller::draw(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, VkBuffer indexBuffer, uint32_t frameIndex)
+{
+	if (commands.empty()) {
+		return;
+	}
+
+	PullPush push{ device.getBufferAddress(drawBuffer->getBuffer()) + frameIndex * drawBuffer->getAlignmentSize() };
+	vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(PullPush), &push);
+
+	constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+	VkDeviceSize frameOffset = frameIndex * indirectBuffer->getAlignmentSize();
+	uint32_t groups[2][2] = { { 0, commandCount16 }, { commandCount16, static_cast<uint32_t>(commands.size()) } };
+	VkIndexType indexTypes[2] = { VK_INDEX_TYPE_UINT16, VK_INDEX_TYPE_UINT32 };
+	for (uint32_t group = 0; group < 2; group++) {
+		uint32_t first = groups[group][0];
+		uint32_t count = groups[group][1] - first;
+		if (count == 0) {
+			continue;
+		}
+		vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, indexTypes[group]);
+		if (indirect) {
+			vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffer->getBuffer(), frameOffset + VkDeviceSize(first) * stride, count, stride);
+			stats.drawCalls++;
+		}
+		else {
+			for (uint32_t i = first; i < first + count; i++) {
+				const auto& command = commands[i];
+				vkCmdDrawIndexed(commandBuffer, command.indexCount, command.instanceCount, command.firstIndex, command.vertexOffset, command.firstInstance);
+			}
+			stats.drawCalls += count;
+		}
+	}
+}
+
+void Magnet::EngineBase::Rendering::VertexPuller::printStats() const
+{
+	std::cout << "\nVertex Pulling :" << std::endl;
+	std::cout << "------------------------------" << std::endl;
+	std::cout << "\t- Mode : " << (indirect ? "Indexed indirect" : "Direct draws") << std::endl;
+	std::cout << "\t- Frames : " << stats.frames << std::endl;
+	if (stats.frames > 0) {
+		std::cout << "\t- Draws per frame : " << stats.draws / stats.frames << " in " << stats.drawCalls / stats.frames << " calls" << std::endl;
+	}
+}
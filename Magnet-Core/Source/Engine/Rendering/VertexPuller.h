@@ -0,0 +1,95 @@
+#pragma once
+#include "../../Commons.h"
+#include "../../VK/Device.h"
+#include "../../VK/Buffer.h"
+
+namespace Magnet {
+	namespace EngineBase {
+		namespace Rendering {
+
+			// Batches draws for the vertex pulling pipelines, which have no vertex input : shader.vert built with
+			// VERTEX_PULLING fetches each vertex through the buffer device address of its draw, so draws of any vertex
+			// format and buffer share one pipeline and are recorded as a single indexed indirect call per index type.
+			//  - per draw data (model matrix, vertex and color addresses, format) is read at gl_InstanceIndex, the
+			//    commands carry the draw index as their first instance
+			//  - the address of the frame's draw data is the only push constant
+			// Without multiDrawIndirect or drawIndirectFirstInstance the same commands are issued as direct draws.
+			// Draw data and commands are per frame in flight. Requires the bufferDeviceAddress capability.
+			class VertexPuller {
+			public:
+				// Must match shader.vert
+				enum class VertexFormat : uint32_t {
+					// Assets::PackedVertex, 16 bytes, positions quantized in the mesh box
+					Packed = 0,
+					// Assets::MeshFile::Vertex, 44 bytes of floats with the color inline
+					Float = 1,
+				};
+
+				// One primitive. Indices are read from the index buffer given to draw, vertexOffset is added to them
+				// before the vertex is fetched from vertices. Colors are RGBA8, one per vertex or a single entry
+				struct DrawInput {
+					glm::mat4 modelMatrix{ 1.f };
+					VkDeviceAddress vertices = 0;
+					VkDeviceAddress colors = 0;
+					VertexFormat format = VertexFormat::Packed;
+					bool perVertexColors = true;
+					uint32_t firstIndex = 0;
+					uint32_t indexCount = 0;
+					int32_t vertexOffset = 0;
+					VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+				};
+
+				struct Stats {
+					uint32_t frames = 0;
+					uint64_t draws = 0;
+					uint64_t drawCalls = 0;
+				};
+
+				VertexPuller(VKBase::Device& device, uint32_t frameCount);
+
+				VertexPuller(const VertexPuller&) = delete;
+				VertexPuller& operator=(const VertexPuller&) = delete;
+
+				// Draws of this frame, grows the per frame buffers when needed
+				void update(const std::vector<DrawInput>& draws, uint32_t frameIndex);
+				// With a pulling pipeline bound, pushes the draw data address to pipelineLayout's vertex stage
+				void draw(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, VkBuffer indexBuffer, uint32_t frameIndex);
+
+				bool usesIndirect() const { return indirect; }
+				const Stats& getStats() const { return stats; }
+				void printStats() const;
+
+			private:
+				// std430 layout, matches DrawData in shader.vert
+				struct DrawData {
+					glm::mat4 modelMatrix{ 1.f };
+					VkDeviceAddress vertices = 0;
+					VkDeviceAddress colors = 0;
+					uint32_t format = 0;
+					uint32_t colorStride = 0;
+					uint32_t padding[2]{};
+				};
+
+				struct PullPush {
+					VkDeviceAddress draws;
+				};
+
+				// Reallocates the per frame draw data and commands to hold at least drawCount draws
+				void reserve(uint32_t drawCount);
+
+				VKBase::Device& device;
+				uint32_t frameCount;
+				bool indirect;
+				Stats stats{};
+
+				// Commands of the frame grouped by index type, 16-bit first
+				std::vector<VkDrawIndexedIndirectCommand> commands;
+				uint32_t commandCount16 = 0;
+
+				// Host visible, one instance per frame in flight
+				std::unique_ptr<VKBase::Buffer> drawBuffer;
+				std::unique_ptr<VKBase::Buffer> indirectBuffer;
+			};
+		}
+	}
+}
@@ -0,0 +1,259 @@
+#include "VisibilityBuffer.h"
+
+Magnet::EngineBase::Rendering::VisibilityBuffer::VisibilityBuffer(
+	VKBase::Device& device,
+	const Shaders& shaders,
+	const std::vector<VkVertexInputBindingDescription>& bindingDescriptions,
+	const std::vector<VkVertexInputAttributeDescription>& positionAttribute,
+	std::vector<VkDescriptorSetLayout> resolveSetLayouts,
+	VkFormat colorFormat,
+	VkFormat depthFormat,
+	uint32_t frameCount) : device{ device }
+{
+	assert(device.capabilities().dynamicRendering && "Visibility buffer requires VK_KHR_dynamic_rendering");
+
+	createDescriptors(frameCount);
+	createPipelines(shaders, bindingDescriptions, positionAttribute, resolveSetLayouts, colorFormat, depthFormat);
+}
+
+Magnet::EngineBase::Rendering::VisibilityBuffer::~VisibilityBuffer()
+{
+	visibilityPipeline.reset();
+	resolvePipeline.reset();
+	vkDestroyPipelineLayout(device.device(), visibilityPipelineLayout, nullptr);
+	vkDestroyPipelineLayout(device.device(), resolvePipelineLayout, nullptr);
+	vkDestroySampler(device.device(), sampler, nullptr);
+}
+
+void Magnet::EngineBase::Rendering::VisibilityBuffer::createDescriptors(uint32_t frameCount)
+{
+	paramsBuffer = std::make_unique<VKBase::Buffer>(
+		device,
+		sizeof(ResolveParams),
+		frameCount,
+		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		device.properties.limits.minUniformBufferOffsetAlignment);
+	paramsBuffer->map();
+
+	// Sized for every draw ID the encoding can hold, never reallocated
+	drawBuffer = std::make_unique<VKBase::Buffer>(
+		device,
+		sizeof(DrawRecord),
+		MAX_DRAWS,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	drawBuffer->map();
+
+	// IDs are fetched per texel, never filtered
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+	if (vkCreateSampler(device.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create visibility buffer sampler!");
+	}
+
+	setLayout = VKBase::DescriptorSetLayout::Builder(device)
+		.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_FRAGMENT_BIT)
+		.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+		.addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+		.addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+		.addBinding(4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+		.addBinding(5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+		.build();
+
+	descriptorPool = VKBase::DescriptorPool::Builder(device)
+		.setMaxSets(1)
+		.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1)
+		.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4)
+		.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1)
+		.build();
+
+	auto paramsInfo = paramsBuffer->descriptorInfo(sizeof(ResolveParams), 0);
+	auto drawInfo = drawBuffer->descriptorInfo();
+
+	bool built = VKBase::DescriptorWriter(*setLayout, *descriptorPool)
+		.writeBuffer(0, &paramsInfo)
+		.writeBuffer(1, &drawInfo)
+		.build(descriptorSet);
+	if (!built) {
+		throw std::runtime_error("failed to allocate visibility buffer descriptor set!");
+	}
+}
+
+void Magnet::EngineBase::Rendering::VisibilityBuffer::createPipelines(
+	const Shaders& shaders,
+	const std::vector<VkVertexInputBindingDescription>& bindingDescriptions,
+	const std::vector<VkVertexInputAttributeDescription>& positionAttribute,
+	std::vector<VkDescriptorSetLayout> resolveSetLayouts,
+	VkFormat colorFormat,
+	VkFormat depthFormat)
+{
+	// Visibility pass : positions only, the draw ID rides along with the transform
+	VkPushConstantRange pushConstantRange{ VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(VisibilityPush) };
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &visibilityPipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create visibility pipeline layout!");
+	}
+
+	VKBase::Pipeline::defaultPipelineConfigInfo(visibilityConfig);
+	visibilityConfig.bindingDescriptions = bindingDescriptions;
+	visibilityConfig.attributeDescriptions = positionAttribute;
+	visibilityConfig.colorAttachmentFormats = { FORMAT };
+	visibilityConfig.depthAttachmentFormat = depthFormat;
+	visibilityConfig.pipelineLayout = visibilityPipelineLayout;
+	visibilityPipeline = std::make_unique<VKBase::Pipeline>(device, shaders.visibilityVert, shaders.visibilityFrag, visibilityConfig);
+
+	// Resolve pass : fullscreen triangle, shares the lighting and shadow sets of the forward layout
+	assert(resolveSetLayouts.size() > 1 && "Resolve set layouts must contain the forward sets");
+	resolveSetLayouts[1] = setLayout->getDescriptorSetLayout();
+
+	pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(resolveSetLayouts.size());
+	pipelineLayoutInfo.pSetLayouts = resolveSetLayouts.data();
+	pipelineLayoutInfo.pushConstantRangeCount = 0;
+	pipelineLayoutInfo.pPushConstantRanges = nullptr;
+
+	if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &resolvePipelineLayout) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create visibility resolve pipeline layout!");
+	}
+
+	VKBase::Pipeline::defaultPipelineConfigInfo(resolveConfig);
+	resolveConfig.bindingDescriptions = {};
+	resolveConfig.attributeDescriptions = {};
+	resolveConfig.depthStencilInfo.depthTestEnable = VK_FALSE;
+	resolveConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+	resolveConfig.colorAttachmentFormats = { colorFormat };
+	resolveConfig.pipelineLayout = resolvePipelineLayout;
+	resolvePipeline = std::make_unique<VKBase::Pipeline>(device, shaders.resolveVert, shaders.resolveFrag, resolveConfig);
+}
+
+void Magnet::EngineBase::Rendering::VisibilityBuffer::writeDescriptors()
+{
+	VKBase::DescriptorWriter writer{ *setLayout, *descriptorPool };
+
+	VkDescriptorBufferInfo vertexInfo{ geometry.vertexBuffer, 0, VK_WHOLE_SIZE };
+	VkDescriptorBufferInfo indexInfo{ geometry.indexBuffer, 0, VK_WHOLE_SIZE };
+	VkDescriptorBufferInfo colorInfo{ geometry.colorBuffer, 0, VK_WHOLE_SIZE };
+	if (geometry.vertexBuffer != VK_NULL_HANDLE && geometry.indexBuffer != VK_NULL_HANDLE && geometry.colorBuffer != VK_NULL_HANDLE) {
+		writer.writeBuffer(2, &vertexInfo).writeBuffer(3, &indexInfo).writeBuffer(5, &colorInfo);
+	}
+
+	VkDescriptorImageInfo imageInfo{ sampler, visibilityImageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+	if (visibilityImageView != VK_NULL_HANDLE) {
+		writer.writeImage(4, &imageInfo);
+	}
+
+	writer.overwrite(descriptorSet);
+}
+
+void Magnet::EngineBase::Rendering::VisibilityBuffer::setGeometry(const Geometry& geometry, const std::vector<DrawInput>& inputs)
+{
+	vkDeviceWaitIdle(device.device());
+
+	// gl_PrimitiveID restarts with every draw, large ranges become several draws
+	draws.clear();
+	for (const auto& input : inputs) {
+		for (uint32_t first = 0; first < input.indexCount; first += MAX_TRIANGLES_PER_DRAW * 3) {
+			DrawRecord record{};
+			record.modelMatrix = input.modelMatrix;
+			record.firstIndex = input.firstIndex + first;
+			record.indexCount = std::min(input.indexCount - first, MAX_TRIANGLES_PER_DRAW * 3);
+			record.colorStride = geometry.perVertexColors ? 1 : 0;
+			record.vertexOffset = input.vertexOffset;
+			record.index16 = input.indexType == VK_INDEX_TYPE_UINT16 ? 1 : 0;
+			record.indexOffset = record.index16 ? 0 : static_cast<uint32_t>(geometry.indexOffset32 / sizeof(uint32_t));
+			draws.push_back(record);
+		}
+	}
+	// Draw IDs are only looked up, grouping the pools binds each once
+	std::stable_partition(draws.begin(), draws.end(), [](const DrawRecord& draw) { return draw.index16 != 0; });
+	if (draws.size() > MAX_DRAWS) {
+		throw std::runtime_error("failed to set visibility buffer geometry, too many draws!");
+	}
+	if (!draws.empty()) {
+		drawBuffer->writeToBuffer(draws.data(), draws.size() * sizeof(DrawRecord));
+	}
+
+	this->geometry = geometry;
+	writeDescriptors();
+}
+
+void Magnet::EngineBase::Rendering::VisibilityBuffer::setVisibilityImage(VkImageView imageView)
+{
+	visibilityImageView = imageView;
+	writeDescriptors();
+}
+
+void Magnet::EngineBase::Rendering::VisibilityBuffer::update(const glm::mat4& viewProjection, VkExtent2D extent, glm::vec4 ambientLight, uint32_t frameIndex)
+{
+	this->viewProjection = viewProjection;
+
+	ResolveParams params{};
+	params.viewProjection = viewProjection;
+	params.screenSize = glm::vec4(
+		static_cast<float>(extent.width),
+		static_cast<float>(extent.height),
+		1.0f / static_cast<float>(extent.width),
+		1.0f / static_cast<float>(extent.height));
+	params.ambientLight = ambientLight;
+	paramsBuffer->writeToIndex(&params, frameIndex);
+}
+
+void Magnet::EngineBase::Rendering::VisibilityBuffer::drawVisibility(VkCommandBuffer commandBuffer, VkExtent2D extent)
+{
+	if (draws.empty()) {
+		return;
+	}
+
+	visibilityPipeline->bind(commandBuffer);
+	VkViewport viewport{ 0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f };
+	VkRect2D scissor{ { 0, 0 }, extent };
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+	VkDeviceSize offsets[1] = { 0 };
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &geometry.vertexBuffer, offsets);
+
+	for (uint32_t i = 0; i < draws.size(); i++) {
+		if (i == 0 || draws[i].index16 != draws[i - 1].index16) {
+			if (draws[i].index16) {
+				vkCmdBindIndexBuffer(commandBuffer, geometry.indexBuffer, 0, VK_INDEX_TYPE_UINT16);
+			}
+			else {
+				vkCmdBindIndexBuffer(commandBuffer, geometry.indexBuffer, geometry.indexOffset32, VK_INDEX_TYPE_UINT32);
+			}
+		}
+		VisibilityPush push{ viewProjection * draws[i].modelMatrix, i };
+		vkCmdPushConstants(commandBuffer, visibilityPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(VisibilityPush), &push);
+		vkCmdDrawIndexed(commandBuffer, draws[i].indexCount, 1, draws[i].firstIndex, draws[i].vertexOffset, 0);
+	}
+}
+
+void Magnet::EngineBase::Rendering::VisibilityBuffer::resolve(VkCommandBuffer commandBuffer, VkExtent2D extent, uint32_t frameIndex)
+{
+	// Geometry descriptors are only written once there is something to resolve
+	if (draws.empty() || visibilityImageView == VK_NULL_HANDLE) {
+		return;
+	}
+
+	resolvePipeline->bind(commandBuffer);
+	VkViewport viewport{ 0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f };
+	VkRect2D scissor{ { 0, 0 }, extent };
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+	uint32_t dynamicOffset = static_cast<uint32_t>(frameIndex * paramsBuffer->getAlignmentSize());
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, resolvePipelineLayout, 1, 1, &descriptorSet, 1, &dynamicOffset);
+	vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+}
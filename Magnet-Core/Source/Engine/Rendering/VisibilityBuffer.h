@@ -0,0 +1,144 @@
+#pragma once
+#include "../../Commons.h"
+#include "../../VK/Device.h"
+#include "../../VK/Buffer.h"
+#include "../../VK/Descriptors.h"
+#include "../../VK/Pipeline.h"
+
+namespace Magnet {
+	namespace EngineBase {
+		namespace Rendering {
+
+			// Visibility buffer rendering : a thin pass rasterizes positions only and writes a 32-bit
+			// (draw ID, triangle ID) per pixel, a fullscreen resolve pass then fetches the triangle from the
+			// global vertex and index buffers, rebuilds its attributes with perspective correct barycentrics
+			// and shades exactly once per pixel, whatever the overdraw of the scene.
+			class VisibilityBuffer {
+			public:
+				static constexpr VkFormat FORMAT = VK_FORMAT_R32_UINT;
+				// Must match visibility.frag and visibility_resolve.frag
+				static constexpr uint32_t TRIANGLE_BITS = 20;
+				static constexpr uint32_t MAX_TRIANGLES_PER_DRAW = 1u << TRIANGLE_BITS;
+				// The all ones ID is the cleared value
+				static constexpr uint32_t MAX_DRAWS = (1u << (32 - TRIANGLE_BITS)) - 1;
+				static constexpr uint32_t EMPTY = 0xFFFFFFFFu;
+
+				// A range of one pool of the global index buffer drawn with one model matrix
+				struct DrawInput {
+					glm::mat4 modelMatrix{ 1.f };
+					uint32_t firstIndex = 0;
+					uint32_t indexCount = 0;
+					int32_t vertexOffset = 0;
+					VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+				};
+
+				// Global buffers of the scene, bound as storage buffers for the resolve. Vertices are PackedVertex, colors
+				// RGBA8 and either one per vertex or a single entry for the whole scene, indices a 16-bit pool followed by
+				// a 32-bit pool at indexOffset32
+				struct Geometry {
+					VkBuffer vertexBuffer = VK_NULL_HANDLE;
+					VkBuffer colorBuffer = VK_NULL_HANDLE;
+					bool perVertexColors = false;
+					VkBuffer indexBuffer = VK_NULL_HANDLE;
+					VkDeviceSize indexOffset32 = 0;
+				};
+
+				struct Shaders {
+					std::string visibilityVert;
+					std::string visibilityFrag;
+					std::string resolveVert;
+					std::string resolveFrag;
+				};
+
+				// resolveSetLayouts are the sets of the forward pipeline layout, set 1 is replaced by the visibility inputs
+				VisibilityBuffer(
+					VKBase::Device& device,
+					const Shaders& shaders,
+					const std::vector<VkVertexInputBindingDescription>& bindingDescriptions,
+					const std::vector<VkVertexInputAttributeDescription>& positionAttribute,
+					std::vector<VkDescriptorSetLayout> resolveSetLayouts,
+					VkFormat colorFormat,
+					VkFormat depthFormat,
+					uint32_t frameCount);
+				~VisibilityBuffer();
+
+				VisibilityBuffer(const VisibilityBuffer&) = delete;
+				VisibilityBuffer& operator=(const VisibilityBuffer&) = delete;
+
+				// Waits for the device, splits draws larger than MAX_TRIANGLES_PER_DRAW
+				void setGeometry(const Geometry& geometry, const std::vector<DrawInput>& draws);
+				// The visibility image is a render graph transient, rebound whenever the graph is compiled
+				void setVisibilityImage(VkImageView imageView);
+
+				void update(const glm::mat4& viewProjection, VkExtent2D extent, glm::vec4 ambientLight, uint32_t frameIndex);
+
+				// Both must be recorded inside a dynamic rendering pass, the resolve pass binds set 1 only
+				void drawVisibility(VkCommandBuffer commandBuffer, VkExtent2D extent);
+				void resolve(VkCommandBuffer commandBuffer, VkExtent2D extent, uint32_t frameIndex);
+
+				VkPipelineLayout getResolvePipelineLayout() const { return resolvePipelineLayout; }
+				uint32_t getDrawCount() const { return static_cast<uint32_t>(draws.size()); }
+
+			private:
+				// std430 layout, matches DrawRecord in visibility_resolve.frag
+				struct DrawRecord {
+					glm::mat4 modelMatrix{ 1.f };
+					uint32_t firstIndex = 0;
+					uint32_t indexCount = 0;
+					// 0 when every vertex reads the first color
+					uint32_t colorStride = 0;
+					int32_t vertexOffset = 0;
+					// First 32-bit word of the draw's index pool
+					uint32_t indexOffset = 0;
+					uint32_t index16 = 0;
+					uint32_t padding[2]{};
+				};
+
+				// std140 layout, matches ResolveParams in visibility_resolve.frag
+				struct ResolveParams {
+					glm::mat4 viewProjection{ 1.f };
+					glm::vec4 screenSize{ 0.f };   // zw is 1 / size
+					glm::vec4 ambientLight{ 0.f }; // w is intensity
+				};
+
+				struct VisibilityPush {
+					glm::mat4 modelViewProjection;
+					uint32_t drawID;
+				};
+
+				void createDescriptors(uint32_t frameCount);
+				void createPipelines(
+					const Shaders& shaders,
+					const std::vector<VkVertexInputBindingDescription>& bindingDescriptions,
+					const std::vector<VkVertexInputAttributeDescription>& positionAttribute,
+					std::vector<VkDescriptorSetLayout> resolveSetLayouts,
+					VkFormat colorFormat,
+					VkFormat depthFormat);
+				void writeDescriptors();
+
+				VKBase::Device& device;
+
+				std::vector<DrawRecord> draws;
+				glm::mat4 viewProjection{ 1.f };
+				Geometry geometry{};
+				VkImageView visibilityImageView = VK_NULL_HANDLE;
+
+				std::unique_ptr<VKBase::Buffer> paramsBuffer;
+				std::unique_ptr<VKBase::Buffer> drawBuffer;
+				VkSampler sampler = VK_NULL_HANDLE;
+
+				std::unique_ptr<VKBase::DescriptorSetLayout> setLayout;
+				std::unique_ptr<VKBase::DescriptorPool> descriptorPool;
+				VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+				VkPipelineLayout visibilityPipelineLayout = VK_NULL_HANDLE;
+				VKBase::PipelineConfigInfo visibilityConfig{};
+				std::unique_ptr<VKBase::Pipeline> visibilityPipeline;
+
+				VkPipelineLayout resolvePipelineLayout = VK_NULL_HANDLE;
+				VKBase::PipelineConfigInfo resolveConfig{};
+				std::unique_ptr<VKBase::Pipeline> resolvePipeline;
+			};
+		}
+	}
+}
@@ -10,6 +10,11 @@ Magnet::Renderer::Renderer(Window& window, VKBase::Device& device) : window{ win
 Magnet::Renderer::~Renderer()
 {
 	freeCommandBuffers();
+	if (pipelineRegistry) {
+		pipelineRegistry->printStats();
+		pipelineRegistry.reset();
+	}
+	vkDestroyPipelineCache(device.device(), pipelineCache, nullptr);
 }
 
 void Magnet::Renderer::createPipelineCache()
@@ -19,6 +24,7 @@ void Magnet::Renderer::createPipelineCache()
     if (vkCreatePipelineCache(device.device(), &pipelineCacheCreateInfo, nullptr, &pipelineCache) != VK_SUCCESS) {
         throw std::runtime_error("Failed to");
     }
+    pipelineRegistry = std::make_unique<VKBase::PipelineRegistry>(device, pipelineCache);
 }
 
 void Magnet::Renderer::createCommandBuffers()
@@ -5,6 +5,7 @@
 
 #include "VK/Device.h"
 #include "VK/Swapchain.h"
+#include "VK/PipelineRegistry.h"
 
 
 namespace Magnet {
@@ -21,6 +22,13 @@ namespace Magnet {
 		
 		void createPipelineCache();
 
+		VkCommandBuffer getCommandBuffer(int frameIndex) const { return commandBuffers[frameIndex]; }
+
+		VKBase::PipelineRegistry& getPipelineRegistry() {
+			assert(pipelineRegistry && "Cannot get pipeline registry before the pipeline cache is created");
+			return *pipelineRegistry;
+		}
+
 	private:
 		void createCommandBuffers();
 		void freeCommandBuffers();
@@ -32,6 +40,7 @@ namespace Magnet {
 		std::vector<VkCommandBuffer> commandBuffers;
 
 		VkPipelineCache pipelineCache{ VK_NULL_HANDLE };
+		std::unique_ptr<VKBase::PipelineRegistry> pipelineRegistry;
 
 		uint32_t currentImageIndex;
 		int currentFrameIndex{ 0 };
@@ -0,0 +1,8 @@
+// Single translation unit holding the implementations of the header only libraries
+#define TINYGLTF_IMPLEMENTATION
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <tinygltf/tiny_gltf.h>
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tinyObjLoader/tiny_obj_loader.h>
@@ -35,7 +35,7 @@ namespace Magnet {
             void* getMappedMemory() const { return mapped; }
             uint32_t getInstanceCount() const { return instanceCount; }
             VkDeviceSize getInstanceSize() const { return instanceSize; }
-            VkDeviceSize getAlignmentSize() const { return instanceSize; }
+            VkDeviceSize getAlignmentSize() const { return alignmentSize; }
             VkBufferUsageFlags getUsageFlags() const { return usageFlags; }
             VkMemoryPropertyFlags getMemoryPropertyFlags() const { return memoryPropertyFlags; }
             VkDeviceSize getBufferSize() const { return bufferSize; }
@@ -172,6 +172,23 @@ namespace Magnet {
             return *this;
         }
 
+        DescriptorWriter& DescriptorWriter::writeImages(uint32_t binding, VkDescriptorImageInfo* imageInfos)
+        {
+            assert(setLayout.bindings.count(binding) == 1 && "Layout does not contain specified binding");
+
+            auto& bindingDescription = setLayout.bindings[binding];
+
+            VkWriteDescriptorSet write{};
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.descriptorType = bindingDescription.descriptorType;
+            write.dstBinding = binding;
+            write.pImageInfo = imageInfos;
+            write.descriptorCount = bindingDescription.descriptorCount;
+
+            writes.push_back(write);
+            return *this;
+        }
+
         bool DescriptorWriter::build(VkDescriptorSet& set)
         {
             bool success = pool.allocateDescriptor(setLayout.getDescriptorSetLayout(), set);
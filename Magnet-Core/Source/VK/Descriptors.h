@@ -84,6 +84,8 @@ namespace Magnet {
 
             DescriptorWriter& writeBuffer(uint32_t binding, VkDescriptorBufferInfo* bufferInfo);
             DescriptorWriter& writeImage(uint32_t binding, VkDescriptorImageInfo* imageInfo);
+            // Fills an array binding, imageInfos must hold the binding's descriptor count
+            DescriptorWriter& writeImages(uint32_t binding, VkDescriptorImageInfo* imageInfos);
 
             bool build(VkDescriptorSet& set);
             void overwrite(VkDescriptorSet& set);
@@ -82,6 +82,91 @@ VkFormat Magnet::VKBase::Device::findSupportedFormat(const std::vector<VkFormat>
     throw std::runtime_error("failed to find supported format!");
 }
 
+void Magnet::VKBase::Device::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory)
+{
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create buffer!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+
+    VkMemoryAllocateFlagsInfo allocFlagsInfo{};
+    allocFlagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+    allocFlagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
+    if (usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) {
+        allocInfo.pNext = &allocFlagsInfo;
+    }
+
+    if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate buffer memory!");
+    }
+
+    vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+}
+
+VkDeviceAddress Magnet::VKBase::Device::getBufferAddress(VkBuffer buffer)
+{
+    VkBufferDeviceAddressInfo addressInfo{};
+    addressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+    addressInfo.buffer = buffer;
+    return functions_.vkGetBufferDeviceAddressKHR(device_, &addressInfo);
+}
+
+VkCommandBuffer Magnet::VKBase::Device::beginSingleTimeCommands()
+{
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = commandPool;
+    allocInfo.commandBufferCount = 1;
+
+    VkCommandBuffer commandBuffer;
+    if (vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate single time command buffer!");
+    }
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    return commandBuffer;
+}
+
+void Magnet::VKBase::Device::endSingleTimeCommands(VkCommandBuffer commandBuffer)
+{
+    vkEndCommandBuffer(commandBuffer);
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+
+    if (vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit single time command buffer!");
+    }
+    vkQueueWaitIdle(graphicsQueue_);
+    vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
+}
+
+VkFormatProperties Magnet::VKBase::Device::getFormatProperties(VkFormat format)
+{
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &formatProperties);
+    return formatProperties;
+}
+
 void Magnet::VKBase::Device::createImageWithInfo(const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory)
 {
     if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
@@ -168,6 +253,7 @@ void Magnet::VKBase::Device::createInstance()
     createInfo.ppEnabledExtensionNames = usedInstanceExtensions.data();
 
     VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo;
+    createInfo.pNext = nullptr;
     if (enableValidationLayers) {
 
         uint32_t instanceLayerCount = 0;
@@ -204,17 +290,32 @@ void Magnet::VKBase::Device::createInstance()
         }
         std::cout << "\n";
 
-        createInfo.enabledLayerCount = static_cast<uint32_t>(usedValidationLayers.size());
-        createInfo.ppEnabledLayerNames = usedValidationLayers.data();
-
         populateDebugMessengerCreateInfo(debugCreateInfo);
         createInfo.pNext = (VkDebugUtilsMessengerCreateInfoEXT*)&debugCreateInfo;
     }
-    else {
-        createInfo.enabledLayerCount = 0;
-        createInfo.pNext = nullptr;
+
+    // Optional layers are enabled when present, e.g. the shader object emulation layer
+    // which passes through on drivers supporting VK_EXT_shader_object natively
+    {
+        uint32_t instanceLayerCount = 0;
+        vkEnumerateInstanceLayerProperties(&instanceLayerCount, nullptr);
+        std::vector<VkLayerProperties> layers(instanceLayerCount);
+        vkEnumerateInstanceLayerProperties(&instanceLayerCount, layers.data());
+
+        for (const auto& optional : getOptionalInstanceLayers()) {
+            for (const auto& layer : layers) {
+                if (strcmp(optional, layer.layerName) == 0) {
+                    std::cout << "Optional layer enabled : " << optional << std::endl;
+                    usedValidationLayers.push_back(optional);
+                    break;
+                }
+            }
+        }
     }
 
+    createInfo.enabledLayerCount = static_cast<uint32_t>(usedValidationLayers.size());
+    createInfo.ppEnabledLayerNames = usedValidationLayers.data();
+
     if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS) {
         throw std::runtime_error("failed to create instance!");
     }
@@ -315,6 +416,7 @@ void Magnet::VKBase::Device::pickPhysicalDevice()
         throw std::runtime_error("Failed to find a suitable GPU!");
     }
     vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    vkGetPhysicalDeviceFeatures(physicalDevice, &features);
     std::cout << "Chosen device : \n" << std::endl;
     std::cout << "\t" << properties.deviceName<<"\n\n";
 }
@@ -338,8 +440,26 @@ void Magnet::VKBase::Device::createLogicalDevice()
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    enableOptionalExtensions();
+
     VkPhysicalDeviceFeatures deviceFeatures = {};
     deviceFeatures.samplerAnisotropy = VK_TRUE;
+    // Needed for wireframe pipelines, optional
+    deviceFeatures.fillModeNonSolid = features.fillModeNonSolid;
+    // gl_PrimitiveID in fragment shaders (visibility buffer), optional
+    deviceFeatures.geometryShader = features.geometryShader;
+    // Compute mipmap generation on formats without linear blits, optional
+    deviceFeatures.shaderStorageImageReadWithoutFormat = features.shaderStorageImageReadWithoutFormat;
+    deviceFeatures.shaderStorageImageWriteWithoutFormat = features.shaderStorageImageWriteWithoutFormat;
+    deviceFeatures.shaderStorageImageArrayDynamicIndexing = features.shaderStorageImageArrayDynamicIndexing;
+    // Block compressed textures (KTX2), optional
+    deviceFeatures.textureCompressionBC = features.textureCompressionBC;
+    deviceFeatures.textureCompressionASTC_LDR = features.textureCompressionASTC_LDR;
+    deviceFeatures.textureCompressionETC2 = features.textureCompressionETC2;
+    // One indirect call for every meshlet draw of the compute culled fallback, optional
+    deviceFeatures.multiDrawIndirect = features.multiDrawIndirect;
+    // Draw index in the first instance of indirect commands (vertex pulling), optional
+    deviceFeatures.drawIndirectFirstInstance = features.drawIndirectFirstInstance;
 
     VkDeviceCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -348,6 +468,7 @@ void Magnet::VKBase::Device::createLogicalDevice()
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
     createInfo.pEnabledFeatures = &deviceFeatures;
+    createInfo.pNext = queryOptionalFeatures();
     createInfo.enabledExtensionCount = static_cast<uint32_t>(usedDeviceExtensions.size());
     createInfo.ppEnabledExtensionNames = usedDeviceExtensions.data();
 
@@ -367,6 +488,187 @@ void Magnet::VKBase::Device::createLogicalDevice()
 
     vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
     vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+
+    loadExtensionFunctions();
+}
+
+void Magnet::VKBase::Device::enableOptionalExtensions()
+{
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+
+    std::unordered_set<std::string> available;
+    for (const auto& extension : availableExtensions) {
+        available.insert(extension.extensionName);
+    }
+
+    for (const char* used : usedDeviceExtensions) {
+        enabledDeviceExtensions.insert(used);
+    }
+
+    std::cout << "\nOptional Device Extensions :" << std::endl;
+    std::cout << "------------------------------" << std::endl;
+    for (const auto& optional : getDeviceOptionalExtensions()) {
+        bool supported = available.find(optional) != available.end();
+        // VK_EXT_shader_object depends on VK_KHR_dynamic_rendering
+        if (std::strcmp(optional, VK_EXT_SHADER_OBJECT_EXTENSION_NAME) == 0) {
+            supported = supported && available.find(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME) != available.end();
+        }
+        std::cout << "\t" << optional << (supported ? " : enabled" : " : unavailable") << std::endl;
+        if (supported && enabledDeviceExtensions.insert(optional).second) {
+            usedDeviceExtensions.push_back(optional);
+        }
+    }
+    std::cout << "\n";
+}
+
+void* Magnet::VKBase::Device::queryOptionalFeatures()
+{
+    void* chain = nullptr;
+    auto link = [&chain](auto& features, VkStructureType type) {
+        features = {};
+        features.sType = type;
+        features.pNext = chain;
+        chain = &features;
+    };
+
+    if (isExtensionEnabled(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME)) {
+        link(extendedDynamicStateFeatures, VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT);
+    }
+    if (isExtensionEnabled(VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME)) {
+        link(extendedDynamicState2Features, VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_2_FEATURES_EXT);
+    }
+    if (isExtensionEnabled(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME)) {
+        link(extendedDynamicState3Features, VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT);
+    }
+    if (isExtensionEnabled(VK_EXT_SHADER_OBJECT_EXTENSION_NAME)) {
+        link(shaderObjectFeatures, VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_OBJECT_FEATURES_EXT);
+    }
+    if (isExtensionEnabled(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME)) {
+        link(graphicsPipelineLibraryFeatures, VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT);
+    }
+    if (isExtensionEnabled(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)) {
+        link(dynamicRenderingFeatures, VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR);
+    }
+    if (isExtensionEnabled(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME)) {
+        link(synchronization2Features, VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR);
+    }
+    if (isExtensionEnabled(VK_EXT_MESH_SHADER_EXTENSION_NAME)) {
+        link(meshShaderFeatures, VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT);
+    }
+    if (isExtensionEnabled(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME)) {
+        link(bufferDeviceAddressFeatures, VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES_KHR);
+    }
+
+    if (chain == nullptr) {
+        return nullptr;
+    }
+
+    VkPhysicalDeviceFeatures2 features2{};
+    features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features2.pNext = chain;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+
+    capabilities_.extendedDynamicState = extendedDynamicStateFeatures.extendedDynamicState == VK_TRUE;
+    capabilities_.extendedDynamicState2 = extendedDynamicState2Features.extendedDynamicState2 == VK_TRUE;
+    capabilities_.dynamicPolygonMode = extendedDynamicState3Features.extendedDynamicState3PolygonMode == VK_TRUE;
+    capabilities_.graphicsPipelineLibrary = graphicsPipelineLibraryFeatures.graphicsPipelineLibrary == VK_TRUE;
+    capabilities_.dynamicRendering = dynamicRenderingFeatures.dynamicRendering == VK_TRUE;
+    // Shader objects are only drawn inside dynamic rendering passes
+    capabilities_.shaderObject = shaderObjectFeatures.shaderObject == VK_TRUE && capabilities_.dynamicRendering;
+    shaderObjectFeatures.shaderObject = capabilities_.shaderObject;
+    capabilities_.synchronization2 = synchronization2Features.synchronization2 == VK_TRUE;
+    capabilities_.meshShader = meshShaderFeatures.taskShader == VK_TRUE && meshShaderFeatures.meshShader == VK_TRUE;
+    capabilities_.bufferDeviceAddress = bufferDeviceAddressFeatures.bufferDeviceAddress == VK_TRUE;
+
+    if (capabilities_.graphicsPipelineLibrary) {
+        VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT libraryProperties{};
+        libraryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT;
+        VkPhysicalDeviceProperties2 properties2{};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties2.pNext = &libraryProperties;
+        vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+        capabilities_.fastLinking = libraryProperties.graphicsPipelineLibraryFastLinking == VK_TRUE;
+    }
+
+    // Only keep the extended dynamic state 3 features we actually use enabled
+    void* next = extendedDynamicState3Features.pNext;
+    extendedDynamicState3Features = {};
+    extendedDynamicState3Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+    extendedDynamicState3Features.pNext = next;
+    extendedDynamicState3Features.extendedDynamicState3PolygonMode = capabilities_.dynamicPolygonMode;
+
+    // Same for mesh shaders, multiview, shading rate and pipeline statistics queries are left disabled
+    next = meshShaderFeatures.pNext;
+    meshShaderFeatures = {};
+    meshShaderFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT;
+    meshShaderFeatures.pNext = next;
+    meshShaderFeatures.taskShader = capabilities_.meshShader;
+    meshShaderFeatures.meshShader = capabilities_.meshShader;
+
+    // Capture and replay is for tools, multiple devices are never grouped
+    bufferDeviceAddressFeatures.bufferDeviceAddressCaptureReplay = VK_FALSE;
+    bufferDeviceAddressFeatures.bufferDeviceAddressMultiDevice = VK_FALSE;
+
+    return chain;
+}
+
+void Magnet::VKBase::Device::loadExtensionFunctions()
+{
+    auto load = [this](auto& function, const char* name) {
+        function = reinterpret_cast<std::remove_reference_t<decltype(function)>>(vkGetDeviceProcAddr(device_, name));
+    };
+
+    // Shader objects expose every dynamic state command, whether or not the matching extension is enabled
+    bool shaderObject = capabilities_.shaderObject;
+
+    if (capabilities_.extendedDynamicState || shaderObject) {
+        load(functions_.vkCmdSetCullModeEXT, "vkCmdSetCullModeEXT");
+        load(functions_.vkCmdSetFrontFaceEXT, "vkCmdSetFrontFaceEXT");
+        load(functions_.vkCmdSetPrimitiveTopologyEXT, "vkCmdSetPrimitiveTopologyEXT");
+        load(functions_.vkCmdSetDepthTestEnableEXT, "vkCmdSetDepthTestEnableEXT");
+        load(functions_.vkCmdSetDepthWriteEnableEXT, "vkCmdSetDepthWriteEnableEXT");
+        load(functions_.vkCmdSetDepthCompareOpEXT, "vkCmdSetDepthCompareOpEXT");
+    }
+    if (capabilities_.extendedDynamicState2 || shaderObject) {
+        load(functions_.vkCmdSetPrimitiveRestartEnableEXT, "vkCmdSetPrimitiveRestartEnableEXT");
+        load(functions_.vkCmdSetRasterizerDiscardEnableEXT, "vkCmdSetRasterizerDiscardEnableEXT");
+        load(functions_.vkCmdSetDepthBiasEnableEXT, "vkCmdSetDepthBiasEnableEXT");
+    }
+    if (capabilities_.dynamicPolygonMode || shaderObject) {
+        load(functions_.vkCmdSetPolygonModeEXT, "vkCmdSetPolygonModeEXT");
+    }
+    if (shaderObject) {
+        load(functions_.vkCreateShadersEXT, "vkCreateShadersEXT");
+        load(functions_.vkDestroyShaderEXT, "vkDestroyShaderEXT");
+        load(functions_.vkCmdBindShadersEXT, "vkCmdBindShadersEXT");
+        load(functions_.vkCmdSetViewportWithCountEXT, "vkCmdSetViewportWithCountEXT");
+        load(functions_.vkCmdSetScissorWithCountEXT, "vkCmdSetScissorWithCountEXT");
+        load(functions_.vkCmdSetVertexInputEXT, "vkCmdSetVertexInputEXT");
+        load(functions_.vkCmdSetRasterizationSamplesEXT, "vkCmdSetRasterizationSamplesEXT");
+        load(functions_.vkCmdSetSampleMaskEXT, "vkCmdSetSampleMaskEXT");
+        load(functions_.vkCmdSetAlphaToCoverageEnableEXT, "vkCmdSetAlphaToCoverageEnableEXT");
+        load(functions_.vkCmdSetColorBlendEnableEXT, "vkCmdSetColorBlendEnableEXT");
+        load(functions_.vkCmdSetColorBlendEquationEXT, "vkCmdSetColorBlendEquationEXT");
+        load(functions_.vkCmdSetColorWriteMaskEXT, "vkCmdSetColorWriteMaskEXT");
+        load(functions_.vkCmdSetStencilTestEnableEXT, "vkCmdSetStencilTestEnableEXT");
+        load(functions_.vkCmdSetDepthBoundsTestEnableEXT, "vkCmdSetDepthBoundsTestEnableEXT");
+    }
+    if (capabilities_.dynamicRendering) {
+        load(functions_.vkCmdBeginRenderingKHR, "vkCmdBeginRenderingKHR");
+        load(functions_.vkCmdEndRenderingKHR, "vkCmdEndRenderingKHR");
+    }
+    if (capabilities_.synchronization2) {
+        load(functions_.vkCmdPipelineBarrier2KHR, "vkCmdPipelineBarrier2KHR");
+    }
+    if (capabilities_.meshShader) {
+        load(functions_.vkCmdDrawMeshTasksEXT, "vkCmdDrawMeshTasksEXT");
+    }
+    if (capabilities_.bufferDeviceAddress) {
+        load(functions_.vkGetBufferDeviceAddressKHR, "vkGetBufferDeviceAddressKHR");
+    }
 }
 
 void Magnet::VKBase::Device::createCommandPool()
@@ -425,6 +727,14 @@ std::vector<const char*> Magnet::VKBase::Device::getRequiredValidationLayers()
     return requiredLayers;
 }
 
+std::vector<const char*> Magnet::VKBase::Device::getOptionalInstanceLayers()
+{
+    std::vector<const char*> optionalLayers;
+    optionalLayers.push_back("VK_LAYER_KHRONOS_shader_object");
+
+    return optionalLayers;
+}
+
 std::vector<const char*> Magnet::VKBase::Device::getDeviceRequiredExtensions()
 {
     std::vector<const char*> requireddeviceExtensions = {
@@ -432,6 +742,26 @@ std::vector<const char*> Magnet::VKBase::Device::getDeviceRequiredExtensions()
     return requireddeviceExtensions;
 }
 
+std::vector<const char*> Magnet::VKBase::Device::getDeviceOptionalExtensions()
+{
+    std::vector<const char*> optionalDeviceExtensions = {
+                VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME,
+                VK_EXT_EXTENDED_DYNAMIC_STATE_2_EXTENSION_NAME,
+                VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME,
+                VK_EXT_SHADER_OBJECT_EXTENSION_NAME,
+                VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME,
+                VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME,
+                VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME,
+                VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME,
+                VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME,
+                VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME,
+                VK_KHR_SPIRV_1_4_EXTENSION_NAME,
+                VK_KHR_SHADER_FLOAT_CONTROLS_EXTENSION_NAME,
+                VK_EXT_MESH_SHADER_EXTENSION_NAME,
+                VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME};
+    return optionalDeviceExtensions;
+}
+
 bool Magnet::VKBase::Device::checkValidationLayersSupport()
 {
     uint32_t layerCount;
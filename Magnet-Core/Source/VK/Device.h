@@ -21,6 +21,73 @@ namespace Magnet {
             bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
         };
 
+        // Optional device functionality, resolved once the logical device is created
+        struct DeviceCapabilities {
+            // VK_EXT_extended_dynamic_state : cull mode, front face, topology, depth test/write/compare
+            bool extendedDynamicState = false;
+            // VK_EXT_extended_dynamic_state2 : primitive restart, rasterizer discard, depth bias enable
+            bool extendedDynamicState2 = false;
+            // VK_EXT_extended_dynamic_state3 : polygon mode
+            bool dynamicPolygonMode = false;
+            // VK_EXT_shader_object, natively or through VK_LAYER_KHRONOS_shader_object, enabled with VK_KHR_dynamic_rendering
+            bool shaderObject = false;
+            // VK_EXT_graphics_pipeline_library : pipelines are linked from separately compiled parts
+            bool graphicsPipelineLibrary = false;
+            // Linking libraries without link time optimization is cheap enough to happen at draw time
+            bool fastLinking = false;
+            // VK_KHR_dynamic_rendering : passes are described at record time, no render pass or framebuffer objects
+            bool dynamicRendering = false;
+            // VK_KHR_synchronization2 : 64 bit stage and access masks, barriers batched in a VkDependencyInfo
+            bool synchronization2 = false;
+            // VK_EXT_mesh_shader : task and mesh shader stages replace the vertex input and vertex stages
+            bool meshShader = false;
+            // VK_KHR_buffer_device_address : shaders read buffers through 64 bit pointers, no descriptor needed
+            bool bufferDeviceAddress = false;
+        };
+
+        // Entry points of optional extensions, null when the extension is not enabled
+        struct ExtensionFunctions {
+            PFN_vkCmdSetCullModeEXT vkCmdSetCullModeEXT = nullptr;
+            PFN_vkCmdSetFrontFaceEXT vkCmdSetFrontFaceEXT = nullptr;
+            PFN_vkCmdSetPrimitiveTopologyEXT vkCmdSetPrimitiveTopologyEXT = nullptr;
+            PFN_vkCmdSetDepthTestEnableEXT vkCmdSetDepthTestEnableEXT = nullptr;
+            PFN_vkCmdSetDepthWriteEnableEXT vkCmdSetDepthWriteEnableEXT = nullptr;
+            PFN_vkCmdSetDepthCompareOpEXT vkCmdSetDepthCompareOpEXT = nullptr;
+            PFN_vkCmdSetPrimitiveRestartEnableEXT vkCmdSetPrimitiveRestartEnableEXT = nullptr;
+            PFN_vkCmdSetRasterizerDiscardEnableEXT vkCmdSetRasterizerDiscardEnableEXT = nullptr;
+            PFN_vkCmdSetDepthBiasEnableEXT vkCmdSetDepthBiasEnableEXT = nullptr;
+            PFN_vkCmdSetPolygonModeEXT vkCmdSetPolygonModeEXT = nullptr;
+
+            // VK_EXT_shader_object, every state of a draw has to be set dynamically
+            PFN_vkCreateShadersEXT vkCreateShadersEXT = nullptr;
+            PFN_vkDestroyShaderEXT vkDestroyShaderEXT = nullptr;
+            PFN_vkCmdBindShadersEXT vkCmdBindShadersEXT = nullptr;
+            PFN_vkCmdSetViewportWithCountEXT vkCmdSetViewportWithCountEXT = nullptr;
+            PFN_vkCmdSetScissorWithCountEXT vkCmdSetScissorWithCountEXT = nullptr;
+            PFN_vkCmdSetVertexInputEXT vkCmdSetVertexInputEXT = nullptr;
+            PFN_vkCmdSetRasterizationSamplesEXT vkCmdSetRasterizationSamplesEXT = nullptr;
+            PFN_vkCmdSetSampleMaskEXT vkCmdSetSampleMaskEXT = nullptr;
+            PFN_vkCmdSetAlphaToCoverageEnableEXT vkCmdSetAlphaToCoverageEnableEXT = nullptr;
+            PFN_vkCmdSetColorBlendEnableEXT vkCmdSetColorBlendEnableEXT = nullptr;
+            PFN_vkCmdSetColorBlendEquationEXT vkCmdSetColorBlendEquationEXT = nullptr;
+            PFN_vkCmdSetColorWriteMaskEXT vkCmdSetColorWriteMaskEXT = nullptr;
+            PFN_vkCmdSetStencilTestEnableEXT vkCmdSetStencilTestEnableEXT = nullptr;
+            PFN_vkCmdSetDepthBoundsTestEnableEXT vkCmdSetDepthBoundsTestEnableEXT = nullptr;
+
+            // VK_KHR_dynamic_rendering
+            PFN_vkCmdBeginRenderingKHR vkCmdBeginRenderingKHR = nullptr;
+            PFN_vkCmdEndRenderingKHR vkCmdEndRenderingKHR = nullptr;
+
+            // VK_KHR_synchronization2
+            PFN_vkCmdPipelineBarrier2KHR vkCmdPipelineBarrier2KHR = nullptr;
+
+            // VK_EXT_mesh_shader
+            PFN_vkCmdDrawMeshTasksEXT vkCmdDrawMeshTasksEXT = nullptr;
+
+            // VK_KHR_buffer_device_address
+            PFN_vkGetBufferDeviceAddressKHR vkGetBufferDeviceAddressKHR = nullptr;
+        };
+
         class Device {
         public:
 #ifdef NDEBUG
@@ -41,12 +108,30 @@ namespace Magnet {
             SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
             uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
             QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); }
+            const DeviceCapabilities& capabilities() const { return capabilities_; }
+            const ExtensionFunctions& functions() const { return functions_; }
+            bool isExtensionEnabled(const std::string& extension) const { return enabledDeviceExtensions.count(extension) > 0; }
             VkFormat findSupportedFormat(
                 const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
-            // Buffer Helper Functions
+            // Buffer Helper Functions, memory of buffers with VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT is allocated addressable
+            void createBuffer(
+                VkDeviceSize size,
+                VkBufferUsageFlags usage,
+                VkMemoryPropertyFlags properties,
+                VkBuffer& buffer,
+                VkDeviceMemory& bufferMemory);
+            // Requires the bufferDeviceAddress capability
+            VkDeviceAddress getBufferAddress(VkBuffer buffer);
+
+            // One-off recording on the graphics queue, end submits and waits for completion
+            VkCommandBuffer beginSingleTimeCommands();
+            void endSingleTimeCommands(VkCommandBuffer commandBuffer);
+
+            VkFormatProperties getFormatProperties(VkFormat format);
 
             VkPhysicalDeviceProperties properties;
+            VkPhysicalDeviceFeatures features;
 
             void createImageWithInfo(
                 const VkImageCreateInfo& imageInfo,
@@ -67,7 +152,13 @@ namespace Magnet {
 
             std::vector<const char*> getInstanceRequiredExtensions();
             std::vector<const char*> getRequiredValidationLayers();
+            std::vector<const char*> getOptionalInstanceLayers();
             std::vector<const char*> getDeviceRequiredExtensions();
+            std::vector<const char*> getDeviceOptionalExtensions();
+
+            void enableOptionalExtensions();
+            void* queryOptionalFeatures();
+            void loadExtensionFunctions();
 
             bool checkValidationLayersSupport();
             QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device);
@@ -91,6 +182,21 @@ namespace Magnet {
             std::vector<const char*> usedValidationLayers;
             std::vector<const char*> usedInstanceExtensions;
             std::vector<const char*> usedDeviceExtensions;
+            std::unordered_set<std::string> enabledDeviceExtensions;
+
+            DeviceCapabilities capabilities_;
+            ExtensionFunctions functions_;
+
+            // Feature structures chained into the device create info, they must outlive vkCreateDevice
+            VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicStateFeatures{};
+            VkPhysicalDeviceExtendedDynamicState2FeaturesEXT extendedDynamicState2Features{};
+            VkPhysicalDeviceExtendedDynamicState3FeaturesEXT extendedDynamicState3Features{};
+            VkPhysicalDeviceShaderObjectFeaturesEXT shaderObjectFeatures{};
+            VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT graphicsPipelineLibraryFeatures{};
+            VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{};
+            VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features{};
+            VkPhysicalDeviceMeshShaderFeaturesEXT meshShaderFeatures{};
+            VkPhysicalDeviceBufferDeviceAddressFeaturesKHR bufferDeviceAddressFeatures{};
         };
 
     }
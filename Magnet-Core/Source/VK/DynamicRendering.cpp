@@ -0,0 +1,47 @@
+#include "DynamicRendering.h"
+
+Magnet::VKBase::RenderingInfo& Magnet::VKBase::RenderingInfo::addColorAttachment(VkImageView imageView, VkAttachmentLoadOp loadOp, VkAttachmentStoreOp storeOp, VkClearColorValue clearColor, VkImageLayout imageLayout)
+{
+	VkRenderingAttachmentInfoKHR attachment{};
+	attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+	attachment.imageView = imageView;
+	attachment.imageLayout = imageLayout;
+	attachment.loadOp = loadOp;
+	attachment.storeOp = storeOp;
+	attachment.clearValue.color = clearColor;
+	colorAttachments.push_back(attachment);
+	return *this;
+}
+
+Magnet::VKBase::RenderingInfo& Magnet::VKBase::RenderingInfo::setDepthAttachment(VkImageView imageView, VkAttachmentLoadOp loadOp, VkAttachmentStoreOp storeOp, float clearDepth, VkImageLayout imageLayout)
+{
+	depthAttachment = {};
+	depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+	depthAttachment.imageView = imageView;
+	depthAttachment.imageLayout = imageLayout;
+	depthAttachment.loadOp = loadOp;
+	depthAttachment.storeOp = storeOp;
+	depthAttachment.clearValue.depthStencil = { clearDepth, 0 };
+	hasDepth = true;
+	return *this;
+}
+
+void Magnet::VKBase::RenderingInfo::begin(const Device& device, VkCommandBuffer commandBuffer)
+{
+	assert(device.capabilities().dynamicRendering && "Cannot begin rendering: VK_KHR_dynamic_rendering is not enabled");
+
+	VkRenderingInfoKHR renderingInfo{};
+	renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+	renderingInfo.renderArea = { { 0, 0 }, extent };
+	renderingInfo.layerCount = 1;
+	renderingInfo.colorAttachmentCount = static_cast<uint32_t>(colorAttachments.size());
+	renderingInfo.pColorAttachments = colorAttachments.data();
+	renderingInfo.pDepthAttachment = hasDepth ? &depthAttachment : nullptr;
+
+	device.functions().vkCmdBeginRenderingKHR(commandBuffer, &renderingInfo);
+}
+
+void Magnet::VKBase::RenderingInfo::end(const Device& device, VkCommandBuffer commandBuffer)
+{
+	device.functions().vkCmdEndRenderingKHR(commandBuffer);
+}
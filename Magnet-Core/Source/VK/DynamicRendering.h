@@ -0,0 +1,37 @@
+#pragma once
+#include "../Commons.h"
+#include "Device.h"
+
+namespace Magnet {
+	namespace VKBase {
+
+		// Describes a VK_KHR_dynamic_rendering pass at record time, no render pass or framebuffer objects involved.
+		// Attachments must already be in the layouts passed here.
+		class RenderingInfo {
+		public:
+			RenderingInfo(VkExtent2D extent) : extent{ extent } {}
+
+			RenderingInfo& addColorAttachment(
+				VkImageView imageView,
+				VkAttachmentLoadOp loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+				VkAttachmentStoreOp storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+				VkClearColorValue clearColor = { { 0.0f, 0.0f, 0.0f, 1.0f } },
+				VkImageLayout imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+			RenderingInfo& setDepthAttachment(
+				VkImageView imageView,
+				VkAttachmentLoadOp loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+				VkAttachmentStoreOp storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+				float clearDepth = 1.0f,
+				VkImageLayout imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+
+			void begin(const Device& device, VkCommandBuffer commandBuffer);
+			void end(const Device& device, VkCommandBuffer commandBuffer);
+
+		private:
+			VkExtent2D extent;
+			std::vector<VkRenderingAttachmentInfoKHR> colorAttachments;
+			VkRenderingAttachmentInfoKHR depthAttachment{};
+			bool hasDepth = false;
+		};
+	}
+}
@@ -0,0 +1,67 @@
+#include "DynamicState.h"
+
+void Magnet::VKBase::RasterState::enableDynamicStates(PipelineConfigInfo& configInfo, const Device& device)
+{
+	const auto& caps = device.capabilities();
+	auto& states = configInfo.dynamicStateEnables;
+
+	if (caps.extendedDynamicState) {
+		states.insert(states.end(), {
+			VK_DYNAMIC_STATE_CULL_MODE_EXT,
+			VK_DYNAMIC_STATE_FRONT_FACE_EXT,
+			VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT,
+			VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE_EXT,
+			VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT,
+			VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT });
+	}
+	if (caps.extendedDynamicState2) {
+		states.insert(states.end(), {
+			VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE_EXT,
+			VK_DYNAMIC_STATE_RASTERIZER_DISCARD_ENABLE_EXT,
+			VK_DYNAMIC_STATE_DEPTH_BIAS_ENABLE_EXT });
+	}
+	if (caps.dynamicPolygonMode) {
+		states.push_back(VK_DYNAMIC_STATE_POLYGON_MODE_EXT);
+	}
+
+	// The vector may have been reallocated
+	configInfo.dynamicStateInfo.pDynamicStates = states.data();
+	configInfo.dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(states.size());
+}
+
+void Magnet::VKBase::RasterState::applyToConfig(PipelineConfigInfo& configInfo) const
+{
+	configInfo.inputAssemblyInfo.topology = topology;
+	configInfo.rasterizationInfo.polygonMode = polygonMode;
+	configInfo.rasterizationInfo.cullMode = cullMode;
+	configInfo.rasterizationInfo.frontFace = frontFace;
+	configInfo.depthStencilInfo.depthTestEnable = depthTestEnable;
+	configInfo.depthStencilInfo.depthWriteEnable = depthWriteEnable;
+	configInfo.depthStencilInfo.depthCompareOp = depthCompareOp;
+	configInfo.inputAssemblyInfo.primitiveRestartEnable = primitiveRestartEnable;
+	configInfo.rasterizationInfo.rasterizerDiscardEnable = rasterizerDiscardEnable;
+	configInfo.rasterizationInfo.depthBiasEnable = depthBiasEnable;
+}
+
+void Magnet::VKBase::RasterState::record(const Device& device, VkCommandBuffer commandBuffer) const
+{
+	const auto& caps = device.capabilities();
+	const auto& fn = device.functions();
+
+	if (caps.extendedDynamicState) {
+		fn.vkCmdSetCullModeEXT(commandBuffer, cullMode);
+		fn.vkCmdSetFrontFaceEXT(commandBuffer, frontFace);
+		fn.vkCmdSetPrimitiveTopologyEXT(commandBuffer, topology);
+		fn.vkCmdSetDepthTestEnableEXT(commandBuffer, depthTestEnable);
+		fn.vkCmdSetDepthWriteEnableEXT(commandBuffer, depthWriteEnable);
+		fn.vkCmdSetDepthCompareOpEXT(commandBuffer, depthCompareOp);
+	}
+	if (caps.extendedDynamicState2) {
+		fn.vkCmdSetPrimitiveRestartEnableEXT(commandBuffer, primitiveRestartEnable);
+		fn.vkCmdSetRasterizerDiscardEnableEXT(commandBuffer, rasterizerDiscardEnable);
+		fn.vkCmdSetDepthBiasEnableEXT(commandBuffer, depthBiasEnable);
+	}
+	if (caps.dynamicPolygonMode) {
+		fn.vkCmdSetPolygonModeEXT(commandBuffer, polygonMode);
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "../Commons.h"
+#include "Device.h"
+#include "Pipeline.h"
+
+namespace Magnet {
+	namespace VKBase {
+
+		// Rasterization and depth state that either lives in the command buffer (extended dynamic state)
+		// or, on devices lacking the extensions, is baked into a pipeline permutation.
+		struct RasterState {
+			VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+			VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+			VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+			VkFrontFace frontFace = VK_FRONT_FACE_CLOCKWISE;
+			VkBool32 depthTestEnable = VK_TRUE;
+			VkBool32 depthWriteEnable = VK_TRUE;
+			VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS;
+			VkBool32 primitiveRestartEnable = VK_FALSE;
+			VkBool32 rasterizerDiscardEnable = VK_FALSE;
+			VkBool32 depthBiasEnable = VK_FALSE;
+
+			bool operator==(const RasterState&) const = default;
+
+			// Adds every state the device can set at record time to the config's dynamic states
+			static void enableDynamicStates(PipelineConfigInfo& configInfo, const Device& device);
+
+			// Writes this state into the fixed function part of the config.
+			// Fields covered by dynamic states are ignored by the pipeline registry key,
+			// so on capable devices every RasterState maps to the same pipeline.
+			void applyToConfig(PipelineConfigInfo& configInfo) const;
+
+			// Records the states enabled by enableDynamicStates, must follow the pipeline bind
+			void record(const Device& device, VkCommandBuffer commandBuffer) const;
+		};
+	}
+}
@@ -0,0 +1,69 @@
+#include "GpuTimer.h"
+
+Magnet::VKBase::GpuTimer::GpuTimer(Device& device, uint32_t frameCount) : device{ device }, recorded(frameCount, false)
+{
+	timestampPeriod = device.properties.limits.timestampPeriod;
+	supported = device.properties.limits.timestampComputeAndGraphics == VK_TRUE && timestampPeriod > 0.0f;
+	if (!supported) {
+		return;
+	}
+
+	VkQueryPoolCreateInfo queryPoolInfo{};
+	queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolInfo.queryCount = frameCount * 2;
+
+	if (vkCreateQueryPool(device.device(), &queryPoolInfo, nullptr, &queryPool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create timestamp query pool!");
+	}
+}
+
+Magnet::VKBase::GpuTimer::~GpuTimer()
+{
+	if (queryPool != VK_NULL_HANDLE) {
+		vkDestroyQueryPool(device.device(), queryPool, nullptr);
+	}
+}
+
+void Magnet::VKBase::GpuTimer::begin(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+	if (!supported) {
+		return;
+	}
+	vkCmdResetQueryPool(commandBuffer, queryPool, frameIndex * 2, 2);
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, frameIndex * 2);
+}
+
+void Magnet::VKBase::GpuTimer::end(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+	if (!supported) {
+		return;
+	}
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, frameIndex * 2 + 1);
+	recorded[frameIndex] = true;
+}
+
+bool Magnet::VKBase::GpuTimer::read(uint32_t frameIndex, double& milliseconds)
+{
+	if (!supported || !recorded[frameIndex]) {
+		return false;
+	}
+
+	std::array<uint64_t, 2> timestamps{};
+	VkResult result = vkGetQueryPoolResults(
+		device.device(),
+		queryPool,
+		frameIndex * 2,
+		2,
+		sizeof(timestamps),
+		timestamps.data(),
+		sizeof(uint64_t),
+		VK_QUERY_RESULT_64_BIT);
+	if (result != VK_SUCCESS) {
+		return false;
+	}
+
+	recorded[frameIndex] = false;
+	milliseconds = static_cast<double>(timestamps[1] - timestamps[0]) * timestampPeriod / 1e6;
+	return true;
+}
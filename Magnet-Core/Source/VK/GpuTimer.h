@@ -0,0 +1,33 @@
+#pragma once
+#include "../Commons.h"
+#include "Device.h"
+
+namespace Magnet {
+	namespace VKBase {
+
+		// Measures GPU time between two points of a command buffer with timestamp queries,
+		// one pair of queries per frame in flight so results are read without stalling.
+		class GpuTimer {
+		public:
+			GpuTimer(Device& device, uint32_t frameCount);
+			~GpuTimer();
+
+			GpuTimer(const GpuTimer&) = delete;
+			GpuTimer& operator=(const GpuTimer&) = delete;
+
+			bool isSupported() const { return supported; }
+
+			void begin(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+			void end(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+			// Time of the last submission recorded for frameIndex, only valid once its fence has been waited on
+			bool read(uint32_t frameIndex, double& milliseconds);
+
+		private:
+			Device& device;
+			VkQueryPool queryPool = VK_NULL_HANDLE;
+			float timestampPeriod = 0.0f;
+			bool supported = false;
+			std::vector<bool> recorded;
+		};
+	}
+}
@@ -1,10 +1,14 @@
 #include "Pipeline.h"
-#include "Model.h"
 
 
-Magnet::VKBase::Pipeline::Pipeline(Device& device, const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo) : device { device }
+Magnet::VKBase::Pipeline::Pipeline(Device& device, const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo, VkPipelineCache pipelineCache) : device { device }
+{
+	createGraphicsPipeline(vertFilepath, fragFilepath, configInfo, pipelineCache);
+}
+
+Magnet::VKBase::Pipeline::Pipeline(Device& device, VkPipeline pipeline, std::future<VkPipeline> optimizedPipeline)
+	: device{ device }, graphicsPipeline{ pipeline }, optimizedPipeline{ std::move(optimizedPipeline) }
 {
-	createGraphicsPipeline(vertFilepath, fragFilepath, configInfo);
 }
 
 Magnet::VKBase::Pipeline::~Pipeline()
@@ -12,6 +16,13 @@ Magnet::VKBase::Pipeline::~Pipeline()
 	vkDestroyShaderModule(device.device(), fragShaderModule, nullptr);
 	vkDestroyShaderModule(device.device(), vertShaderModule, nullptr);
 	vkDestroyPipeline(device.device(), graphicsPipeline, nullptr);
+	vkDestroyPipeline(device.device(), retiredPipeline, nullptr);
+	if (optimizedPipeline.valid()) {
+		VkPipeline optimized = takeOptimizedPipeline();
+		if (optimized != VK_NULL_HANDLE) {
+			vkDestroyPipeline(device.device(), optimized, nullptr);
+		}
+	}
 }
 
 std::vector<char> Magnet::VKBase::Pipeline::readFile(const std::string& filepath)
@@ -32,14 +43,14 @@ std::vector<char> Magnet::VKBase::Pipeline::readFile(const std::string& filepath
 	return buffer;
 }
 
-void Magnet::VKBase::Pipeline::createGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo)
+void Magnet::VKBase::Pipeline::createGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo, VkPipelineCache pipelineCache)
 {
 	assert(
 		configInfo.pipelineLayout != nullptr &&
 		"Cannot create graphics pipeline: no pipelineLayout provided in config info");
 	assert(
-		configInfo.renderPass != nullptr &&
-		"Cannot create graphics pipeline: no renderPass provided in config info");
+		(configInfo.renderPass != nullptr || !configInfo.colorAttachmentFormats.empty() || configInfo.depthAttachmentFormat != VK_FORMAT_UNDEFINED) &&
+		"Cannot create graphics pipeline: no renderPass or attachment formats provided in config info");
 
 	auto vertCode = readFile(vertFilepath);
 	auto fragCode = readFile(fragFilepath);
@@ -63,8 +74,8 @@ void Magnet::VKBase::Pipeline::createGraphicsPipeline(const std::string& vertFil
 	shaderStages[1].pNext = nullptr;
 	shaderStages[1].pSpecializationInfo = nullptr;
 
-	auto bindingDescriptions = Model::Vertex::getBindingDescriptions();
-	auto attributeDescriptions = Model::Vertex::getAttributeDescriptions();
+	auto& bindingDescriptions = configInfo.bindingDescriptions;
+	auto& attributeDescriptions = configInfo.attributeDescriptions;
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
@@ -89,10 +100,15 @@ void Magnet::VKBase::Pipeline::createGraphicsPipeline(const std::string& vertFil
 	pipelineInfo.renderPass = configInfo.renderPass;
 	pipelineInfo.subpass = configInfo.subpass;
 
+	VkPipelineRenderingCreateInfoKHR renderingInfo = renderingCreateInfo(configInfo);
+	if (configInfo.renderPass == nullptr) {
+		pipelineInfo.pNext = &renderingInfo;
+	}
+
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;  // Optional
 	pipelineInfo.basePipelineIndex = -1;               // Optional
 
-	if (vkCreateGraphicsPipelines(device.device(),VK_NULL_HANDLE,1,&pipelineInfo,nullptr,&graphicsPipeline) != VK_SUCCESS) {
+	if (vkCreateGraphicsPipelines(device.device(),pipelineCache,1,&pipelineInfo,nullptr,&graphicsPipeline) != VK_SUCCESS) {
 		throw std::runtime_error("failed to create graphics pipeline!");
 	}
 
@@ -116,9 +132,39 @@ void Magnet::VKBase::Pipeline::createShaderModule(const std::vector<char>& code,
 
 void Magnet::VKBase::Pipeline::bind(VkCommandBuffer commandBuffer)
 {
+	if (optimizedPipeline.valid() && optimizedPipeline.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+		// The fast-linked pipeline stays in use when the optimized link failed
+		VkPipeline optimized = takeOptimizedPipeline();
+		if (optimized != VK_NULL_HANDLE) {
+			retiredPipeline = graphicsPipeline;
+			graphicsPipeline = optimized;
+		}
+	}
 	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
 }
 
+VkPipeline Magnet::VKBase::Pipeline::takeOptimizedPipeline()
+{
+	try {
+		return optimizedPipeline.get();
+	}
+	catch (const std::exception& e) {
+		std::cerr << "keeping fast-linked pipeline: " << e.what() << std::endl;
+		return VK_NULL_HANDLE;
+	}
+}
+
+VkPipelineRenderingCreateInfoKHR Magnet::VKBase::Pipeline::renderingCreateInfo(const PipelineConfigInfo& configInfo)
+{
+	VkPipelineRenderingCreateInfoKHR renderingInfo{};
+	renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+	renderingInfo.colorAttachmentCount = static_cast<uint32_t>(configInfo.colorAttachmentFormats.size());
+	renderingInfo.pColorAttachmentFormats = configInfo.colorAttachmentFormats.data();
+	renderingInfo.depthAttachmentFormat = configInfo.depthAttachmentFormat;
+	renderingInfo.stencilAttachmentFormat = configInfo.stencilAttachmentFormat;
+	return renderingInfo;
+}
+
 void Magnet::VKBase::Pipeline::defaultPipelineConfigInfo(PipelineConfigInfo& configInfo)
 {
 	configInfo.inputAssemblyInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
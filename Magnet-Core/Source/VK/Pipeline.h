@@ -2,6 +2,8 @@
 #include "../Commons.h"
 #include "Device.h"
 
+#include <future>
+
 
 namespace Magnet {
 	namespace VKBase{
@@ -13,6 +15,8 @@ namespace Magnet {
 		PipelineConfigInfo(const PipelineConfigInfo&) = delete;
 		PipelineConfigInfo& operator=(const PipelineConfigInfo&) = delete;
 
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
 		VkPipelineViewportStateCreateInfo viewportInfo;
 		VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo;
 		VkPipelineRasterizationStateCreateInfo rasterizationInfo;
@@ -25,12 +29,18 @@ namespace Magnet {
 		VkPipelineLayout pipelineLayout = nullptr;
 		VkRenderPass renderPass = nullptr;
 		uint32_t subpass = 0;
+		// Attachment formats used instead of renderPass when rendering with VK_KHR_dynamic_rendering
+		std::vector<VkFormat> colorAttachmentFormats{};
+		VkFormat depthAttachmentFormat = VK_FORMAT_UNDEFINED;
+		VkFormat stencilAttachmentFormat = VK_FORMAT_UNDEFINED;
 	};
 
 
 		class Pipeline {
 	public:
-		Pipeline(Device& device, const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo);
+		Pipeline(Device& device, const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo, VkPipelineCache pipelineCache = VK_NULL_HANDLE);
+		// Adopts an already linked pipeline, replaced on bind by optimizedPipeline once it is ready
+		Pipeline(Device& device, VkPipeline pipeline, std::future<VkPipeline> optimizedPipeline = {});
 
 		~Pipeline();
 
@@ -40,18 +50,26 @@ namespace Magnet {
 		void bind(VkCommandBuffer commandBuffer);
 
 		static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
+		// Chained into the pipeline create info when configInfo has no render pass
+		static VkPipelineRenderingCreateInfoKHR renderingCreateInfo(const PipelineConfigInfo& configInfo);
 
-	private:
 		static std::vector<char> readFile(const std::string& filepath);
 
-		void createGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath,const PipelineConfigInfo& configInfo);
+	private:
+		void createGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath,const PipelineConfigInfo& configInfo, VkPipelineCache pipelineCache);
 
 		void createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule);
+		// Waits for the optimized pipeline, VK_NULL_HANDLE if its link failed
+		VkPipeline takeOptimizedPipeline();
 
 		Device& device;
 		VkPipeline graphicsPipeline;
-		VkShaderModule vertShaderModule;
-		VkShaderModule fragShaderModule;
+		VkShaderModule vertShaderModule = VK_NULL_HANDLE;
+		VkShaderModule fragShaderModule = VK_NULL_HANDLE;
+
+		std::future<VkPipeline> optimizedPipeline;
+		// Pipeline replaced by the optimized one, frames in flight may still use it
+		VkPipeline retiredPipeline = VK_NULL_HANDLE;
 	};
 	}
 }
\ No newline at end of file
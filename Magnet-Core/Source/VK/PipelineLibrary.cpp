@@ -0,0 +1,244 @@
+#include "PipelineLibrary.h"
+#include "PipelineRegistry.h"
+#include "../Utils.h"
+
+Magnet::VKBase::PipelineLibrary::PipelineLibrary(Device& device, VkPipelineCache pipelineCache) : device{ device }, pipelineCache{ pipelineCache }
+{
+	assert(device.capabilities().graphicsPipelineLibrary && "Cannot create pipeline library: VK_EXT_graphics_pipeline_library is not enabled");
+}
+
+Magnet::VKBase::PipelineLibrary::~PipelineLibrary()
+{
+	// Linked pipelines (and their pending optimized builds) must be released before the library
+	for (auto* parts : { &vertexInputParts, &preRasterizationParts, &fragmentShaderParts, &fragmentOutputParts }) {
+		for (auto& kv : *parts) {
+			vkDestroyPipeline(device.device(), kv.second, nullptr);
+		}
+		parts->clear();
+	}
+}
+
+VkPipeline Magnet::VKBase::PipelineLibrary::fastLink(const std::string& vertFilepath, std::size_t vertId, const std::string& fragFilepath, std::size_t fragId, const PipelineConfigInfo& configInfo)
+{
+	Parts parts = getParts(vertFilepath, vertId, fragFilepath, fragId, configInfo);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	VkPipeline pipeline = link(parts, configInfo.pipelineLayout, false);
+	stats.fastLinkTimeMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	stats.fastLinks++;
+
+	return pipeline;
+}
+
+std::future<VkPipeline> Magnet::VKBase::PipelineLibrary::optimizeAsync(const std::string& vertFilepath, std::size_t vertId, const std::string& fragFilepath, std::size_t fragId, const PipelineConfigInfo& configInfo)
+{
+	// Parts are only ever created on the calling thread, the worker only reads their handles
+	Parts parts = getParts(vertFilepath, vertId, fragFilepath, fragId, configInfo);
+	VkPipelineLayout layout = configInfo.pipelineLayout;
+	stats.optimizedLinks++;
+
+	return std::async(std::launch::async, [this, parts, layout]() {
+		return link(parts, layout, true);
+	});
+}
+
+void Magnet::VKBase::PipelineLibrary::printStats() const
+{
+	std::cout << "\nPipeline Library :" << std::endl;
+	std::cout << "------------------------------" << std::endl;
+	std::cout << "\t- Parts : " << vertexInputParts.size() << " vertex input, " << preRasterizationParts.size() << " pre-rasterization, "
+		<< fragmentShaderParts.size() << " fragment shader, " << fragmentOutputParts.size() << " fragment output" << std::endl;
+	std::cout << "\t- Part compiles : " << stats.partCompiles << " (" << stats.partCompileTimeMs << " ms)" << std::endl;
+	std::cout << "\t- Part hits : " << stats.partHits << std::endl;
+	std::cout << "\t- Fast links : " << stats.fastLinks << " (" << stats.fastLinkTimeMs << " ms)" << std::endl;
+	std::cout << "\t- Optimized links : " << stats.optimizedLinks << std::endl;
+}
+
+Magnet::VKBase::PipelineLibrary::Parts Magnet::VKBase::PipelineLibrary::getParts(const std::string& vertFilepath, std::size_t vertId, const std::string& fragFilepath, std::size_t fragId, const PipelineConfigInfo& configInfo)
+{
+	Parts parts{};
+	parts.vertexInput = getPart(vertexInputParts, PipelineRegistry::vertexInputKey(configInfo), [&]() {
+		return createVertexInputPart(configInfo);
+	});
+	parts.preRasterization = getPart(preRasterizationParts, PipelineRegistry::preRasterizationKey(configInfo, vertId), [&]() {
+		return createPreRasterizationPart(vertFilepath, configInfo);
+	});
+	parts.fragmentShader = getPart(fragmentShaderParts, PipelineRegistry::fragmentShaderKey(configInfo, fragId), [&]() {
+		return createFragmentShaderPart(fragFilepath, configInfo);
+	});
+	parts.fragmentOutput = getPart(fragmentOutputParts, PipelineRegistry::fragmentOutputKey(configInfo), [&]() {
+		return createFragmentOutputPart(configInfo);
+	});
+	return parts;
+}
+
+VkPipeline Magnet::VKBase::PipelineLibrary::getPart(PartCache& parts, PartKey key, const std::function<VkPipeline()>& compile)
+{
+	auto it = parts.find(key);
+	if (it != parts.end()) {
+		stats.partHits++;
+		return it->second;
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	VkPipeline part = compile();
+	stats.partCompileTimeMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	stats.partCompiles++;
+
+	parts.emplace(std::move(key), part);
+	return part;
+}
+
+VkPipeline Magnet::VKBase::PipelineLibrary::createVertexInputPart(const PipelineConfigInfo& configInfo)
+{
+	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(configInfo.attributeDescriptions.size());
+	vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(configInfo.bindingDescriptions.size());
+	vertexInputInfo.pVertexAttributeDescriptions = configInfo.attributeDescriptions.data();
+	vertexInputInfo.pVertexBindingDescriptions = configInfo.bindingDescriptions.data();
+
+	VkGraphicsPipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.pVertexInputState = &vertexInputInfo;
+	pipelineInfo.pInputAssemblyState = &configInfo.inputAssemblyInfo;
+	pipelineInfo.pDynamicState = &configInfo.dynamicStateInfo;
+
+	return createPart(pipelineInfo, VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT);
+}
+
+VkPipeline Magnet::VKBase::PipelineLibrary::createPreRasterizationPart(const std::string& vertFilepath, const PipelineConfigInfo& configInfo)
+{
+	VkShaderModule vertShaderModule = createShaderModule(vertFilepath);
+
+	VkPipelineShaderStageCreateInfo shaderStage{};
+	shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStage.stage = VK_SHADER_STAGE_VERTEX_BIT;
+	shaderStage.module = vertShaderModule;
+	shaderStage.pName = "main";
+
+	VkGraphicsPipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.stageCount = 1;
+	pipelineInfo.pStages = &shaderStage;
+	pipelineInfo.pViewportState = &configInfo.viewportInfo;
+	pipelineInfo.pRasterizationState = &configInfo.rasterizationInfo;
+	pipelineInfo.pDynamicState = &configInfo.dynamicStateInfo;
+	pipelineInfo.layout = configInfo.pipelineLayout;
+	pipelineInfo.renderPass = configInfo.renderPass;
+	pipelineInfo.subpass = configInfo.subpass;
+
+	VkPipelineRenderingCreateInfoKHR renderingInfo = Pipeline::renderingCreateInfo(configInfo);
+	if (configInfo.renderPass == nullptr) {
+		pipelineInfo.pNext = &renderingInfo;
+	}
+
+	VkPipeline part = createPart(pipelineInfo, VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT);
+	vkDestroyShaderModule(device.device(), vertShaderModule, nullptr);
+	return part;
+}
+
+VkPipeline Magnet::VKBase::PipelineLibrary::createFragmentShaderPart(const std::string& fragFilepath, const PipelineConfigInfo& configInfo)
+{
+	VkShaderModule fragShaderModule = createShaderModule(fragFilepath);
+
+	VkPipelineShaderStageCreateInfo shaderStage{};
+	shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shaderStage.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	shaderStage.module = fragShaderModule;
+	shaderStage.pName = "main";
+
+	VkGraphicsPipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.stageCount = 1;
+	pipelineInfo.pStages = &shaderStage;
+	pipelineInfo.pDepthStencilState = &configInfo.depthStencilInfo;
+	pipelineInfo.pMultisampleState = &configInfo.multisampleInfo;
+	pipelineInfo.pDynamicState = &configInfo.dynamicStateInfo;
+	pipelineInfo.layout = configInfo.pipelineLayout;
+	pipelineInfo.renderPass = configInfo.renderPass;
+	pipelineInfo.subpass = configInfo.subpass;
+
+	VkPipelineRenderingCreateInfoKHR renderingInfo = Pipeline::renderingCreateInfo(configInfo);
+	if (configInfo.renderPass == nullptr) {
+		pipelineInfo.pNext = &renderingInfo;
+	}
+
+	VkPipeline part = createPart(pipelineInfo, VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT);
+	vkDestroyShaderModule(device.device(), fragShaderModule, nullptr);
+	return part;
+}
+
+VkPipeline Magnet::VKBase::PipelineLibrary::createFragmentOutputPart(const PipelineConfigInfo& configInfo)
+{
+	VkGraphicsPipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.pColorBlendState = &configInfo.colorBlendInfo;
+	pipelineInfo.pMultisampleState = &configInfo.multisampleInfo;
+	pipelineInfo.pDynamicState = &configInfo.dynamicStateInfo;
+	pipelineInfo.renderPass = configInfo.renderPass;
+	pipelineInfo.subpass = configInfo.subpass;
+
+	VkPipelineRenderingCreateInfoKHR renderingInfo = Pipeline::renderingCreateInfo(configInfo);
+	if (configInfo.renderPass == nullptr) {
+		pipelineInfo.pNext = &renderingInfo;
+	}
+
+	return createPart(pipelineInfo, VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT);
+}
+
+VkPipeline Magnet::VKBase::PipelineLibrary::createPart(VkGraphicsPipelineCreateInfo& pipelineInfo, VkGraphicsPipelineLibraryFlagsEXT flags)
+{
+	VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo{};
+	libraryInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+	libraryInfo.flags = flags;
+
+	libraryInfo.pNext = pipelineInfo.pNext;
+	pipelineInfo.pNext = &libraryInfo;
+	// Keep what is needed to build a link time optimized pipeline from this part later on
+	pipelineInfo.flags |= VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+
+	VkPipeline part;
+	if (vkCreateGraphicsPipelines(device.device(), pipelineCache, 1, &pipelineInfo, nullptr, &part) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create graphics pipeline library part!");
+	}
+	return part;
+}
+
+VkPipeline Magnet::VKBase::PipelineLibrary::link(const Parts& parts, VkPipelineLayout layout, bool optimize)
+{
+	std::array<VkPipeline, 4> libraries = { parts.vertexInput, parts.preRasterization, parts.fragmentShader, parts.fragmentOutput };
+
+	VkPipelineLibraryCreateInfoKHR linkingInfo{};
+	linkingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+	linkingInfo.libraryCount = static_cast<uint32_t>(libraries.size());
+	linkingInfo.pLibraries = libraries.data();
+
+	VkGraphicsPipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.pNext = &linkingInfo;
+	pipelineInfo.layout = layout;
+	pipelineInfo.flags = optimize ? VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0;
+
+	VkPipeline pipeline;
+	if (vkCreateGraphicsPipelines(device.device(), pipelineCache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+		throw std::runtime_error("failed to link graphics pipeline libraries!");
+	}
+	return pipeline;
+}
+
+VkShaderModule Magnet::VKBase::PipelineLibrary::createShaderModule(const std::string& filepath)
+{
+	auto code = Pipeline::readFile(filepath);
+
+	VkShaderModuleCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	createInfo.codeSize = code.size();
+	createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+	VkShaderModule shaderModule;
+	if (vkCreateShaderModule(device.device(), &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create shader module");
+	}
+	return shaderModule;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include "../Commons.h"
+#include "Device.h"
+#include "Pipeline.h"
+
+#include <future>
+
+namespace Magnet {
+	namespace VKBase {
+
+		// VK_EXT_graphics_pipeline_library support : the vertex input, pre-rasterization, fragment shader and
+		// fragment output parts of a pipeline are compiled separately and cached by the state they consume and
+		// their shader. A new pipeline is then fast-linked from cached parts, while a link time optimized version is
+		// built in the background to replace it.
+		class PipelineLibrary {
+		public:
+			struct Stats {
+				uint32_t partCompiles = 0;
+				uint32_t partHits = 0;
+				uint32_t fastLinks = 0;
+				uint32_t optimizedLinks = 0;
+				double partCompileTimeMs = 0.0;
+				double fastLinkTimeMs = 0.0;
+			};
+
+			// Shader id (parts with a shader stage only) and the state consumed by a part flattened into words, with their hash
+			struct PartKey {
+				std::size_t shaderId = 0;
+				std::vector<uint32_t> state;
+				std::size_t hash = 0;
+
+				bool operator==(const PartKey& other) const { return hash == other.hash && shaderId == other.shaderId && state == other.state; }
+			};
+			struct PartKeyHash {
+				std::size_t operator()(const PartKey& key) const { return key.hash; }
+			};
+
+			PipelineLibrary(Device& device, VkPipelineCache pipelineCache = VK_NULL_HANDLE);
+			~PipelineLibrary();
+
+			PipelineLibrary(const PipelineLibrary&) = delete;
+			PipelineLibrary& operator=(const PipelineLibrary&) = delete;
+
+			// Links a pipeline without link time optimization, only missing parts are compiled
+			VkPipeline fastLink(const std::string& vertFilepath, std::size_t vertId, const std::string& fragFilepath, std::size_t fragId, const PipelineConfigInfo& configInfo);
+			// Links the same parts with link time optimization on a worker thread
+			std::future<VkPipeline> optimizeAsync(const std::string& vertFilepath, std::size_t vertId, const std::string& fragFilepath, std::size_t fragId, const PipelineConfigInfo& configInfo);
+
+			const Stats& getStats() const { return stats; }
+			void printStats() const;
+
+		private:
+			struct Parts {
+				VkPipeline vertexInput;
+				VkPipeline preRasterization;
+				VkPipeline fragmentShader;
+				VkPipeline fragmentOutput;
+			};
+
+			using PartCache = std::unordered_map<PartKey, VkPipeline, PartKeyHash>;
+
+			Parts getParts(const std::string& vertFilepath, std::size_t vertId, const std::string& fragFilepath, std::size_t fragId, const PipelineConfigInfo& configInfo);
+			VkPipeline getPart(PartCache& parts, PartKey key, const std::function<VkPipeline()>& compile);
+
+			VkPipeline createVertexInputPart(const PipelineConfigInfo& configInfo);
+			VkPipeline createPreRasterizationPart(const std::string& vertFilepath, const PipelineConfigInfo& configInfo);
+			VkPipeline createFragmentShaderPart(const std::string& fragFilepath, const PipelineConfigInfo& configInfo);
+			VkPipeline createFragmentOutputPart(const PipelineConfigInfo& configInfo);
+			VkPipeline createPart(VkGraphicsPipelineCreateInfo& pipelineInfo, VkGraphicsPipelineLibraryFlagsEXT flags);
+
+			VkPipeline link(const Parts& parts, VkPipelineLayout layout, bool optimize);
+			VkShaderModule createShaderModule(const std::string& filepath);
+
+			Device& device;
+			VkPipelineCache pipelineCache;
+
+			PartCache vertexInputParts;
+			PartCache preRasterizationParts;
+			PartCache fragmentShaderParts;
+			PartCache fragmentOutputParts;
+			Stats stats{};
+		};
+	}
+}
@@ -0,0 +1,354 @@
+#include "PipelineRegistry.h"
+#include "../Utils.h"
+
+#include <bit>
+#include <string_view>
+
+Magnet::VKBase::PipelineRegistry::PipelineRegistry(Device& device, VkPipelineCache pipelineCache) : device{ device }, pipelineCache{ pipelineCache }
+{
+	if (device.capabilities().graphicsPipelineLibrary && device.capabilities().fastLinking) {
+		library = std::make_unique<PipelineLibrary>(device, pipelineCache);
+	}
+}
+
+Magnet::VKBase::PipelineRegistry::~PipelineRegistry()
+{
+	clear();
+}
+
+std::shared_ptr<Magnet::VKBase::Pipeline> Magnet::VKBase::PipelineRegistry::getPipeline(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo)
+{
+	stats.requests++;
+
+	Key key = makeKey(vertFilepath, fragFilepath, configInfo);
+	auto it = pipelines.find(key);
+	if (it != pipelines.end()) {
+		stats.hits++;
+		return it->second;
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	std::shared_ptr<Pipeline> pipeline;
+	if (library) {
+		// Fast-link from cached parts now, swap in the link time optimized pipeline when it is ready
+		VkPipeline linked = library->fastLink(vertFilepath, key.vertId, fragFilepath, key.fragId, configInfo);
+		pipeline = std::make_shared<Pipeline>(device, linked, library->optimizeAsync(vertFilepath, key.vertId, fragFilepath, key.fragId, configInfo));
+	}
+	else {
+		pipeline = std::make_shared<Pipeline>(device, vertFilepath, fragFilepath, configInfo, pipelineCache);
+	}
+	double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	stats.compiles++;
+	stats.compileTimeMs += elapsedMs;
+	stats.maxCompileTimeMs = std::max(stats.maxCompileTimeMs, elapsedMs);
+
+	pipelines.emplace(std::move(key), pipeline);
+	return pipeline;
+}
+
+void Magnet::VKBase::PipelineRegistry::clear()
+{
+	// Pipelines still referenced elsewhere are destroyed when their last owner releases them
+	pipelines.clear();
+	shaderIds.clear();
+}
+
+void Magnet::VKBase::PipelineRegistry::printStats() const
+{
+	std::cout << "\nPipeline Registry :" << std::endl;
+	std::cout << "------------------------------" << std::endl;
+	std::cout << "\t- Pipelines : " << pipelines.size() << std::endl;
+	std::cout << "\t- Requests : " << stats.requests << std::endl;
+	std::cout << "\t- Cache hits : " << stats.hits << std::endl;
+	std::cout << "\t- Compiles : " << stats.compiles << std::endl;
+	std::cout << "\t- Compile time : " << stats.compileTimeMs << " ms (max " << stats.maxCompileTimeMs << " ms)" << std::endl;
+	if (library) {
+		library->printStats();
+	}
+}
+
+namespace {
+	// State set through the command buffer does not affect the compiled pipeline
+	bool isDynamic(const Magnet::VKBase::PipelineConfigInfo& configInfo, VkDynamicState state)
+	{
+		const auto& states = configInfo.dynamicStateEnables;
+		return std::find(states.begin(), states.end(), state) != states.end();
+	}
+
+	uint32_t dynamicOr(const Magnet::VKBase::PipelineConfigInfo& configInfo, VkDynamicState state, uint32_t value)
+	{
+		return isDynamic(configInfo, state) ? ~0u : value;
+	}
+
+	// Topologies a dynamic topology can switch between without changing pipeline
+	uint32_t topologyClass(VkPrimitiveTopology topology)
+	{
+		switch (topology) {
+		case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+			return 0;
+		case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+		case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+		case VK_PRIMITIVE_TOPOLOGY_LINE_LIST_WITH_ADJACENCY:
+		case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP_WITH_ADJACENCY:
+			return 1;
+		case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST:
+		case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP:
+		case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN:
+		case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST_WITH_ADJACENCY:
+		case VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP_WITH_ADJACENCY:
+			return 2;
+		case VK_PRIMITIVE_TOPOLOGY_PATCH_LIST:
+			return 3;
+		default:
+			return ~0u;
+		}
+	}
+
+	// Pipeline state is flattened into 32-bit words, the same words are hashed and compared
+	template<typename T>
+	void writeWord(std::vector<uint32_t>& words, T value)
+	{
+		if constexpr (std::is_floating_point_v<T>) {
+			words.push_back(std::bit_cast<uint32_t>(static_cast<float>(value)));
+		}
+		else if constexpr (sizeof(T) > sizeof(uint32_t)) {
+			words.push_back(static_cast<uint32_t>(static_cast<uint64_t>(value)));
+			words.push_back(static_cast<uint32_t>(static_cast<uint64_t>(value) >> 32));
+		}
+		else {
+			words.push_back(static_cast<uint32_t>(value));
+		}
+	}
+
+	template<typename... Values>
+	void writeWords(std::vector<uint32_t>& words, Values... values)
+	{
+		(writeWord(words, values), ...);
+	}
+
+	std::size_t hashWords(const std::vector<uint32_t>& words)
+	{
+		return std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(uint32_t)));
+	}
+
+	void writeDynamicStates(std::vector<uint32_t>& words, const Magnet::VKBase::PipelineConfigInfo& configInfo)
+	{
+		writeWords(words, configInfo.dynamicStateEnables.size());
+		for (VkDynamicState state : configInfo.dynamicStateEnables) {
+			writeWords(words, static_cast<uint32_t>(state));
+		}
+	}
+
+	// Stands in for the render pass when the pipeline targets dynamic rendering
+	void writeAttachmentFormats(std::vector<uint32_t>& words, const Magnet::VKBase::PipelineConfigInfo& configInfo)
+	{
+		writeWords(words, configInfo.colorAttachmentFormats.size());
+		for (VkFormat format : configInfo.colorAttachmentFormats) {
+			writeWords(words, static_cast<uint32_t>(format));
+		}
+		writeWords(words,
+			static_cast<uint32_t>(configInfo.depthAttachmentFormat),
+			static_cast<uint32_t>(configInfo.stencilAttachmentFormat));
+	}
+
+	void writeVertexInputState(std::vector<uint32_t>& words, const Magnet::VKBase::PipelineConfigInfo& configInfo)
+	{
+		writeWords(words, configInfo.bindingDescriptions.size(), configInfo.attributeDescriptions.size());
+		for (const auto& binding : configInfo.bindingDescriptions) {
+			writeWords(words, binding.binding, binding.stride, static_cast<uint32_t>(binding.inputRate));
+		}
+		for (const auto& attribute : configInfo.attributeDescriptions) {
+			writeWords(words, attribute.location, attribute.binding, static_cast<uint32_t>(attribute.format), attribute.offset);
+		}
+
+		const auto& inputAssembly = configInfo.inputAssemblyInfo;
+		uint32_t topology = static_cast<uint32_t>(inputAssembly.topology);
+		if (isDynamic(configInfo, VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT)) {
+			// Only the topology class has to match the pipeline
+			topology = topologyClass(inputAssembly.topology);
+		}
+		writeWords(words,
+			topology,
+			dynamicOr(configInfo, VK_DYNAMIC_STATE_PRIMITIVE_RESTART_ENABLE_EXT, inputAssembly.primitiveRestartEnable));
+
+		writeDynamicStates(words, configInfo);
+	}
+
+	void writePreRasterizationState(std::vector<uint32_t>& words, const Magnet::VKBase::PipelineConfigInfo& configInfo)
+	{
+		const auto& viewport = configInfo.viewportInfo;
+		writeWords(words, viewport.viewportCount, viewport.scissorCount);
+
+		const auto& raster = configInfo.rasterizationInfo;
+		writeWords(words,
+			raster.depthClampEnable,
+			dynamicOr(configInfo, VK_DYNAMIC_STATE_RASTERIZER_DISCARD_ENABLE_EXT, raster.rasterizerDiscardEnable),
+			dynamicOr(configInfo, VK_DYNAMIC_STATE_POLYGON_MODE_EXT, static_cast<uint32_t>(raster.polygonMode)),
+			dynamicOr(configInfo, VK_DYNAMIC_STATE_CULL_MODE_EXT, raster.cullMode),
+			dynamicOr(configInfo, VK_DYNAMIC_STATE_FRONT_FACE_EXT, static_cast<uint32_t>(raster.frontFace)),
+			dynamicOr(configInfo, VK_DYNAMIC_STATE_DEPTH_BIAS_ENABLE_EXT, raster.depthBiasEnable),
+			raster.depthBiasConstantFactor,
+			raster.depthBiasClamp,
+			raster.depthBiasSlopeFactor,
+			raster.lineWidth);
+
+		writeWords(words,
+			reinterpret_cast<uintptr_t>(configInfo.pipelineLayout),
+			reinterpret_cast<uintptr_t>(configInfo.renderPass),
+			configInfo.subpass);
+		writeAttachmentFormats(words, configInfo);
+
+		writeDynamicStates(words, configInfo);
+	}
+
+	void writeFragmentShaderState(std::vector<uint32_t>& words, const Magnet::VKBase::PipelineConfigInfo& configInfo)
+	{
+		const auto& multisample = configInfo.multisampleInfo;
+		writeWords(words,
+			static_cast<uint32_t>(multisample.rasterizationSamples),
+			multisample.sampleShadingEnable,
+			multisample.minSampleShading);
+
+		const auto& depth = configInfo.depthStencilInfo;
+		writeWords(words,
+			dynamicOr(configInfo, VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE_EXT, depth.depthTestEnable),
+			dynamicOr(configInfo, VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT, depth.depthWriteEnable),
+			dynamicOr(configInfo, VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT, static_cast<uint32_t>(depth.depthCompareOp)),
+			depth.depthBoundsTestEnable,
+			depth.minDepthBounds,
+			depth.maxDepthBounds,
+			depth.stencilTestEnable);
+		for (const VkStencilOpState* op : { &depth.front, &depth.back }) {
+			writeWords(words,
+				static_cast<uint32_t>(op->failOp),
+				static_cast<uint32_t>(op->passOp),
+				static_cast<uint32_t>(op->depthFailOp),
+				static_cast<uint32_t>(op->compareOp),
+				op->compareMask,
+				op->writeMask,
+				op->reference);
+		}
+
+		writeWords(words,
+			reinterpret_cast<uintptr_t>(configInfo.pipelineLayout),
+			reinterpret_cast<uintptr_t>(configInfo.renderPass),
+			configInfo.subpass);
+		writeAttachmentFormats(words, configInfo);
+
+		writeDynamicStates(words, configInfo);
+	}
+
+	void writeFragmentOutputState(std::vector<uint32_t>& words, const Magnet::VKBase::PipelineConfigInfo& configInfo)
+	{
+		const auto& multisample = configInfo.multisampleInfo;
+		writeWords(words,
+			static_cast<uint32_t>(multisample.rasterizationSamples),
+			multisample.alphaToCoverageEnable,
+			multisample.alphaToOneEnable);
+
+		const auto& blendAttachment = configInfo.colorBlendAttachment;
+		writeWords(words,
+			blendAttachment.blendEnable,
+			static_cast<uint32_t>(blendAttachment.srcColorBlendFactor),
+			static_cast<uint32_t>(blendAttachment.dstColorBlendFactor),
+			static_cast<uint32_t>(blendAttachment.colorBlendOp),
+			static_cast<uint32_t>(blendAttachment.srcAlphaBlendFactor),
+			static_cast<uint32_t>(blendAttachment.dstAlphaBlendFactor),
+			static_cast<uint32_t>(blendAttachment.alphaBlendOp),
+			blendAttachment.colorWriteMask);
+
+		const auto& blend = configInfo.colorBlendInfo;
+		writeWords(words,
+			blend.logicOpEnable,
+			static_cast<uint32_t>(blend.logicOp),
+			blend.attachmentCount,
+			blend.blendConstants[0],
+			blend.blendConstants[1],
+			blend.blendConstants[2],
+			blend.blendConstants[3]);
+
+		writeWords(words,
+			reinterpret_cast<uintptr_t>(configInfo.renderPass),
+			configInfo.subpass);
+		writeAttachmentFormats(words, configInfo);
+
+		writeDynamicStates(words, configInfo);
+	}
+
+	template<typename Write>
+	std::size_t hashState(const Magnet::VKBase::PipelineConfigInfo& configInfo, Write write)
+	{
+		std::vector<uint32_t> words;
+		write(words, configInfo);
+		return hashWords(words);
+	}
+
+	template<typename Write>
+	Magnet::VKBase::PipelineLibrary::PartKey makePartKey(const Magnet::VKBase::PipelineConfigInfo& configInfo, std::size_t shaderId, Write write)
+	{
+		Magnet::VKBase::PipelineLibrary::PartKey key;
+		key.shaderId = shaderId;
+		write(key.state, configInfo);
+		key.hash = hashWords(key.state);
+		Magnet::hashCombine(key.hash, shaderId);
+		return key;
+	}
+}
+
+void Magnet::VKBase::PipelineRegistry::writeState(const PipelineConfigInfo& configInfo, std::vector<uint32_t>& words)
+{
+	writeVertexInputState(words, configInfo);
+	writePreRasterizationState(words, configInfo);
+	writeFragmentShaderState(words, configInfo);
+	writeFragmentOutputState(words, configInfo);
+}
+
+Magnet::VKBase::PipelineRegistry::Key Magnet::VKBase::PipelineRegistry::makeKey(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo)
+{
+	Key key;
+	key.vertId = shaderModuleId(vertFilepath);
+	key.fragId = shaderModuleId(fragFilepath);
+	writeState(configInfo, key.state);
+	key.hash = hashWords(key.state);
+	hashCombine(key.hash, key.vertId, key.fragId);
+	return key;
+}
+
+std::size_t Magnet::VKBase::PipelineRegistry::hashConfig(const PipelineConfigInfo& configInfo)
+{
+	return hashState(configInfo, [](std::vector<uint32_t>& words, const PipelineConfigInfo& config) { writeState(config, words); });
+}
+
+Magnet::VKBase::PipelineLibrary::PartKey Magnet::VKBase::PipelineRegistry::vertexInputKey(const PipelineConfigInfo& configInfo)
+{
+	return makePartKey(configInfo, 0, writeVertexInputState);
+}
+
+Magnet::VKBase::PipelineLibrary::PartKey Magnet::VKBase::PipelineRegistry::preRasterizationKey(const PipelineConfigInfo& configInfo, std::size_t vertId)
+{
+	return makePartKey(configInfo, vertId, writePreRasterizationState);
+}
+
+Magnet::VKBase::PipelineLibrary::PartKey Magnet::VKBase::PipelineRegistry::fragmentShaderKey(const PipelineConfigInfo& configInfo, std::size_t fragId)
+{
+	return makePartKey(configInfo, fragId, writeFragmentShaderState);
+}
+
+Magnet::VKBase::PipelineLibrary::PartKey Magnet::VKBase::PipelineRegistry::fragmentOutputKey(const PipelineConfigInfo& configInfo)
+{
+	return makePartKey(configInfo, 0, writeFragmentOutputState);
+}
+
+std::size_t Magnet::VKBase::PipelineRegistry::shaderModuleId(const std::string& filepath)
+{
+	auto it = shaderIds.find(filepath);
+	if (it != shaderIds.end()) {
+		return it->second;
+	}
+
+	auto code = Pipeline::readFile(filepath);
+	std::size_t id = shaderCodeIds.emplace(std::string(code.data(), code.size()), shaderCodeIds.size()).first->second;
+	shaderIds.emplace(filepath, id);
+	return id;
+}
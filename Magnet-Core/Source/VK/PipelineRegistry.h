@@ -0,0 +1,79 @@
+#pragma once
+#include "../Commons.h"
+#include "Device.h"
+#include "Pipeline.h"
+#include "PipelineLibrary.h"
+
+namespace Magnet {
+	namespace VKBase {
+
+		// Owns every graphics pipeline of the renderer and deduplicates them by their full state (fixed function state,
+		// dynamic states, render pass or attachment formats and shader code). The state is hashed to find a pipeline
+		// and compared in full, so configurations whose hashes collide still get their own pipeline.
+		// Pipelines are compiled the first time they are requested and shared afterwards.
+		class PipelineRegistry {
+		public:
+			struct Stats {
+				uint32_t requests = 0;
+				uint32_t hits = 0;
+				uint32_t compiles = 0;
+				double compileTimeMs = 0.0;
+				double maxCompileTimeMs = 0.0;
+			};
+
+			// Shader ids and the pipeline state flattened into words, with their hash
+			struct Key {
+				std::size_t vertId = 0;
+				std::size_t fragId = 0;
+				std::vector<uint32_t> state;
+				std::size_t hash = 0;
+
+				bool operator==(const Key& other) const { return hash == other.hash && vertId == other.vertId && fragId == other.fragId && state == other.state; }
+			};
+			struct KeyHash {
+				std::size_t operator()(const Key& key) const { return key.hash; }
+			};
+
+			PipelineRegistry(Device& device, VkPipelineCache pipelineCache = VK_NULL_HANDLE);
+			~PipelineRegistry();
+
+			PipelineRegistry(const PipelineRegistry&) = delete;
+			PipelineRegistry& operator=(const PipelineRegistry&) = delete;
+
+			std::shared_ptr<Pipeline> getPipeline(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo);
+			Key makeKey(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo);
+			bool contains(const Key& key) const { return pipelines.find(key) != pipelines.end(); }
+			size_t size() const { return pipelines.size(); }
+			void clear();
+
+			const Stats& getStats() const { return stats; }
+			void printStats() const;
+
+			// Appends the state of every graphics pipeline library part
+			static void writeState(const PipelineConfigInfo& configInfo, std::vector<uint32_t>& words);
+			static std::size_t hashConfig(const PipelineConfigInfo& configInfo);
+			// Keys of the graphics pipeline library parts, from the state each part consumes and its shader id
+			static PipelineLibrary::PartKey vertexInputKey(const PipelineConfigInfo& configInfo);
+			static PipelineLibrary::PartKey preRasterizationKey(const PipelineConfigInfo& configInfo, std::size_t vertId);
+			static PipelineLibrary::PartKey fragmentShaderKey(const PipelineConfigInfo& configInfo, std::size_t fragId);
+			static PipelineLibrary::PartKey fragmentOutputKey(const PipelineConfigInfo& configInfo);
+
+			// Files with the same SPIR-V share an id
+			std::size_t shaderModuleId(const std::string& filepath);
+
+		private:
+			Device& device;
+			VkPipelineCache pipelineCache;
+
+			// Set when the device supports graphics pipeline libraries
+			std::unique_ptr<PipelineLibrary> library;
+
+			std::unordered_map<Key, std::shared_ptr<Pipeline>, KeyHash> pipelines;
+			// Shader id per file, looked up by SPIR-V content so renamed copies of a shader still share pipelines
+			std::unordered_map<std::string, std::size_t> shaderIds;
+			// Shader id per SPIR-V code, compared in full. Kept by clear() since the library's parts refer to the ids
+			std::unordered_map<std::string, std::size_t> shaderCodeIds;
+			Stats stats{};
+		};
+	}
+}
@@ -0,0 +1,139 @@
+#include "ShaderObject.h"
+
+Magnet::VKBase::ShaderObject::ShaderObject(
+	Device& device,
+	const std::string& vertFilepath,
+	const std::string& fragFilepath,
+	const std::vector<VkDescriptorSetLayout>& setLayouts,
+	const std::vector<VkPushConstantRange>& pushConstantRanges) : device{ device }
+{
+	assert(device.capabilities().shaderObject && "Cannot create shader objects: VK_EXT_shader_object is not enabled");
+	createShaders(vertFilepath, fragFilepath, setLayouts, pushConstantRanges);
+}
+
+Magnet::VKBase::ShaderObject::~ShaderObject()
+{
+	for (VkShaderEXT shader : shaders) {
+		if (shader != VK_NULL_HANDLE) {
+			device.functions().vkDestroyShaderEXT(device.device(), shader, nullptr);
+		}
+	}
+}
+
+void Magnet::VKBase::ShaderObject::createShaders(const std::string& vertFilepath, const std::string& fragFilepath, const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pushConstantRanges)
+{
+	auto vertCode = Pipeline::readFile(vertFilepath);
+	auto fragCode = Pipeline::readFile(fragFilepath);
+
+	std::array<VkShaderCreateInfoEXT, 2> createInfos{};
+	for (auto& createInfo : createInfos) {
+		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_CREATE_INFO_EXT;
+		// Linked stages let the implementation optimize across the interface, like a monolithic pipeline
+		createInfo.flags = VK_SHADER_CREATE_LINK_STAGE_BIT_EXT;
+		createInfo.codeType = VK_SHADER_CODE_TYPE_SPIRV_EXT;
+		createInfo.pName = "main";
+		createInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+		createInfo.pSetLayouts = setLayouts.data();
+		createInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+		createInfo.pPushConstantRanges = pushConstantRanges.data();
+	}
+
+	createInfos[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	createInfos[0].nextStage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	createInfos[0].codeSize = vertCode.size();
+	createInfos[0].pCode = vertCode.data();
+
+	createInfos[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	createInfos[1].nextStage = 0;
+	createInfos[1].codeSize = fragCode.size();
+	createInfos[1].pCode = fragCode.data();
+
+	if (device.functions().vkCreateShadersEXT(device.device(), static_cast<uint32_t>(createInfos.size()), createInfos.data(), nullptr, shaders.data()) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create shader objects!");
+	}
+}
+
+void Magnet::VKBase::ShaderObject::bind(VkCommandBuffer commandBuffer, const PipelineConfigInfo& configInfo, VkExtent2D extent)
+{
+	const auto& fn = device.functions();
+
+	const VkShaderStageFlagBits stages[2] = { VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT };
+	fn.vkCmdBindShadersEXT(commandBuffer, 2, stages, shaders.data());
+
+	// Vertex input
+	std::vector<VkVertexInputBindingDescription2EXT> bindings;
+	for (const auto& binding : configInfo.bindingDescriptions) {
+		VkVertexInputBindingDescription2EXT description{};
+		description.sType = VK_STRUCTURE_TYPE_VERTEX_INPUT_BINDING_DESCRIPTION_2_EXT;
+		description.binding = binding.binding;
+		description.stride = binding.stride;
+		description.inputRate = binding.inputRate;
+		description.divisor = 1;
+		bindings.push_back(description);
+	}
+	std::vector<VkVertexInputAttributeDescription2EXT> attributes;
+	for (const auto& attribute : configInfo.attributeDescriptions) {
+		VkVertexInputAttributeDescription2EXT description{};
+		description.sType = VK_STRUCTURE_TYPE_VERTEX_INPUT_ATTRIBUTE_DESCRIPTION_2_EXT;
+		description.location = attribute.location;
+		description.binding = attribute.binding;
+		description.format = attribute.format;
+		description.offset = attribute.offset;
+		attributes.push_back(description);
+	}
+	fn.vkCmdSetVertexInputEXT(commandBuffer, static_cast<uint32_t>(bindings.size()), bindings.data(), static_cast<uint32_t>(attributes.size()), attributes.data());
+
+	// Input assembly
+	fn.vkCmdSetPrimitiveTopologyEXT(commandBuffer, configInfo.inputAssemblyInfo.topology);
+	fn.vkCmdSetPrimitiveRestartEnableEXT(commandBuffer, configInfo.inputAssemblyInfo.primitiveRestartEnable);
+
+	// Viewport
+	VkViewport viewport{ 0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f };
+	VkRect2D scissor{ { 0, 0 }, extent };
+	fn.vkCmdSetViewportWithCountEXT(commandBuffer, 1, &viewport);
+	fn.vkCmdSetScissorWithCountEXT(commandBuffer, 1, &scissor);
+
+	// Rasterization
+	const auto& raster = configInfo.rasterizationInfo;
+	fn.vkCmdSetRasterizerDiscardEnableEXT(commandBuffer, raster.rasterizerDiscardEnable);
+	fn.vkCmdSetPolygonModeEXT(commandBuffer, raster.polygonMode);
+	fn.vkCmdSetCullModeEXT(commandBuffer, raster.cullMode);
+	fn.vkCmdSetFrontFaceEXT(commandBuffer, raster.frontFace);
+	fn.vkCmdSetDepthBiasEnableEXT(commandBuffer, raster.depthBiasEnable);
+	if (raster.depthBiasEnable) {
+		vkCmdSetDepthBias(commandBuffer, raster.depthBiasConstantFactor, raster.depthBiasClamp, raster.depthBiasSlopeFactor);
+	}
+	vkCmdSetLineWidth(commandBuffer, raster.lineWidth);
+
+	// Multisampling
+	const auto& multisample = configInfo.multisampleInfo;
+	const VkSampleMask sampleMask = ~0u;
+	fn.vkCmdSetRasterizationSamplesEXT(commandBuffer, multisample.rasterizationSamples);
+	fn.vkCmdSetSampleMaskEXT(commandBuffer, multisample.rasterizationSamples, multisample.pSampleMask ? multisample.pSampleMask : &sampleMask);
+	fn.vkCmdSetAlphaToCoverageEnableEXT(commandBuffer, multisample.alphaToCoverageEnable);
+
+	// Depth and stencil
+	const auto& depth = configInfo.depthStencilInfo;
+	fn.vkCmdSetDepthTestEnableEXT(commandBuffer, depth.depthTestEnable);
+	fn.vkCmdSetDepthWriteEnableEXT(commandBuffer, depth.depthWriteEnable);
+	fn.vkCmdSetDepthCompareOpEXT(commandBuffer, depth.depthCompareOp);
+	fn.vkCmdSetStencilTestEnableEXT(commandBuffer, depth.stencilTestEnable);
+	// depthBounds is not enabled on the device, so its dynamic state must not be set
+
+	// Color blending, the same attachment state is used for every color attachment
+	const auto& attachment = configInfo.colorBlendAttachment;
+	uint32_t attachmentCount = configInfo.colorBlendInfo.attachmentCount;
+	std::vector<VkBool32> blendEnables(attachmentCount, attachment.blendEnable);
+	std::vector<VkColorComponentFlags> writeMasks(attachmentCount, attachment.colorWriteMask);
+	VkColorBlendEquationEXT equation{};
+	equation.srcColorBlendFactor = attachment.srcColorBlendFactor;
+	equation.dstColorBlendFactor = attachment.dstColorBlendFactor;
+	equation.colorBlendOp = attachment.colorBlendOp;
+	equation.srcAlphaBlendFactor = attachment.srcAlphaBlendFactor;
+	equation.dstAlphaBlendFactor = attachment.dstAlphaBlendFactor;
+	equation.alphaBlendOp = attachment.alphaBlendOp;
+	std::vector<VkColorBlendEquationEXT> equations(attachmentCount, equation);
+	fn.vkCmdSetColorBlendEnableEXT(commandBuffer, 0, attachmentCount, blendEnables.data());
+	fn.vkCmdSetColorBlendEquationEXT(commandBuffer, 0, attachmentCount, equations.data());
+	fn.vkCmdSetColorWriteMaskEXT(commandBuffer, 0, attachmentCount, writeMasks.data());
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "../Commons.h"
+#include "Device.h"
+#include "Pipeline.h"
+
+namespace Magnet {
+	namespace VKBase {
+
+		// Alternative to Pipeline built on VK_EXT_shader_object : the vertex and fragment stages are
+		// compiled into linked VkShaderEXT objects and every piece of state is recorded at bind time
+		// from a PipelineConfigInfo, so no state combination ever needs a compile.
+		class ShaderObject {
+		public:
+			ShaderObject(
+				Device& device,
+				const std::string& vertFilepath,
+				const std::string& fragFilepath,
+				const std::vector<VkDescriptorSetLayout>& setLayouts,
+				const std::vector<VkPushConstantRange>& pushConstantRanges);
+			~ShaderObject();
+
+			ShaderObject(const ShaderObject&) = delete;
+			ShaderObject& operator=(const ShaderObject&) = delete;
+
+			// Binds both stages and records the complete state described by configInfo
+			void bind(VkCommandBuffer commandBuffer, const PipelineConfigInfo& configInfo, VkExtent2D extent);
+
+		private:
+			void createShaders(const std::string& vertFilepath, const std::string& fragFilepath, const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pushConstantRanges);
+
+			Device& device;
+			std::array<VkShaderEXT, 2> shaders{ VK_NULL_HANDLE, VK_NULL_HANDLE };
+		};
+	}
+}
@@ -18,7 +18,10 @@ void Magnet::VKBase::SwapChain::Init()
 	createImageViews();
 	createSyncObjects();
 	createDepthResources();
-	createRenderPass();
+	dynamicRendering = device.capabilities().dynamicRendering;
+	if (!dynamicRendering) {
+		createRenderPass();
+	}
 }
 
 Magnet::VKBase::SwapChain::~SwapChain()
@@ -43,7 +46,9 @@ Magnet::VKBase::SwapChain::~SwapChain()
 		vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
 	}
 
-	vkDestroyRenderPass(device.device(), renderPass, nullptr);
+	if (renderPass != VK_NULL_HANDLE) {
+		vkDestroyRenderPass(device.device(), renderPass, nullptr);
+	}
 
 	// cleanup synchronization objects
 	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
@@ -329,6 +334,10 @@ void Magnet::VKBase::SwapChain::createRenderPass()
 
 void Magnet::VKBase::SwapChain::createFramebuffers()
 {
+	if (dynamicRendering) {
+		return;
+	}
+
 	swapChainFramebuffers.resize(imageCount());
 	for (size_t i = 0; i < imageCount(); i++) {
 		std::array<VkImageView, 2> attachments = { swapChainImageViews[i], depthImageViews[i] };
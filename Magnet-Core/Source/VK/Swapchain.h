@@ -1,6 +1,7 @@
 #pragma once
 #include "../Commons.h"
 #include "Device.h"
+#include "DynamicRendering.h"
 
 #include <vulkan/vulkan.h>
 
@@ -20,6 +21,7 @@ namespace Magnet {
 
             VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
             VkRenderPass getRenderPass() { return renderPass; }
+            VkImage getImage(int index) { return swapChainImages[index]; }
             VkImageView getImageView(int index) { return swapChainImageViews[index]; }
             size_t imageCount() { return swapChainImages.size(); }
             VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
@@ -41,6 +43,11 @@ namespace Magnet {
 
             void createFramebuffers();
 
+            // With VK_KHR_dynamic_rendering no render pass or framebuffers are created, the render graph
+            // transitions the swapchain images and begins rendering on them
+            bool usesDynamicRendering() const { return dynamicRendering; }
+            VkFormat getDepthFormat() const { return swapChainDepthFormat; }
+
         private:
             void Init();
             void createSwapChain();
@@ -61,7 +68,8 @@ namespace Magnet {
             VkExtent2D swapChainExtent;
 
             std::vector<VkFramebuffer> swapChainFramebuffers;
-            VkRenderPass renderPass;
+            VkRenderPass renderPass = VK_NULL_HANDLE;
+            bool dynamicRendering = false;
 
             std::vector<VkImage> depthImages;
             std::vector<VkDeviceMemory> depthImageMemorys;
@@ -1,3 +1,9 @@
+-- glslc of the Vulkan SDK when VULKAN_SDK is set, the one on the PATH otherwise
+local vulkanSdk = os.getenv("VULKAN_SDK")
+Glslc = vulkanSdk and ('"' .. path.join(vulkanSdk, os.host() == "windows" and "Bin/glslc.exe" or "bin/glslc") .. '"') or "glslc"
+-- Shaders are rebuilt when a file they include changes
+ShaderIncludes = os.matchfiles(path.join(_SCRIPT_DIR, "assets/defaults/shaders/*.glsl"))
+
 project "Magnet-Editor"
    kind "ConsoleApp"
    language "C++"
@@ -28,7 +34,34 @@ project "Magnet-Editor"
    targetdir ("../Binaries/" .. OutputDir .. "/%{prj.name}")
    objdir ("../Binaries/Intermediates/" .. OutputDir .. "/%{prj.name}")
    
-   prebuildcommands { "cd $(ProjectDir)assets\\defaults\\shaders\\ \n call compile_vs.bat" }
+   -- GLSL is compiled to SPIR-V next to its source by glslc, from the Vulkan SDK or the PATH, on every platform
+   files
+   {
+      "assets/defaults/shaders/*.vert",
+      "assets/defaults/shaders/*.frag",
+      "assets/defaults/shaders/*.comp",
+      "assets/defaults/shaders/*.task",
+      "assets/defaults/shaders/*.mesh",
+      "assets/defaults/shaders/*.glsl"
+   }
+
+   filter "files:assets/defaults/shaders/*.vert or assets/defaults/shaders/*.frag or assets/defaults/shaders/*.comp"
+       buildmessage "Compiling %{file.name}"
+       buildcommands { Glslc .. ' "%{file.abspath}" -o "%{file.abspath}.spv"' }
+       buildoutputs { "%{file.abspath}.spv" }
+       buildinputs { ShaderIncludes }
+
+   -- Mesh shaders need SPIR-V 1.4
+   filter "files:assets/defaults/shaders/*.task or assets/defaults/shaders/*.mesh"
+       buildmessage "Compiling %{file.name}"
+       buildcommands { Glslc .. ' --target-env=vulkan1.2 "%{file.abspath}" -o "%{file.abspath}.spv"' }
+       buildoutputs { "%{file.abspath}.spv" }
+       buildinputs { ShaderIncludes }
+
+   -- Vertex pulling variant of shader.vert, reads vertices through buffer device addresses
+   filter "files:assets/defaults/shaders/shader.vert"
+       buildcommands { Glslc .. ' --target-env=vulkan1.2 -DVERTEX_PULLING "%{file.abspath}" -o "%{file.directory}/shader_pulled.vert.spv"' }
+       buildoutputs { "%{file.directory}/shader_pulled.vert.spv" }
 
    filter "system:windows"
        systemversion "latest"
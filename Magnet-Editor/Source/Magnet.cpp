@@ -1,12 +1,50 @@
 #include "Engine.h"
+#include "Engine/Rendering/TextureCompressor.h"
 
 
-int main() {
+int main(int argc, char** argv) {
 
-    Magnet::Engine app{};
+    //Offline asset cooking, before the device exists
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--compress-textures" || argument == "--compress-textures-fast" || argument == "--compress-textures-high") {
+            Magnet::EngineBase::Rendering::TextureCompressor::Settings settings{};
+            if (argument == "--compress-textures-fast") {
+                settings.quality = Magnet::EngineBase::Rendering::TextureCompressor::Quality::Fast;
+            }
+            else if (argument == "--compress-textures-high") {
+                settings.quality = Magnet::EngineBase::Rendering::TextureCompressor::Quality::High;
+            }
+            Magnet::EngineBase::Rendering::TextureCompressor compressor{ settings };
+            compressor.compressDirectory("assets/defaults/textures");
+            compressor.printStats();
+        }
+    }
 
     //Initialization
-    app.init();
+    Magnet::Engine app{};
+
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--dump-render-graph") {
+            app.setRenderGraphDump(true);
+        }
+        else if (argument == "--shader-objects") {
+            app.setRenderBackend(Magnet::Engine::RenderBackend::ShaderObjects);
+        }
+        else if (argument == "--visibility-buffer") {
+            app.setRenderPath(Magnet::Engine::RenderPath::VisibilityBuffer);
+        }
+        else if (argument == "--meshlets") {
+            app.setRenderPath(Magnet::Engine::RenderPath::Meshlets);
+        }
+        else if (argument == "--vertex-pulling") {
+            app.setRenderPath(Magnet::Engine::RenderPath::VertexPulling);
+        }
+        else if (argument == "--bench-lights") {
+            app.benchmarkLighting();
+        }
+    }
 
     //Main App Loop
     while (not app.shouldClose()) {
@@ -0,0 +1,107 @@
+// Shared by the forward (shader.frag), visibility buffer (visibility_resolve.frag) and meshlet (meshlet.frag) shading.
+// Set 2 is the clustered lighting, set 3 the cascaded shadow maps.
+
+const uint MAX_LIGHTS_PER_CLUSTER = 256;
+
+struct PointLight {
+  vec4 positionRadius; // w is the influence radius
+  vec4 colorIntensity; // w is intensity
+};
+
+layout(set = 2, binding = 0) uniform ClusterParams {
+  mat4 inverseProjection;
+  mat4 view;
+  uvec4 gridSize;    // w is the light count
+  vec4 screenSize;   // zw is the tile size in pixels
+  vec4 depthParams;  // near, far, slice scale, slice bias
+  uvec4 options;     // x is 1 when clustered
+} cluster;
+
+layout(std430, set = 2, binding = 1) readonly buffer Lights {
+  PointLight lights[];
+};
+
+layout(std430, set = 2, binding = 2) readonly buffer LightGrid {
+  uint lightCounts[];
+};
+
+layout(std430, set = 2, binding = 3) readonly buffer LightIndices {
+  uint lightIndices[];
+};
+
+const uint CASCADE_COUNT = 4;
+
+layout(set = 3, binding = 0) uniform ShadowParams {
+  mat4 cascadeViewProjection[CASCADE_COUNT];
+  vec4 splitDepths;
+  vec4 lightDirection;
+  vec4 lightColor; // w is intensity
+} shadow;
+
+layout(set = 3, binding = 1) uniform sampler2DArrayShadow shadowMap;
+
+// 3x3 PCF in the cascade covering the fragment's view depth
+float sampleShadow(vec3 positionWorld, float viewDepth) {
+  uint cascade = CASCADE_COUNT - 1;
+  for (uint i = 0; i < CASCADE_COUNT - 1; i++) {
+    if (viewDepth < shadow.splitDepths[i]) {
+      cascade = i;
+      break;
+    }
+  }
+  if (viewDepth > shadow.splitDepths[CASCADE_COUNT - 1]) {
+    return 1.0;
+  }
+
+  vec4 lightSpace = shadow.cascadeViewProjection[cascade] * vec4(positionWorld, 1.0);
+  vec3 coords = lightSpace.xyz / lightSpace.w;
+  coords.xy = coords.xy * 0.5 + 0.5;
+
+  vec2 texelSize = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+  float lit = 0.0;
+  for (int x = -1; x <= 1; x++) {
+    for (int y = -1; y <= 1; y++) {
+      lit += texture(shadowMap, vec4(coords.xy + vec2(x, y) * texelSize, float(cascade), coords.z));
+    }
+  }
+  return lit / 9.0;
+}
+
+vec3 evaluateLight(PointLight light, vec3 positionWorld, vec3 normal) {
+  vec3 directionToLight = light.positionRadius.xyz - positionWorld;
+  float distanceSquared = dot(directionToLight, directionToLight);
+  // Windowed inverse square falloff, reaches zero at the light radius the clusters were built with
+  float window = clamp(1.0 - distanceSquared / (light.positionRadius.w * light.positionRadius.w), 0.0, 1.0);
+  float attenuation = window * window / max(distanceSquared, 0.0001);
+
+  vec3 lightColor = light.colorIntensity.xyz * light.colorIntensity.w * attenuation;
+  return lightColor * max(dot(normal, normalize(directionToLight)), 0);
+}
+
+// Diffuse light reaching a surface : shadowed sun plus the point lights of its cluster
+vec3 shadeSurface(vec3 positionWorld, vec3 normal, vec2 fragCoord) {
+  vec3 diffuseLight = vec3(0.0);
+  float viewDepth = -(cluster.view * vec4(positionWorld, 1.0)).z;
+
+  // Directional sun, shadowed by the cascades
+  vec3 sunColor = shadow.lightColor.xyz * shadow.lightColor.w;
+  diffuseLight += sunColor * max(dot(normal, -shadow.lightDirection.xyz), 0) * sampleShadow(positionWorld, viewDepth);
+
+  if (cluster.options.x == 0) {
+    // Brute force reference
+    for (uint i = 0; i < cluster.gridSize.w; i++) {
+      diffuseLight += evaluateLight(lights[i], positionWorld, normal);
+    }
+  } else {
+    uint slice = uint(max(log(viewDepth) * cluster.depthParams.z + cluster.depthParams.w, 0.0));
+    uvec3 tile = uvec3(uvec2(fragCoord / cluster.screenSize.zw), min(slice, cluster.gridSize.z - 1));
+    tile.xy = min(tile.xy, cluster.gridSize.xy - 1);
+    uint clusterIndex = tile.x + tile.y * cluster.gridSize.x + tile.z * cluster.gridSize.x * cluster.gridSize.y;
+
+    uint count = lightCounts[clusterIndex];
+    for (uint i = 0; i < count; i++) {
+      diffuseLight += evaluateLight(lights[lightIndices[clusterIndex * MAX_LIGHTS_PER_CLUSTER + i]], positionWorld, normal);
+    }
+  }
+  return diffuseLight;
+}
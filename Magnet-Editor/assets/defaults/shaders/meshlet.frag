@@ -0,0 +1,21 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+layout (location = 0) in vec3 fragColor;
+layout (location = 1) in vec3 fragPosWorld;
+layout (location = 2) in vec3 fragNormalWorld;
+
+layout (location = 0) out vec4 outColor;
+
+#define MESHLET_SET 1
+#include "meshlet.glsl"
+#include "lighting.glsl"
+
+// Same shading as shader.frag, the ambient light comes from the meshlet parameters
+void main() {
+  vec3 normal = normalize(fragNormalWorld);
+  vec3 ambientLight = params.ambientLight.xyz * params.ambientLight.w;
+  vec3 diffuseLight = shadeSurface(fragPosWorld, normal, gl_FragCoord.xy);
+
+  outColor = vec4((ambientLight + diffuseLight) * fragColor, 1);
+}
@@ -0,0 +1,113 @@
+// Meshlet inputs shared by the mesh shader path (meshlet.task, meshlet.mesh, meshlet.frag) and the culling pass of the
+// indirect fallback (meshlet_cull.comp). The includer defines MESHLET_SET, layouts match MeshletRenderer and MeshletBuilder.
+
+// Words per vertex, matches PackedVertex : unorm16 position (2), octahedral snorm16 normal, half UV
+const uint VERTEX_STRIDE = 4;
+
+struct Meshlet {
+  uint vertexOffset;
+  uint triangleOffset;
+  uint vertexCount;
+  uint triangleCount;
+};
+
+struct MeshletBounds {
+  vec4 sphere;   // w is the radius
+  vec4 coneApex;
+  vec4 cone;     // xyz is the axis, w the cutoff, 1 never culls
+};
+
+struct DrawRecord {
+  mat4 modelMatrix; // includes the dequantization of the mesh
+  uint firstMeshlet;
+  uint meshletCount;
+  uint firstCommand;
+  float scale;      // largest axis scale, negative when not uniform
+  int vertexOffset; // first vertex of the mesh, added to the meshlet vertices
+};
+
+layout(set = MESHLET_SET, binding = 0) uniform MeshletParams {
+  mat4 viewProjection;
+  vec4 frustumPlanes[6];
+  vec4 cameraPosition;
+  vec4 ambientLight; // w is intensity
+  uvec4 options;     // draw count, frustum culling, cone culling, color stride
+} params;
+
+layout(std430, set = MESHLET_SET, binding = 1) readonly buffer Draws {
+  DrawRecord draws[];
+};
+
+layout(std430, set = MESHLET_SET, binding = 2) readonly buffer Meshlets {
+  Meshlet meshlets[];
+};
+
+layout(std430, set = MESHLET_SET, binding = 3) readonly buffer Bounds {
+  MeshletBounds meshletBounds[];
+};
+
+// Indices into the vertices of the draw's mesh
+layout(std430, set = MESHLET_SET, binding = 4) readonly buffer MeshletVertices {
+  uint meshletVertices[];
+};
+
+// Three 8-bit indices into the meshlet's vertices
+layout(std430, set = MESHLET_SET, binding = 5) readonly buffer MeshletTriangles {
+  uint meshletTriangles[];
+};
+
+layout(std430, set = MESHLET_SET, binding = 6) readonly buffer Vertices {
+  uint vertexData[];
+};
+
+layout(std430, set = MESHLET_SET, binding = 7) readonly buffer Colors {
+  uint colors[];
+};
+
+layout(std430, set = MESHLET_SET, binding = 9) buffer MeshletStats {
+  uint visibleMeshlets;
+} stats;
+
+// Quantized position, the draw's model matrix dequantizes it
+vec3 loadPosition(uint vertex) {
+  uint base = vertex * VERTEX_STRIDE;
+  return vec3(unpackUnorm2x16(vertexData[base]), unpackUnorm2x16(vertexData[base + 1]).x);
+}
+
+vec2 loadEncodedNormal(uint vertex) {
+  return unpackSnorm2x16(vertexData[vertex * VERTEX_STRIDE + 2]);
+}
+
+vec3 loadColor(uint vertex) {
+  return unpackUnorm4x8(colors[vertex * params.options.w]).rgb;
+}
+
+uvec3 loadTriangle(Meshlet meshlet, uint triangle) {
+  uint packed = meshletTriangles[meshlet.triangleOffset + triangle];
+  return uvec3(packed & 0xFFu, (packed >> 8) & 0xFFu, (packed >> 16) & 0xFFu);
+}
+
+// Bounding sphere against the frustum planes, then the normal cone : a camera inside the cone behind its apex only
+// sees the back of every triangle, which back face culling would drop anyway
+bool isMeshletVisible(DrawRecord draw, uint meshletIndex) {
+  MeshletBounds bounds = meshletBounds[meshletIndex];
+
+  if (params.options.y != 0u) {
+    vec3 center = (draw.modelMatrix * vec4(bounds.sphere.xyz, 1.0)).xyz;
+    float radius = bounds.sphere.w * abs(draw.scale);
+    for (uint i = 0; i < 6; i++) {
+      if (dot(params.frustumPlanes[i].xyz, center) + params.frustumPlanes[i].w < -radius) {
+        return false;
+      }
+    }
+  }
+
+  if (params.options.z != 0u && draw.scale > 0.0 && bounds.cone.w < 1.0) {
+    vec3 apex = (draw.modelMatrix * vec4(bounds.coneApex.xyz, 1.0)).xyz;
+    vec3 axis = normalize(mat3(draw.modelMatrix) * bounds.cone.xyz);
+    if (dot(normalize(apex - params.cameraPosition.xyz), axis) >= bounds.cone.w) {
+      return false;
+    }
+  }
+  return true;
+}
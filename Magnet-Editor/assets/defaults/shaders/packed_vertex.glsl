@@ -0,0 +1,9 @@
+// Decoding of PackedVertex, shared by the forward (shader.vert), visibility buffer (visibility_resolve.frag) and meshlet (meshlet.mesh) passes.
+// Positions are unorm16 in the mesh quantization box, folded into the model matrix on the CPU side.
+
+vec3 decodeOctahedral(vec2 encoded) {
+  vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+  float t = max(-n.z, 0.0);
+  n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+  return normalize(n);
+}
@@ -1,4 +1,5 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 
 layout (location = 0) in vec3 fragColor;
 layout (location = 1) in vec3 fragPosWorld;
@@ -14,20 +15,12 @@ layout(set = 0, binding = 0) uniform GlobalUBO {
   vec4 lightColor;
 } ubo;
 
-layout(push_constant) uniform Push {
-  mat4 modelMatrix;
-  mat4 normalMatrix;
-} push;
-
-
+#include "lighting.glsl"
 
 void main() {
-  vec3 directionToLight = ubo.lightPosition - fragPosWorld;
-  float attenuation = 1.0 / dot(directionToLight, directionToLight); // distance squared
-
-  vec3 lightColor = ubo.lightColor.xyz * ubo.lightColor.w * attenuation;
+  vec3 normal = normalize(fragNormalWorld);
   vec3 ambientLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w;
-  vec3 diffuseLight = lightColor * max(dot(normalize(fragNormalWorld), normalize(directionToLight)), 0);
+  vec3 diffuseLight = shadeSurface(fragPosWorld, normal, gl_FragCoord.xy);
 
-  outColor = vec4((ambientLight+diffuseLight)*fragColor,1);
+  outColor = vec4((ambientLight + diffuseLight) * fragColor, 1);
 }
\ No newline at end of file
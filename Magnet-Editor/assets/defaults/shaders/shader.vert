@@ -1,10 +1,46 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 
-layout(location = 0) in vec3 position;
-layout(location = 1) in vec3 color;
-layout(location = 2) in vec3 normal;
+#ifdef VERTEX_PULLING
+#extension GL_EXT_buffer_reference : require
+
+// Built a second time with VERTEX_PULLING (shader_pulled.vert.spv) for pipelines with no vertex input : each vertex is
+// fetched through the addresses of its draw, read at gl_InstanceIndex (see VertexPuller)
+const uint FORMAT_PACKED = 0; // PackedVertex, 4 words
+const uint FORMAT_FLOAT = 1;  // MeshFile::Vertex, 11 floats : position, normal, uv, color
+
+layout(buffer_reference, std430, buffer_reference_align = 4) readonly buffer Words {
+  uint words[];
+};
+
+struct DrawData {
+  mat4 modelMatrix; // includes the dequantization of packed meshes
+  Words vertices;
+  Words colors;
+  uint format;
+  uint colorStride; // 0 when a single color is shared by every vertex
+};
+
+layout(buffer_reference, std430, buffer_reference_align = 16) readonly buffer DrawBuffer {
+  DrawData draws[];
+};
+
+layout(push_constant) uniform Push {
+  DrawBuffer draws;
+} push;
+#else
+// Matches PackedVertex : the position w is 1, the normal is octahedral encoded
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec4 color;
+layout(location = 2) in vec2 normal;
 layout(location = 3) in vec2 uv;
 
+// The model matrix includes the dequantization of the mesh
+layout(push_constant) uniform Push {
+  mat4 modelMatrix;
+} push;
+#endif
+
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec3 fragPosWorld;
 layout(location = 2) out vec3 fragNormalWorld;
@@ -17,15 +53,36 @@ layout(set = 0, binding = 0) uniform GlobalUBO {
   vec4 lightColor;
 } ubo;
 
-layout(push_constant) uniform Push {
-  mat4 modelMatrix;
-  mat4 normalMatrix;
-} push;
+#include "packed_vertex.glsl"
 
 void main() {
-  vec4 positionWorld = push.modelMatrix * vec4(position, 1.0);
+#ifdef VERTEX_PULLING
+  DrawData draw = push.draws.draws[gl_InstanceIndex];
+  uint vertex = uint(gl_VertexIndex);
+  mat4 modelMatrix = draw.modelMatrix;
+  vec4 position;
+  vec3 normalModel;
+  vec3 color;
+  if (draw.format == FORMAT_PACKED) {
+    uint base = vertex * 4;
+    position = vec4(unpackUnorm2x16(draw.vertices.words[base]), unpackUnorm2x16(draw.vertices.words[base + 1]).x, 1.0);
+    normalModel = decodeOctahedral(unpackSnorm2x16(draw.vertices.words[base + 2]));
+    color = unpackUnorm4x8(draw.colors.words[vertex * draw.colorStride]).rgb;
+  }
+  else {
+    uint base = vertex * 11;
+    position = vec4(uintBitsToFloat(uvec3(draw.vertices.words[base], draw.vertices.words[base + 1], draw.vertices.words[base + 2])), 1.0);
+    normalModel = normalize(uintBitsToFloat(uvec3(draw.vertices.words[base + 3], draw.vertices.words[base + 4], draw.vertices.words[base + 5])));
+    color = uintBitsToFloat(uvec3(draw.vertices.words[base + 8], draw.vertices.words[base + 9], draw.vertices.words[base + 10]));
+  }
+#else
+  mat4 modelMatrix = push.modelMatrix;
+  vec3 normalModel = decodeOctahedral(normal);
+#endif
+
+  vec4 positionWorld = modelMatrix * position;
   gl_Position = ubo.projection * ubo.view * positionWorld;
-  fragNormalWorld = normalize(mat3(push.normalMatrix) * normal);
+  fragNormalWorld = normalize(transpose(inverse(mat3(modelMatrix))) * normalModel);
   fragPosWorld = positionWorld.xyz;
-  fragColor = color;
-}
\ No newline at end of file
+  fragColor = color.rgb;
+}
@@ -0,0 +1,5 @@
+#version 450
+
+// Depth only, the fixed function depth write is all the cascades need
+void main() {
+}
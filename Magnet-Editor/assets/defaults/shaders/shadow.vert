@@ -0,0 +1,13 @@
+#version 450
+
+// Quantized PackedVertex position, w is 1
+layout(location = 0) in vec4 position;
+
+layout(push_constant) uniform Push {
+  mat4 modelMatrix;
+  mat4 lightViewProjection;
+} push;
+
+void main() {
+  gl_Position = push.lightViewProjection * push.modelMatrix * position;
+}
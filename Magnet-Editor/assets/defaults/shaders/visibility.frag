@@ -0,0 +1,16 @@
+#version 450
+
+// Must match VisibilityBuffer::TRIANGLE_BITS
+const uint TRIANGLE_BITS = 20;
+
+layout(location = 0) out uint outVisibility;
+
+layout(push_constant) uniform Push {
+  mat4 modelViewProjection;
+  uint drawID;
+} push;
+
+void main() {
+  // gl_PrimitiveID restarts at 0 for every draw, draws are split so it fits in TRIANGLE_BITS
+  outVisibility = (push.drawID << TRIANGLE_BITS) | uint(gl_PrimitiveID);
+}
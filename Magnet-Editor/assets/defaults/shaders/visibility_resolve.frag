@@ -0,0 +1,125 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+// Must match VisibilityBuffer::TRIANGLE_BITS and VisibilityBuffer::EMPTY
+const uint TRIANGLE_BITS = 20;
+const uint TRIANGLE_MASK = (1u << TRIANGLE_BITS) - 1u;
+const uint EMPTY = 0xFFFFFFFFu;
+// Words per vertex, matches PackedVertex : unorm16 position (2), octahedral snorm16 normal, half UV
+const uint VERTEX_STRIDE = 4;
+
+layout(location = 0) out vec4 outColor;
+
+struct DrawRecord {
+  mat4 modelMatrix;
+  uint firstIndex;
+  uint indexCount;
+  uint colorStride; // 0 when every vertex reads the first color
+  int vertexOffset;
+  uint indexOffset; // first word of the draw's index pool
+  uint index16;
+  uint pad0;
+  uint pad1;
+};
+
+layout(set = 1, binding = 0) uniform ResolveParams {
+  mat4 viewProjection;
+  vec4 screenSize;   // zw is 1 / size
+  vec4 ambientLight; // w is intensity
+} params;
+
+layout(std430, set = 1, binding = 1) readonly buffer Draws {
+  DrawRecord draws[];
+};
+
+layout(std430, set = 1, binding = 2) readonly buffer Vertices {
+  uint vertexData[];
+};
+
+// 16-bit pool from word 0, then the 32-bit pool
+layout(std430, set = 1, binding = 3) readonly buffer Indices {
+  uint indices[];
+};
+
+layout(set = 1, binding = 4) uniform usampler2D visibilityBuffer;
+
+layout(std430, set = 1, binding = 5) readonly buffer Colors {
+  uint colors[];
+};
+
+#include "lighting.glsl"
+#include "packed_vertex.glsl"
+
+// Quantized position, the draw's model matrix dequantizes it
+vec3 loadPosition(uint vertex) {
+  uint base = vertex * VERTEX_STRIDE;
+  return vec3(unpackUnorm2x16(vertexData[base]), unpackUnorm2x16(vertexData[base + 1]).x);
+}
+
+vec3 loadNormal(uint vertex) {
+  return decodeOctahedral(unpackSnorm2x16(vertexData[vertex * VERTEX_STRIDE + 2]));
+}
+
+uint loadVertexIndex(DrawRecord draw, uint index) {
+  if (draw.index16 != 0u) {
+    uint pair = indices[draw.indexOffset + (index >> 1)];
+    return ((index & 1u) != 0u ? pair >> 16 : pair & 0xFFFFu) + uint(draw.vertexOffset);
+  }
+  return indices[draw.indexOffset + index] + uint(draw.vertexOffset);
+}
+
+vec3 loadColor(uint vertex, uint colorStride) {
+  return unpackUnorm4x8(colors[vertex * colorStride]).rgb;
+}
+
+// Perspective correct barycentrics of the pixel inside the clip space triangle
+vec3 computeBarycentrics(vec4 clip0, vec4 clip1, vec4 clip2, vec2 ndc) {
+  vec3 invW = 1.0 / vec3(clip0.w, clip1.w, clip2.w);
+  vec2 p0 = clip0.xy * invW.x;
+  vec2 p1 = clip1.xy * invW.y;
+  vec2 p2 = clip2.xy * invW.z;
+
+  // Screen space barycentrics from the edge functions
+  float area = (p1.x - p0.x) * (p2.y - p0.y) - (p2.x - p0.x) * (p1.y - p0.y);
+  float b1 = ((ndc.x - p0.x) * (p2.y - p0.y) - (p2.x - p0.x) * (ndc.y - p0.y)) / area;
+  float b2 = ((p1.x - p0.x) * (ndc.y - p0.y) - (ndc.x - p0.x) * (p1.y - p0.y)) / area;
+  vec3 screen = vec3(1.0 - b1 - b2, b1, b2);
+
+  vec3 perspective = screen * invW;
+  return perspective / (perspective.x + perspective.y + perspective.z);
+}
+
+void main() {
+  uint visibility = texelFetch(visibilityBuffer, ivec2(gl_FragCoord.xy), 0).x;
+  if (visibility == EMPTY) {
+    discard;
+  }
+
+  DrawRecord draw = draws[visibility >> TRIANGLE_BITS];
+  uint firstIndex = draw.firstIndex + (visibility & TRIANGLE_MASK) * 3;
+  uvec3 triangle = uvec3(loadVertexIndex(draw, firstIndex), loadVertexIndex(draw, firstIndex + 1), loadVertexIndex(draw, firstIndex + 2));
+
+  vec3 position0 = (draw.modelMatrix * vec4(loadPosition(triangle.x), 1.0)).xyz;
+  vec3 position1 = (draw.modelMatrix * vec4(loadPosition(triangle.y), 1.0)).xyz;
+  vec3 position2 = (draw.modelMatrix * vec4(loadPosition(triangle.z), 1.0)).xyz;
+
+  vec2 ndc = gl_FragCoord.xy * params.screenSize.zw * 2.0 - 1.0;
+  vec3 barycentrics = computeBarycentrics(
+    params.viewProjection * vec4(position0, 1.0),
+    params.viewProjection * vec4(position1, 1.0),
+    params.viewProjection * vec4(position2, 1.0),
+    ndc);
+
+  vec3 positionWorld = mat3(position0, position1, position2) * barycentrics;
+  vec3 normalLocal = mat3(loadNormal(triangle.x), loadNormal(triangle.y), loadNormal(triangle.z)) * barycentrics;
+  vec3 color = mat3(
+    loadColor(triangle.x, draw.colorStride),
+    loadColor(triangle.y, draw.colorStride),
+    loadColor(triangle.z, draw.colorStride)) * barycentrics;
+  vec3 normal = normalize(transpose(inverse(mat3(draw.modelMatrix))) * normalLocal);
+
+  vec3 ambientLight = params.ambientLight.xyz * params.ambientLight.w;
+  vec3 diffuseLight = shadeSurface(positionWorld, normal, gl_FragCoord.xy);
+
+  outColor = vec4((ambientLight + diffuseLight) * color, 1);
+}